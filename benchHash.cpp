@@ -0,0 +1,1384 @@
+/***********************************************************************
+ * Program:
+ *    BENCH HASH
+ * Summary:
+ *    Micro-benchmarks for the hash containers. This is a separate
+ *    driver from the unit tests; build it with optimization:
+ *       g++ -std=c++17 -O2 -DNDEBUG benchHash.cpp -o benchHash -pthread
+ *    Run "benchHash [benchmark] [maxKeys]" where benchmark is one of the
+ *    names listed in main() (or "all") and maxKeys caps the largest
+ *    table. Redirect the output into bench_output.txt to keep it.
+ * Author
+ *       Marco Varela &  Andre Regino
+ ************************************************************************/
+
+#include "hash.h"       // for custom::unordered_set
+#include "flatHash.h"   // for custom::flat_unordered_set
+#include "pool.h"       // for custom::pool_allocator
+#include "hashPolicy.h" // for the bucket index policies
+#include "concurrentHash.h" // for custom::concurrent_unordered_set
+#include "executor.h"   // for the parallel rehash executors
+#include "hashFunction.h" // for the seeded custom::hash
+#include "smallHash.h"  // for custom::small_unordered_set
+#include "shardedHash.h" // for custom::sharded_unordered_set
+#include "epochHash.h"   // for custom::epoch_unordered_set
+#include "constexprHash.h" // for custom::constexpr_unordered_set
+#include "cuckooHash.h"   // for custom::cuckoo_unordered_set
+
+#include <algorithm>    // for std::sort and std::shuffle
+#include <atomic>       // for std::atomic flag to stop the writer
+#include <chrono>       // for std::chrono::steady_clock
+#include <cstdint>      // for uint64_t
+#include <cstdio>       // for std::remove
+#include <cstdlib>      // for std::strtoull
+#include <iostream>     // for std::cout
+#include <iomanip>      // for std::setw
+#include <mutex>        // for std::mutex
+#include <random>       // for std::mt19937_64 to shuffle the probes
+#include <thread>       // for std::thread
+#include <string>       // for std::string
+#include <string_view>  // for std::string_view
+#include <vector>       // for std::vector of keys
+
+/**********************************************************************
+ * TIMER
+ * Wall clock nanoseconds since construction
+ ***********************************************************************/
+class Timer
+{
+public:
+   Timer() : start(std::chrono::steady_clock::now()) {}
+   double elapsed() const
+   {
+      return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(
+         std::chrono::steady_clock::now() - start).count();
+   }
+private:
+   std::chrono::steady_clock::time_point start;
+};
+
+/**********************************************************************
+ * RANDOM KEYS
+ * num distinct-enough pseudo-random 64 bit keys from splitmix64
+ ***********************************************************************/
+std::vector<uint64_t> randomKeys(size_t num, uint64_t seed)
+{
+   std::vector<uint64_t> keys(num);
+   for (size_t i = 0; i < num; i++)
+   {
+      uint64_t z = (seed += 0x9e3779b97f4a7c15ULL);
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+      keys[i] = z ^ (z >> 31);
+   }
+   return keys;
+}
+
+// keep the optimizer from discarding the lookups
+volatile size_t sink;
+
+/**********************************************************************
+ * MEASURE SET
+ * Insert the keys, then look every key up, then look up keys that are
+ * not there. Report nanoseconds per operation.
+ ***********************************************************************/
+template <class Set, class Key>
+void measureSet(const char * name, const std::vector<Key>& keys,
+                const std::vector<Key>& misses)
+{
+   Set s;
+   Timer tInsert;
+   for (auto& key : keys)
+      s.insert(key);
+   double nsInsert = tInsert.elapsed() / keys.size();
+
+   size_t found = 0;
+   Timer tHit;
+   for (auto& key : keys)
+      found += (s.find(key) != s.end());
+   double nsHit = tHit.elapsed() / keys.size();
+
+   Timer tMiss;
+   for (auto& key : misses)
+      found += (s.find(key) != s.end());
+   double nsMiss = tMiss.elapsed() / misses.size();
+   sink = found;
+
+   std::cout << std::setw(12) << keys.size()
+             << std::setw(22) << name
+             << std::setw(12) << nsInsert
+             << std::setw(12) << nsHit
+             << std::setw(12) << nsMiss << "\n";
+}
+
+/**********************************************************************
+ * BENCH FLAT
+ * The chained unordered_set against the open-addressing
+ * flat_unordered_set from 1K keys up to maxKeys
+ ***********************************************************************/
+void benchFlat(size_t maxKeys)
+{
+   std::cout << "flat: chained vs open addressing (ns/op)\n"
+             << std::setw(12) << "keys" << std::setw(22) << "container"
+             << std::setw(12) << "insert" << std::setw(12) << "find hit"
+             << std::setw(12) << "find miss" << "\n";
+   for (size_t num = 1000; num <= maxKeys; num *= 10)
+   {
+      std::vector<uint64_t> keys   = randomKeys(num, 1);
+      std::vector<uint64_t> misses = randomKeys(num, 2);
+      measureSet<custom::unordered_set<uint64_t>>     ("unordered_set",      keys, misses);
+      measureSet<custom::flat_unordered_set<uint64_t>>("flat_unordered_set", keys, misses);
+   }
+   std::cout << std::endl;
+}
+
+/**********************************************************************
+ * BENCH POOL
+ * The chained unordered_set with its nodes from the global allocator
+ * against the same set drawing every bucket's nodes from the node pool
+ ***********************************************************************/
+void benchPool(size_t maxKeys)
+{
+   typedef custom::unordered_set<uint64_t, std::hash<uint64_t>, std::equal_to<uint64_t>,
+                                 custom::pool_allocator<uint64_t>> PoolSet;
+   std::cout << "pool: global allocator vs node pool (ns/op)\n"
+             << std::setw(12) << "keys" << std::setw(22) << "container"
+             << std::setw(12) << "insert" << std::setw(12) << "find hit"
+             << std::setw(12) << "find miss" << "\n";
+   for (size_t num = 1000; num <= maxKeys; num *= 10)
+   {
+      std::vector<uint64_t> keys   = randomKeys(num, 1);
+      std::vector<uint64_t> misses = randomKeys(num, 2);
+      measureSet<custom::unordered_set<uint64_t>>("std::allocator", keys, misses);
+      measureSet<PoolSet>                        ("pool_allocator", keys, misses);
+   }
+   std::cout << std::endl;
+}
+
+/**********************************************************************
+ * MEASURE INDEX
+ * Turn every hash into a bucket index with one policy. The bucket count
+ * is read at run time so the compiler cannot fold the divide.
+ ***********************************************************************/
+template <class Policy>
+void measureIndex(const char * name, const std::vector<uint64_t>& hashes,
+                  size_t numBuckets)
+{
+   Policy policy;
+   numBuckets = policy.bucket_count(numBuckets);
+   size_t total = 0;
+   Timer t;
+   for (auto hash : hashes)
+      total += policy.index(hash, numBuckets);
+   double ns = t.elapsed() / hashes.size();
+   sink = total;
+
+   std::cout << std::setw(12) << numBuckets
+             << std::setw(22) << name
+             << std::setw(12) << ns << "\n";
+}
+
+/**********************************************************************
+ * BENCH INDEX
+ * The cost of turning a hash into a bucket index, alone and inside
+ * the chained unordered_set, for each bucket index policy
+ ***********************************************************************/
+void benchIndex(size_t maxKeys)
+{
+   typedef std::hash<uint64_t> Hash;
+   typedef std::equal_to<uint64_t> Equal;
+   typedef std::allocator<uint64_t> Alloc;
+
+   std::vector<uint64_t> hashes = randomKeys(maxKeys, 3);
+   size_t numBuckets = maxKeys + 3;   // odd, and only known at run time
+   std::cout << "index: hash to bucket index (ns/op)\n"
+             << std::setw(12) << "buckets" << std::setw(22) << "policy"
+             << std::setw(12) << "index" << "\n";
+   measureIndex<custom::modulo_index>      ("modulo_index",       hashes, numBuckets);
+   measureIndex<custom::power_of_two_index>("power_of_two_index", hashes, numBuckets);
+   measureIndex<custom::fastrange_index>   ("fastrange_index",    hashes, numBuckets);
+   measureIndex<custom::prime_index>       ("prime_index",        hashes, numBuckets);
+   std::cout << "\n";
+
+   std::cout << "index: unordered_set by policy (ns/op)\n"
+             << std::setw(12) << "keys" << std::setw(22) << "policy"
+             << std::setw(12) << "insert" << std::setw(12) << "find hit"
+             << std::setw(12) << "find miss" << "\n";
+   for (size_t num = 1000; num <= maxKeys; num *= 10)
+   {
+      std::vector<uint64_t> keys   = randomKeys(num, 1);
+      std::vector<uint64_t> misses = randomKeys(num, 2);
+      measureSet<custom::unordered_set<uint64_t, Hash, Equal, Alloc, custom::modulo_index>>
+         ("modulo_index", keys, misses);
+      measureSet<custom::unordered_set<uint64_t, Hash, Equal, Alloc, custom::power_of_two_index>>
+         ("power_of_two_index", keys, misses);
+      measureSet<custom::unordered_set<uint64_t, Hash, Equal, Alloc, custom::fastrange_index>>
+         ("fastrange_index", keys, misses);
+      measureSet<custom::unordered_set<uint64_t, Hash, Equal, Alloc, custom::prime_index>>
+         ("prime_index", keys, misses);
+   }
+   std::cout << std::endl;
+}
+
+/**********************************************************************
+ * STRING HASH
+ * std::hash<std::string> under another name, so cache_hash_code
+ * leaves the hash out of the nodes
+ ***********************************************************************/
+struct StringHash
+{
+   size_t operator()(const std::string& s) const { return std::hash<std::string>()(s); }
+};
+
+/**********************************************************************
+ * BENCH CACHE
+ * Long string keys with and without the hash cached in each node
+ ***********************************************************************/
+void benchCache(size_t maxKeys)
+{
+   std::cout << "cache: string keys, hash recomputed vs cached (ns/op)\n"
+             << std::setw(12) << "keys" << std::setw(22) << "container"
+             << std::setw(12) << "insert" << std::setw(12) << "find hit"
+             << std::setw(12) << "find miss" << "\n";
+   for (size_t num = 1000; num <= maxKeys; num *= 10)
+   {
+      // a long shared prefix makes both hashing and == expensive
+      std::vector<std::string> keys;
+      std::vector<std::string> misses;
+      for (auto key : randomKeys(num, 1))
+         keys.push_back("/usr/share/lab/hash/key/" + std::to_string(key));
+      for (auto key : randomKeys(num, 2))
+         misses.push_back("/usr/share/lab/hash/key/" + std::to_string(key));
+      measureSet<custom::unordered_set<std::string, StringHash>>("recomputed", keys, misses);
+      measureSet<custom::unordered_set<std::string>>            ("cached",     keys, misses);
+   }
+   std::cout << std::endl;
+}
+
+/**********************************************************************
+ * BUFFER HASH and BUFFER EQUAL
+ * Transparent functors for std::string keys: a string_view into a
+ * receive buffer hashes and compares the same as the string it names
+ ***********************************************************************/
+struct BufferHash
+{
+   typedef void is_transparent;
+   size_t operator()(std::string_view s) const { return std::hash<std::string_view>()(s); }
+};
+struct BufferEqual
+{
+   typedef void is_transparent;
+   bool operator()(std::string_view lhs, std::string_view rhs) const { return lhs == rhs; }
+};
+
+/**********************************************************************
+ * BENCH TRANSPARENT
+ * Look up string keys that arrive as slices of one network buffer,
+ * half of them present. The classic path copies each slice into a
+ * std::string (the keys are too long for the small string buffer, so
+ * that is an allocation); the transparent path probes with the slice.
+ ***********************************************************************/
+void benchTransparent(size_t maxKeys)
+{
+   std::cout << "transparent: string keys from a buffer (ns/lookup)\n"
+             << std::setw(12) << "keys" << std::setw(22) << "lookup"
+             << std::setw(12) << "find" << "\n";
+   for (size_t num = 1000; num <= maxKeys; num *= 10)
+   {
+      custom::unordered_set<std::string, BufferHash, BufferEqual> s;
+      std::string buffer;
+      std::vector<std::pair<size_t, size_t>> slices;
+      std::vector<uint64_t> hits = randomKeys(num, 1);
+      std::vector<uint64_t> misses = randomKeys(num, 2);
+      for (size_t i = 0; i < num; i++)
+      {
+         std::string key = "session:" + std::to_string(hits[i]);
+         s.insert(key);
+         for (const std::string& probe : { key, "session:" + std::to_string(misses[i]) })
+         {
+            slices.push_back(std::make_pair(buffer.size(), probe.size()));
+            buffer += probe;
+         }
+      }
+
+      size_t found = 0;
+      Timer tCopy;
+      for (auto& slice : slices)
+         found += (s.find(std::string(buffer, slice.first, slice.second)) != s.end());
+      double nsCopy = tCopy.elapsed() / slices.size();
+
+      Timer tView;
+      for (auto& slice : slices)
+         found += (s.find(std::string_view(buffer).substr(slice.first, slice.second)) != s.end());
+      double nsView = tView.elapsed() / slices.size();
+      sink = found;
+
+      std::cout << std::setw(12) << num << std::setw(22) << "copy to std::string"
+                << std::setw(12) << nsCopy << "\n"
+                << std::setw(12) << num << std::setw(22) << "string_view"
+                << std::setw(12) << nsView << "\n";
+   }
+   std::cout << std::endl;
+}
+
+/**********************************************************************
+ * BENCH BATCH
+ * Scalar insert and find against insert_many and find_many, fed in
+ * pages of 1000 keys, half of the lookups missing. The larger tables
+ * are well past the last level cache, where the prefetching pays.
+ ***********************************************************************/
+void benchBatch(size_t maxKeys)
+{
+   const size_t PAGE = 1000;
+   std::cout << "batch: scalar vs batched in pages of " << PAGE << " (ns/key)\n"
+             << std::setw(12) << "keys" << std::setw(22) << "api"
+             << std::setw(12) << "insert" << std::setw(12) << "find" << "\n";
+   for (size_t num = 10000; num <= maxKeys; num *= 10)
+   {
+      std::vector<uint64_t> keys = randomKeys(num, 1);
+      std::vector<uint64_t> probes = randomKeys(num, 2);
+      for (size_t i = 0; i < num; i += 2)
+         probes[i] = keys[(i * 7919) % num];
+      std::vector<std::vector<uint64_t>> keyPages;
+      std::vector<std::vector<uint64_t>> probePages;
+      for (size_t i = 0; i < num; i += PAGE)
+      {
+         keyPages.emplace_back(keys.begin() + i, keys.begin() + std::min(num, i + PAGE));
+         probePages.emplace_back(probes.begin() + i, probes.begin() + std::min(num, i + PAGE));
+      }
+
+      custom::unordered_set<uint64_t> scalar;
+      Timer tScalarInsert;
+      for (auto& page : keyPages)
+         for (auto key : page)
+            scalar.insert(key);
+      double nsScalarInsert = tScalarInsert.elapsed() / num;
+      size_t found = 0;
+      Timer tScalarFind;
+      for (auto& page : probePages)
+         for (auto key : page)
+            found += (scalar.find(key) != scalar.end());
+      double nsScalarFind = tScalarFind.elapsed() / num;
+
+      custom::unordered_set<uint64_t> batch;
+      Timer tBatchInsert;
+      for (auto& page : keyPages)
+         batch.insert_many(page);
+      double nsBatchInsert = tBatchInsert.elapsed() / num;
+      std::vector<bool> out;
+      Timer tBatchFind;
+      for (auto& page : probePages)
+      {
+         out.clear();
+         found += batch.find_many(page, std::back_inserter(out));
+      }
+      double nsBatchFind = tBatchFind.elapsed() / num;
+      sink = found;
+
+      std::cout << std::setw(12) << num << std::setw(22) << "scalar"
+                << std::setw(12) << nsScalarInsert << std::setw(12) << nsScalarFind << "\n"
+                << std::setw(12) << num << std::setw(22) << "batch"
+                << std::setw(12) << nsBatchInsert << std::setw(12) << nsBatchFind << "\n";
+   }
+   std::cout << std::endl;
+}
+
+/**********************************************************************
+ * BENCH BULK
+ * A warm start: load a vector of distinct keys into an empty set by
+ * inserting one at a time, with the presized range constructor, and
+ * with the range constructor that trusts the keys to be unique
+ ***********************************************************************/
+void benchBulk(size_t maxKeys)
+{
+   std::cout << "bulk: loading distinct keys (ns/key)\n"
+             << std::setw(12) << "keys" << std::setw(22) << "load"
+             << std::setw(12) << "time" << "\n";
+   for (size_t num = 10000; num <= maxKeys; num *= 10)
+   {
+      std::vector<uint64_t> keys(num);
+      for (size_t i = 0; i < num; i++)
+         keys[i] = i * 0x9e3779b97f4a7c15ULL;
+
+      // Load once untimed, so every variant finds the heap already
+      // faulted in. Only the load is timed, not tearing the set down.
+      delete new custom::unordered_set<uint64_t>(keys.begin(), keys.end());
+
+      Timer tInsert;
+      custom::unordered_set<uint64_t> * pInsert = new custom::unordered_set<uint64_t>;
+      for (auto key : keys)
+         pInsert->insert(key);
+      double nsInsert = tInsert.elapsed() / num;
+      delete pInsert;
+
+      Timer tRange;
+      custom::unordered_set<uint64_t> * pRange = new custom::unordered_set<uint64_t>(keys.begin(), keys.end());
+      double nsRange = tRange.elapsed() / num;
+      delete pRange;
+
+      Timer tUnique;
+      custom::unordered_set<uint64_t> * pUnique = new custom::unordered_set<uint64_t>(custom::unique_keys, keys.begin(), keys.end());
+      double nsUnique = tUnique.elapsed() / num;
+      delete pUnique;
+
+      std::cout << std::setw(12) << num << std::setw(22) << "insert one by one"
+                << std::setw(12) << nsInsert << "\n"
+                << std::setw(12) << num << std::setw(22) << "range, presized"
+                << std::setw(12) << nsRange << "\n"
+                << std::setw(12) << num << std::setw(22) << "range, unique keys"
+                << std::setw(12) << nsUnique << "\n";
+   }
+   std::cout << std::endl;
+}
+
+/**********************************************************************
+ * MEASURE REHASH
+ * Fill a set with the keys, then time one rehash to twice the buckets
+ ***********************************************************************/
+template <class Rehash>
+void measureRehash(const char * name, const std::vector<uint64_t>& keys, Rehash rehash)
+{
+   custom::unordered_set<uint64_t> s(keys.size());
+   for (auto key : keys)
+      s.insert(key);
+   size_t numBuckets = s.bucket_count() * 2;
+
+   Timer t;
+   rehash(s, numBuckets);
+   double ms = t.elapsed() / 1000000.0;
+   sink = s.bucket_count();
+
+   std::cout << std::setw(12) << keys.size()
+             << std::setw(22) << name
+             << std::setw(12) << ms << "\n";
+}
+
+/**********************************************************************
+ * BENCH REHASH
+ * One growth event: the single-threaded rehash that moves every
+ * element, against the split rehash that splices nodes, in one task
+ * and on every hardware thread
+ ***********************************************************************/
+void benchRehash(size_t maxKeys)
+{
+   size_t numThreads = custom::thread_executor().concurrency();
+   std::cout << "rehash: doubling the buckets, " << numThreads << " hardware threads (ms)\n"
+             << std::setw(12) << "keys" << std::setw(22) << "rehash"
+             << std::setw(12) << "time" << "\n";
+   for (size_t num = 10000; num <= maxKeys; num *= 10)
+   {
+      std::vector<uint64_t> keys = randomKeys(num, 1);
+      measureRehash("serial, move", keys, [](custom::unordered_set<uint64_t>& s, size_t n)
+      {
+         s.rehash(n);
+      });
+      measureRehash("split, one task", keys, [](custom::unordered_set<uint64_t>& s, size_t n)
+      {
+         s.rehash(n, custom::inline_executor());
+      });
+      measureRehash("split, threads", keys, [](custom::unordered_set<uint64_t>& s, size_t n)
+      {
+         s.rehash(n, custom::thread_executor());
+      });
+   }
+   std::cout << std::endl;
+}
+
+// std::hash<uint64_t> under another name, so the set counts its probes
+struct CountedHash : std::hash<uint64_t>
+{
+};
+namespace custom
+{
+   template <>
+   struct instrument_hash<uint64_t, CountedHash> : std::true_type
+   {
+   };
+}
+
+/**********************************************************************
+ * MEASURE STATS
+ * Fill a set with the keys and look each one up, then print the
+ * health report and what the lookups cost
+ ***********************************************************************/
+template <class Hash, class Key>
+void measureStats(const char * name, const std::vector<Key>& keys)
+{
+   custom::unordered_set<Key, Hash> s;
+   for (auto& key : keys)
+      s.insert(key);
+
+   size_t found = 0;
+   Timer t;
+   for (auto& key : keys)
+      found += (s.find(key) != s.end());
+   double nsFind = t.elapsed() / keys.size();
+   sink = found;
+
+   custom::hash_stats stats = s.stats();
+   std::cout << std::setw(12) << keys.size()
+             << std::setw(22) << name
+             << std::setw(10) << stats.maxChain
+             << std::setw(10) << stats.meanChain
+             << std::setw(10) << stats.emptyRatio * 100.0
+             << std::setw(12) << stats.comparesPerFind()
+             << std::setw(12) << nsFind << "\n";
+}
+
+/**********************************************************************
+ * BENCH STATS
+ * The health report for random keys and for keys that are all
+ * multiples of 1024, which the identity std::hash<uint64_t> puts in
+ * the same few buckets, and the cost of counting the probes
+ ***********************************************************************/
+void benchStats(size_t maxKeys)
+{
+   std::cout << "stats: chain health, plain and instrumented\n"
+             << std::setw(12) << "keys" << std::setw(22) << "set"
+             << std::setw(10) << "max" << std::setw(10) << "mean"
+             << std::setw(10) << "empty %" << std::setw(12) << "cmp/find"
+             << std::setw(12) << "find ns" << "\n";
+   for (size_t num = 10000; num <= maxKeys; num *= 10)
+   {
+      std::vector<uint64_t> random = randomKeys(num, 1);
+      measureStats<std::hash<uint64_t>>("random", random);
+      measureStats<CountedHash>("random, counted", random);
+
+      // the chains grow with the keys, so the fill is quadratic
+      if (num > 100000)
+         continue;
+      std::vector<uint64_t> strided(num);
+      for (size_t i = 0; i < num; i++)
+         strided[i] = (uint64_t)i << 10;
+      measureStats<std::hash<uint64_t>>("strided", strided);
+      measureStats<CountedHash>("strided, counted", strided);
+   }
+   std::cout << std::endl;
+}
+
+/**********************************************************************
+ * BENCH HASH FUNCTION
+ * std::hash against the seeded custom::hash on key patterns that
+ * defeat the identity: sequential, strided by 1024, only the high bits
+ * set, and random; then numbered strings. std::hash puts every
+ * high-bit key in one chain and a strided key in one of 1024, so the
+ * fill is quadratic and those runs stop at 10K and 100K keys.
+ ***********************************************************************/
+void benchHashFunction(size_t maxKeys)
+{
+   std::cout << "hash function: chain health by key pattern\n"
+             << std::setw(12) << "keys" << std::setw(22) << "keys, hash"
+             << std::setw(10) << "max" << std::setw(10) << "mean"
+             << std::setw(10) << "empty %" << std::setw(12) << "cmp/find"
+             << std::setw(12) << "find ns" << "\n";
+   for (size_t num = 10000; num <= maxKeys; num *= 10)
+   {
+      std::vector<uint64_t> sequential(num);
+      std::vector<uint64_t> strided(num);
+      std::vector<uint64_t> high(num);
+      for (size_t i = 0; i < num; i++)
+      {
+         sequential[i] = i;
+         strided[i] = (uint64_t)i << 10;
+         high[i] = (uint64_t)i << 40;
+      }
+      std::vector<uint64_t> random = randomKeys(num, 1);
+
+      measureStats<std::hash<uint64_t>>("sequential, std", sequential);
+      measureStats<custom::hash<uint64_t>>("sequential, custom", sequential);
+      if (num <= 100000)
+         measureStats<std::hash<uint64_t>>("strided, std", strided);
+      if (num <= 10000)
+         measureStats<std::hash<uint64_t>>("high bits, std", high);
+      measureStats<custom::hash<uint64_t>>("strided, custom", strided);
+      measureStats<custom::hash<uint64_t>>("high bits, custom", high);
+      measureStats<std::hash<uint64_t>>("random, std", random);
+      measureStats<custom::hash<uint64_t>>("random, custom", random);
+
+      std::vector<std::string> names(num);
+      for (size_t i = 0; i < num; i++)
+         names[i] = "customer-" + std::to_string(i);
+      measureStats<std::hash<std::string>>("strings, std", names);
+      measureStats<custom::hash<std::string>>("strings, custom", names);
+   }
+   std::cout << std::endl;
+}
+
+/**********************************************************************
+ * BENCH BLOOM
+ * Lookups where a share of the keys miss, with no filter and with
+ * filters of several sizes. Reports nanoseconds per find and the
+ * share of the misses the filter let through.
+ ***********************************************************************/
+void benchBloom(size_t maxKeys)
+{
+   std::cout << "bloom: find ns by miss ratio, filter bits per key (false positive %)\n"
+             << std::setw(12) << "keys" << std::setw(10) << "miss %";
+   const size_t bits[] = { 0, 4, 8, 12 };
+   for (size_t b : bits)
+      std::cout << std::setw(10) << b << std::setw(8) << "fp %";
+   std::cout << "\n";
+
+   const size_t missPercents[] = { 0, 50, 90, 99 };
+   for (size_t num = 10000; num <= maxKeys; num *= 10)
+   {
+      std::vector<uint64_t> keys = randomKeys(num, 1);
+      std::vector<uint64_t> misses = randomKeys(num, 2);
+      for (size_t missPercent : missPercents)
+      {
+         // the same queries for every filter: num lookups, missPercent% missing
+         std::vector<uint64_t> queries(num);
+         for (size_t i = 0; i < num; i++)
+            queries[i] = (i % 100 < missPercent) ? misses[i] : keys[i];
+
+         std::cout << std::setw(12) << num << std::setw(10) << missPercent;
+         for (size_t b : bits)
+         {
+            custom::unordered_set<uint64_t> s;
+            s.bloom_filter(b);
+            for (auto key : keys)
+               s.insert(key);
+            custom::hash_stats before = s.stats();
+
+            size_t found = 0;
+            Timer t;
+            for (auto key : queries)
+               found += (s.find(key) != s.end());
+            double ns = t.elapsed() / num;
+            sink = found;
+
+            custom::hash_stats after = s.stats();
+            size_t numPassed = after.bloomFalsePositives - before.bloomFalsePositives;
+            size_t numMisses = numPassed + after.bloomRejected - before.bloomRejected;
+            std::cout << std::setw(10) << ns << std::setw(8)
+                      << (numMisses ? 100.0 * numPassed / numMisses : 0.0);
+         }
+         std::cout << "\n";
+      }
+   }
+   std::cout << std::endl;
+}
+
+/**********************************************************************
+ * BENCH SNAPSHOT
+ * A warm start: inserting every key again against mapping a snapshot
+ * saved from the set, then the cost of a find in each
+ ***********************************************************************/
+void benchSnapshot(size_t maxKeys)
+{
+   const char * path = "benchHash.snapshot";
+   std::cout << "snapshot: rebuild against save and map (ms, find in ns)\n"
+             << std::setw(12) << "keys" << std::setw(12) << "insert"
+             << std::setw(12) << "save" << std::setw(12) << "map"
+             << std::setw(12) << "first find" << std::setw(12) << "find set"
+             << std::setw(12) << "find map" << "\n";
+   for (size_t num = 10000; num <= maxKeys; num *= 10)
+   {
+      std::vector<uint64_t> keys = randomKeys(num, 1);
+
+      Timer tInsert;
+      custom::unordered_set<uint64_t> s;
+      for (auto key : keys)
+         s.insert(key);
+      double msInsert = tInsert.elapsed() / 1000000.0;
+
+      Timer tSave;
+      s.save(path);
+      double msSave = tSave.elapsed() / 1000000.0;
+
+      Timer tMap;
+      auto ms = custom::unordered_set<uint64_t>::load_mapped(path);
+      double msMap = tMap.elapsed() / 1000000.0;
+
+      // the first pass over the mapping pays for its page faults
+      size_t found = 0;
+      Timer tFirst;
+      for (auto key : keys)
+         found += ms.count(key);
+      double nsFirst = tFirst.elapsed() / num;
+
+      Timer tSet;
+      for (auto key : keys)
+         found += (s.find(key) != s.end());
+      double nsSet = tSet.elapsed() / num;
+
+      Timer tFind;
+      for (auto key : keys)
+         found += ms.count(key);
+      double nsMap = tFind.elapsed() / num;
+      sink = found;
+
+      std::cout << std::setw(12) << num
+                << std::setw(12) << msInsert
+                << std::setw(12) << msSave
+                << std::setw(12) << msMap
+                << std::setw(12) << nsFirst
+                << std::setw(12) << nsSet
+                << std::setw(12) << nsMap << "\n";
+   }
+   std::remove(path);
+   std::cout << std::endl;
+}
+
+/**********************************************************************
+ * MEASURE LATENCY
+ * Time every insert on its own and report the percentiles of the
+ * distribution, so the stalls of a rehash show in the tail
+ ***********************************************************************/
+template <class Set>
+void measureLatency(const char * name, Set& s, const std::vector<uint64_t>& keys)
+{
+   std::vector<double> ns(keys.size());
+   for (size_t i = 0; i < keys.size(); i++)
+   {
+      Timer t;
+      s.insert(keys[i]);
+      ns[i] = t.elapsed();
+   }
+   std::sort(ns.begin(), ns.end());
+   auto percentile = [&ns](double p) { return ns[(size_t)(p * (ns.size() - 1))]; };
+
+   std::cout << std::setw(12) << keys.size()
+             << std::setw(22) << name
+             << std::setw(12) << percentile(0.50)
+             << std::setw(12) << percentile(0.99)
+             << std::setw(12) << percentile(0.999)
+             << std::setw(12) << percentile(0.9999)
+             << std::setw(14) << ns.back() << "\n";
+}
+
+/**********************************************************************
+ * BENCH LATENCY
+ * Insert tail latency with rehash all at once against the
+ * incremental migration
+ ***********************************************************************/
+void benchLatency(size_t maxKeys)
+{
+   std::cout << "latency: insert percentiles, eager vs incremental rehash (ns)\n"
+             << std::setw(12) << "keys" << std::setw(22) << "rehash"
+             << std::setw(12) << "p50" << std::setw(12) << "p99"
+             << std::setw(12) << "p99.9" << std::setw(12) << "p99.99"
+             << std::setw(14) << "max" << "\n";
+   for (size_t num = 1000; num <= maxKeys; num *= 10)
+   {
+      std::vector<uint64_t> keys = randomKeys(num, 1);
+      custom::unordered_set<uint64_t> eager;
+      custom::unordered_set<uint64_t> incremental;
+      incremental.incremental_rehash(true);
+      measureLatency("eager",       eager,       keys);
+      measureLatency("incremental", incremental, keys);
+   }
+   std::cout << std::endl;
+}
+
+/**********************************************************************
+ * LOCKED SET
+ * The unordered_set behind one global mutex: what we do today
+ ***********************************************************************/
+class LockedSet
+{
+public:
+   bool insert(uint64_t key)
+   {
+      std::lock_guard<std::mutex> lock(mutex);
+      return s.insert(key).second;
+   }
+   bool contains(uint64_t key)
+   {
+      std::lock_guard<std::mutex> lock(mutex);
+      return s.find(key) != s.end();
+   }
+   size_t erase(uint64_t key)
+   {
+      std::lock_guard<std::mutex> lock(mutex);
+      size_t numBefore = s.size();
+      s.erase(key);
+      return numBefore - s.size();
+   }
+private:
+   std::mutex mutex;
+   custom::unordered_set<uint64_t> s;
+};
+
+/**********************************************************************
+ * MEASURE THREADS
+ * numThreads threads each run numOps operations on one shared set:
+ * one insert in every ten, the rest lookups. Report millions of
+ * operations per second across all the threads.
+ ***********************************************************************/
+template <class Set>
+void measureThreads(const char * name, size_t numThreads, size_t numOps,
+                    const std::vector<uint64_t>& keys)
+{
+   Set s;
+   for (size_t i = 0; i < keys.size() / 2; i++)
+      s.insert(keys[i]);
+
+   std::vector<std::thread> threads;
+   Timer t;
+   for (size_t iThread = 0; iThread < numThreads; iThread++)
+      threads.emplace_back([&s, &keys, iThread, numOps]()
+      {
+         size_t found = 0;
+         for (size_t i = 0; i < numOps; i++)
+         {
+            uint64_t key = keys[(iThread * 7919 + i * 31) % keys.size()];
+            if (i % 10 == 0)
+               s.insert(key);
+            else
+               found += s.contains(key);
+         }
+         sink = found;
+      });
+   for (auto& thread : threads)
+      thread.join();
+   double mops = (double)(numThreads * numOps) / t.elapsed() * 1000.0;
+
+   std::cout << std::setw(12) << numThreads
+             << std::setw(22) << name
+             << std::setw(12) << mops << "\n";
+}
+
+/**********************************************************************
+ * BENCH CONCURRENT
+ * Mixed read/write throughput from one thread up to every hardware
+ * thread: one global mutex against the striped locks
+ ***********************************************************************/
+void benchConcurrent(size_t maxKeys)
+{
+   size_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+   std::vector<uint64_t> keys = randomKeys(maxKeys, 1);
+   size_t numOps = 1000000;
+   std::cout << "concurrent: 90% find, 10% insert (Mops/s)\n"
+             << std::setw(12) << "threads" << std::setw(22) << "container"
+             << std::setw(12) << "throughput" << "\n";
+   for (size_t numThreads = 1; ; numThreads = std::min(numThreads * 2, maxThreads))
+   {
+      measureThreads<LockedSet>                                 ("global mutex", numThreads, numOps, keys);
+      measureThreads<custom::concurrent_unordered_set<uint64_t>>("striped",      numThreads, numOps, keys);
+      measureThreads<custom::sharded_unordered_set<uint64_t>>   ("sharded",      numThreads, numOps, keys);
+      if (numThreads == maxThreads)
+         break;
+   }
+   std::cout << std::endl;
+}
+
+/**********************************************************************
+ * MEASURE INSERT THREADS
+ * numThreads threads fill one empty set, each with its own share of
+ * the keys, so the set grows all the way. Millions of inserts a second.
+ ***********************************************************************/
+template <class Set>
+void measureInsertThreads(const char * name, size_t numThreads,
+                          const std::vector<uint64_t>& keys)
+{
+   Set s;
+   std::vector<std::thread> threads;
+   Timer t;
+   for (size_t iThread = 0; iThread < numThreads; iThread++)
+      threads.emplace_back([&s, &keys, iThread, numThreads]()
+      {
+         for (size_t i = iThread; i < keys.size(); i += numThreads)
+            s.insert(keys[i]);
+      });
+   for (auto& thread : threads)
+      thread.join();
+   double mops = (double)keys.size() / t.elapsed() * 1000.0;
+
+   std::cout << std::setw(12) << numThreads
+             << std::setw(22) << name
+             << std::setw(12) << mops << "\n";
+}
+
+/**********************************************************************
+ * BENCH SHARDED
+ * Insert throughput from an empty set, from one thread up to every
+ * hardware thread. Growth stops every thread of the global mutex and
+ * the striped set, but only the threads in one shard of the sharded.
+ ***********************************************************************/
+void benchSharded(size_t maxKeys)
+{
+   size_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+   std::vector<uint64_t> keys = randomKeys(maxKeys, 1);
+   std::cout << "sharded: " << maxKeys << " inserts into an empty set (Mops/s)\n"
+             << std::setw(12) << "threads" << std::setw(22) << "container"
+             << std::setw(12) << "throughput" << "\n";
+   for (size_t numThreads = 1; ; numThreads = std::min(numThreads * 2, maxThreads))
+   {
+      measureInsertThreads<LockedSet>                                 ("global mutex", numThreads, keys);
+      measureInsertThreads<custom::concurrent_unordered_set<uint64_t>>("striped",      numThreads, keys);
+      measureInsertThreads<custom::sharded_unordered_set<uint64_t>>   ("sharded",      numThreads, keys);
+      if (numThreads == maxThreads)
+         break;
+   }
+   std::cout << std::endl;
+}
+
+/**********************************************************************
+ * BENCH NODE
+ * Moving every key from one set to another: a new node and a copy of
+ * the string for each, against extract and insert of the node itself,
+ * then merge of the whole set
+ ***********************************************************************/
+void benchNode(size_t maxKeys)
+{
+   std::cout << "node: move every key to another set (ns per key)\n"
+             << std::setw(12) << "keys" << std::setw(14) << "copy+erase"
+             << std::setw(14) << "extract" << std::setw(14) << "merge" << "\n";
+   for (size_t num = 10000; num <= maxKeys; num *= 10)
+   {
+      // longer than the small string buffer, so a copy allocates too
+      std::vector<std::string> keys;
+      for (uint64_t key : randomKeys(num, 1))
+         keys.push_back("a key long enough to leave the buffer " + std::to_string(key));
+
+      custom::unordered_set<std::string> src1;
+      custom::unordered_set<std::string> src2;
+      custom::unordered_set<std::string> src3;
+      for (auto& key : keys)
+      {
+         src1.insert(key);
+         src2.insert(key);
+         src3.insert(key);
+      }
+      custom::unordered_set<std::string> dest1;
+      custom::unordered_set<std::string> dest2;
+      custom::unordered_set<std::string> dest3;
+
+      Timer tCopy;
+      for (auto& key : keys)
+      {
+         auto it = src1.find(key);
+         dest1.insert(*it);
+         src1.erase(key);
+      }
+      double nsCopy = tCopy.elapsed() / num;
+
+      Timer tExtract;
+      for (auto& key : keys)
+         dest2.insert(src2.extract(key));
+      double nsExtract = tExtract.elapsed() / num;
+
+      Timer tMerge;
+      dest3.merge(src3);
+      double nsMerge = tMerge.elapsed() / num;
+      sink = dest1.size() + dest2.size() + dest3.size();
+
+      std::cout << std::setw(12) << num << std::setw(14) << nsCopy
+                << std::setw(14) << nsExtract << std::setw(14) << nsMerge << "\n";
+   }
+   std::cout << std::endl;
+}
+
+/**********************************************************************
+ * BENCH SHRINK
+ * A burst of keys drained back to 1000: the bucket memory left behind
+ * without a min_load_factor and with one, and how long the erases took
+ ***********************************************************************/
+void benchShrink(size_t maxKeys)
+{
+   typedef custom::unordered_set<uint64_t> Set;
+   const size_t numKept = 1000;
+   std::cout << "shrink: drain a burst to " << numKept << " keys (bucket KB, erase ns per key)\n"
+             << std::setw(12) << "keys" << std::setw(12) << "kept KB" << std::setw(10) << "erase"
+             << std::setw(12) << "min 0.1 KB" << std::setw(10) << "erase" << "\n";
+   for (size_t num = 10000; num <= maxKeys; num *= 10)
+   {
+      std::vector<uint64_t> keys = randomKeys(num, 1);
+      std::cout << std::setw(12) << num;
+      for (float minLoad : { 0.0f, 0.1f })
+      {
+         Set s;
+         s.min_load_factor(minLoad);
+         for (auto key : keys)
+            s.insert(key);
+
+         Timer t;
+         for (size_t i = numKept; i < num; i++)
+            s.erase(keys[i]);
+         double ns = t.elapsed() / (num - numKept);
+         sink = s.size();
+
+         // each bucket is a whole list object, empty or not
+         std::cout << std::setw(12) << s.bucket_count() * sizeof(custom::list<uint64_t>) / 1024
+                   << std::setw(10) << ns;
+      }
+      std::cout << "\n";
+   }
+   std::cout << std::endl;
+}
+
+/**********************************************************************
+ * BENCH SMALL
+ * Many short-lived tiny sets: build one of n keys, look each up
+ * twice, and let it go. The inline set never reaches the heap.
+ ***********************************************************************/
+template <class Set>
+double buildTiny(size_t numKeys, size_t numSets)
+{
+   size_t found = 0;
+   Timer t;
+   for (size_t iSet = 0; iSet < numSets; iSet++)
+   {
+      Set s;
+      for (size_t i = 0; i < numKeys; i++)
+         s.insert((uint64_t)(iSet + i * 7));
+      for (size_t i = 0; i < numKeys * 2; i++)
+         found += (s.find((uint64_t)(iSet + i * 7)) != s.end());
+   }
+   sink = found;
+   return t.elapsed() / numSets;
+}
+
+void benchSmall(size_t maxKeys)
+{
+   const size_t numSets = std::max((size_t)10000, maxKeys / 10);
+   std::cout << "small: build and probe one set of n keys (ns per set)\n"
+             << std::setw(12) << "keys" << std::setw(16) << "unordered_set"
+             << std::setw(16) << "small<8>" << "\n";
+   for (size_t numKeys : { 1, 2, 4, 8, 16 })
+   {
+      std::cout << std::setw(12) << numKeys
+                << std::setw(16) << buildTiny<custom::unordered_set<uint64_t>>(numKeys, numSets)
+                << std::setw(16) << buildTiny<custom::small_unordered_set<uint64_t, 8>>(numKeys, numSets)
+                << "\n";
+   }
+   std::cout << std::endl;
+}
+
+/**********************************************************************
+ * MEASURE READ THREADS
+ * numReaders threads each run numOps lookups on one shared set while
+ * one more thread inserts a key and erases it again, a little under
+ * a thousand times a second. Millions of lookups a second across the
+ * readers, and how many writes landed meanwhile.
+ ***********************************************************************/
+template <class Set>
+void measureReadThreads(const char * name, size_t numReaders, size_t numOps,
+                        const std::vector<uint64_t>& keys)
+{
+   Set s;
+   for (size_t i = 0; i < keys.size() / 2; i++)
+      s.insert(keys[i]);
+
+   std::atomic<bool> done(false);
+   size_t numWrites = 0;
+   std::thread writer([&s, &keys, &done, &numWrites]()
+   {
+      for (size_t i = keys.size() / 2; !done.load(); i++)
+      {
+         uint64_t key = keys[keys.size() / 2 + i % (keys.size() / 2)];
+         s.insert(key);
+         s.erase(key);
+         numWrites += 2;
+         std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+   });
+
+   std::vector<std::thread> readers;
+   Timer t;
+   for (size_t iThread = 0; iThread < numReaders; iThread++)
+      readers.emplace_back([&s, &keys, iThread, numOps]()
+      {
+         size_t found = 0;
+         for (size_t i = 0; i < numOps; i++)
+            found += s.contains(keys[(iThread * 7919 + i * 31) % keys.size()]);
+         sink = found;
+      });
+   for (auto& reader : readers)
+      reader.join();
+   double mops = (double)(numReaders * numOps) / t.elapsed() * 1000.0;
+   done = true;
+   writer.join();
+
+   std::cout << std::setw(12) << numReaders
+             << std::setw(22) << name
+             << std::setw(12) << mops
+             << std::setw(10) << numWrites << "\n";
+}
+
+/**********************************************************************
+ * BENCH EPOCH
+ * Read throughput while a writer changes the set now and then, from
+ * one reader up to every hardware thread. Every lookup of the mutex,
+ * striped and sharded sets writes a lock word other readers share;
+ * the epoch set's readers write only a slot of their own.
+ ***********************************************************************/
+void benchEpoch(size_t maxKeys)
+{
+   size_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+   std::vector<uint64_t> keys = randomKeys(std::max((size_t)2, maxKeys), 1);
+   size_t numOps = 2000000;
+   std::cout << "epoch: lookups beside one slow writer (Mops/s)\n"
+             << std::setw(12) << "readers" << std::setw(22) << "container"
+             << std::setw(12) << "throughput" << std::setw(10) << "writes" << "\n";
+   for (size_t numThreads = 1; ; numThreads = std::min(numThreads * 2, maxThreads))
+   {
+      measureReadThreads<LockedSet>                                 ("global mutex", numThreads, numOps, keys);
+      measureReadThreads<custom::concurrent_unordered_set<uint64_t>>("striped",      numThreads, numOps, keys);
+      measureReadThreads<custom::sharded_unordered_set<uint64_t>>   ("sharded",      numThreads, numOps, keys);
+      measureReadThreads<custom::epoch_unordered_set<uint64_t>>     ("epoch",        numThreads, numOps, keys);
+      if (numThreads == maxThreads)
+         break;
+   }
+   std::cout << std::endl;
+}
+
+/**********************************************************************
+ * BENCH FROZEN
+ * A set built once, then only read: the time to freeze it on one
+ * thread and on every hardware thread, the bytes per key of each
+ * layout, and a find in each
+ ***********************************************************************/
+void benchFrozen(size_t maxKeys)
+{
+   std::cout << "frozen: chained against frozen (freeze ms, bytes per key, find ns)\n"
+             << std::setw(12) << "keys" << std::setw(12) << "freeze"
+             << std::setw(12) << "threads" << std::setw(12) << "set B/key"
+             << std::setw(14) << "frozen B/key" << std::setw(12) << "find set"
+             << std::setw(14) << "find frozen" << "\n";
+   for (size_t num = 10000; num <= maxKeys; num *= 10)
+   {
+      std::vector<uint64_t> keys = randomKeys(num, 1);
+      custom::unordered_set<uint64_t> s;
+      for (auto key : keys)
+         s.insert(key);
+
+      Timer tFreeze;
+      custom::frozen_set<uint64_t> fs = s.freeze();
+      double msFreeze = tFreeze.elapsed() / 1000000.0;
+
+      Timer tThreads;
+      custom::frozen_set<uint64_t> fsThreads = s.freeze(custom::thread_executor());
+      double msThreads = tThreads.elapsed() / 1000000.0;
+
+      // a bucket is a whole list object, a node the key and two links
+      double bytesSet = (double)(s.bucket_count() * sizeof(custom::list<uint64_t>) +
+                                 s.size() * (sizeof(uint64_t) + 2 * sizeof(void *))) / num;
+      double bytesFrozen = (double)fs.num_bytes() / num;
+
+      // probed out of insertion order, so the nodes are not met in the order
+      // they were allocated
+      std::vector<uint64_t> probes(keys);
+      std::shuffle(probes.begin(), probes.end(), std::mt19937_64(2));
+
+      size_t found = 0;
+      Timer tSet;
+      for (auto key : probes)
+         found += (s.find(key) != s.end());
+      double nsSet = tSet.elapsed() / num;
+
+      Timer tFrozen;
+      for (auto key : probes)
+         found += fs.count(key);
+      double nsFrozen = tFrozen.elapsed() / num;
+      sink = found + fsThreads.size();
+
+      std::cout << std::setw(12) << num
+                << std::setw(12) << msFreeze
+                << std::setw(12) << msThreads
+                << std::setw(12) << bytesSet
+                << std::setw(14) << bytesFrozen
+                << std::setw(12) << nsSet
+                << std::setw(14) << nsFrozen << "\n";
+   }
+   std::cout << std::endl;
+}
+
+/**********************************************************************
+ * BENCH CONSTEXPR
+ * A fixed keyword table: what building it at startup costs against
+ * the set the compiler built, then a lookup of a word in each
+ ***********************************************************************/
+static constexpr const char * KEYWORDS[] =
+{
+   "alignas", "alignof", "auto", "bool", "break", "case", "catch", "char",
+   "class", "const", "constexpr", "continue", "default", "delete", "do", "double",
+   "else", "enum", "explicit", "extern", "false", "float", "for", "friend",
+   "goto", "if", "inline", "int", "long", "mutable", "namespace", "new",
+};
+static constexpr auto KEYWORD_SET = custom::make_constexpr_unordered_set(KEYWORDS);
+
+void benchConstexpr(size_t maxKeys)
+{
+   const size_t numBuilds = 10000;
+   const size_t numFinds = std::max((size_t)1000000, maxKeys);
+
+   Timer tBuild;
+   size_t built = 0;
+   for (size_t i = 0; i < numBuilds; i++)
+   {
+      custom::unordered_set<std::string> s;
+      for (auto word : KEYWORDS)
+         s.insert(word);
+      built += s.size();
+   }
+   double nsBuild = tBuild.elapsed() / numBuilds;
+
+   custom::unordered_set<std::string> s;
+   for (auto word : KEYWORDS)
+      s.insert(word);
+
+   // every keyword, and as many words that are not
+   std::vector<std::string> words;
+   for (auto word : KEYWORDS)
+   {
+      words.push_back(word);
+      words.push_back(std::string(word) + "_");
+   }
+
+   size_t found = built;
+   Timer tSet;
+   for (size_t i = 0; i < numFinds; i++)
+      found += (s.find(words[i % words.size()]) != s.end());
+   double nsSet = tSet.elapsed() / numFinds;
+
+   Timer tConstexpr;
+   for (size_t i = 0; i < numFinds; i++)
+      found += KEYWORD_SET.count(words[i % words.size()].c_str());
+   double nsConstexpr = tConstexpr.elapsed() / numFinds;
+   sink = found;
+
+   std::cout << "constexpr: " << KEYWORD_SET.size() << " keywords (startup ns, find ns)\n"
+             << std::setw(22) << "container" << std::setw(12) << "startup"
+             << std::setw(12) << "find" << "\n"
+             << std::setw(22) << "unordered_set" << std::setw(12) << nsBuild
+             << std::setw(12) << nsSet << "\n"
+             << std::setw(22) << "constexpr" << std::setw(12) << 0.0
+             << std::setw(12) << nsConstexpr << "\n"
+             << std::endl;
+}
+
+/**********************************************************************
+ * MEASURE FILLED
+ * Insert the keys into a set already sized, then find every key in
+ * shuffled order, then keys that are not there: ns per operation
+ ***********************************************************************/
+template <class Set>
+void measureFilled(Set& s, const std::vector<uint64_t>& keys,
+                   const std::vector<uint64_t>& misses,
+                   double& nsInsert, double& nsHit, double& nsMiss)
+{
+   Timer tInsert;
+   for (auto key : keys)
+      s.insert(key);
+   nsInsert = tInsert.elapsed() / keys.size();
+
+   std::vector<uint64_t> probes(keys);
+   std::shuffle(probes.begin(), probes.end(), std::mt19937_64(2));
+
+   size_t found = 0;
+   Timer tHit;
+   for (auto key : probes)
+      found += (s.find(key) != s.end());
+   nsHit = tHit.elapsed() / probes.size();
+
+   Timer tMiss;
+   for (auto key : misses)
+      found += (s.find(key) != s.end());
+   nsMiss = tMiss.elapsed() / misses.size();
+   sink = found;
+}
+
+/**********************************************************************
+ * BENCH CUCKOO
+ * The chained set and the cuckoo set given the same bytes: the chained
+ * set holds num keys, the cuckoo set as many buckets as fit in what
+ * those cost, filled to 95%. Reported are the keys each holds, the
+ * bytes per key and the ns per insert, find hit and find miss
+ ***********************************************************************/
+void benchCuckoo(size_t maxKeys)
+{
+   std::cout << "cuckoo: chained vs cuckoo at equal memory (ns/op)\n"
+             << std::setw(12) << "budget KB" << std::setw(16) << "container"
+             << std::setw(12) << "keys" << std::setw(10) << "B/key"
+             << std::setw(10) << "insert" << std::setw(10) << "find hit"
+             << std::setw(11) << "find miss" << "\n";
+   for (size_t num = 10000; num <= maxKeys; num *= 10)
+   {
+      std::vector<uint64_t> keys   = randomKeys(num, 1);
+      std::vector<uint64_t> misses = randomKeys(num, 2);
+      custom::unordered_set<uint64_t> s;
+      double nsInsert, nsHit, nsMiss;
+      measureFilled(s, keys, misses, nsInsert, nsHit, nsMiss);
+
+      // a bucket is a whole list object, a node the key and two links
+      size_t budget = s.bucket_count() * sizeof(custom::list<uint64_t>) +
+                      s.size() * (sizeof(uint64_t) + 2 * sizeof(void *));
+      std::cout << std::setw(12) << budget / 1024 << std::setw(16) << "unordered_set"
+                << std::setw(12) << s.size() << std::setw(10) << (double)budget / s.size()
+                << std::setw(10) << nsInsert << std::setw(10) << nsHit
+                << std::setw(11) << nsMiss << "\n";
+
+      // the same bytes of buckets, filled without growing
+      typedef custom::cuckoo_unordered_set<uint64_t> Cuckoo;
+      Cuckoo cs(budget / Cuckoo::bucket_bytes());
+      std::vector<uint64_t> keysCuckoo = randomKeys(cs.bucket_count() * Cuckoo::SLOTS * 19 / 20, 1);
+      measureFilled(cs, keysCuckoo, misses, nsInsert, nsHit, nsMiss);
+      std::cout << std::setw(12) << cs.num_bytes() / 1024 << std::setw(16) << "cuckoo"
+                << std::setw(12) << cs.size() << std::setw(10) << (double)cs.num_bytes() / cs.size()
+                << std::setw(10) << nsInsert << std::setw(10) << nsHit
+                << std::setw(11) << nsMiss << "\n";
+   }
+   std::cout << std::endl;
+}
+
+/**********************************************************************
+ * MAIN
+ * Run one benchmark by name, or all of them
+ ***********************************************************************/
+int main(int argc, char ** argv)
+{
+   std::string which = (argc > 1) ? argv[1] : "all";
+   size_t maxKeys = (argc > 2) ? (size_t)std::strtoull(argv[2], nullptr, 10) : 1000000;
+
+   std::cout.setf(std::ios::fixed);
+   std::cout.precision(1);
+
+   if (which == "all" || which == "flat")
+      benchFlat(maxKeys);
+   if (which == "all" || which == "pool")
+      benchPool(maxKeys);
+   if (which == "all" || which == "index")
+      benchIndex(maxKeys);
+   if (which == "all" || which == "cache")
+      benchCache(maxKeys);
+   if (which == "all" || which == "latency")
+      benchLatency(maxKeys);
+   if (which == "all" || which == "concurrent")
+      benchConcurrent(maxKeys);
+   if (which == "all" || which == "transparent")
+      benchTransparent(maxKeys);
+   if (which == "all" || which == "batch")
+      benchBatch(maxKeys);
+   if (which == "all" || which == "bulk")
+      benchBulk(maxKeys);
+   if (which == "all" || which == "rehash")
+      benchRehash(maxKeys);
+   if (which == "all" || which == "stats")
+      benchStats(maxKeys);
+   if (which == "all" || which == "function")
+      benchHashFunction(maxKeys);
+   if (which == "all" || which == "snapshot")
+      benchSnapshot(maxKeys);
+   if (which == "all" || which == "bloom")
+      benchBloom(maxKeys);
+   if (which == "all" || which == "node")
+      benchNode(maxKeys);
+   if (which == "all" || which == "shrink")
+      benchShrink(maxKeys);
+   if (which == "all" || which == "small")
+      benchSmall(maxKeys);
+   if (which == "all" || which == "sharded")
+      benchSharded(maxKeys);
+   if (which == "all" || which == "epoch")
+      benchEpoch(maxKeys);
+   if (which == "all" || which == "frozen")
+      benchFrozen(maxKeys);
+   if (which == "all" || which == "constexpr")
+      benchConstexpr(maxKeys);
+   if (which == "all" || which == "cuckoo")
+      benchCuckoo(maxKeys);
+
+   return 0;
+}
@@ -0,0 +1,167 @@
+/***********************************************************************
+ * Header:
+ *    BLOOM FILTER
+ * Summary:
+ *    A blocked Bloom filter for custom::unordered_set to turn away a
+ *    find that will miss before it touches a bucket. Every key sets
+ *    its bits in one 512 bit block, a cache line, so a query reads one
+ *    line however many bits it checks. No false negatives: a key the
+ *    filter turns away is not in the set. Bits are never cleared, so a
+ *    key erased still passes until the filter is rebuilt.
+ *
+ *    This will contain the class definition of:
+ *        blocked_bloom_filter : the bits and how often they were right
+ * Author
+ *       Marco Varela &  Andre Regino
+ ************************************************************************/
+
+#pragma once
+
+#include "hashPolicy.h" // for mix64, mulhi64 and prefetch
+#include <cstddef>      // for size_t
+#include <cstdint>      // for uint64_t
+#include <vector>       // for std::vector of bits
+
+class TestBloomFilter;  // forward declaration for BloomFilter unit tests
+
+namespace custom
+{
+
+/************************************************
+ * BLOCKED BLOOM FILTER
+ * Off until configure() gives it bits per key. The
+ * counts of queries turned away and of queries let
+ * through that missed anyway survive a rebuild.
+ ************************************************/
+class blocked_bloom_filter
+{
+   friend class ::TestBloomFilter;   // give unit tests access to the privates
+public:
+   static const size_t BLOCK_WORDS = 8;     // 512 bits, one cache line
+   static const size_t BLOCK_BYTES = BLOCK_WORDS * sizeof(uint64_t);
+   static const size_t MAX_HASHES = 7;      // 9 bits each from one mixed hash
+
+   blocked_bloom_filter() : bitsPerKey(0), numHashes(0), numBlocks(0),
+                            numRejected(0), numFalsePositives(0), numStale(0)
+   {
+   }
+
+   // room for numKeys at bitsPerKey each, every bit clear. 0 turns it off
+   void configure(size_t bitsPerKey, size_t numKeys);
+
+   // zero every bit, keeping the size
+   void clear()
+   {
+      for (auto& word : words)
+         word = 0;
+      numStale = 0;
+   }
+
+   // record a key, by its hash
+   void add(size_t hash)
+   {
+      uint64_t h = mix64(hash);
+      uint64_t * block = blockAt(blockOf(h));
+      uint64_t g = mix64(h ^ 0x9e3779b97f4a7c15ULL);
+      for (size_t i = 0; i < numHashes; i++, g >>= 9)
+         block[(g >> 6) & 7] |= (uint64_t)1 << (g & 63);
+   }
+
+   // might a key with this hash be in the set? Never false for one that is
+   bool may_contain(size_t hash) const
+   {
+      uint64_t h = mix64(hash);
+      const uint64_t * block = blockAt(blockOf(h));
+      uint64_t g = mix64(h ^ 0x9e3779b97f4a7c15ULL);
+      for (size_t i = 0; i < numHashes; i++, g >>= 9)
+         if (!(block[(g >> 6) & 7] & ((uint64_t)1 << (g & 63))))
+            return false;
+      return true;
+   }
+
+   // may_contain, counting the keys turned away
+   bool admits(size_t hash)
+   {
+      if (may_contain(hash))
+         return true;
+      numRejected++;
+      return false;
+   }
+
+   // start loading the block a query for this hash will read
+   void prefetch(size_t hash) const
+   {
+      custom::prefetch(blockAt(blockOf(mix64(hash))));
+   }
+
+   // a key that was let through was not there after all
+   void missed()         { numFalsePositives++; }
+   // a key was erased, but its bits stay set
+   void erased()         { numStale++;          }
+
+   bool active() const                  { return bitsPerKey != 0;                   }
+   size_t bits_per_key() const          { return bitsPerKey;                        }
+   size_t num_hashes() const            { return numHashes;                         }
+   size_t num_bytes() const             { return numBlocks * BLOCK_BYTES;           }
+   size_t num_stale() const             { return numStale;                          }
+   size_t num_rejected() const          { return numRejected;                       }
+   size_t num_false_positives() const   { return numFalsePositives;                 }
+
+private:
+   // the high bits of the mixed hash choose the block
+   size_t blockOf(uint64_t h) const
+   {
+      return (size_t)mulhi64(h, numBlocks);
+   }
+
+   // block i, starting on a cache line. The words are only 8 byte aligned,
+   // so they hold a block extra and the blocks start at the first line.
+   // Found again on every query, so a copy of the words needs no fixing up
+   const uint64_t * blockAt(size_t i) const
+   {
+      size_t skip = (size_t)(0 - (uintptr_t)words.data()) % BLOCK_BYTES / sizeof(uint64_t);
+      return words.data() + skip + i * BLOCK_WORDS;
+   }
+   uint64_t * blockAt(size_t i)
+   {
+      return const_cast<uint64_t *>(static_cast<const blocked_bloom_filter *>(this)->blockAt(i));
+   }
+
+   std::vector<uint64_t> words;   // numBlocks blocks of BLOCK_WORDS words, and one to align them
+   size_t bitsPerKey;             // the budget the filter was sized with, 0 when off
+   size_t numHashes;              // bits set for each key, in one block
+   size_t numBlocks;              // cache lines of bits
+   size_t numRejected;            // queries turned away
+   size_t numFalsePositives;      // queries let through that then missed
+   size_t numStale;               // keys erased since the last rebuild
+};
+
+/*****************************************
+ * BLOCKED BLOOM FILTER :: CONFIGURE
+ * ln 2 bits set per key is best for a plain
+ * filter. Rounded, between 1 and MAX_HASHES.
+ ****************************************/
+inline void blocked_bloom_filter::configure(size_t bitsPerKey, size_t numKeys)
+{
+   this->bitsPerKey = bitsPerKey;
+   numStale = 0;
+   if (bitsPerKey == 0)
+   {
+      words = std::vector<uint64_t>();
+      numHashes = 0;
+      numBlocks = 0;
+      return;
+   }
+
+   numHashes = (bitsPerKey * 693 + 500) / 1000;
+   if (numHashes < 1)
+      numHashes = 1;
+   if (numHashes > MAX_HASHES)
+      numHashes = MAX_HASHES;
+
+   size_t numBits = (numKeys ? numKeys : 1) * bitsPerKey;
+   numBlocks = (numBits + BLOCK_WORDS * 64 - 1) / (BLOCK_WORDS * 64);
+   words.assign((numBlocks + 1) * BLOCK_WORDS, 0);
+}
+
+}
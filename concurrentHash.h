@@ -0,0 +1,435 @@
+/***********************************************************************
+ * Header:
+ *    CONCURRENT HASH
+ * Summary:
+ *    A thread-safe hash set on the same bucket layout as
+ *    custom::unordered_set: a vector of lists. The buckets are guarded
+ *    by an array of striped reader-writer locks. A key's stripe depends
+ *    only on its hash and the bucket count is always a multiple of the
+ *    stripe count, so every element of a bucket is under the same lock:
+ *       stripe = hash % NUM_STRIPES
+ *       bucket = hash % bucket_count()
+ *    Lookups take their stripe shared, inserts and erases take it
+ *    exclusive, and growth takes every stripe exclusive, in order.
+ *
+ *    This will contain the class definition of:
+ *        concurrent_unordered_set : A hash set safe to share between threads
+ * Author
+ *       Marco Varela &  Andre Regino
+ ************************************************************************/
+
+#pragma once
+
+#include "list.h"          // because this->buckets[0] is a list
+#include "vector.h"        // because this->buckets is a vector
+#include <algorithm>       // for std::max
+#include <atomic>          // for std::atomic
+#include <cmath>           // for std::ceil
+#include <functional>      // for std::hash
+#include <memory>          // for std::allocator
+#include <mutex>           // for std::unique_lock
+#include <shared_mutex>    // for std::shared_timed_mutex
+#include <vector>          // for the batch scratch space
+
+class TestConcurrentHash;  // forward declaration for ConcurrentHash unit tests
+
+namespace custom
+{
+
+/************************************************
+ * CONCURRENT UNORDERED SET
+ * A set implemented as a hash with striped locks.
+ * There are no iterators: they could not stay
+ * valid while other threads insert. Use contains()
+ * and for_each() instead.
+ *
+ * The allocator must be thread-safe, so
+ * custom::pool_allocator does not belong here.
+ ************************************************/
+template <typename T,
+          typename Hash = std::hash<T>,
+          typename EqPred = std::equal_to<T>,
+          typename A = std::allocator<T> >
+class concurrent_unordered_set
+{
+   friend class ::TestConcurrentHash;   // give unit tests access to the privates
+   typedef custom::list<T, A> Bucket;
+public:
+   static const size_t NUM_STRIPES = 64;   // locks, a power of two
+
+   //
+   // Construct
+   //
+   concurrent_unordered_set() : buckets(NUM_STRIPES), numElements(0), maxLoadFactor(1)
+   {
+   }
+   concurrent_unordered_set(size_t numBuckets) : buckets(stripedCount(numBuckets)),
+                                                 numElements(0), maxLoadFactor(1)
+   {
+   }
+   concurrent_unordered_set(const concurrent_unordered_set& rhs) = delete;
+   concurrent_unordered_set& operator=(const concurrent_unordered_set& rhs) = delete;
+
+   //
+   // Access
+   //
+   bool contains(const T& t);
+   size_t count(const T& t)
+   {
+      return contains(t) ? 1 : 0;
+   }
+   template <class Keys, class OutIterator>
+   size_t find_many(const Keys& keys, OutIterator out);
+   template <class Callback>
+   void for_each(Callback callback);
+
+   //
+   // Insert
+   //
+   bool insert(const T& t);
+   template <class Keys>
+   size_t insert_many(const Keys& keys);
+   void rehash(size_t numBuckets);
+   void reserve(size_t num)
+   {
+      rehash((size_t)std::ceil((float)num / max_load_factor()));
+   }
+
+   //
+   // Remove
+   //
+   size_t erase(const T& t);
+   void clear();
+
+   //
+   // Status
+   //
+   size_t size() const
+   {
+      return numElements.load(std::memory_order_relaxed);
+   }
+   bool empty() const
+   {
+      return size() == 0;
+   }
+   size_t bucket_count()
+   {
+      std::shared_lock<std::shared_timed_mutex> lock(stripes[0].mutex);
+      return buckets.size();
+   }
+   float max_load_factor() const noexcept
+   {
+      return maxLoadFactor.load(std::memory_order_relaxed);
+   }
+   void max_load_factor(float m)
+   {
+      maxLoadFactor.store(m, std::memory_order_relaxed);
+   }
+
+private:
+   // one lock on a cache line of its own, so readers of
+   // neighboring stripes do not bounce each other's lines
+   struct alignas(64) Stripe
+   {
+      std::shared_timed_mutex mutex;
+   };
+
+   // hold every stripe exclusive, always locked in the same order
+   class LockAll
+   {
+   public:
+      LockAll(Stripe * stripes) : stripes(stripes)
+      {
+         for (size_t i = 0; i < NUM_STRIPES; i++)
+            stripes[i].mutex.lock();
+      }
+      ~LockAll()
+      {
+         for (size_t i = NUM_STRIPES; i > 0; i--)
+            stripes[i - 1].mutex.unlock();
+      }
+   private:
+      Stripe * stripes;
+   };
+
+   // the smallest multiple of NUM_STRIPES holding num buckets
+   static size_t stripedCount(size_t num)
+   {
+      return num <= NUM_STRIPES ? NUM_STRIPES : (num + NUM_STRIPES - 1) / NUM_STRIPES * NUM_STRIPES;
+   }
+   static size_t stripeOf(size_t hash)
+   {
+      return hash & (NUM_STRIPES - 1);
+   }
+
+   // callers hold the stripe of the hash
+   bool containsLocked(const T& t, size_t hash);
+   bool insertLocked(const T& t, size_t hash);
+   void growIfNeeded(size_t num);
+
+   // group the batch by stripe: order holds the positions in keys,
+   // stripe s owns order[start[s]] through order[start[s + 1] - 1]
+   template <class Keys>
+   void groupByStripe(const Keys& keys, std::vector<size_t>& hashes,
+                      std::vector<size_t>& order, size_t (&start)[NUM_STRIPES + 1]);
+
+   Stripe stripes[NUM_STRIPES];            // the locks guarding the buckets
+   custom::vector<Bucket> buckets;         // each bucket in the hash
+   std::atomic<size_t> numElements;        // number of elements in the Hash
+   std::atomic<float> maxLoadFactor;       // the ratio of elements to buckets signifying a rehash
+};
+
+/*****************************************
+ * CONCURRENT UNORDERED SET :: CONTAINS LOCKED
+ * Walk the bucket of a key whose stripe we hold
+ ****************************************/
+template <typename T, typename H, typename E, typename A>
+bool concurrent_unordered_set<T, H, E, A>::containsLocked(const T& t, size_t hash)
+{
+   E equal;
+   Bucket& bucket = buckets[hash % buckets.size()];
+   for (auto it = bucket.begin(); it != bucket.end(); ++it)
+      if (equal(*it, t))
+         return true;
+   return false;
+}
+
+/*****************************************
+ * CONCURRENT UNORDERED SET :: INSERT LOCKED
+ * Add a key whose stripe we hold exclusive
+ ****************************************/
+template <typename T, typename H, typename E, typename A>
+bool concurrent_unordered_set<T, H, E, A>::insertLocked(const T& t, size_t hash)
+{
+   if (containsLocked(t, hash))
+      return false;
+   buckets[hash % buckets.size()].push_back(t);
+   numElements.fetch_add(1, std::memory_order_relaxed);
+   return true;
+}
+
+/*****************************************
+ * CONCURRENT UNORDERED SET :: CONTAINS
+ * Is the key in the set? Takes one stripe shared
+ ****************************************/
+template <typename T, typename H, typename E, typename A>
+bool concurrent_unordered_set<T, H, E, A>::contains(const T& t)
+{
+   size_t hash = H()(t);
+   std::shared_lock<std::shared_timed_mutex> lock(stripes[stripeOf(hash)].mutex);
+   return containsLocked(t, hash);
+}
+
+/*****************************************
+ * CONCURRENT UNORDERED SET :: INSERT
+ * Add one key. Returns false if it was there
+ ****************************************/
+template <typename T, typename H, typename E, typename A>
+bool concurrent_unordered_set<T, H, E, A>::insert(const T& t)
+{
+   size_t hash = H()(t);
+   bool inserted;
+   {
+      std::unique_lock<std::shared_timed_mutex> lock(stripes[stripeOf(hash)].mutex);
+      inserted = insertLocked(t, hash);
+   }
+
+   // Grow outside the stripe: growth needs every stripe
+   if (inserted)
+      growIfNeeded(size());
+   return inserted;
+}
+
+/*****************************************
+ * CONCURRENT UNORDERED SET :: ERASE
+ * Remove one key. Returns the number removed
+ ****************************************/
+template <typename T, typename H, typename E, typename A>
+size_t concurrent_unordered_set<T, H, E, A>::erase(const T& t)
+{
+   size_t hash = H()(t);
+   E equal;
+   std::unique_lock<std::shared_timed_mutex> lock(stripes[stripeOf(hash)].mutex);
+   Bucket& bucket = buckets[hash % buckets.size()];
+   for (auto it = bucket.begin(); it != bucket.end(); ++it)
+      if (equal(*it, t))
+      {
+         bucket.erase(it);
+         numElements.fetch_sub(1, std::memory_order_relaxed);
+         return 1;
+      }
+   return 0;
+}
+
+/*****************************************
+ * CONCURRENT UNORDERED SET :: CLEAR
+ * Remove every element
+ ****************************************/
+template <typename T, typename H, typename E, typename A>
+void concurrent_unordered_set<T, H, E, A>::clear()
+{
+   LockAll lock(stripes);
+   for (auto& bucket : buckets)
+      bucket.clear();
+   numElements.store(0, std::memory_order_relaxed);
+}
+
+/*****************************************
+ * CONCURRENT UNORDERED SET :: REHASH
+ * Grow to at least numBuckets. Every stripe is
+ * held, so no reader sees a half-moved table
+ ****************************************/
+template <typename T, typename H, typename E, typename A>
+void concurrent_unordered_set<T, H, E, A>::rehash(size_t numBuckets)
+{
+   LockAll lock(stripes);
+
+   // Another thread may have grown the table while we waited
+   numBuckets = stripedCount(numBuckets);
+   if (numBuckets <= buckets.size())
+      return;
+
+   // Move the elements into the new buckets, one at a time
+   H hash;
+   custom::vector<Bucket> bucketNew(numBuckets);
+   for (auto& bucket : buckets)
+      for (auto& element : bucket)
+         bucketNew[hash(element) % numBuckets].push_back(std::move(element));
+   std::swap(buckets, bucketNew);
+}
+
+/*****************************************
+ * CONCURRENT UNORDERED SET :: GROW IF NEEDED
+ * Double the buckets if num elements are over
+ * the load factor
+ ****************************************/
+template <typename T, typename H, typename E, typename A>
+void concurrent_unordered_set<T, H, E, A>::growIfNeeded(size_t num)
+{
+   size_t numBuckets = bucket_count();
+   if ((float)num > (float)numBuckets * max_load_factor())
+      rehash(std::max(numBuckets * 2, (size_t)std::ceil((float)num / max_load_factor())));
+}
+
+/*****************************************
+ * CONCURRENT UNORDERED SET :: GROUP BY STRIPE
+ * Hash the whole batch and counting-sort it
+ * by stripe so each stripe is locked once
+ ****************************************/
+template <typename T, typename H, typename E, typename A>
+template <class Keys>
+void concurrent_unordered_set<T, H, E, A>::groupByStripe(const Keys& keys,
+   std::vector<size_t>& hashes, std::vector<size_t>& order, size_t (&start)[NUM_STRIPES + 1])
+{
+   H hash;
+   for (auto it = keys.begin(); it != keys.end(); ++it)
+      hashes.push_back(hash(*it));
+
+   // count, then turn the counts into starting positions
+   for (size_t s = 0; s <= NUM_STRIPES; s++)
+      start[s] = 0;
+   for (size_t h : hashes)
+      start[stripeOf(h) + 1]++;
+   for (size_t s = 0; s < NUM_STRIPES; s++)
+      start[s + 1] += start[s];
+
+   size_t next[NUM_STRIPES];
+   for (size_t s = 0; s < NUM_STRIPES; s++)
+      next[s] = start[s];
+   order.resize(hashes.size());
+   for (size_t i = 0; i < hashes.size(); i++)
+      order[next[stripeOf(hashes[i])]++] = i;
+}
+
+/*****************************************
+ * CONCURRENT UNORDERED SET :: FIND MANY
+ * Write whether each key is present to out, in
+ * the order of keys. Returns the number found.
+ * Each stripe is taken shared at most once.
+ ****************************************/
+template <typename T, typename H, typename E, typename A>
+template <class Keys, class OutIterator>
+size_t concurrent_unordered_set<T, H, E, A>::find_many(const Keys& keys, OutIterator out)
+{
+   std::vector<const T *> pKeys;
+   for (auto it = keys.begin(); it != keys.end(); ++it)
+      pKeys.push_back(&*it);
+   std::vector<size_t> hashes;
+   std::vector<size_t> order;
+   size_t start[NUM_STRIPES + 1];
+   groupByStripe(keys, hashes, order, start);
+
+   std::vector<char> found(pKeys.size(), 0);
+   size_t numFound = 0;
+   for (size_t s = 0; s < NUM_STRIPES; s++)
+   {
+      if (start[s] == start[s + 1])
+         continue;
+      std::shared_lock<std::shared_timed_mutex> lock(stripes[s].mutex);
+      for (size_t i = start[s]; i < start[s + 1]; i++)
+         if (containsLocked(*pKeys[order[i]], hashes[order[i]]))
+         {
+            found[order[i]] = 1;
+            numFound++;
+         }
+   }
+
+   for (char f : found)
+      *out++ = (f != 0);
+   return numFound;
+}
+
+/*****************************************
+ * CONCURRENT UNORDERED SET :: INSERT MANY
+ * Insert a batch of keys. Returns the number
+ * that were new. The table is grown for the
+ * batch up front, then each stripe is taken
+ * exclusive at most once.
+ ****************************************/
+template <typename T, typename H, typename E, typename A>
+template <class Keys>
+size_t concurrent_unordered_set<T, H, E, A>::insert_many(const Keys& keys)
+{
+   std::vector<const T *> pKeys;
+   for (auto it = keys.begin(); it != keys.end(); ++it)
+      pKeys.push_back(&*it);
+   growIfNeeded(size() + pKeys.size());
+
+   std::vector<size_t> hashes;
+   std::vector<size_t> order;
+   size_t start[NUM_STRIPES + 1];
+   groupByStripe(keys, hashes, order, start);
+
+   size_t numInserted = 0;
+   for (size_t s = 0; s < NUM_STRIPES; s++)
+   {
+      if (start[s] == start[s + 1])
+         continue;
+      std::unique_lock<std::shared_timed_mutex> lock(stripes[s].mutex);
+      for (size_t i = start[s]; i < start[s + 1]; i++)
+         if (insertLocked(*pKeys[order[i]], hashes[order[i]]))
+            numInserted++;
+   }
+   return numInserted;
+}
+
+/*****************************************
+ * CONCURRENT UNORDERED SET :: FOR EACH
+ * Call callback on every element. Each stripe
+ * is held shared while its buckets are visited,
+ * so callback must not modify this set.
+ ****************************************/
+template <typename T, typename H, typename E, typename A>
+template <class Callback>
+void concurrent_unordered_set<T, H, E, A>::for_each(Callback callback)
+{
+   for (size_t s = 0; s < NUM_STRIPES; s++)
+   {
+      std::shared_lock<std::shared_timed_mutex> lock(stripes[s].mutex);
+      for (size_t iBucket = s; iBucket < buckets.size(); iBucket += NUM_STRIPES)
+         for (auto it = buckets[iBucket].begin(); it != buckets[iBucket].end(); ++it)
+            callback(*it);
+   }
+}
+
+}
@@ -0,0 +1,276 @@
+/***********************************************************************
+ * Header:
+ *    CONSTEXPR HASH
+ * Summary:
+ *    A set of fixed keys built entirely by the compiler. Declared
+ *    constexpr, it is constant-initialized into read-only data: no
+ *    allocation, no static initializer, nothing to run at startup.
+ *    (Pointer keys in a position-independent program sit in
+ *    .data.rel.ro, which the loader relocates before main.)
+ *       constexpr auto keywords = custom::make_constexpr_unordered_set<const char *>(
+ *          { "if", "else", "while", "for" });
+ *       static_assert(keywords.contains("while"), "");
+ *    The N keys fill N slots by the same pilot scheme as frozen_set:
+ *    a find is one hash, one pilot, one key and one compare. Every
+ *    division is by a constant, N or the bucket count, so it compiles
+ *    to a multiply.
+ *
+ *    This will contain the class definition of:
+ *        constexpr_hash         : a hash the compiler can run
+ *        constexpr_equal_to     : ==, and the characters for a C string
+ *        constexpr_unordered_set: the set
+ * Author
+ *       Marco Varela &  Andre Regino
+ ************************************************************************/
+
+#pragma once
+
+#include "hashPolicy.h"    // for mix64, which is constexpr
+#include <cstddef>         // for size_t
+#include <cstdint>         // for uint32_t and uint64_t
+#include <stdexcept>       // for std::logic_error, a compile error when constexpr
+#include <type_traits>     // for std::enable_if
+#if __cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+#include <string_view>     // for std::string_view
+#define CUSTOM_CONSTEXPR_STRING_VIEW
+#endif
+
+class TestConstexprHash;   // forward declaration for ConstexprHash unit tests
+
+namespace custom
+{
+
+/*****************************************************
+ * CONSTEXPR HASH BYTES
+ * FNV-1a over n characters, then mixed, so short
+ * keys differ in every bit
+ ****************************************************/
+constexpr uint64_t constexpr_hash_chars(const char * s, size_t n)
+{
+   uint64_t h = 0xcbf29ce484222325ULL;
+   for (size_t i = 0; i < n; i++)
+   {
+      h ^= (uint64_t)(unsigned char)s[i];
+      h *= 0x100000001b3ULL;
+   }
+   return mix64(h);
+}
+
+/************************************************
+ * CONSTEXPR HASH
+ * Integers and enums, C strings and string_views
+ ************************************************/
+template <typename T, typename Enable = void>
+struct constexpr_hash;
+
+template <typename T>
+struct constexpr_hash<T, typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type>
+{
+   constexpr size_t operator () (T t) const
+   {
+      return (size_t)mix64((uint64_t)t);
+   }
+};
+
+template <>
+struct constexpr_hash<const char *, void>
+{
+   constexpr size_t operator () (const char * s) const
+   {
+      size_t n = 0;
+      while (s[n])
+         n++;
+      return (size_t)constexpr_hash_chars(s, n);
+   }
+};
+
+#ifdef CUSTOM_CONSTEXPR_STRING_VIEW
+template <>
+struct constexpr_hash<std::string_view, void>
+{
+   constexpr size_t operator () (std::string_view s) const
+   {
+      return (size_t)constexpr_hash_chars(s.data(), s.size());
+   }
+};
+#endif
+
+/************************************************
+ * CONSTEXPR EQUAL TO
+ * ==, except that two C strings are equal when
+ * their characters are
+ ************************************************/
+template <typename T>
+struct constexpr_equal_to
+{
+   constexpr bool operator () (const T& lhs, const T& rhs) const
+   {
+      return lhs == rhs;
+   }
+};
+
+template <>
+struct constexpr_equal_to<const char *>
+{
+   constexpr bool operator () (const char * lhs, const char * rhs) const
+   {
+      size_t i = 0;
+      while (lhs[i] && lhs[i] == rhs[i])
+         i++;
+      return lhs[i] == rhs[i];
+   }
+};
+
+/************************************************
+ * CONSTEXPR UNORDERED SET
+ * N distinct keys, placed when the set is built.
+ * Built in a constant expression, a failure such as
+ * two keys with one hash is a compile error.
+ ************************************************/
+template <typename T,
+          size_t N,
+          typename Hash = constexpr_hash<T>,
+          typename EqPred = constexpr_equal_to<T> >
+class constexpr_unordered_set
+{
+   friend class ::TestConstexprHash;   // give unit tests access to the privates
+   static_assert(N > 0, "a constexpr set has at least one key");
+public:
+   // the keys are one array, so a pointer walks them
+   typedef const T * iterator;
+
+   static const size_t NUM_BUCKETS = (N + 2) / 3;   // three keys for each pilot
+
+   //
+   // Construct
+   //
+   constexpr explicit constexpr_unordered_set(const T (&source)[N]) : keys(), pilots()
+   {
+      build(source);
+   }
+
+   //
+   // Iterator
+   //
+   constexpr iterator begin() const  { return keys;     }
+   constexpr iterator end() const    { return keys + N; }
+
+   //
+   // Access
+   //
+   constexpr iterator find(const T& t) const
+   {
+      uint64_t h = (uint64_t)Hash()(t);
+      const T * p = keys + slotOf(h, pilots[bucketOf(h)]);
+      return EqPred()(*p, t) ? p : end();
+   }
+   constexpr size_t count(const T& t) const
+   {
+      return find(t) == end() ? 0 : 1;
+   }
+   constexpr bool contains(const T& t) const
+   {
+      return find(t) != end();
+   }
+
+   //
+   // Status
+   //
+   constexpr size_t size() const   { return N;     }
+   constexpr bool empty() const    { return false; }
+
+private:
+   static constexpr size_t bucketOf(uint64_t h)
+   {
+      return (size_t)((h * 0x9E3779B97F4A7C15ULL) >> 32) % NUM_BUCKETS;
+   }
+   static constexpr size_t slotOf(uint64_t h, uint32_t pilot)
+   {
+      return (size_t)(mix64(h ^ (((uint64_t)pilot + 1) * 0xC2B2AE3D27D4EB4FULL)) % N);
+   }
+
+   constexpr void build(const T (&source)[N]);
+
+   T keys[N];                      // every key, in its slot
+   uint32_t pilots[NUM_BUCKETS];   // where the keys of each bucket go
+};
+
+/*****************************************
+ * CONSTEXPR UNORDERED SET :: BUILD
+ * The longest buckets take their pilots first,
+ * while most slots are still free
+ ****************************************/
+template <typename T, size_t N, typename H, typename E>
+constexpr void constexpr_unordered_set<T, N, H, E>::build(const T (&source)[N])
+{
+   uint64_t hashes[N] = {};
+   size_t start[NUM_BUCKETS + 1] = {};
+   for (size_t i = 0; i < N; i++)
+   {
+      hashes[i] = (uint64_t)H()(source[i]);
+      start[bucketOf(hashes[i]) + 1]++;
+   }
+
+   // the keys of each bucket, together
+   size_t maxLength = 0;
+   for (size_t b = 0; b < NUM_BUCKETS; b++)
+   {
+      if (start[b + 1] > maxLength)
+         maxLength = start[b + 1];
+      start[b + 1] += start[b];
+   }
+   size_t members[N] = {};
+   size_t next[NUM_BUCKETS] = {};
+   for (size_t b = 0; b < NUM_BUCKETS; b++)
+      next[b] = start[b];
+   for (size_t i = 0; i < N; i++)
+      members[next[bucketOf(hashes[i])]++] = i;
+
+   bool taken[N] = {};
+   size_t tried[N] = {};
+   for (size_t length = maxLength; length > 0; length--)
+      for (size_t b = 0; b < NUM_BUCKETS; b++)
+      {
+         if (start[b + 1] - start[b] != length)
+            continue;
+
+         for (size_t j = start[b]; j < start[b + 1]; j++)
+            for (size_t k = j + 1; k < start[b + 1]; k++)
+               if (hashes[members[j]] == hashes[members[k]])
+                  throw std::logic_error("constexpr_unordered_set: two keys have the same hash");
+
+         for (uint32_t pilot = 0; ; pilot++)
+         {
+            bool fits = true;
+            for (size_t j = 0; fits && j < length; j++)
+            {
+               tried[j] = slotOf(hashes[members[start[b] + j]], pilot);
+               fits = !taken[tried[j]];
+               for (size_t k = 0; fits && k < j; k++)
+                  fits = tried[k] != tried[j];
+            }
+            if (!fits)
+               continue;
+
+            for (size_t j = 0; j < length; j++)
+            {
+               taken[tried[j]] = true;
+               keys[tried[j]] = source[members[start[b] + j]];
+            }
+            pilots[b] = pilot;
+            break;
+         }
+      }
+}
+
+/*****************************************************
+ * MAKE CONSTEXPR UNORDERED SET
+ * The set of a braced list, its size counted for you
+ ****************************************************/
+template <typename T, size_t N>
+constexpr constexpr_unordered_set<T, N> make_constexpr_unordered_set(const T (&keys)[N])
+{
+   return constexpr_unordered_set<T, N>(keys);
+}
+
+}
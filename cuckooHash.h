@@ -0,0 +1,794 @@
+/***********************************************************************
+ * Header:
+ *    CUCKOO HASH
+ * Summary:
+ *    A bucketized cuckoo sibling of custom::unordered_set. Every element
+ *    lives in one of exactly two buckets of four slots, chosen by two
+ *    hash functions: the mixed hash, and that hash mixed again. A
+ *    lookup reads those two buckets and nothing else. A bucket of small
+ *    keys is padded to a power of two no larger than a cache line, so
+ *    it never straddles two: a lookup touches at most two cache lines,
+ *    however full the table is.
+ *
+ *    An insert whose two buckets are both full makes room by a
+ *    breadth-first search for the shortest chain of displacements that
+ *    ends in a free slot, then moves the chain from its far end. The
+ *    table only grows when that search fails or it is 95% full.
+ *
+ *    This will contain the class definition of:
+ *        cuckoo_unordered_set           : A hash set of two-choice buckets
+ *        cuckoo_unordered_set::iterator : An iterator through the set
+ * Author
+ *       Marco Varela &  Andre Regino
+ ************************************************************************/
+
+#pragma once
+
+#include "pair.h"       // for custom::pair returned from insert
+#include "hashPolicy.h" // for mix64, mulhi64 and prefetch
+#include <memory>       // for std::allocator and std::align
+#include <functional>   // for std::hash and std::equal_to
+#include <cstdint>      // for uint8_t, uint16_t, uint32_t and uint64_t
+#include <cstring>      // for std::memcpy of the four tags
+#include <new>          // for placement new of the buckets
+#include <stdexcept>    // for std::runtime_error
+#include <utility>      // for std::move and std::swap
+#ifdef _MSC_VER
+#include <intrin.h>     // for _BitScanForward
+#endif
+
+class TestCuckooHash;   // forward declaration for CuckooHash unit tests
+
+namespace custom
+{
+
+/*****************************************************
+ * CUCKOO BUCKET ALIGNMENT
+ * The smallest power of two holding a bucket of size
+ * bytes, when that fits in a 64 byte cache line.
+ * A larger bucket keeps its natural alignment
+ ****************************************************/
+constexpr size_t cuckoo_bucket_alignment(size_t size, size_t align)
+{
+   if (size > 64)
+      return align;
+   size_t alignment = align;
+   while (alignment < size)
+      alignment *= 2;
+   return alignment;
+}
+
+/************************************************
+ * CUCKOO UNORDERED SET
+ * A set implemented as a bucketized cuckoo hash
+ ************************************************/
+template <typename T,
+          typename Hash = std::hash<T>,
+          typename EqPred = std::equal_to<T>,
+          typename A = std::allocator<T> >
+class cuckoo_unordered_set
+{
+   friend class ::TestCuckooHash;   // give unit tests access to the privates
+public:
+   static const size_t SLOTS = 4;   // elements in a bucket
+
+   //
+   // Construct
+   //
+   cuckoo_unordered_set() : buckets(nullptr), pRaw(nullptr),
+      numBuckets(0), numElements(0)
+   {
+   }
+   cuckoo_unordered_set(size_t numBuckets) : cuckoo_unordered_set()
+   {
+      rehash(numBuckets);
+   }
+   cuckoo_unordered_set(size_t numBuckets, const Hash& hash) : cuckoo_unordered_set()
+   {
+      hashFunction = hash;
+      rehash(numBuckets);
+   }
+   cuckoo_unordered_set(const cuckoo_unordered_set& rhs) : cuckoo_unordered_set()
+   {
+      *this = rhs;
+   }
+   cuckoo_unordered_set(cuckoo_unordered_set&& rhs) noexcept : cuckoo_unordered_set()
+   {
+      swap(rhs);
+   }
+   template <class Iterator>
+   cuckoo_unordered_set(Iterator first, Iterator last) : cuckoo_unordered_set()
+   {
+      while (first != last)
+         insert(*first++);
+   }
+   cuckoo_unordered_set(const std::initializer_list<T>& il) : cuckoo_unordered_set()
+   {
+      insert(il);
+   }
+   ~cuckoo_unordered_set()
+   {
+      destroy();
+   }
+
+   //
+   // Assign
+   //
+   cuckoo_unordered_set& operator=(const cuckoo_unordered_set& rhs);
+   cuckoo_unordered_set& operator=(cuckoo_unordered_set&& rhs) noexcept
+   {
+      clear();
+      swap(rhs);
+      return *this;
+   }
+   cuckoo_unordered_set& operator=(const std::initializer_list<T>& il)
+   {
+      clear();
+      insert(il);
+      return *this;
+   }
+   void swap(cuckoo_unordered_set& rhs) noexcept
+   {
+      std::swap(buckets,     rhs.buckets);
+      std::swap(pRaw,        rhs.pRaw);
+      std::swap(numBuckets,  rhs.numBuckets);
+      std::swap(numElements, rhs.numElements);
+      std::swap(hashFunction, rhs.hashFunction);
+   }
+
+   //
+   // Iterator
+   //
+   class iterator;
+   iterator begin()
+   {
+      iterator it(buckets, 0, buckets + numBuckets);
+      it.skipEmpty();
+      return it;
+   }
+   iterator end()
+   {
+      return iterator(buckets + numBuckets, 0, buckets + numBuckets);
+   }
+
+   //
+   // Access
+   //
+   iterator find(const T& t);
+
+   //
+   // Insert
+   //
+   custom::pair<iterator, bool> insert(const T& t);
+   void insert(const std::initializer_list<T>& il)
+   {
+      reserve(numElements + il.size());
+      for (auto& t : il)
+         insert(t);
+   }
+   void rehash(size_t numBuckets);
+   void reserve(size_t num)
+   {
+      // enough buckets that num elements stay under the 95% load factor
+      rehash((num * 20 + 19 * SLOTS - 1) / (19 * SLOTS));
+   }
+
+   //
+   // Remove
+   //
+   void clear() noexcept;
+   iterator erase(const T& t);
+
+   //
+   // Status
+   //
+   size_t size() const
+   {
+      return numElements;
+   }
+   bool empty() const
+   {
+      return size() == 0;
+   }
+   size_t bucket_count() const
+   {
+      return numBuckets;
+   }
+   float load_factor() const noexcept
+   {
+      return numBuckets == 0 ? (float)0.0 : (float)numElements / (float)(numBuckets * SLOTS);
+   }
+   float max_load_factor() const noexcept
+   {
+      return (float)0.95;
+   }
+   static size_t bucket_bytes()
+   {
+      return sizeof(Bucket);
+   }
+   size_t num_bytes() const
+   {
+      return numBuckets * sizeof(Bucket);
+   }
+   Hash hash_function() const
+   {
+      return hashFunction;
+   }
+
+private:
+   // four tags, zero for an empty slot, then four slots
+   struct Slots
+   {
+      uint8_t tags[SLOTS];
+      alignas(T) unsigned char storage[SLOTS * sizeof(T)];
+   };
+   struct alignas(cuckoo_bucket_alignment(sizeof(Slots), alignof(Slots))) Bucket : Slots
+   {
+      T * slot(size_t i)
+      {
+         return reinterpret_cast<T *>(this->storage) + i;
+      }
+      const T * slot(size_t i) const
+      {
+         return reinterpret_cast<const T *>(this->storage) + i;
+      }
+   };
+
+   // one step of a displacement search: the element in slot of
+   // bucket parent moves to bucket
+   struct Step
+   {
+      size_t   bucket;
+      uint16_t parent;
+      uint8_t  slot;
+      uint8_t  depth;
+   };
+   static const size_t MAX_SEARCH = 1024;  // buckets a displacement search visits
+   static const size_t MAX_DEPTH  = 5;     // displacements an insert may cause
+
+   static Step step(size_t bucket, size_t parent, size_t slot, size_t depth)
+   {
+      Step s;
+      s.bucket = bucket;
+      s.parent = (uint16_t)parent;
+      s.slot   = (uint8_t)slot;
+      s.depth  = (uint8_t)depth;
+      return s;
+   }
+
+   typedef typename std::allocator_traits<A>::template rebind_alloc<T>             SlotAlloc;
+   typedef typename std::allocator_traits<A>::template rebind_alloc<unsigned char> RawAlloc;
+
+   // the most elements a table of this many buckets holds: 95% full
+   static size_t maxLoad(size_t numBuckets)
+   {
+      return numBuckets * SLOTS * 19 / 20;
+   }
+
+   // spread the bits so identity hashes such as std::hash<int> place well
+   uint64_t hashOf(const T& t) const
+   {
+      return mix64((uint64_t)hashFunction(t));
+   }
+   // the low byte: the high bits already chose the first bucket
+   static uint8_t tagOf(uint64_t hash)
+   {
+      uint8_t tag = (uint8_t)hash;
+      return tag == 0 ? 1 : tag;
+   }
+   size_t bucket1(uint64_t hash) const
+   {
+      return (size_t)mulhi64(hash, numBuckets);
+   }
+   // the second hash function, never the same bucket as the first
+   size_t bucket2(uint64_t hash, size_t b1) const
+   {
+      size_t b2 = (size_t)mulhi64(mix64(hash ^ 0x9E3779B97F4A7C15ULL), numBuckets);
+      if (b2 == b1 && numBuckets > 1)
+         b2 = (b1 + 1 == numBuckets) ? 0 : b1 + 1;
+      return b2;
+   }
+   // the high bit of each byte whose tag is tag, all four at once
+   // (read little-endian, so tags[0] is the low byte).
+   // A byte just above a match may also be set: the key compare
+   // weeds those out, and the lowest set byte is always a match
+   static uint32_t matchTags(const Bucket & bucket, uint8_t tag)
+   {
+      uint32_t tags;
+      std::memcpy(&tags, bucket.tags, sizeof(tags));
+      uint32_t x = tags ^ (0x01010101u * tag);
+      return (x - 0x01010101u) & ~x & 0x80808080u;
+   }
+   // the slot of the lowest byte set in bits, which is not zero
+   static size_t lowestByte(uint32_t bits)
+   {
+#if defined(_MSC_VER)
+      unsigned long index;
+      _BitScanForward(&index, bits);
+      return (size_t)index / 8;
+#else
+      return (size_t)__builtin_ctz(bits) / 8;
+#endif
+   }
+
+   // the bucket an element in bucket b would move to
+   size_t alternate(uint64_t hash, size_t b) const
+   {
+      size_t b1 = bucket1(hash);
+      return b == b1 ? bucket2(hash, b1) : b1;
+   }
+
+   iterator iteratorAt(size_t b, size_t i)
+   {
+      return iterator(buckets + b, i, buckets + numBuckets);
+   }
+
+   size_t findSlot(size_t b, const T& t, uint8_t tag) const;
+   size_t freeSlot(size_t b) const;
+   bool place(uint64_t hash, size_t& b, size_t& i);
+   bool search(size_t b1, size_t b2, Step * steps, size_t& iLast, size_t& bFree) const;
+   void allocate(size_t newBuckets);
+   void resize(size_t newBuckets);
+   void destroy() noexcept;
+
+   Bucket *        buckets;      // numBuckets buckets, cache line aligned when small
+   unsigned char * pRaw;         // the allocation that holds the buckets
+   size_t          numBuckets;   // number of buckets, any count
+   size_t          numElements;  // number of full slots
+   Hash            hashFunction; // hashes every element, with its own seed if it takes one
+};
+
+
+/************************************************
+ * CUCKOO UNORDERED SET ITERATOR
+ * Iterator for a cuckoo unordered set
+ ************************************************/
+template <typename T, typename H, typename E, typename A>
+class cuckoo_unordered_set <T, H, E, A> ::iterator
+{
+   friend class ::TestCuckooHash;   // give unit tests access to the privates
+   template <typename TT, typename HH, typename EE, typename AA>
+   friend class custom::cuckoo_unordered_set;
+public:
+   //
+   // Construct
+   //
+   iterator() : pBucket(nullptr), iSlot(0), pEnd(nullptr)
+   {
+   }
+   iterator(Bucket * pBucket, size_t iSlot, Bucket * pEnd) :
+      pBucket(pBucket), iSlot(iSlot), pEnd(pEnd)
+   {
+   }
+
+   //
+   // Compare
+   //
+   bool operator != (const iterator& rhs) const { return !(*this == rhs); }
+   bool operator == (const iterator& rhs) const
+   {
+      return pBucket == rhs.pBucket && iSlot == rhs.iSlot;
+   }
+
+   //
+   // Access
+   //
+   T& operator * ()
+   {
+      return *pBucket->slot(iSlot);
+   }
+
+   //
+   // Arithmetic
+   //
+   iterator& operator ++ ()
+   {
+      next();
+      skipEmpty();
+      return *this;
+   }
+   iterator operator ++ (int postfix)
+   {
+      iterator temp(*this);
+      ++(*this);
+      return temp;
+   }
+
+private:
+   void next()
+   {
+      if (++iSlot == SLOTS)
+      {
+         iSlot = 0;
+         ++pBucket;
+      }
+   }
+
+   // advance past empty slots
+   void skipEmpty()
+   {
+      while (pBucket != pEnd && pBucket->tags[iSlot] == 0)
+         next();
+   }
+
+   Bucket * pBucket;  // bucket of the current slot
+   size_t   iSlot;    // the current slot in that bucket
+   Bucket * pEnd;     // one past the last bucket
+};
+
+
+/*****************************************
+ * CUCKOO UNORDERED SET :: FIND SLOT
+ * The slot of bucket b holding t, or SLOTS
+ ****************************************/
+template <typename T, typename H, typename E, typename A>
+size_t cuckoo_unordered_set<T, H, E, A>::findSlot(size_t b, const T& t, uint8_t tag) const
+{
+   E equal;
+   const Bucket & bucket = buckets[b];
+   for (uint32_t bits = matchTags(bucket, tag); bits; bits &= bits - 1)
+   {
+      size_t i = lowestByte(bits);
+      if (equal(*bucket.slot(i), t))
+         return i;
+   }
+   return SLOTS;
+}
+
+/*****************************************
+ * CUCKOO UNORDERED SET :: FREE SLOT
+ * The first empty slot of bucket b, or SLOTS
+ ****************************************/
+template <typename T, typename H, typename E, typename A>
+size_t cuckoo_unordered_set<T, H, E, A>::freeSlot(size_t b) const
+{
+   uint32_t bits = matchTags(buckets[b], 0);
+   return bits ? lowestByte(bits) : SLOTS;
+}
+
+/*****************************************
+ * CUCKOO UNORDERED SET :: FIND
+ * Look in the two buckets t may be in, no further
+ ****************************************/
+template <typename T, typename H, typename E, typename A>
+typename cuckoo_unordered_set<T, H, E, A>::iterator cuckoo_unordered_set<T, H, E, A>::find(const T& t)
+{
+   if (numBuckets == 0)
+      return end();
+
+   // both lines are on their way before the first is searched
+   uint64_t hash = hashOf(t);
+   uint8_t tag = tagOf(hash);
+   size_t b1 = bucket1(hash);
+   size_t b2 = bucket2(hash, b1);
+   prefetch(buckets + b2);
+
+   size_t i = findSlot(b1, t, tag);
+   if (i != SLOTS)
+      return iteratorAt(b1, i);
+   i = findSlot(b2, t, tag);
+   return (i == SLOTS) ? end() : iteratorAt(b2, i);
+}
+
+/*****************************************
+ * CUCKOO UNORDERED SET :: SEARCH
+ * Breadth first from the two full buckets b1 and b2:
+ * every element of a bucket could move to its other
+ * bucket. Stop at the first bucket with a free slot,
+ * so the chain of displacements is the shortest.
+ * A chain never passes through one bucket twice.
+ ****************************************/
+template <typename T, typename H, typename E, typename A>
+bool cuckoo_unordered_set<T, H, E, A>::search(size_t b1, size_t b2, Step * steps,
+                                              size_t& iLast, size_t& bFree) const
+{
+   size_t numSteps = 0;
+   steps[numSteps++] = step(b1, MAX_SEARCH, SLOTS, 0);
+   steps[numSteps++] = step(b2, MAX_SEARCH, SLOTS, 0);
+
+   for (size_t iStep = 0; iStep < numSteps; iStep++)
+   {
+      if (steps[iStep].depth == MAX_DEPTH)
+         continue;
+
+      size_t b = steps[iStep].bucket;
+      for (size_t i = 0; i < SLOTS; i++)
+      {
+         size_t bAlt = alternate(hashOf(*buckets[b].slot(i)), b);
+
+         // the chain may not come back to a bucket it already moved from
+         bool onChain = false;
+         for (size_t j = iStep; j != MAX_SEARCH && !onChain; j = steps[j].parent)
+            onChain = steps[j].bucket == bAlt;
+         if (onChain)
+            continue;
+
+         // the element in slot i can move straight to a free slot
+         if (freeSlot(bAlt) != SLOTS)
+         {
+            steps[numSteps] = step(bAlt, iStep, i, steps[iStep].depth + 1);
+            iLast = numSteps;
+            bFree = bAlt;
+            return true;
+         }
+         if (numSteps == MAX_SEARCH)
+            return false;
+         steps[numSteps++] = step(bAlt, iStep, i, steps[iStep].depth + 1);
+      }
+   }
+   return false;
+}
+
+/*****************************************
+ * CUCKOO UNORDERED SET :: PLACE
+ * Find a free slot for an element with this hash,
+ * displacing others as needed. Set b and i to it.
+ * Return false when there is no room
+ ****************************************/
+template <typename T, typename H, typename E, typename A>
+bool cuckoo_unordered_set<T, H, E, A>::place(uint64_t hash, size_t& b, size_t& i)
+{
+   if (numBuckets == 0)
+      return false;
+
+   // a free slot in either bucket
+   size_t b1 = bucket1(hash);
+   size_t b2 = bucket2(hash, b1);
+   if ((i = freeSlot(b1)) != SLOTS)
+   {
+      b = b1;
+      return true;
+   }
+   if ((i = freeSlot(b2)) != SLOTS)
+   {
+      b = b2;
+      return true;
+   }
+
+   // the shortest chain of displacements that ends in a free slot
+   Step steps[MAX_SEARCH + 1];
+   size_t iStep;
+   size_t bTo;
+   if (!search(b1, b2, steps, iStep, bTo))
+      return false;
+
+   // move from the far end of the chain, so each element
+   // goes into the slot just emptied ahead of it
+   SlotAlloc alloc;
+   size_t iTo = freeSlot(bTo);
+   while (steps[iStep].parent != MAX_SEARCH)
+   {
+      size_t bFrom = steps[steps[iStep].parent].bucket;
+      size_t iFrom = steps[iStep].slot;
+      std::allocator_traits<SlotAlloc>::construct(alloc, buckets[bTo].slot(iTo),
+                                                  std::move(*buckets[bFrom].slot(iFrom)));
+      std::allocator_traits<SlotAlloc>::destroy(alloc, buckets[bFrom].slot(iFrom));
+      buckets[bTo].tags[iTo] = buckets[bFrom].tags[iFrom];
+      buckets[bFrom].tags[iFrom] = 0;
+
+      bTo = bFrom;
+      iTo = iFrom;
+      iStep = steps[iStep].parent;
+   }
+   b = bTo;
+   i = iTo;
+   return true;
+}
+
+/*****************************************
+ * CUCKOO UNORDERED SET :: INSERT
+ * Insert one element into the set
+ ****************************************/
+template <typename T, typename H, typename E, typename A>
+custom::pair<typename cuckoo_unordered_set<T, H, E, A>::iterator, bool>
+   cuckoo_unordered_set<T, H, E, A>::insert(const T& t)
+{
+   // See if the element is already there. If so, then return out.
+   iterator it = find(t);
+   if (it != end())
+      return custom::pair<iterator, bool>(it, false);
+
+   // Grow if the table is full, or if no displacement makes room.
+   uint64_t hash = hashOf(t);
+   if (numElements + 1 > maxLoad(numBuckets))
+      resize(numBuckets == 0 ? 2 : numBuckets * 2);
+   size_t b;
+   size_t i;
+   while (!place(hash, b, i))
+   {
+      // A table this empty that cannot place an element never will:
+      // too many elements share the same two buckets
+      if (numElements < maxLoad(numBuckets) / 8)
+         throw std::runtime_error("cuckoo_unordered_set: too many elements share two buckets, is the hash weak?");
+      resize(numBuckets * 2);
+   }
+
+   // Actually place the new element in the slot.
+   SlotAlloc alloc;
+   std::allocator_traits<SlotAlloc>::construct(alloc, buckets[b].slot(i), t);
+   buckets[b].tags[i] = tagOf(hash);
+   numElements++;
+
+   return custom::pair<iterator, bool>(iteratorAt(b, i), true);
+}
+
+/*****************************************
+ * CUCKOO UNORDERED SET :: ERASE
+ * Remove one element from the set. The slot is
+ * simply empty again: no probe ever passed it
+ ****************************************/
+template <typename T, typename H, typename E, typename A>
+typename cuckoo_unordered_set<T, H, E, A>::iterator cuckoo_unordered_set<T, H, E, A>::erase(const T& t)
+{
+   // Find element to be erased. Return end() if the element is not present.
+   iterator it = find(t);
+   if (it == end())
+      return end();
+
+   // Determine the return value.
+   iterator itReturn = it;
+   ++itReturn;
+
+   // Destroy the element.
+   SlotAlloc alloc;
+   std::allocator_traits<SlotAlloc>::destroy(alloc, it.pBucket->slot(it.iSlot));
+   it.pBucket->tags[it.iSlot] = 0;
+   numElements--;
+
+   // Return iterator to the next element.
+   return itReturn;
+}
+
+/*****************************************
+ * CUCKOO UNORDERED SET :: REHASH
+ * Grow the set to at least numBuckets buckets
+ ****************************************/
+template <typename T, typename H, typename E, typename A>
+void cuckoo_unordered_set<T, H, E, A>::rehash(size_t numBuckets)
+{
+   // never go below what the current elements need
+   size_t minBuckets = (numElements * 20 + 19 * SLOTS - 1) / (19 * SLOTS);
+   size_t newBuckets = numBuckets > minBuckets ? numBuckets : minBuckets;
+
+   // If the current buckets are sufficient, then do nothing.
+   if (newBuckets <= this->numBuckets)
+      return;
+
+   resize(newBuckets);
+}
+
+/*****************************************
+ * CUCKOO UNORDERED SET :: ALLOCATE
+ * A table of newBuckets empty buckets, each on a
+ * boundary of its own alignment
+ ****************************************/
+template <typename T, typename H, typename E, typename A>
+void cuckoo_unordered_set<T, H, E, A>::allocate(size_t newBuckets)
+{
+   RawAlloc alloc;
+   size_t numBytes = newBuckets * sizeof(Bucket) + alignof(Bucket);
+   pRaw = std::allocator_traits<RawAlloc>::allocate(alloc, numBytes);
+   void * p = pRaw;
+   std::align(alignof(Bucket), newBuckets * sizeof(Bucket), p, numBytes);
+   buckets = static_cast<Bucket *>(p);
+   for (size_t b = 0; b < newBuckets; b++)
+      new (buckets + b) Bucket();
+   numBuckets = newBuckets;
+}
+
+/*****************************************
+ * CUCKOO UNORDERED SET :: RESIZE
+ * Move every element into a fresh table of newBuckets
+ * buckets. Should one not fit, the fresh table doubles
+ * before the rest move in
+ ****************************************/
+template <typename T, typename H, typename E, typename A>
+void cuckoo_unordered_set<T, H, E, A>::resize(size_t newBuckets)
+{
+   Bucket *        bucketsOld = buckets;
+   unsigned char * pRawOld    = pRaw;
+   size_t          numOld     = numBuckets;
+
+   // Create the new table with every slot empty.
+   allocate(newBuckets);
+
+   // Move the elements into the new table, one at a time.
+   SlotAlloc slotAlloc;
+   for (size_t bOld = 0; bOld < numOld; bOld++)
+      for (size_t iOld = 0; iOld < SLOTS; iOld++)
+         if (bucketsOld[bOld].tags[iOld] != 0)
+         {
+            T * pOld = bucketsOld[bOld].slot(iOld);
+            uint64_t hash = hashOf(*pOld);
+            size_t b;
+            size_t i;
+            while (!place(hash, b, i))
+               resize(numBuckets * 2);
+            std::allocator_traits<SlotAlloc>::construct(slotAlloc, buckets[b].slot(i), std::move(*pOld));
+            std::allocator_traits<SlotAlloc>::destroy(slotAlloc, pOld);
+            buckets[b].tags[i] = bucketsOld[bOld].tags[iOld];
+         }
+
+   // Release the old table.
+   if (pRawOld != nullptr)
+   {
+      RawAlloc rawAlloc;
+      std::allocator_traits<RawAlloc>::deallocate(rawAlloc, pRawOld, numOld * sizeof(Bucket) + alignof(Bucket));
+   }
+}
+
+/*****************************************
+ * CUCKOO UNORDERED SET :: CLEAR
+ * Destroy every element but keep the table
+ ****************************************/
+template <typename T, typename H, typename E, typename A>
+void cuckoo_unordered_set<T, H, E, A>::clear() noexcept
+{
+   SlotAlloc alloc;
+   for (size_t b = 0; b < numBuckets; b++)
+      for (size_t i = 0; i < SLOTS; i++)
+         if (buckets[b].tags[i] != 0)
+         {
+            std::allocator_traits<SlotAlloc>::destroy(alloc, buckets[b].slot(i));
+            buckets[b].tags[i] = 0;
+         }
+   numElements = 0;
+}
+
+/*****************************************
+ * CUCKOO UNORDERED SET :: DESTROY
+ * Destroy every element and release the table
+ ****************************************/
+template <typename T, typename H, typename E, typename A>
+void cuckoo_unordered_set<T, H, E, A>::destroy() noexcept
+{
+   if (pRaw == nullptr)
+      return;
+
+   clear();
+   RawAlloc alloc;
+   std::allocator_traits<RawAlloc>::deallocate(alloc, pRaw, numBuckets * sizeof(Bucket) + alignof(Bucket));
+   buckets = nullptr;
+   pRaw = nullptr;
+   numBuckets = 0;
+}
+
+/*****************************************
+ * CUCKOO UNORDERED SET :: ASSIGNMENT
+ * Copy the table slot for slot so nothing is hashed again
+ ****************************************/
+template <typename T, typename H, typename E, typename A>
+cuckoo_unordered_set<T, H, E, A>& cuckoo_unordered_set<T, H, E, A>::operator=(const cuckoo_unordered_set& rhs)
+{
+   if (this == &rhs)
+      return *this;
+
+   destroy();
+   hashFunction = rhs.hashFunction;
+   if (rhs.numBuckets == 0)
+      return *this;
+
+   allocate(rhs.numBuckets);
+   SlotAlloc alloc;
+   for (size_t b = 0; b < numBuckets; b++)
+      for (size_t i = 0; i < SLOTS; i++)
+         if (rhs.buckets[b].tags[i] != 0)
+         {
+            std::allocator_traits<SlotAlloc>::construct(alloc, buckets[b].slot(i), *rhs.buckets[b].slot(i));
+            buckets[b].tags[i] = rhs.buckets[b].tags[i];
+         }
+   numElements = rhs.numElements;
+   return *this;
+}
+
+/*****************************************
+ * SWAP
+ * Stand-alone cuckoo unordered set swap
+ ****************************************/
+template <typename T, typename H, typename E, typename A>
+void swap(cuckoo_unordered_set<T, H, E, A>& lhs, cuckoo_unordered_set<T, H, E, A>& rhs)
+{
+   lhs.swap(rhs);
+}
+
+}
@@ -0,0 +1,518 @@
+/***********************************************************************
+ * Header:
+ *    EPOCH HASH
+ * Summary:
+ *    A hash set for data read far more often than it is written.
+ *    Readers take no lock and write no line another thread reads:
+ *    each announces the epoch it read in, in a slot of its own, walks
+ *    chains of atomic links, and clears the slot. Writers take one
+ *    mutex, publish every change with a single atomic store, and
+ *    retire what they unlinked. A retired node or table is freed only
+ *    once every reader that could still hold it has left, which is
+ *    epoch-based reclamation:
+ *       retire(p)        : p is unlinked, tagged with the epoch now
+ *       advance          : the epoch moves on
+ *       reclaim          : free every p tagged before the oldest epoch
+ *                          a reader is still in
+ *
+ *    This will contain the class definition of:
+ *        epoch_domain        : the reader slots and the retired list
+ *        epoch_unordered_set : the set its readers never lock
+ * Author
+ *       Marco Varela &  Andre Regino
+ ************************************************************************/
+
+#pragma once
+
+#include "hashPolicy.h"    // for mix64
+#include <atomic>          // for std::atomic and std::atomic_thread_fence
+#include <cstddef>         // for size_t
+#include <cstdint>         // for uint64_t
+#include <functional>      // for std::hash and std::equal_to
+#include <mutex>           // for std::mutex and std::lock_guard
+#include <utility>         // for std::move
+#include <vector>          // for std::vector of retired pointers
+
+class TestEpochHash;       // forward declaration for EpochHash unit tests
+
+namespace custom
+{
+
+/************************************************
+ * EPOCH THREAD INDEX
+ * A number for this thread below MAX_THREADS, the
+ * same in every epoch_domain, given back when the
+ * thread ends. MAX_THREADS when all are taken.
+ ************************************************/
+const size_t EPOCH_MAX_THREADS = 128;
+
+class epoch_thread_registry
+{
+public:
+   static size_t acquire()
+   {
+      std::lock_guard<std::mutex> lock(mutex());
+      for (size_t i = 0; i < EPOCH_MAX_THREADS; i++)
+         if (!used()[i])
+         {
+            used()[i] = true;
+            return i;
+         }
+      return EPOCH_MAX_THREADS;
+   }
+   static void release(size_t index)
+   {
+      std::lock_guard<std::mutex> lock(mutex());
+      if (index < EPOCH_MAX_THREADS)
+         used()[index] = false;
+   }
+
+private:
+   static std::mutex& mutex()   { static std::mutex m;              return m; }
+   static bool * used()         { static bool u[EPOCH_MAX_THREADS]; return u; }
+};
+
+inline size_t epoch_thread_index()
+{
+   struct Registration
+   {
+      Registration() : index(epoch_thread_registry::acquire()) {}
+      ~Registration() { epoch_thread_registry::release(index); }
+      size_t index;
+   };
+   thread_local Registration registration;
+   return registration.index;
+}
+
+/************************************************
+ * EPOCH DOMAIN
+ * One reader slot for each thread, each on a cache
+ * line of its own, and what the writers retired. A
+ * thread past EPOCH_MAX_THREADS has no slot: enter()
+ * says so and the caller must lock instead.
+ ************************************************/
+class epoch_domain
+{
+   friend class ::TestEpochHash;   // give unit tests access to the privates
+public:
+   epoch_domain() : epoch(1)
+   {
+   }
+   ~epoch_domain()
+   {
+      // no reader may be left, so everything can go
+      for (auto& r : retired)
+         r.destroy(r.p);
+   }
+   epoch_domain(const epoch_domain&) = delete;
+   epoch_domain& operator=(const epoch_domain&) = delete;
+
+   //
+   // Reader: enter, read, leave. Entering again before leaving
+   // is fine, the slot stays announced until the outer leave.
+   //
+   bool enter()
+   {
+      size_t i = epoch_thread_index();
+      if (i == EPOCH_MAX_THREADS)
+         return false;
+      Slot& slot = slots[i];
+      if (slot.depth++ == 0)
+      {
+         slot.epoch.store(epoch.load(std::memory_order_acquire), std::memory_order_relaxed);
+         // the slot is visible before anything the reader loads next
+         std::atomic_thread_fence(std::memory_order_seq_cst);
+      }
+      return true;
+   }
+   void leave()
+   {
+      Slot& slot = slots[epoch_thread_index()];
+      if (--slot.depth == 0)
+         slot.epoch.store(0, std::memory_order_release);
+   }
+
+   //
+   // Writer, holding the writers' lock: retire what was
+   // unlinked, then advance to free what no reader holds
+   //
+   template <class U>
+   void retire(U * p)
+   {
+      retired.push_back(Retired{ epoch.load(std::memory_order_relaxed), p, &destroyAs<U> });
+   }
+   void advance();
+   size_t num_retired() const
+   {
+      return retired.size();
+   }
+
+private:
+   struct alignas(64) Slot
+   {
+      Slot() : epoch(0), depth(0) {}
+      std::atomic<uint64_t> epoch;   // the epoch this reader entered in, 0 when out
+      size_t depth;                  // enters not yet left, only its thread touches it
+   };
+   struct Retired
+   {
+      uint64_t epoch;                // the epoch it was unlinked in
+      void * p;                      // what to free
+      void (*destroy)(void *);       // how to free it
+   };
+   template <class U>
+   static void destroyAs(void * p)
+   {
+      delete static_cast<U *>(p);
+   }
+
+   alignas(64) std::atomic<uint64_t> epoch;   // the current epoch, only writers move it
+   Slot slots[EPOCH_MAX_THREADS];             // one for each reader thread
+   std::vector<Retired> retired;              // unlinked, not yet freed
+};
+
+/*****************************************
+ * EPOCH DOMAIN :: ADVANCE
+ * Move to the next epoch, then free everything
+ * retired before the oldest epoch a reader is in.
+ * A reader that entered after the move sees none
+ * of what was unlinked before it.
+ ****************************************/
+inline void epoch_domain::advance()
+{
+   // the unlinks are visible before any slot is read
+   std::atomic_thread_fence(std::memory_order_seq_cst);
+   epoch.fetch_add(1, std::memory_order_seq_cst);
+
+   uint64_t oldest = ~(uint64_t)0;
+   for (size_t i = 0; i < EPOCH_MAX_THREADS; i++)
+   {
+      uint64_t e = slots[i].epoch.load(std::memory_order_acquire);
+      if (e != 0 && e < oldest)
+         oldest = e;
+   }
+
+   size_t numKept = 0;
+   for (size_t i = 0; i < retired.size(); i++)
+   {
+      if (retired[i].epoch < oldest)
+         retired[i].destroy(retired[i].p);
+      else
+         retired[numKept++] = retired[i];
+   }
+   retired.resize(numKept);
+}
+
+/************************************************
+ * EPOCH UNORDERED SET
+ * A chained hash whose readers never lock. The
+ * bucket count is a power of two and the mixed hash
+ * is masked, so finding a bucket writes nothing.
+ * A rehash copies every element into new nodes of
+ * a new table: a reader still walking the old one
+ * must not be led into another chain.
+ ************************************************/
+template <typename T,
+          typename Hash = std::hash<T>,
+          typename EqPred = std::equal_to<T> >
+class epoch_unordered_set
+{
+   friend class ::TestEpochHash;   // give unit tests access to the privates
+public:
+   //
+   // Construct
+   //
+   epoch_unordered_set() : table(new Table(8)), numElements(0), maxLoadFactor(1)
+   {
+   }
+   epoch_unordered_set(size_t numBuckets, const Hash& hash = Hash()) :
+      table(new Table(powerOfTwo(numBuckets))), numElements(0), maxLoadFactor(1), hashFunction(hash)
+   {
+   }
+   epoch_unordered_set(const epoch_unordered_set& rhs) = delete;
+   epoch_unordered_set& operator=(const epoch_unordered_set& rhs) = delete;
+   ~epoch_unordered_set()
+   {
+      delete table.load(std::memory_order_relaxed);
+   }
+
+   //
+   // Access: no lock, unless this thread has no reader slot
+   //
+   bool contains(const T& t);
+   size_t count(const T& t)
+   {
+      return contains(t) ? 1 : 0;
+   }
+   template <class Callback>
+   void for_each(Callback callback);
+
+   //
+   // Insert: one writer at a time
+   //
+   bool insert(const T& t);
+   void reserve(size_t num);
+
+   //
+   // Remove
+   //
+   size_t erase(const T& t);
+   void clear();
+
+   //
+   // Status
+   //
+   size_t size() const
+   {
+      return numElements.load(std::memory_order_relaxed);
+   }
+   bool empty() const
+   {
+      return size() == 0;
+   }
+   size_t bucket_count() const
+   {
+      return table.load(std::memory_order_acquire)->numBuckets;
+   }
+   float max_load_factor() const
+   {
+      std::lock_guard<std::mutex> lock(writer);
+      return maxLoadFactor;
+   }
+   void max_load_factor(float m)
+   {
+      std::lock_guard<std::mutex> lock(writer);
+      maxLoadFactor = m;
+   }
+   size_t num_retired()
+   {
+      std::lock_guard<std::mutex> lock(writer);
+      return domain.num_retired();
+   }
+   Hash hash_function() const
+   {
+      return hashFunction;
+   }
+
+private:
+   // an element, its hash, and the next node of its chain
+   struct Node
+   {
+      Node(const T& value, size_t hash) : value(value), hash(hash), pNext(nullptr) {}
+      const T value;
+      const size_t hash;
+      std::atomic<Node *> pNext;
+   };
+
+   // the bucket heads; deleting a table deletes its nodes
+   struct Table
+   {
+      Table(size_t numBuckets) : numBuckets(numBuckets), heads(new std::atomic<Node *>[numBuckets])
+      {
+         for (size_t i = 0; i < numBuckets; i++)
+            heads[i].store(nullptr, std::memory_order_relaxed);
+      }
+      ~Table()
+      {
+         for (size_t i = 0; i < numBuckets; i++)
+            for (Node * p = heads[i].load(std::memory_order_relaxed); p; )
+            {
+               Node * pNext = p->pNext.load(std::memory_order_relaxed);
+               delete p;
+               p = pNext;
+            }
+         delete [] heads;
+      }
+      std::atomic<Node *>& bucket(size_t hash)
+      {
+         return heads[(size_t)mix64(hash) & (numBuckets - 1)];
+      }
+      size_t numBuckets;
+      std::atomic<Node *> * heads;
+   };
+
+   static size_t powerOfTwo(size_t num)
+   {
+      size_t numBuckets = 8;
+      while (numBuckets < num)
+         numBuckets *= 2;
+      return numBuckets;
+   }
+
+   // the reader's walk, in a table it holds
+   bool containsIn(Table * pTable, const T& t, size_t hash) const
+   {
+      for (Node * p = pTable->bucket(hash).load(std::memory_order_acquire); p;
+           p = p->pNext.load(std::memory_order_acquire))
+         if (p->hash == hash && EqPred()(p->value, t))
+            return true;
+      return false;
+   }
+
+   // the writer's, who holds the lock and sees every link
+   bool containsWriter(const T& t, size_t hash)
+   {
+      return containsIn(table.load(std::memory_order_relaxed), t, hash);
+   }
+   void rehashLocked(size_t numBuckets);
+
+   std::atomic<Table *> table;          // published whole, read without a lock
+   std::atomic<size_t> numElements;     // written under the lock, read anywhere
+   float maxLoadFactor;                 // the ratio of elements to buckets signifying a rehash
+   Hash hashFunction;                   // read by every thread, written by none
+   mutable std::mutex writer;           // one writer at a time
+   epoch_domain domain;                 // the readers and what they may still hold
+};
+
+/*****************************************
+ * EPOCH UNORDERED SET :: CONTAINS
+ * Announce the epoch, walk the chain, leave
+ ****************************************/
+template <typename T, typename H, typename E>
+bool epoch_unordered_set<T, H, E>::contains(const T& t)
+{
+   size_t hash = hashFunction(t);
+   if (!domain.enter())
+   {
+      std::lock_guard<std::mutex> lock(writer);
+      return containsWriter(t, hash);
+   }
+   bool found = containsIn(table.load(std::memory_order_acquire), t, hash);
+   domain.leave();
+   return found;
+}
+
+/*****************************************
+ * EPOCH UNORDERED SET :: FOR EACH
+ * Call callback on every element of the table as
+ * it was when the walk began, or as changed since
+ ****************************************/
+template <typename T, typename H, typename E>
+template <class Callback>
+void epoch_unordered_set<T, H, E>::for_each(Callback callback)
+{
+   bool entered = domain.enter();
+   std::unique_lock<std::mutex> lock(writer, std::defer_lock);
+   if (!entered)
+      lock.lock();
+
+   Table * pTable = table.load(std::memory_order_acquire);
+   for (size_t i = 0; i < pTable->numBuckets; i++)
+      for (Node * p = pTable->heads[i].load(std::memory_order_acquire); p;
+           p = p->pNext.load(std::memory_order_acquire))
+         callback(p->value);
+
+   if (entered)
+      domain.leave();
+}
+
+/*****************************************
+ * EPOCH UNORDERED SET :: INSERT
+ * A new node goes on the front of its chain, whole
+ * before the one store that links it in
+ ****************************************/
+template <typename T, typename H, typename E>
+bool epoch_unordered_set<T, H, E>::insert(const T& t)
+{
+   size_t hash = hashFunction(t);
+   std::lock_guard<std::mutex> lock(writer);
+   if (containsWriter(t, hash))
+      return false;
+
+   size_t num = numElements.load(std::memory_order_relaxed) + 1;
+   Table * pTable = table.load(std::memory_order_relaxed);
+   if ((float)num > maxLoadFactor * (float)pTable->numBuckets)
+   {
+      rehashLocked(pTable->numBuckets * 2);
+      pTable = table.load(std::memory_order_relaxed);
+   }
+
+   Node * pNode = new Node(t, hash);
+   std::atomic<Node *>& head = pTable->bucket(hash);
+   pNode->pNext.store(head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+   head.store(pNode, std::memory_order_release);
+   numElements.store(num, std::memory_order_relaxed);
+   return true;
+}
+
+/*****************************************
+ * EPOCH UNORDERED SET :: RESERVE
+ * Room for num elements without a rehash
+ ****************************************/
+template <typename T, typename H, typename E>
+void epoch_unordered_set<T, H, E>::reserve(size_t num)
+{
+   std::lock_guard<std::mutex> lock(writer);
+   size_t numBuckets = powerOfTwo((size_t)((float)num / maxLoadFactor) + 1);
+   if (numBuckets > table.load(std::memory_order_relaxed)->numBuckets)
+      rehashLocked(numBuckets);
+}
+
+/*****************************************
+ * EPOCH UNORDERED SET :: ERASE
+ * Link past the node, then retire it. A reader
+ * standing on it still finds the rest of the chain.
+ ****************************************/
+template <typename T, typename H, typename E>
+size_t epoch_unordered_set<T, H, E>::erase(const T& t)
+{
+   size_t hash = hashFunction(t);
+   std::lock_guard<std::mutex> lock(writer);
+
+   std::atomic<Node *> * pLink = &table.load(std::memory_order_relaxed)->bucket(hash);
+   for (Node * p = pLink->load(std::memory_order_relaxed); p;
+        pLink = &p->pNext, p = pLink->load(std::memory_order_relaxed))
+   {
+      if (p->hash == hash && E()(p->value, t))
+      {
+         pLink->store(p->pNext.load(std::memory_order_relaxed), std::memory_order_release);
+         numElements.store(numElements.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+         domain.retire(p);
+         domain.advance();
+         return 1;
+      }
+   }
+   return 0;
+}
+
+/*****************************************
+ * EPOCH UNORDERED SET :: CLEAR
+ * Publish an empty table and retire the full one
+ ****************************************/
+template <typename T, typename H, typename E>
+void epoch_unordered_set<T, H, E>::clear()
+{
+   std::lock_guard<std::mutex> lock(writer);
+   Table * pOld = table.load(std::memory_order_relaxed);
+   table.store(new Table(8), std::memory_order_release);
+   numElements.store(0, std::memory_order_relaxed);
+   domain.retire(pOld);
+   domain.advance();
+}
+
+/*****************************************
+ * EPOCH UNORDERED SET :: REHASH LOCKED
+ * Copy every element into a new table, publish it,
+ * and retire the old table with all its nodes
+ ****************************************/
+template <typename T, typename H, typename E>
+void epoch_unordered_set<T, H, E>::rehashLocked(size_t numBuckets)
+{
+   Table * pOld = table.load(std::memory_order_relaxed);
+   Table * pNew = new Table(powerOfTwo(numBuckets));
+   for (size_t i = 0; i < pOld->numBuckets; i++)
+      for (Node * p = pOld->heads[i].load(std::memory_order_relaxed); p;
+           p = p->pNext.load(std::memory_order_relaxed))
+      {
+         Node * pNode = new Node(p->value, p->hash);
+         std::atomic<Node *>& head = pNew->bucket(p->hash);
+         pNode->pNext.store(head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+         head.store(pNode, std::memory_order_relaxed);
+      }
+
+   table.store(pNew, std::memory_order_release);
+   domain.retire(pOld);
+   domain.advance();
+}
+
+}
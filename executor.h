@@ -0,0 +1,140 @@
+/***********************************************************************
+ * Header:
+ *    EXECUTOR
+ * Summary:
+ *    Runs a batch of independent tasks for the containers that can
+ *    split up their work, such as a parallel rehash. An executor is
+ *    anything with these two members:
+ *       size_t concurrency() const           : how many tasks to split into
+ *       void run(size_t numTasks, Task task) : call task(i) for every i in
+ *                                              [0, numTasks), return when
+ *                                              they are all done
+ *
+ *    This will contain the class definition of:
+ *        inline_executor : every task in turn on the calling thread
+ *        thread_executor : each task on its own std::thread
+ * Author
+ *       Marco Varela &  Andre Regino
+ ************************************************************************/
+
+#pragma once
+
+#include <cstddef>      // for size_t
+#include <exception>    // for std::exception_ptr
+#include <system_error> // for std::system_error when a thread cannot start
+#include <thread>       // for std::thread
+#include <vector>       // for std::vector of threads
+
+class TestExecutor;     // forward declaration for Executor unit tests
+
+namespace custom
+{
+
+/************************************************
+ * INLINE EXECUTOR
+ * Run the tasks one after another on this thread.
+ * The work is split the same way, so it is the
+ * reference a parallel run is checked against.
+ ************************************************/
+class inline_executor
+{
+public:
+   inline_executor(size_t numTasks = 1) : numTasks(numTasks ? numTasks : 1)
+   {
+   }
+   size_t concurrency() const
+   {
+      return numTasks;
+   }
+   template <class Task>
+   void run(size_t numTasks, Task task)
+   {
+      for (size_t i = 0; i < numTasks; i++)
+         task(i);
+   }
+
+private:
+   size_t numTasks;   // how many tasks the work is split into
+};
+
+/************************************************
+ * THREAD EXECUTOR
+ * Run each task on its own thread, the first one
+ * on the calling thread, and join them all. The
+ * first exception a task throws is rethrown here
+ * once every thread is done.
+ ************************************************/
+class thread_executor
+{
+   friend class ::TestExecutor;   // give unit tests access to the privates
+public:
+   thread_executor() : numThreads(std::thread::hardware_concurrency())
+   {
+      if (numThreads == 0)
+         numThreads = 1;
+   }
+   thread_executor(size_t numThreads) : numThreads(numThreads ? numThreads : 1)
+   {
+   }
+   size_t concurrency() const
+   {
+      return numThreads;
+   }
+   template <class Task>
+   void run(size_t numTasks, Task task);
+
+private:
+   size_t numThreads;   // how many tasks the work is split into
+};
+
+/*****************************************
+ * THREAD EXECUTOR :: RUN
+ * Call task(i) for every i in [0, numTasks). When
+ * no more threads can be made, the tasks that have
+ * none run on the calling thread instead.
+ ****************************************/
+template <class Task>
+void thread_executor::run(size_t numTasks, Task task)
+{
+   if (numTasks == 0)
+      return;
+
+   // one error slot per task, so no task waits on another to report
+   std::vector<std::exception_ptr> errors(numTasks);
+   auto runTask = [&task, &errors](size_t i)
+   {
+      try
+      {
+         task(i);
+      }
+      catch (...)
+      {
+         errors[i] = std::current_exception();
+      }
+   };
+
+   // reserved up front, so only the thread itself can fail to start
+   std::vector<std::thread> threads;
+   threads.reserve(numTasks - 1);
+   size_t iInline = 1;
+   try
+   {
+      for (; iInline < numTasks; iInline++)
+         threads.emplace_back(runTask, iInline);
+   }
+   catch (const std::system_error&)
+   {
+   }
+
+   runTask(0);
+   for (; iInline < numTasks; iInline++)
+      runTask(iInline);
+   for (auto& thread : threads)
+      thread.join();
+
+   for (auto& error : errors)
+      if (error)
+         std::rethrow_exception(error);
+}
+
+}
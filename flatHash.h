@@ -0,0 +1,679 @@
+/***********************************************************************
+ * Header:
+ *    FLAT HASH
+ * Summary:
+ *    An open-addressing sibling of custom::unordered_set. Every element
+ *    lives in one flat array of slots with a parallel array of one-byte
+ *    control tags. A lookup compares 16 tags at a time (SSE2 when the
+ *    compiler offers it) and only touches the slots whose tag matches.
+ *
+ *    This will contain the class definition of:
+ *        control_group                : 16 control bytes probed at once
+ *        flat_unordered_set           : A hash set in one flat array
+ *        flat_unordered_set::iterator : An iterator through the set
+ * Author
+ *       Marco Varela &  Andre Regino
+ ************************************************************************/
+
+#pragma once
+
+#include "pair.h"       // for custom::pair returned from insert
+#include <memory>       // for std::allocator
+#include <functional>   // for std::hash and std::equal_to
+#include <cstdint>      // for int8_t, uint32_t, and uint64_t
+#include <cstring>      // for std::memset and std::memcpy
+#include <utility>      // for std::move and std::swap
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>  // for the 16-wide control byte compares
+#define CUSTOM_FLAT_HASH_SSE2
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>     // for _BitScanForward and _BitScanReverse
+#endif
+
+class TestFlatHash;     // forward declaration for FlatHash unit tests
+
+namespace custom
+{
+
+/************************************************
+ * CONTROL GROUP
+ * A window of 16 control bytes. A full slot holds
+ * the low 7 bits of its hash (0b0hhhhhhh), so one
+ * compare finds every candidate in the window.
+ ************************************************/
+class control_group
+{
+public:
+   static const size_t WIDTH   = 16;     // number of control bytes in a group
+   static const int8_t EMPTY   = -128;   // 0b10000000 : never been used
+   static const int8_t DELETED = -2;     // 0b11111110 : a tombstone left by erase
+
+   control_group(const int8_t * pos)
+   {
+#ifdef CUSTOM_FLAT_HASH_SSE2
+      ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pos));
+#else
+      std::memcpy(ctrl, pos, WIDTH);
+#endif
+   }
+
+   // a bit for every slot whose tag is h2
+   uint32_t match(int8_t h2) const
+   {
+#ifdef CUSTOM_FLAT_HASH_SSE2
+      return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl));
+#else
+      uint32_t mask = 0;
+      for (size_t i = 0; i < WIDTH; i++)
+         if (ctrl[i] == h2)
+            mask |= (uint32_t)1 << i;
+      return mask;
+#endif
+   }
+
+   // a bit for every slot that has never been used
+   uint32_t matchEmpty() const
+   {
+      return match(EMPTY);
+   }
+
+   // a bit for every slot that is available for an insert
+   uint32_t matchEmptyOrDeleted() const
+   {
+#ifdef CUSTOM_FLAT_HASH_SSE2
+      // both EMPTY and DELETED are less than -1, full tags are not
+      return (uint32_t)_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-1), ctrl));
+#else
+      uint32_t mask = 0;
+      for (size_t i = 0; i < WIDTH; i++)
+         if (ctrl[i] < -1)
+            mask |= (uint32_t)1 << i;
+      return mask;
+#endif
+   }
+
+   // index of the lowest set bit. The mask must not be zero
+   static size_t lowestBit(uint32_t mask)
+   {
+#if defined(_MSC_VER)
+      unsigned long index;
+      _BitScanForward(&index, mask);
+      return (size_t)index;
+#else
+      return (size_t)__builtin_ctz(mask);
+#endif
+   }
+
+   // number of clear bits above the highest set bit of a 16 bit mask
+   static size_t leadingZeros(uint32_t mask)
+   {
+      if (mask == 0)
+         return WIDTH;
+#if defined(_MSC_VER)
+      unsigned long index;
+      _BitScanReverse(&index, mask);
+      return WIDTH - 1 - (size_t)index;
+#else
+      return (size_t)__builtin_clz(mask) - (32 - WIDTH);
+#endif
+   }
+
+private:
+#ifdef CUSTOM_FLAT_HASH_SSE2
+   __m128i ctrl;
+#else
+   int8_t ctrl[WIDTH];
+#endif
+};
+
+/************************************************
+ * FLAT UNORDERED SET
+ * A set implemented as an open-addressing hash
+ ************************************************/
+template <typename T,
+          typename Hash = std::hash<T>,
+          typename EqPred = std::equal_to<T>,
+          typename A = std::allocator<T> >
+class flat_unordered_set
+{
+   friend class ::TestFlatHash;   // give unit tests access to the privates
+public:
+   //
+   // Construct
+   //
+   flat_unordered_set() : ctrl(nullptr), slots(nullptr),
+      numCapacity(0), numElements(0), numGrowth(0)
+   {
+   }
+   flat_unordered_set(size_t numBuckets) : flat_unordered_set()
+   {
+      rehash(numBuckets);
+   }
+   flat_unordered_set(const flat_unordered_set& rhs) : flat_unordered_set()
+   {
+      *this = rhs;
+   }
+   flat_unordered_set(flat_unordered_set&& rhs) noexcept : flat_unordered_set()
+   {
+      swap(rhs);
+   }
+   template <class Iterator>
+   flat_unordered_set(Iterator first, Iterator last) : flat_unordered_set()
+   {
+      while (first != last)
+         insert(*first++);
+   }
+   flat_unordered_set(const std::initializer_list<T>& il) : flat_unordered_set()
+   {
+      insert(il);
+   }
+   ~flat_unordered_set()
+   {
+      destroy();
+   }
+
+   //
+   // Assign
+   //
+   flat_unordered_set& operator=(const flat_unordered_set& rhs);
+   flat_unordered_set& operator=(flat_unordered_set&& rhs) noexcept
+   {
+      clear();
+      swap(rhs);
+      return *this;
+   }
+   flat_unordered_set& operator=(const std::initializer_list<T>& il)
+   {
+      clear();
+      insert(il);
+      return *this;
+   }
+   void swap(flat_unordered_set& rhs) noexcept
+   {
+      std::swap(ctrl,        rhs.ctrl);
+      std::swap(slots,       rhs.slots);
+      std::swap(numCapacity, rhs.numCapacity);
+      std::swap(numElements, rhs.numElements);
+      std::swap(numGrowth,   rhs.numGrowth);
+   }
+
+   //
+   // Iterator
+   //
+   class iterator;
+   iterator begin()
+   {
+      iterator it(ctrl, slots, ctrl + numCapacity);
+      it.skipEmpty();
+      return it;
+   }
+   iterator end()
+   {
+      return iterator(ctrl + numCapacity, slots + numCapacity, ctrl + numCapacity);
+   }
+
+   //
+   // Access
+   //
+   iterator find(const T& t)
+   {
+      size_t i = findIndex(t, hashOf(t));
+      return (i == numCapacity) ? end() : iteratorAt(i);
+   }
+
+   //
+   // Insert
+   //
+   custom::pair<iterator, bool> insert(const T& t);
+   void insert(const std::initializer_list<T>& il)
+   {
+      reserve(numElements + il.size());
+      for (auto& t : il)
+         insert(t);
+   }
+   void rehash(size_t numBuckets);
+   void reserve(size_t num)
+   {
+      // enough slots that num elements stay under the 7/8 load factor
+      rehash((num * 8 + 6) / 7);
+   }
+
+   //
+   // Remove
+   //
+   void clear() noexcept;
+   iterator erase(const T& t);
+
+   //
+   // Status
+   //
+   size_t size() const
+   {
+      return numElements;
+   }
+   bool empty() const
+   {
+      return size() == 0;
+   }
+   size_t bucket_count() const
+   {
+      return numCapacity;
+   }
+   float load_factor() const noexcept
+   {
+      return numCapacity == 0 ? (float)0.0 : (float)numElements / (float)numCapacity;
+   }
+   float max_load_factor() const noexcept
+   {
+      return (float)0.875;
+   }
+
+private:
+   typedef typename std::allocator_traits<A>::template rebind_alloc<T>      SlotAlloc;
+   typedef typename std::allocator_traits<A>::template rebind_alloc<int8_t> CtrlAlloc;
+
+   // the most elements a table of this capacity holds: 7/8 full
+   static size_t maxLoad(size_t capacity)
+   {
+      return capacity - capacity / 8;
+   }
+
+   // smallest power of two capacity, at least one group, holding num slots
+   static size_t normalize(size_t num)
+   {
+      size_t capacity = control_group::WIDTH;
+      while (capacity < num)
+         capacity *= 2;
+      return capacity;
+   }
+
+   // spread the bits so identity hashes such as std::hash<int> probe well
+   size_t hashOf(const T& t) const
+   {
+      Hash hashFunction;
+      uint64_t h = (uint64_t)hashFunction(t);
+      h ^= h >> 33;
+      h *= 0xff51afd7ed558ccdULL;
+      h ^= h >> 33;
+      return (size_t)h;
+   }
+   static size_t h1(size_t hash) { return hash >> 7;            }
+   static int8_t h2(size_t hash) { return (int8_t)(hash & 0x7F); }
+
+   // set a control byte, keeping the mirrored tail in step with the head
+   void setCtrl(size_t i, int8_t h)
+   {
+      ctrl[i] = h;
+      if (i < control_group::WIDTH - 1)
+         ctrl[numCapacity + i] = h;
+   }
+
+   iterator iteratorAt(size_t i)
+   {
+      return iterator(ctrl + i, slots + i, ctrl + numCapacity);
+   }
+
+   size_t findIndex(const T& t, size_t hash) const;
+   size_t findFirstNonFull(size_t hash) const;
+   void resize(size_t newCapacity);
+   void destroy() noexcept;
+
+   int8_t * ctrl;         // numCapacity + WIDTH tags, the tail mirrors the head
+   T *      slots;        // numCapacity slots, only the full ones are constructed
+   size_t   numCapacity;  // number of slots, zero or a power of two
+   size_t   numElements;  // number of full slots
+   size_t   numGrowth;    // number of empty slots we may fill before a rehash
+};
+
+
+/************************************************
+ * FLAT UNORDERED SET ITERATOR
+ * Iterator for a flat unordered set
+ ************************************************/
+template <typename T, typename H, typename E, typename A>
+class flat_unordered_set <T, H, E, A> ::iterator
+{
+   friend class ::TestFlatHash;   // give unit tests access to the privates
+   template <typename TT, typename HH, typename EE, typename AA>
+   friend class custom::flat_unordered_set;
+public:
+   //
+   // Construct
+   //
+   iterator() : pCtrl(nullptr), pSlot(nullptr), pCtrlEnd(nullptr)
+   {
+   }
+   iterator(int8_t * pCtrl, T * pSlot, int8_t * pCtrlEnd) :
+      pCtrl(pCtrl), pSlot(pSlot), pCtrlEnd(pCtrlEnd)
+   {
+   }
+
+   //
+   // Compare
+   //
+   bool operator != (const iterator& rhs) const { return pCtrl != rhs.pCtrl; }
+   bool operator == (const iterator& rhs) const { return pCtrl == rhs.pCtrl; }
+
+   //
+   // Access
+   //
+   T& operator * ()
+   {
+      return *pSlot;
+   }
+
+   //
+   // Arithmetic
+   //
+   iterator& operator ++ ()
+   {
+      ++pCtrl;
+      ++pSlot;
+      skipEmpty();
+      return *this;
+   }
+   iterator operator ++ (int postfix)
+   {
+      iterator temp(*this);
+      ++(*this);
+      return temp;
+   }
+
+private:
+   // advance past empty slots and tombstones
+   void skipEmpty()
+   {
+      while (pCtrl != pCtrlEnd && *pCtrl < 0)
+      {
+         ++pCtrl;
+         ++pSlot;
+      }
+   }
+
+   int8_t * pCtrl;     // control byte of the current slot
+   T *      pSlot;     // the current slot
+   int8_t * pCtrlEnd;  // one past the last control byte
+};
+
+
+/*****************************************
+ * FLAT UNORDERED SET :: FIND INDEX
+ * Walk the probe sequence one group at a time.
+ * Return numCapacity when the element is missing
+ ****************************************/
+template <typename T, typename H, typename E, typename A>
+size_t flat_unordered_set<T, H, E, A>::findIndex(const T& t, size_t hash) const
+{
+   if (numCapacity == 0)
+      return numCapacity;
+
+   E equal;
+   size_t mask = numCapacity - 1;
+   size_t pos  = h1(hash) & mask;
+   size_t step = 0;
+   while (true)
+   {
+      // compare only the slots whose tag matches
+      control_group group(ctrl + pos);
+      for (uint32_t bits = group.match(h2(hash)); bits; bits &= bits - 1)
+      {
+         size_t i = (pos + control_group::lowestBit(bits)) & mask;
+         if (equal(slots[i], t))
+            return i;
+      }
+
+      // an empty slot ends every probe sequence that passed through here
+      if (group.matchEmpty())
+         return numCapacity;
+
+      // triangular probing visits every group of a power of two table
+      step += control_group::WIDTH;
+      pos = (pos + step) & mask;
+   }
+}
+
+/*****************************************
+ * FLAT UNORDERED SET :: FIND FIRST NON FULL
+ * The first empty or deleted slot on the probe sequence
+ ****************************************/
+template <typename T, typename H, typename E, typename A>
+size_t flat_unordered_set<T, H, E, A>::findFirstNonFull(size_t hash) const
+{
+   size_t mask = numCapacity - 1;
+   size_t pos  = h1(hash) & mask;
+   size_t step = 0;
+   while (true)
+   {
+      uint32_t bits = control_group(ctrl + pos).matchEmptyOrDeleted();
+      if (bits)
+         return (pos + control_group::lowestBit(bits)) & mask;
+      step += control_group::WIDTH;
+      pos = (pos + step) & mask;
+   }
+}
+
+/*****************************************
+ * FLAT UNORDERED SET :: INSERT
+ * Insert one element into the set
+ ****************************************/
+template <typename T, typename H, typename E, typename A>
+custom::pair<typename flat_unordered_set<T, H, E, A>::iterator, bool>
+   flat_unordered_set<T, H, E, A>::insert(const T& t)
+{
+   // See if the element is already there. If so, then return out.
+   size_t hash = hashOf(t);
+   size_t i = findIndex(t, hash);
+   if (i != numCapacity)
+      return custom::pair<iterator, bool>(iteratorAt(i), false);
+
+   // Grow (or sweep out tombstones) if we would fill the last empty slot.
+   if (numCapacity == 0)
+      resize(control_group::WIDTH);
+   i = findFirstNonFull(hash);
+   if (numGrowth == 0 && ctrl[i] == control_group::EMPTY)
+   {
+      resize(numElements * 32 <= numCapacity * 25 ? numCapacity : numCapacity * 2);
+      i = findFirstNonFull(hash);
+   }
+
+   // Actually place the new element in the slot.
+   SlotAlloc alloc;
+   std::allocator_traits<SlotAlloc>::construct(alloc, slots + i, t);
+   if (ctrl[i] == control_group::EMPTY)
+      numGrowth--;
+   setCtrl(i, h2(hash));
+   numElements++;
+
+   return custom::pair<iterator, bool>(iteratorAt(i), true);
+}
+
+/*****************************************
+ * FLAT UNORDERED SET :: ERASE
+ * Remove one element from the set
+ ****************************************/
+template <typename T, typename H, typename E, typename A>
+typename flat_unordered_set<T, H, E, A>::iterator flat_unordered_set<T, H, E, A>::erase(const T& t)
+{
+   // Find element to be erased. Return end() if the element is not present.
+   size_t i = findIndex(t, hashOf(t));
+   if (i == numCapacity)
+      return end();
+
+   // Determine the return value.
+   iterator itReturn = iteratorAt(i);
+   ++itReturn;
+
+   // Destroy the element.
+   SlotAlloc alloc;
+   std::allocator_traits<SlotAlloc>::destroy(alloc, slots + i);
+   numElements--;
+
+   // If every group holding this slot also holds an empty slot, no probe
+   // sequence ever walked past it, so it can go back to empty. Otherwise
+   // it must become a tombstone so later lookups keep probing.
+   size_t mask = numCapacity - 1;
+   uint32_t emptyBefore = control_group(ctrl + ((i - control_group::WIDTH) & mask)).matchEmpty();
+   uint32_t emptyAfter  = control_group(ctrl + i).matchEmpty();
+   if (emptyBefore && emptyAfter &&
+       control_group::lowestBit(emptyAfter) + control_group::leadingZeros(emptyBefore) < control_group::WIDTH)
+   {
+      setCtrl(i, control_group::EMPTY);
+      numGrowth++;
+   }
+   else
+      setCtrl(i, control_group::DELETED);
+
+   // Return iterator to the next element.
+   return itReturn;
+}
+
+/*****************************************
+ * FLAT UNORDERED SET :: REHASH
+ * Grow the set to at least numBuckets slots
+ ****************************************/
+template <typename T, typename H, typename E, typename A>
+void flat_unordered_set<T, H, E, A>::rehash(size_t numBuckets)
+{
+   // never go below what the current elements need
+   size_t minBuckets = (numElements * 8 + 6) / 7;
+   size_t newCapacity = normalize(numBuckets > minBuckets ? numBuckets : minBuckets);
+
+   // If the current capacity is sufficient, then do nothing.
+   if (newCapacity <= numCapacity)
+      return;
+
+   resize(newCapacity);
+}
+
+/*****************************************
+ * FLAT UNORDERED SET :: RESIZE
+ * Move every element into a fresh table of newCapacity slots.
+ * This also drops every tombstone
+ ****************************************/
+template <typename T, typename H, typename E, typename A>
+void flat_unordered_set<T, H, E, A>::resize(size_t newCapacity)
+{
+   int8_t * ctrlOld     = ctrl;
+   T *      slotsOld    = slots;
+   size_t   capacityOld = numCapacity;
+
+   // Create the new table with every slot empty. The set keeps the
+   // old one until both arrays are allocated.
+   CtrlAlloc ctrlAlloc;
+   SlotAlloc slotAlloc;
+   int8_t * ctrlNew = std::allocator_traits<CtrlAlloc>::allocate(ctrlAlloc, newCapacity + control_group::WIDTH);
+   T * slotsNew;
+   try
+   {
+      slotsNew = std::allocator_traits<SlotAlloc>::allocate(slotAlloc, newCapacity);
+   }
+   catch (...)
+   {
+      std::allocator_traits<CtrlAlloc>::deallocate(ctrlAlloc, ctrlNew, newCapacity + control_group::WIDTH);
+      throw;
+   }
+   std::memset(ctrlNew, control_group::EMPTY, newCapacity + control_group::WIDTH);
+   ctrl = ctrlNew;
+   slots = slotsNew;
+   numCapacity = newCapacity;
+
+   // Move the elements into the new table, one at a time.
+   for (size_t i = 0; i < capacityOld; i++)
+      if (ctrlOld[i] >= 0)
+      {
+         size_t hash = hashOf(slotsOld[i]);
+         size_t iNew = findFirstNonFull(hash);
+         std::allocator_traits<SlotAlloc>::construct(slotAlloc, slots + iNew, std::move(slotsOld[i]));
+         std::allocator_traits<SlotAlloc>::destroy(slotAlloc, slotsOld + i);
+         setCtrl(iNew, h2(hash));
+      }
+   numGrowth = maxLoad(numCapacity) - numElements;
+
+   // Release the old table.
+   if (ctrlOld != nullptr)
+   {
+      std::allocator_traits<CtrlAlloc>::deallocate(ctrlAlloc, ctrlOld, capacityOld + control_group::WIDTH);
+      std::allocator_traits<SlotAlloc>::deallocate(slotAlloc, slotsOld, capacityOld);
+   }
+}
+
+/*****************************************
+ * FLAT UNORDERED SET :: CLEAR
+ * Destroy every element but keep the table
+ ****************************************/
+template <typename T, typename H, typename E, typename A>
+void flat_unordered_set<T, H, E, A>::clear() noexcept
+{
+   if (numCapacity == 0)
+      return;
+
+   SlotAlloc alloc;
+   for (size_t i = 0; i < numCapacity; i++)
+      if (ctrl[i] >= 0)
+         std::allocator_traits<SlotAlloc>::destroy(alloc, slots + i);
+   std::memset(ctrl, control_group::EMPTY, numCapacity + control_group::WIDTH);
+   numElements = 0;
+   numGrowth = maxLoad(numCapacity);
+}
+
+/*****************************************
+ * FLAT UNORDERED SET :: DESTROY
+ * Destroy every element and release the table
+ ****************************************/
+template <typename T, typename H, typename E, typename A>
+void flat_unordered_set<T, H, E, A>::destroy() noexcept
+{
+   if (numCapacity == 0)
+      return;
+
+   clear();
+   CtrlAlloc ctrlAlloc;
+   SlotAlloc slotAlloc;
+   std::allocator_traits<CtrlAlloc>::deallocate(ctrlAlloc, ctrl, numCapacity + control_group::WIDTH);
+   std::allocator_traits<SlotAlloc>::deallocate(slotAlloc, slots, numCapacity);
+   ctrl = nullptr;
+   slots = nullptr;
+   numCapacity = numElements = numGrowth = 0;
+}
+
+/*****************************************
+ * FLAT UNORDERED SET :: ASSIGNMENT
+ * Copy the table slot for slot so nothing is hashed again
+ ****************************************/
+template <typename T, typename H, typename E, typename A>
+flat_unordered_set<T, H, E, A>& flat_unordered_set<T, H, E, A>::operator=(const flat_unordered_set& rhs)
+{
+   if (this == &rhs)
+      return *this;
+
+   destroy();
+   if (rhs.numCapacity == 0)
+      return *this;
+
+   CtrlAlloc ctrlAlloc;
+   SlotAlloc slotAlloc;
+   ctrl  = std::allocator_traits<CtrlAlloc>::allocate(ctrlAlloc, rhs.numCapacity + control_group::WIDTH);
+   slots = std::allocator_traits<SlotAlloc>::allocate(slotAlloc, rhs.numCapacity);
+   std::memcpy(ctrl, rhs.ctrl, rhs.numCapacity + control_group::WIDTH);
+   numCapacity = rhs.numCapacity;
+   for (size_t i = 0; i < numCapacity; i++)
+      if (ctrl[i] >= 0)
+         std::allocator_traits<SlotAlloc>::construct(slotAlloc, slots + i, rhs.slots[i]);
+   numElements = rhs.numElements;
+   numGrowth   = rhs.numGrowth;
+   return *this;
+}
+
+/*****************************************
+ * SWAP
+ * Stand-alone flat unordered set swap
+ ****************************************/
+template <typename T, typename H, typename E, typename A>
+void swap(flat_unordered_set<T, H, E, A>& lhs, flat_unordered_set<T, H, E, A>& rhs)
+{
+   lhs.swap(rhs);
+}
+
+}
@@ -0,0 +1,500 @@
+/***********************************************************************
+ * Header:
+ *    FROZEN HASH
+ * Summary:
+ *    An immutable set for keys known up front, placed by a minimal
+ *    perfect hash in the style of PTHash. n keys fill exactly n slots
+ *    of one array: no chains, no empty slots. A find is one hash, one
+ *    small pilot read, one key read and one compare:
+ *       h     = mix64(hash(t))
+ *       part  = the partition the high bits of h pick
+ *       pilot = pilots[the bucket of h within part]
+ *       slot  = mix64(h ^ pilot) scaled to the keys of part
+ *    Building tries pilots 0, 1, 2 ... for each bucket, biggest
+ *    bucket first, until its keys all land on free slots. The buckets
+ *    are skewed, as PTHash does, so most keys are placed early. Every
+ *    partition is built on its own, so an executor builds them in
+ *    parallel, and the result is the same however many ran.
+ *
+ *    Saved, the file is:
+ *       frozen_header                  : what the keys are and how many
+ *       frozen_partition[numParts + 1] : where each partition starts
+ *       uint32_t[numBuckets]           : the pilots
+ *       T[numElements]                 : the keys, in their slots
+ *    and load maps it back in place, as mapped_unordered_set does.
+ *
+ *    This will contain the class definition of:
+ *        frozen_header    : the first bytes of the file
+ *        frozen_partition : the first key and bucket of a partition
+ *        frozen_set       : the set
+ * Author
+ *       Marco Varela &  Andre Regino
+ ************************************************************************/
+
+#pragma once
+
+#include "hashPolicy.h"   // for mix64 and mulhi64
+#include "mappedHash.h"   // for map_file, unmap_file and snapshot_header::ENDIAN
+#include "executor.h"     // for the parallel build
+#include <algorithm>      // for std::sort
+#include <cstddef>        // for size_t
+#include <cstdint>        // for uint32_t and uint64_t
+#include <cstring>        // for std::memcmp and std::memcpy
+#include <fstream>        // for std::ofstream
+#include <functional>     // for std::hash and std::equal_to
+#include <stdexcept>      // for std::runtime_error
+#include <string>         // for std::string in error messages
+#include <type_traits>    // for std::is_trivially_copyable
+#include <utility>        // for std::swap and std::move
+#include <vector>         // for std::vector of keys and pilots
+
+class TestFrozenHash;     // forward declaration for FrozenHash unit tests
+
+namespace custom
+{
+
+/************************************************
+ * FROZEN HEADER
+ * The start of a saved frozen_set
+ ************************************************/
+struct frozen_header
+{
+   static const uint32_t VERSION = 1;
+
+   char     magic[8];        // "CUSTMPH" and a null
+   uint32_t version;         // VERSION when written
+   uint32_t endian;          // snapshot_header::ENDIAN as the writer stored it
+   uint32_t keySize;         // sizeof(T)
+   uint32_t keyAlign;        // alignof(T)
+   uint64_t numElements;     // keys in the file
+   uint64_t numPartitions;   // entries in the partition array, less one
+   uint64_t numBuckets;      // pilots in the file
+   uint64_t keysOffset;      // from the start of the file to the first key
+};
+
+/************************************************
+ * FROZEN PARTITION
+ * Partition p has keys [firstKey, next.firstKey)
+ * and pilots [firstBucket, next.firstBucket)
+ ************************************************/
+struct frozen_partition
+{
+   uint64_t firstKey;
+   uint64_t firstBucket;
+};
+
+/*****************************************************
+ * FROZEN KEYS OFFSET
+ * The keys follow the pilots, aligned for T and
+ * never less than for a uint64_t
+ ****************************************************/
+inline uint64_t frozen_keys_offset(uint64_t numPartitions, uint64_t numBuckets, size_t keyAlign)
+{
+   uint64_t align = keyAlign > 8 ? keyAlign : 8;
+   uint64_t end = sizeof(frozen_header) + (numPartitions + 1) * sizeof(frozen_partition) +
+                  numBuckets * sizeof(uint32_t);
+   return (end + align - 1) / align * align;
+}
+
+/************************************************
+ * FROZEN SET
+ * Built once from distinct keys, then only read,
+ * from any number of threads. Two keys whose hashes
+ * are equal can never be told apart by a pilot, so
+ * building throws on them: Hash must not collide on
+ * the keys given.
+ ************************************************/
+template <typename T,
+          typename Hash = std::hash<T>,
+          typename EqPred = std::equal_to<T> >
+class frozen_set
+{
+   friend class ::TestFrozenHash;   // give unit tests access to the privates
+public:
+   // the keys are one array, so a pointer walks them
+   typedef const T * iterator;
+
+   static const size_t KEYS_PER_BUCKET = 3;          // keys for each pilot, on average
+   static const size_t KEYS_PER_PARTITION = 32768;   // keys built as one piece, on average
+
+   //
+   // Construct
+   //
+   explicit frozen_set(const Hash& hash = Hash()) : frozen_set(std::vector<T>(), hash)
+   {
+   }
+   frozen_set(std::vector<T> keys, const Hash& hash = Hash())
+      : frozen_set(std::move(keys), hash, inline_executor())
+   {
+   }
+   template <class Executor>
+   frozen_set(std::vector<T> keys, const Hash& hash, Executor&& executor)
+      : base(nullptr), numBytes(0), parts(nullptr), pilots(nullptr), keys(nullptr),
+        numElements(0), numPartitions(0), hashFunction(hash)
+   {
+      build(keys, executor);
+   }
+   frozen_set(frozen_set&& rhs) noexcept
+      : base(nullptr), numBytes(0), parts(nullptr), pilots(nullptr), keys(nullptr),
+        numElements(0), numPartitions(0)
+   {
+      swap(rhs);
+   }
+   frozen_set(const frozen_set&) = delete;
+   frozen_set& operator=(const frozen_set&) = delete;
+   frozen_set& operator=(frozen_set&& rhs) noexcept
+   {
+      swap(rhs);
+      return *this;
+   }
+   ~frozen_set()
+   {
+      if (base)
+         unmap_file(base, numBytes);
+   }
+   void swap(frozen_set& rhs) noexcept
+   {
+      // a vector keeps its buffer through a swap, so the pointers stay good
+      ownParts.swap(rhs.ownParts);
+      ownPilots.swap(rhs.ownPilots);
+      ownKeys.swap(rhs.ownKeys);
+      std::swap(base, rhs.base);
+      std::swap(numBytes, rhs.numBytes);
+      std::swap(parts, rhs.parts);
+      std::swap(pilots, rhs.pilots);
+      std::swap(keys, rhs.keys);
+      std::swap(numElements, rhs.numElements);
+      std::swap(numPartitions, rhs.numPartitions);
+      std::swap(hashFunction, rhs.hashFunction);
+   }
+
+   //
+   // Save and load: the file maps straight back, nothing rebuilt
+   //
+   void save(const char * path) const;
+   static frozen_set load(const char * path, const Hash& hash = Hash());
+
+   //
+   // Iterator
+   //
+   iterator begin() const  { return keys;               }
+   iterator end() const    { return keys + numElements; }
+
+   //
+   // Access
+   //
+   iterator find(const T& t) const
+   {
+      uint64_t h = mix64(hashFunction(t));
+      const frozen_partition * part = parts + mulhi64(h, numPartitions);
+      size_t numKeys = (size_t)(part[1].firstKey - part[0].firstKey);
+      if (numKeys == 0)
+         return end();
+      size_t numBuckets = (size_t)(part[1].firstBucket - part[0].firstBucket);
+      uint32_t pilot = pilots[part->firstBucket + bucketOf(h, numBuckets)];
+      const T * p = keys + part->firstKey + slotOf(h, pilot, numKeys);
+      return EqPred()(*p, t) ? p : end();
+   }
+   size_t count(const T& t) const
+   {
+      return find(t) == end() ? 0 : 1;
+   }
+   bool contains(const T& t) const
+   {
+      return find(t) != end();
+   }
+
+   //
+   // Status
+   //
+   size_t size() const      { return numElements;      }
+   bool empty() const       { return numElements == 0; }
+   size_t num_bytes() const
+   {
+      return (numPartitions + 1) * sizeof(frozen_partition) +
+             (size_t)parts[numPartitions].firstBucket * sizeof(uint32_t) +
+             numElements * sizeof(T);
+   }
+   Hash hash_function() const
+   {
+      return hashFunction;
+   }
+
+private:
+   // the bucket of h within a partition, from other bits than picked the
+   // partition. 60% of the keys go to the first 30% of the buckets: those
+   // crowded buckets take their pilots while most slots are free, and the
+   // rest are short enough to fit in what is left.
+   static size_t bucketOf(uint64_t h, size_t numBuckets)
+   {
+      const uint64_t SIXTY_PERCENT = 0x9999999999999999ULL;
+      uint64_t hb = h * 0x9E3779B97F4A7C15ULL;
+      size_t numDense = numBuckets * 3 / 10;
+      if (numDense && hb < SIXTY_PERCENT)
+         return (size_t)mulhi64(hb / 3 * 5, numDense);
+      return numDense + (size_t)mulhi64((hb - SIXTY_PERCENT) / 2 * 5, numBuckets - numDense);
+   }
+   // where a pilot sends h among the keys of its partition
+   static size_t slotOf(uint64_t h, uint32_t pilot, size_t numKeys)
+   {
+      return (size_t)mulhi64(mix64(h ^ (((uint64_t)pilot + 1) * 0xC2B2AE3D27D4EB4FULL)), numKeys);
+   }
+
+   template <class Executor>
+   void build(std::vector<T>& source, Executor& executor);
+   void buildPartition(size_t p, const std::vector<uint64_t>& hashes, std::vector<size_t>& slots);
+
+   std::vector<frozen_partition> ownParts;   // the partitions, when built here
+   std::vector<uint32_t> ownPilots;          // the pilots, when built here
+   std::vector<T> ownKeys;                   // the keys, when built here
+   const void * base;                        // the mapped file, when loaded
+   size_t numBytes;                          // the length of the mapping
+   const frozen_partition * parts;           // numPartitions + 1 of them, the last an end marker
+   const uint32_t * pilots;                  // one for each bucket of every partition
+   const T * keys;                           // every key, in its slot
+   size_t numElements;                       // the length of keys
+   size_t numPartitions;                     // the length of parts, less one
+   Hash hashFunction;                        // must hash as the build did
+};
+
+/*****************************************
+ * FROZEN SET :: BUILD
+ * Hash every key, group them by partition, find
+ * the pilots of each partition as a task of its
+ * own, then move each key into its slot
+ ****************************************/
+template <typename T, typename H, typename E>
+template <class Executor>
+void frozen_set<T, H, E>::build(std::vector<T>& source, Executor& executor)
+{
+   size_t n = source.size();
+   numPartitions = n / KEYS_PER_PARTITION + 1;
+   size_t numTasks = executor.concurrency() < numPartitions ? executor.concurrency() : numPartitions;
+   if (numTasks == 0)
+      numTasks = 1;
+
+   std::vector<uint64_t> hashesBySource(n);
+   executor.run(numTasks, [&](size_t t)
+   {
+      for (size_t i = n * t / numTasks; i < n * (t + 1) / numTasks; i++)
+         hashesBySource[i] = mix64(hashFunction(source[i]));
+   });
+
+   // how many keys each partition has, and so where its keys and pilots start
+   ownParts.assign(numPartitions + 1, frozen_partition{ 0, 0 });
+   for (size_t i = 0; i < n; i++)
+      ownParts[mulhi64(hashesBySource[i], numPartitions) + 1].firstKey++;
+   for (size_t p = 0; p < numPartitions; p++)
+   {
+      uint64_t numKeys = ownParts[p + 1].firstKey;
+      ownParts[p + 1].firstKey = ownParts[p].firstKey + numKeys;
+      ownParts[p + 1].firstBucket = ownParts[p].firstBucket + (numKeys + KEYS_PER_BUCKET - 1) / KEYS_PER_BUCKET;
+   }
+
+   // the keys, partition after partition
+   std::vector<size_t> order(n);
+   std::vector<uint64_t> hashes(n);
+   std::vector<uint64_t> next(numPartitions);
+   for (size_t p = 0; p < numPartitions; p++)
+      next[p] = ownParts[p].firstKey;
+   for (size_t i = 0; i < n; i++)
+   {
+      size_t iKey = (size_t)next[mulhi64(hashesBySource[i], numPartitions)]++;
+      order[iKey] = i;
+      hashes[iKey] = hashesBySource[i];
+   }
+
+   ownPilots.assign((size_t)ownParts[numPartitions].firstBucket, 0);
+   std::vector<size_t> slots(n);
+   executor.run(numTasks, [&](size_t t)
+   {
+      for (size_t p = t; p < numPartitions; p += numTasks)
+         buildPartition(p, hashes, slots);
+   });
+
+   // every slot has exactly one key, so moving them in order fills the array
+   std::vector<size_t> from(n);
+   for (size_t i = 0; i < n; i++)
+      from[slots[i]] = order[i];
+   ownKeys.reserve(n);
+   for (size_t i = 0; i < n; i++)
+      ownKeys.push_back(std::move(source[from[i]]));
+
+   parts = ownParts.data();
+   pilots = ownPilots.data();
+   keys = ownKeys.data();
+   numElements = n;
+}
+
+/*****************************************
+ * FROZEN SET :: BUILD PARTITION
+ * The biggest buckets take their pilots first,
+ * while most slots are still free. slots[i] is
+ * where the ith key of the partitions goes.
+ ****************************************/
+template <typename T, typename H, typename E>
+void frozen_set<T, H, E>::buildPartition(size_t p, const std::vector<uint64_t>& hashes,
+                                         std::vector<size_t>& slots)
+{
+   size_t firstKey = (size_t)ownParts[p].firstKey;
+   size_t numKeys = (size_t)ownParts[p + 1].firstKey - firstKey;
+   size_t firstBucket = (size_t)ownParts[p].firstBucket;
+   size_t numBuckets = (size_t)ownParts[p + 1].firstBucket - firstBucket;
+   if (numKeys == 0)
+      return;
+
+   // the keys of each bucket, together
+   std::vector<size_t> start(numBuckets + 1, 0);
+   for (size_t i = 0; i < numKeys; i++)
+      start[bucketOf(hashes[firstKey + i], numBuckets) + 1]++;
+   for (size_t b = 0; b < numBuckets; b++)
+      start[b + 1] += start[b];
+   std::vector<size_t> members(numKeys);
+   std::vector<size_t> next(start.begin(), start.end() - 1);
+   for (size_t i = 0; i < numKeys; i++)
+      members[next[bucketOf(hashes[firstKey + i], numBuckets)]++] = firstKey + i;
+
+   std::vector<size_t> byLength(numBuckets);
+   for (size_t b = 0; b < numBuckets; b++)
+      byLength[b] = b;
+   std::sort(byLength.begin(), byLength.end(), [&start](size_t lhs, size_t rhs)
+   {
+      size_t lengthLhs = start[lhs + 1] - start[lhs];
+      size_t lengthRhs = start[rhs + 1] - start[rhs];
+      return lengthLhs != lengthRhs ? lengthLhs > lengthRhs : lhs < rhs;
+   });
+
+   std::vector<bool> taken(numKeys, false);
+   std::vector<size_t> tried;
+   for (size_t b : byLength)
+   {
+      if (start[b] == start[b + 1])
+         break;   // the rest are empty too
+
+      for (size_t j = start[b]; j < start[b + 1]; j++)
+         for (size_t k = j + 1; k < start[b + 1]; k++)
+            if (hashes[members[j]] == hashes[members[k]])
+               throw std::runtime_error("frozen_set: two keys have the same hash");
+
+      for (uint64_t pilot = 0; ; pilot++)
+      {
+         if (pilot > 0xFFFFFFFFULL)
+            throw std::runtime_error("frozen_set: no pilot places a bucket");
+
+         tried.clear();
+         bool fits = true;
+         for (size_t j = start[b]; fits && j < start[b + 1]; j++)
+         {
+            size_t slot = slotOf(hashes[members[j]], (uint32_t)pilot, numKeys);
+            fits = !taken[slot] && std::find(tried.begin(), tried.end(), slot) == tried.end();
+            tried.push_back(slot);
+         }
+         if (!fits)
+            continue;
+
+         for (size_t j = 0; j < tried.size(); j++)
+         {
+            taken[tried[j]] = true;
+            slots[members[start[b] + j]] = firstKey + tried[j];
+         }
+         ownPilots[firstBucket + b] = (uint32_t)pilot;
+         break;
+      }
+   }
+}
+
+/*****************************************
+ * FROZEN SET :: SAVE
+ * The header, partitions, pilots, padding and keys
+ ****************************************/
+template <typename T, typename H, typename E>
+void frozen_set<T, H, E>::save(const char * path) const
+{
+   static_assert(std::is_trivially_copyable<T>::value,
+                 "only trivially copyable keys can be saved and mapped back");
+
+   frozen_header header;
+   std::memcpy(header.magic, "CUSTMPH", 8);
+   header.version       = frozen_header::VERSION;
+   header.endian        = snapshot_header::ENDIAN;
+   header.keySize       = (uint32_t)sizeof(T);
+   header.keyAlign      = (uint32_t)alignof(T);
+   header.numElements   = numElements;
+   header.numPartitions = numPartitions;
+   header.numBuckets    = parts[numPartitions].firstBucket;
+   header.keysOffset    = frozen_keys_offset(numPartitions, header.numBuckets, alignof(T));
+
+   std::ofstream fout(path, std::ios::out | std::ios::binary | std::ios::trunc);
+   if (!fout)
+      throw std::runtime_error(std::string("cannot create the frozen set ") + path);
+
+   fout.write((const char *)&header, sizeof(header));
+   fout.write((const char *)parts, (numPartitions + 1) * sizeof(frozen_partition));
+   fout.write((const char *)pilots, (size_t)header.numBuckets * sizeof(uint32_t));
+   std::vector<char> padding((size_t)(header.keysOffset - sizeof(header) -
+                                      (numPartitions + 1) * sizeof(frozen_partition) -
+                                      header.numBuckets * sizeof(uint32_t)), 0);
+   fout.write(padding.data(), padding.size());
+   fout.write((const char *)keys, numElements * sizeof(T));
+
+   fout.close();
+   if (!fout)
+      throw std::runtime_error(std::string("cannot write the frozen set ") + path);
+}
+
+/*****************************************
+ * FROZEN SET :: LOAD
+ * Map the file, check it holds this kind of key
+ * laid out by this hash, and find in place
+ ****************************************/
+template <typename T, typename H, typename E>
+frozen_set<T, H, E> frozen_set<T, H, E>::load(const char * path, const H& hash)
+{
+   static_assert(std::is_trivially_copyable<T>::value,
+                 "only trivially copyable keys can be saved and mapped back");
+
+   frozen_set s(hash);
+   s.base = map_file(path, s.numBytes);   // unmapped by ~frozen_set if we throw
+
+   frozen_header header;
+   bool valid = s.numBytes >= sizeof(header);
+   if (valid)
+   {
+      std::memcpy(&header, s.base, sizeof(header));
+      valid = std::memcmp(header.magic, "CUSTMPH", 8) == 0 &&
+              header.version == frozen_header::VERSION &&
+              header.endian == snapshot_header::ENDIAN &&
+              header.keySize == sizeof(T) &&
+              header.keyAlign == alignof(T) &&
+              header.numPartitions > 0 &&
+              header.keysOffset == frozen_keys_offset(header.numPartitions, header.numBuckets, alignof(T)) &&
+              header.keysOffset + header.numElements * sizeof(T) <= s.numBytes;
+   }
+   if (!valid)
+      throw std::runtime_error(std::string("not a frozen set of this key type: ") + path);
+
+   const char * bytes = (const char *)s.base;
+   s.parts         = (const frozen_partition *)(bytes + sizeof(header));
+   s.pilots        = (const uint32_t *)(bytes + sizeof(header) + (header.numPartitions + 1) * sizeof(frozen_partition));
+   s.keys          = (const T *)(bytes + header.keysOffset);
+   s.numElements   = (size_t)header.numElements;
+   s.numPartitions = (size_t)header.numPartitions;
+
+   // the partitions must stay within the keys and pilots, or a find reads past them
+   for (size_t p = 0; valid && p < s.numPartitions; p++)
+      valid = s.parts[p].firstKey <= s.parts[p + 1].firstKey &&
+              s.parts[p].firstBucket <= s.parts[p + 1].firstBucket &&
+              (s.parts[p].firstKey == s.parts[p + 1].firstKey) == (s.parts[p].firstBucket == s.parts[p + 1].firstBucket);
+   valid = valid && s.parts[0].firstKey == 0 && s.parts[0].firstBucket == 0 &&
+           s.parts[s.numPartitions].firstKey == header.numElements &&
+           s.parts[s.numPartitions].firstBucket == header.numBuckets;
+   if (!valid)
+      throw std::runtime_error(std::string("not a frozen set of this key type: ") + path);
+
+   // another hash, or another seed, sends the first key to another slot
+   if (s.numElements && s.find(s.keys[0]) != s.keys)
+      throw std::runtime_error(std::string("the frozen set was saved with another hash: ") + path);
+   return s;
+}
+
+}
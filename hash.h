@@ -21,15 +21,41 @@
 
 #include "list.h"     // because this->buckets[0] is a list
 #include "vector.h"   // because this->buckets is a vector
+#include "pair.h"     // because insert returns a custom::pair
+#include "hashPolicy.h" // for the bucket index policies
+#include "executor.h"   // for the parallel rehash
+#include "hashStats.h"  // for stats() and the probe counters
+#include "mappedHash.h" // for save() and load_mapped()
+#include "frozenHash.h" // for freeze()
+#include "bloomFilter.h" // for the filter in front of find
 #include <memory>     // for std::allocator
 #include <functional> // for std::hash
 #include <cmath>      // for std::ceil
+#include <type_traits> // for std::conditional
+#include <iterator>   // for std::distance and the iterator categories
+#include <algorithm>  // for std::max
+#include <cstring>    // for std::memcpy into a snapshot
+#include <vector>     // for std::vector of snapshot offsets
    
 
 class TestHash;             // forward declaration for Hash unit tests
 
 namespace custom
 {
+/************************************************
+ * UNIQUE KEYS
+ * Passed ahead of a range to promise that no two of
+ * its elements are equal, so each one is placed in
+ * its bucket without looking for it first
+ ************************************************/
+struct unique_keys_t
+{
+};
+const unique_keys_t unique_keys = unique_keys_t();
+
+template <typename T, size_t Shards, typename Hash, typename EqPred, typename A, typename I>
+class sharded_unordered_set;   // hashes once, then asks a shard with that hash
+
 /************************************************
  * UNORDERED SET
  * A set implemented as a hash
@@ -37,18 +63,36 @@ namespace custom
 template <typename T,
           typename Hash = std::hash<T>,
           typename EqPred = std::equal_to<T>,
-          typename A = std::allocator<T> >
+          typename A = std::allocator<T>,
+          typename I = custom::modulo_index >
 class unordered_set
 {
    friend class ::TestHash;   // give unit tests access to the privates
+   template <typename TT, size_t SS, typename HH, typename EE, typename AA, typename II>
+   friend class custom::sharded_unordered_set;
+
+   // a bucket holds the bare element, or the element and its hash
+   // when cache_hash_code<T, Hash> asks for it
+   typedef typename std::conditional<cache_hash_code<T, Hash>::value,
+                                     hashed_value<T>, T>::type Entry;
+   typedef custom::list<Entry, typename std::allocator_traits<A>::template rebind_alloc<Entry>> Bucket;
 public:
    //
    // Construct
    //
-   unordered_set() : buckets(8), numElements(0), maxLoadFactor(1)
+   unordered_set() : buckets(I().bucket_count(8)), numElements(0), maxLoadFactor(1), minLoadFactor(0), thinned(false),
+                     iMigrate(0), incremental(false),
+                     parallelThreshold(PARALLEL_REHASH_OFF)
    {
    }
-   unordered_set(size_t numBuckets) : buckets(numBuckets), numElements(0), maxLoadFactor(1)
+   unordered_set(size_t numBuckets) : buckets(I().bucket_count(numBuckets)), numElements(0), maxLoadFactor(1), minLoadFactor(0), thinned(false),
+                                      iMigrate(0), incremental(false),
+                                      parallelThreshold(PARALLEL_REHASH_OFF)
+   {
+   }
+   unordered_set(size_t numBuckets, const Hash& hash) : buckets(I().bucket_count(numBuckets)), numElements(0), maxLoadFactor(1), minLoadFactor(0), thinned(false),
+                                                        iMigrate(0), incremental(false),
+                                                        parallelThreshold(PARALLEL_REHASH_OFF), hashFunction(hash)
    {
    }
    unordered_set(const unordered_set&  rhs) 
@@ -60,12 +104,20 @@ public:
       *this = std::move(rhs);
    }
    template <class Iterator>
-   unordered_set(Iterator first, Iterator last)
+   unordered_set(Iterator first, Iterator last) : numElements(0), maxLoadFactor(1), minLoadFactor(0), thinned(false),
+                                                  iMigrate(0), incremental(false),
+                                                  parallelThreshold(PARALLEL_REHASH_OFF)
    {
-      while (first != last)
-      {
-         insert(*first++);
-      }
+      presize(first, last);
+      insertRange(first, last, std::false_type());
+   }
+   template <class Iterator>
+   unordered_set(unique_keys_t, Iterator first, Iterator last) : numElements(0), maxLoadFactor(1), minLoadFactor(0), thinned(false),
+                                                                 iMigrate(0), incremental(false),
+                                                                 parallelThreshold(PARALLEL_REHASH_OFF)
+   {
+      presize(first, last);
+      insertRange(first, last, std::true_type());
    }
 
    //
@@ -74,31 +126,68 @@ public:
    unordered_set& operator=(const unordered_set& rhs)
    {
       buckets = rhs.buckets;
+      bucketsOld = rhs.bucketsOld;
+      iMigrate = rhs.iMigrate;
+      incremental = rhs.incremental;
+      parallelThreshold = rhs.parallelThreshold;
+      counters = rhs.counters;
+      hashFunction = rhs.hashFunction;
+      filter = rhs.filter;
       numElements = (int)rhs.size();
       maxLoadFactor = rhs.max_load_factor();
-      
+      minLoadFactor = rhs.min_load_factor();
+      thinned = rhs.thinned;
       
       return *this;
    }
    unordered_set& operator=(unordered_set&& rhs) noexcept
    {
-      if (!rhs.buckets.empty())
-         buckets = rhs.buckets;
-      else
-         buckets = std::move(rhs.buckets);
+      // rhs is left as a default-constructed set, reusing our emptied buckets
+      clear();
+      buckets.swap(rhs.buckets);
+      if (rhs.buckets.size() != I().bucket_count(8))
+         rhs.buckets = custom::vector<Bucket>(I().bucket_count(8));
+      bucketsOld = std::move(rhs.bucketsOld);
+      rhs.bucketsOld = custom::vector<Bucket>();
+      iMigrate = rhs.iMigrate;
+      rhs.iMigrate = 0;
+      incremental = rhs.incremental;
+      parallelThreshold = rhs.parallelThreshold;
+      counters = rhs.counters;
+      hashFunction = rhs.hashFunction;
+      filter = std::move(rhs.filter);
+      rhs.filter = blocked_bloom_filter();
       
       numElements = (int)rhs.size();
       maxLoadFactor = rhs.max_load_factor();
+      minLoadFactor = rhs.min_load_factor();
+      thinned = rhs.thinned;
       
       rhs.numElements = 0;
+      rhs.thinned = false;
       rhs.maxLoadFactor = 1.0;
       
       return *this;
    }
    unordered_set& operator=(const std::initializer_list<T>& il)
    {
+      assign(il.begin(), il.end());
       return *this;
    }
+   template <class Iterator>
+   void assign(Iterator first, Iterator last)
+   {
+      clear();
+      presize(first, last);
+      insertRange(first, last, std::false_type());
+   }
+   template <class Iterator>
+   void assign(unique_keys_t, Iterator first, Iterator last)
+   {
+      clear();
+      presize(first, last);
+      insertRange(first, last, std::true_type());
+   }
    void swap(unordered_set& rhs)
    {
       std::swap(*this, rhs);
@@ -111,6 +200,12 @@ public:
    class local_iterator;
    iterator begin()
    {
+      // the buckets not yet migrated come first, then the new table
+      for (auto itBucket = bucketsOld.begin(); itBucket != bucketsOld.end(); itBucket++)
+      {
+         if (!(*itBucket).empty())
+            return iterator(bucketsOld.end(), itBucket, (*itBucket).begin(), &buckets);
+      }
       for (auto itBucket = buckets.begin(); itBucket != buckets.end(); itBucket++)
       {
          if (!(*itBucket).empty())
@@ -136,19 +231,110 @@ public:
    //
    size_t bucket(const T& t)
    {
-      Hash hashFunction;
-      return hashFunction(t) % bucket_count();
+      return bucketOf(hashFunction(t));
    }
    iterator find(const T& t);
+   template <class Keys, class OutIterator>
+   size_t find_many(const Keys& keys, OutIterator out);
+
+   // a key of another type, such as a string_view into a std::string
+   // set, is hashed and compared as it is when Hash and EqPred allow it
+   template <class K, class = typename std::enable_if<transparent_lookup<Hash, EqPred, K>::value>::type>
+   size_t bucket(const K& key)
+   {
+      return bucketOf(hashFunction(key));
+   }
+   template <class K, class = typename std::enable_if<transparent_lookup<Hash, EqPred, K>::value>::type>
+   iterator find(const K& key)
+   {
+      counters.start();
+      iterator it = lookupHashed(key, hashFunction(key));
+      counters.endFind();
+      return it;
+   }
+
+   //
+   // Node handle: an element on its own list node, in no set. extract
+   // takes the node out of its bucket and insert splices it into a set
+   // of the same type, so moving an element between sets never
+   // allocates, frees, copies or moves it.
+   //
+   class node_type
+   {
+      friend class unordered_set;
+   public:
+      node_type()
+      {
+      }
+      node_type(node_type&& rhs) noexcept : nodes(std::move(rhs.nodes))
+      {
+      }
+      node_type& operator=(node_type&& rhs) noexcept
+      {
+         nodes = std::move(rhs.nodes);
+         return *this;
+      }
+      bool empty() const noexcept
+      {
+         return nodes.empty();
+      }
+      explicit operator bool() const noexcept
+      {
+         return !nodes.empty();
+      }
+      T& value() const
+      {
+         return valueOf(*nodes.begin());
+      }
+   private:
+      mutable Bucket nodes;   // the one node, or none when empty
+   };
+   struct insert_return_type;
 
    //   
    // Insert
    //
-   custom::pair<iterator, bool> insert(const T& t);
+   custom::pair<iterator, bool> insert(const T& t)
+   {
+      return insertUnique(t);
+   }
+   custom::pair<iterator, bool> insert(T&& t)
+   {
+      return insertUnique(std::move(t));
+   }
+   template <class ... Args>
+   custom::pair<iterator, bool> emplace(Args&& ... args)
+   {
+      return emplaceDispatch(is_key<Args...>(), std::forward<Args>(args)...);
+   }
+   template <class ... Args>
+   iterator emplace_hint(iterator, Args&& ... args)
+   {
+      // a chained bucket has no use for the hint
+      return emplace(std::forward<Args>(args)...).first;
+   }
    void insert(const std::initializer_list<T> & il);
+   insert_return_type insert(node_type&& node);
+   iterator insert(iterator, node_type&& node)
+   {
+      // a chained bucket has no use for the hint
+      return insert(std::move(node)).position;
+   }
+   void merge(unordered_set& source);
+   void merge(unordered_set&& source)
+   {
+      merge(source);
+   }
+   template <class Keys>
+   size_t insert_many(const Keys& keys);
    void rehash(size_t numBuckets);
+   template <class Executor>
+   void rehash(size_t numBuckets, Executor&& executor);
    void reserve(size_t num)
    {
+      // sized on purpose: the buckets are not given back on the next insert
+      thinned = false;
+
       // Calculate the desired load factor based on the maximum load factor
       float possibleLoadFactor = static_cast<float>(num) / buckets.size();
 
@@ -173,9 +359,26 @@ public:
    {
       for (auto &bucket : buckets)
          bucket.clear();
+      bucketsOld = custom::vector<Bucket>();
+      iMigrate = 0;
       numElements = 0;
+      thinned = false;
+      filter.clear();
+   }
+   iterator erase(const T& t)
+   {
+      return eraseKey(t);
+   }
+   template <class K, class = typename std::enable_if<transparent_lookup<Hash, EqPred, K>::value>::type>
+   iterator erase(const K& key)
+   {
+      return eraseKey(key);
+   }
+   node_type extract(iterator position);
+   node_type extract(const T& t)
+   {
+      return extract(findHashed(t, hashFunction(t)));
    }
-   iterator erase(const T& t);
 
    //
    // Status
@@ -198,7 +401,7 @@ public:
    }
    float load_factor() const noexcept 
    { 
-      return (float)(size()/bucket_count());
+      return (float)size() / (float)bucket_count();
    }
    float max_load_factor() const noexcept 
    { 
@@ -209,16 +412,353 @@ public:
       maxLoadFactor = m;
    }
 
+   //
+   // Shrink: rehash never gives buckets back, so a table that drained
+   // after a burst keeps them all. shrink_to_fit sizes the table for
+   // the elements it holds. With a min_load_factor above 0, the first
+   // insert after erases leave the load below it shrinks the table to
+   // half full. A table just sized by reserve, rehash or a batch is
+   // kept. Erase never rebuckets, so erasing as you iterate is safe.
+   // The trigger never rises above a quarter of max_load_factor, so a
+   // size that swings back and forth does not rehash on every turn.
+   // The nodes are spliced, so no element is moved or copied.
+   //
+   static const size_t MIN_BUCKETS = 8;
+   void shrink_to_fit()
+   {
+      shrinkTo(min_buckets_required(numElements));
+   }
+   float min_load_factor() const noexcept
+   {
+      return minLoadFactor;
+   }
+   void min_load_factor(float m)
+   {
+      minLoadFactor = m;
+   }
+   hash_stats stats() const;
+   Hash hash_function() const
+   {
+      return hashFunction;
+   }
+
+   //
+   // Snapshot: write the keys to a file that maps straight back as a
+   // read-only set, for a restart that does not insert them again
+   //
+   void save(const char * path) const;
+   static mapped_unordered_set<T, Hash, EqPred, I> load_mapped(const char * path, const Hash& hash = Hash())
+   {
+      return mapped_unordered_set<T, Hash, EqPred, I>(path, hash);
+   }
+
+   //
+   // Freeze: a copy of the keys placed by a minimal perfect hash, for a
+   // set built once and then only queried. Hash must not collide on them.
+   //
+   frozen_set<T, Hash, EqPred> freeze() const
+   {
+      return freeze(inline_executor());
+   }
+   template <class Executor>
+   frozen_set<T, Hash, EqPred> freeze(Executor&& executor) const;
+
+   //
+   // Incremental rehash: growing starts a migration instead of moving
+   // every element at once. The old and new tables coexist, each insert
+   // moves MIGRATE_STEP old buckets along, and lookups check the old
+   // bucket before the new one. Erase never migrates, so a loop that
+   // erases as it iterates sees every element once. Turning it off
+   // finishes the move.
+   //
+   bool incremental_rehash() const noexcept
+   {
+      return incremental;
+   }
+   void incremental_rehash(bool on)
+   {
+      if (!on)
+         finishMigration();
+      incremental = on;
+   }
+   bool rehashing() const noexcept
+   {
+      return !bucketsOld.empty();
+   }
+
+   //
+   // Bloom filter: with bitsPerKey bits for every element the table can
+   // hold before it grows, a find that misses is usually turned away
+   // without touching a bucket. Rebuilt on every rehash, and after an
+   // erase once the erased keys outnumber the live ones. 0 turns it off.
+   //
+   void bloom_filter(size_t bitsPerKey)
+   {
+      filter.configure(bitsPerKey, 0);
+      rebuildFilter();
+   }
+   size_t bloom_filter() const noexcept
+   {
+      return filter.bits_per_key();
+   }
+
+   //
+   // Parallel rehash: off unless asked for. rehash(n, executor) splits
+   // one rehash across the executor's tasks. Setting a threshold makes
+   // every growth or shrink of a table at least that big run on each
+   // hardware thread, calling Hash from all of them at once.
+   //
+   static const size_t PARALLEL_REHASH_OFF = (size_t)-1;
+   size_t parallel_rehash_threshold() const noexcept
+   {
+      return parallelThreshold;
+   }
+   void parallel_rehash_threshold(size_t num)
+   {
+      parallelThreshold = num;
+   }
+
 private:
 
    size_t min_buckets_required(size_t num) const
    {
-      return (size_t)99;
+      return (size_t)std::ceil((float)num / maxLoadFactor);
+   }
+   // the length of a range, or 0 when it can only be read once
+   template <class Iterator>
+   static size_t rangeSize(Iterator first, Iterator last, std::forward_iterator_tag)
+   {
+      return (size_t)std::distance(first, last);
+   }
+   template <class Iterator>
+   static size_t rangeSize(Iterator, Iterator, std::input_iterator_tag)
+   {
+      return 0;
+   }
+
+   // size an empty table once for everything in a range
+   template <class Iterator>
+   void presize(Iterator first, Iterator last)
+   {
+      size_t numBuckets = min_buckets_required(
+         rangeSize(first, last, typename std::iterator_traits<Iterator>::iterator_category()));
+      if (numBuckets > bucket_count())
+         buckets.resize(indexPolicy.bucket_count(numBuckets));
+      else if (buckets.empty())
+         buckets.resize(indexPolicy.bucket_count(8));
+      thinned = false;
+      rebuildFilter();
+   }
+
+   // add every element of a range, with or without looking for it first
+   template <class Iterator>
+   void insertRange(Iterator first, Iterator last, std::false_type)
+   {
+      for (; first != last; ++first)
+         insertUnique(*first);
+   }
+   template <class Iterator>
+   void insertRange(Iterator first, Iterator last, std::true_type)
+   {
+      for (; first != last; ++first)
+         placeUnique(*first);
+   }
+   size_t bucketOf(size_t hash)
+   {
+      return indexPolicy.index(hash, bucket_count());
+   }
+   template <class K>
+   iterator findInBucket(custom::vector<Bucket>& table, const K& key, size_t hash, size_t iBucket);
+   template <class Executor>
+   void rehashSplit(size_t numBuckets, Executor& executor);
+   template <class K>
+   iterator findHashed(const K& key, size_t hash)
+   {
+      return findHashed(key, hash, bucketOf(hash));
+   }
+   template <class K>
+   iterator findHashed(const K& key, size_t hash, size_t iBucket);
+   template <class K>
+   iterator lookupHashed(const K& key, size_t hash)
+   {
+      return lookupHashed(key, hash, bucketOf(hash));
+   }
+   template <class K>
+   iterator lookupHashed(const K& key, size_t hash, size_t iBucket);
+   template <class K>
+   iterator findInTables(const K& key, size_t hash, size_t iBucket);
+   template <class K>
+   iterator eraseKey(const K& key);
+   void rebuildFilter();
+
+   // an element is gone: its bits stay in the filter until the stale
+   // keys outnumber the live ones
+   void noteErased()
+   {
+      thinned = true;
+      if (!filter.active())
+         return;
+      filter.erased();
+      if (filter.num_stale() > (size_t)numElements)
+         rebuildFilter();
+   }
+
+   // have erases left the table so empty the next insert should give
+   // buckets back? A table sized on purpose is left alone until then
+   bool sparse() const
+   {
+      if (!thinned || minLoadFactor <= 0 || bucket_count() <= MIN_BUCKETS || rehashing())
+         return false;
+      return load_factor() < std::min(minLoadFactor, maxLoadFactor / 4);
+   }
+   void shrinkIfSparse()
+   {
+      if (sparse())
+         shrinkTo(min_buckets_required(numElements * 2));
+   }
+   void shrinkTo(size_t numBuckets);
+
+   // shrink if erases left the table sparse, then grow, all at once
+   // or by migration, if one more would cross the limit
+   void makeRoomForOne()
+   {
+      shrinkIfSparse();
+      if (min_buckets_required(numElements + 1) > bucket_count())
+      {
+         if (incremental)
+            beginMigration(min_buckets_required(numElements * 2));
+         else
+            reserve(numElements * 2);
+      }
+   }
+
+   // the element just pushed on the back of a bucket
+   iterator backOf(size_t iBucket)
+   {
+      return iterator(buckets.end(),
+                      typename custom::vector<Bucket>::iterator(iBucket, buckets),
+                      buckets[iBucket].rbegin());
+   }
+
+   // a node from another set carries the hash that set gave it
+   static void setHash(T&, size_t)                            { }
+   static void setHash(hashed_value<T>& entry, size_t hash)   { entry.hash = hash; }
+
+   // move the node itNode of from into this set unless its element is here
+   custom::pair<iterator, bool> spliceUnique(Bucket& from, typename Bucket::iterator itNode);
+
+   // move the old buckets into the new table a few at a time
+   static const size_t MIGRATE_STEP = 2;
+   void beginMigration(size_t numBuckets);
+   void migrateBucket(size_t iOld);
+   void migrate(size_t numSteps);
+   void finishMigration()
+   {
+      while (rehashing())
+         migrate(bucketsOld.size());
+   }
+
+   // the element in an entry and the hash it was stored with
+   static T& valueOf(T& entry)                       { return entry;       }
+   static T& valueOf(hashed_value<T>& entry)         { return entry.value; }
+   static const T& valueOf(const T& entry)                   { return entry;       }
+   static const T& valueOf(const hashed_value<T>& entry)     { return entry.value; }
+   size_t hashOf(const T& entry) const               { return hashFunction(entry); }
+   size_t hashOf(const hashed_value<T>& entry) const { return entry.hash;  }
+
+   // does the entry hold key? A cached hash settles most misses without EqPred
+   template <class K>
+   bool holds(const T& entry, const K& key, size_t) const
+   {
+      return EqPred()(entry, key);
+   }
+   template <class K>
+   bool holds(const hashed_value<T>& entry, const K& key, size_t hash) const
+   {
+      return entry.hash == hash && EqPred()(entry.value, key);
+   }
+
+   // put t on the back of a bucket, with its hash if the entries keep one
+   template <class U>
+   void pushEntry(Bucket& bucket, U&& t, size_t, std::false_type)
+   {
+      bucket.push_back(std::forward<U>(t));
+   }
+   template <class U>
+   void pushEntry(Bucket& bucket, U&& t, size_t hash, std::true_type)
+   {
+      bucket.emplace_back(std::forward<U>(t), hash);
+   }
+
+   // copy or move t into a new node unless it is already there
+   template <class U>
+   custom::pair<iterator, bool> insertUnique(U&& t)
+   {
+      size_t hash = hashFunction(t);
+      return insertHashed(std::forward<U>(t), hash);
+   }
+   template <class U>
+   custom::pair<iterator, bool> insertHashed(U&& t, size_t hash);
+
+   // put t in its bucket, trusting that it is not already there
+   template <class U>
+   void placeUnique(U&& t)
+   {
+      size_t hash = hashFunction(t);
+      if (min_buckets_required(numElements + 1) > bucket_count())
+         rehash(bucket_count() * 2);
+      pushEntry(buckets[bucketOf(hash)], std::forward<U>(t), hash, cache_hash_code<T, Hash>());
+      numElements++;
+      if (filter.active())
+         filter.add(hash);
+   }
+
+   // A batch is worked through BATCH_WINDOW keys at a time: hash them
+   // all and prefetch their bucket slots, then prefetch the head of
+   // each chain, then walk the chains. The misses of a window overlap
+   // instead of each key stalling on its own.
+   static const size_t BATCH_WINDOW = 16;
+   template <class Iterator>
+   size_t prefetchWindow(Iterator& it, const Iterator& itEnd,
+                         const T * pKeys[BATCH_WINDOW], size_t hashes[BATCH_WINDOW],
+                         size_t iBuckets[BATCH_WINDOW]);
+
+   // are the emplace arguments a single T, which can be hashed and
+   // compared as it is? Anything else must be built before it is hashed
+   template <class ... Args>
+   struct is_key : std::false_type
+   {
+   };
+   template <class Arg>
+   struct is_key<Arg> : std::is_same<typename std::decay<Arg>::type, T>
+   {
+   };
+   template <class Arg>
+   custom::pair<iterator, bool> emplaceDispatch(std::true_type, Arg&& arg)
+   {
+      return insertUnique(std::forward<Arg>(arg));
+   }
+   template <class ... Args>
+   custom::pair<iterator, bool> emplaceDispatch(std::false_type, Args&& ... args)
+   {
+      // build it on the stack, so a duplicate never allocates a node
+      T t(std::forward<Args>(args)...);
+      return insertUnique(std::move(t));
    }
 
-   custom::vector<custom::list<T,A>> buckets;  // each bucket in the hash
+   custom::vector<Bucket> buckets;             // each bucket in the hash
    int numElements;                            // number of elements in the Hash
    float maxLoadFactor;                        // the ratio of elements to buckets signifying a rehash
+   float minLoadFactor;                        // the ratio below which an insert shrinks, 0 for never
+   bool thinned;                               // erased from since the table was last sized
+   I indexPolicy;                              // turns a hash into a bucket index
+   custom::vector<Bucket> bucketsOld;          // the table being migrated, empty when not rehashing
+   size_t iMigrate;                            // the next old bucket to migrate
+   bool incremental;                           // grow by migration rather than all at once
+   size_t parallelThreshold;                   // the size from which a rehash runs in parallel, off by default
+   hash_counters<instrument_hash<T, Hash>::value> counters;   // probe counts, empty unless instrumented
+   Hash hashFunction;                          // hashes every element, with its own seed if it takes one
+   blocked_bloom_filter filter;                // turns away most misses, off unless asked for
 };
 
 
@@ -226,31 +766,34 @@ private:
  * UNORDERED SET ITERATOR
  * Iterator for an unordered set
  ************************************************/
-template <typename T, typename H, typename E, typename A>
-class unordered_set <T, H, E, A> ::iterator
+template <typename T, typename H, typename E, typename A, typename I>
+class unordered_set <T, H, E, A, I> ::iterator
 {
    friend class ::TestHash;   // give unit tests access to the privates
-   template <typename TT, typename HH, typename EE, typename AA>
+   template <typename TT, typename HH, typename EE, typename AA, typename II>
    friend class custom::unordered_set;
 public:
    // 
    // Construct
-   iterator() 
+   iterator() : pBucketsNext(nullptr)
    {
    }
-   iterator(const typename custom::vector<custom::list<T> >::iterator& itVectorEnd,
-            const typename custom::vector<custom::list<T> >::iterator& itVector,
-            const typename custom::list<T>::iterator &itList)
+   iterator(const typename custom::vector<Bucket>::iterator& itVectorEnd,
+            const typename custom::vector<Bucket>::iterator& itVector,
+            const typename Bucket::iterator &itList,
+            custom::vector<Bucket> * pBucketsNext = nullptr)
    {
       this->itVectorEnd = itVectorEnd;
       this->itVector = itVector;
       this->itList = itList;
+      this->pBucketsNext = pBucketsNext;
    }
    iterator(const iterator& rhs) 
    { 
       itVectorEnd = rhs.itVectorEnd;
       itVector = rhs.itVector;
       itList = rhs.itList;
+      pBucketsNext = rhs.pBucketsNext;
    }
 
    //
@@ -261,6 +804,7 @@ public:
       itVectorEnd = rhs.itVectorEnd;
       itVector = rhs.itVector;
       itList = rhs.itList;
+      pBucketsNext = rhs.pBucketsNext;
       return *this;
    }
 
@@ -287,7 +831,7 @@ public:
    //
    T& operator * ()
    {
-      return *(itList);
+      return valueOf(*itList);
    }
 
    //
@@ -302,22 +846,36 @@ public:
    }
 
 private:
-   typename vector<list<T>>::iterator itVectorEnd;
-   typename list<T>::iterator itList;
-   typename vector<list<T>>::iterator itVector;
+   typename vector<Bucket>::iterator itVectorEnd;
+   typename Bucket::iterator itList;
+   typename vector<Bucket>::iterator itVector;
+   vector<Bucket> * pBucketsNext;   // the new table, while walking the old one
 };
 
 
+/************************************************
+ * UNORDERED SET INSERT RETURN TYPE
+ * What insert(node_type&&) did: where the element
+ * is, whether it went in, and the node when not
+ ************************************************/
+template <typename T, typename H, typename E, typename A, typename I>
+struct unordered_set <T, H, E, A, I> ::insert_return_type
+{
+   iterator position;
+   bool inserted;
+   node_type node;
+};
+
 /************************************************
  * UNORDERED SET LOCAL ITERATOR
  * Iterator for a single bucket in an unordered set
  ************************************************/
-template <typename T, typename H, typename E, typename A>
-class unordered_set <T, H, E, A> ::local_iterator
+template <typename T, typename H, typename E, typename A, typename I>
+class unordered_set <T, H, E, A, I> ::local_iterator
 {
    friend class ::TestHash;   // give unit tests access to the privates
 
-   template <typename TT, typename HH, typename EE, typename AA>
+   template <typename TT, typename HH, typename EE, typename AA, typename II>
    friend class custom::unordered_set;
 public:
    // 
@@ -326,7 +884,7 @@ public:
    local_iterator()  
    {
    }
-   local_iterator(const typename custom::list<T>::iterator& itList) 
+   local_iterator(const typename Bucket::iterator& itList) 
    {
       this->itList = itList;
    }
@@ -367,7 +925,7 @@ public:
    //
    T& operator * ()
    {
-      return *(itList);
+      return valueOf(*itList);
    }
 
    // 
@@ -386,19 +944,22 @@ public:
    }
 
 private:
-   typename list<T>::iterator itList;
+   typename Bucket::iterator itList;
 };
 
 
 /*****************************************
- * UNORDERED SET :: ERASE
- * Remove one element from the unordered set
+ * UNORDERED SET :: ERASE KEY
+ * Remove one element from the unordered set, given
+ * the element or a transparent key equal to it
  ****************************************/
-template <typename T, typename Hash, typename E, typename A>
-typename unordered_set <T, Hash, E, A> ::iterator unordered_set<T,Hash,E,A>::erase(const T& t)
+template <typename T, typename Hash, typename E, typename A, typename I>
+template <class K>
+typename unordered_set <T, Hash, E, A, I> ::iterator unordered_set<T,Hash,E,A,I>::eraseKey(const K& key)
 {
    // Find element to be erased. Return end() if the element is not present.
-   iterator itErase = find(t);
+   // No bucket migrates here: it might be one an iterator already passed.
+   iterator itErase = findHashed(key, hashFunction(key));
    if (itErase == end())
       return itErase;
    
@@ -406,76 +967,304 @@ typename unordered_set <T, Hash, E, A> ::iterator unordered_set<T,Hash,E,A>::era
    iterator itReturn = itErase;
    itReturn++;
    
-   // Erase the element from the bucket.
-   buckets[bucket(t)].erase(itErase.itList);
-
-   
+   // Erase the element from the bucket we found it in.
+   (*itErase.itVector).erase(itErase.itList);
    numElements--;
+
+   noteErased();
    
    // Return iterator to the next element.
    return itReturn;
-
 }
 
 /*****************************************
- * UNORDERED SET :: INSERT
- * Insert one element into the hash
+ * UNORDERED SET :: INSERT HASHED
+ * Insert one element whose hash is already known,
+ * copying an lvalue and moving an rvalue into the
+ * new node
  ****************************************/
-template <typename T, typename H, typename E, typename A>
-custom::pair<typename custom::unordered_set<T, H, E, A>::iterator, bool> unordered_set<T, H, E, A>::insert(const T& t)
+template <typename T, typename H, typename E, typename A, typename I>
+template <class U>
+custom::pair<typename custom::unordered_set<T, H, E, A, I>::iterator, bool> unordered_set<T, H, E, A, I>::insertHashed(U&& t, size_t hash)
 {
-   // Find the bucket where the new element is to reside.
-   size_t iBucket = bucket(t);
+   // Move the migration along before looking.
+   if (rehashing())
+      migrate(MIGRATE_STEP);
 
    // See if the element is already there. If so, then return out.
-   for (typename custom::list<T>::iterator it = buckets[iBucket].begin(); it != buckets[iBucket].end(); ++it)
-       if (*it == t)
-           return custom::pair<custom::unordered_set<T, H, E, A>::iterator, bool>(find(t), false);
+   counters.start();
+   iterator itFound = findHashed(t, hash);
+   counters.endInsert();
+   if (itFound != end())
+      return custom::pair<custom::unordered_set<T, H, E, A, I>::iterator, bool>(itFound, false);
 
    // Reserve more space if we are already at the limit.
-   if (min_buckets_required(numElements + 1) > bucket_count())
-   {
-       reserve(numElements * 2);
-       iBucket = bucket(t);
-   }
+   makeRoomForOne();
+   size_t iBucket = bucketOf(hash);
 
    // Actually insert the new element on the back of the bucket.
-   buckets[iBucket].push_back(t);
+   pushEntry(buckets[iBucket], std::forward<U>(t), hash, cache_hash_code<T, H>());
    ++numElements; // Increment the count of elements
+   if (filter.active())
+      filter.add(hash);
+
+   // The new element is the tail of its bucket.
+   return custom::pair<custom::unordered_set<T, H, E, A, I>::iterator, bool>(backOf(iBucket), true);
+}
+
+/*****************************************
+ * UNORDERED SET :: SPLICE UNIQUE
+ * Move one node of another list into this set, as
+ * insertHashed would put a new one, unless an equal
+ * element is here already. The hash is taken again:
+ * the set the node came from may have another seed.
+ ****************************************/
+template <typename T, typename H, typename E, typename A, typename I>
+custom::pair<typename custom::unordered_set<T, H, E, A, I>::iterator, bool> unordered_set<T, H, E, A, I>::spliceUnique(Bucket& from, typename Bucket::iterator itNode)
+{
+   size_t hash = hashFunction(valueOf(*itNode));
+   if (rehashing())
+      migrate(MIGRATE_STEP);
+
+   counters.start();
+   iterator itFound = findHashed(valueOf(*itNode), hash);
+   counters.endInsert();
+   if (itFound != end())
+      return custom::pair<custom::unordered_set<T, H, E, A, I>::iterator, bool>(itFound, false);
 
-   iterator itInserted = find(t);
+   makeRoomForOne();
+   size_t iBucket = bucketOf(hash);
 
-   // Return the results.
-   return custom::pair<custom::unordered_set<T, H, E, A>::iterator, bool>(itInserted, true);
+   // Relink the node on the back of its bucket, nothing allocated.
+   setHash(*itNode, hash);
+   buckets[iBucket].splice(buckets[iBucket].end(), from, itNode);
+   ++numElements;
+   if (filter.active())
+      filter.add(hash);
+
+   return custom::pair<custom::unordered_set<T, H, E, A, I>::iterator, bool>(backOf(iBucket), true);
 }
-template <typename T, typename H, typename E, typename A>
-void unordered_set<T, H, E, A>::insert(const std::initializer_list<T> & il)
+
+/*****************************************
+ * UNORDERED SET :: EXTRACT
+ * Unlink the element at position into a node handle,
+ * leaving the node and the element where they are
+ ****************************************/
+template <typename T, typename H, typename E, typename A, typename I>
+typename unordered_set <T, H, E, A, I> ::node_type unordered_set<T, H, E, A, I>::extract(iterator position)
+{
+   node_type node;
+   if (position == end())
+      return node;
+
+   node.nodes.splice(node.nodes.end(), *position.itVector, position.itList);
+   numElements--;
+   noteErased();
+   return node;
+}
+
+/*****************************************
+ * UNORDERED SET :: INSERT NODE
+ * Splice the element of a node handle into the set.
+ * When an equal element is here already, the node
+ * is handed back in the result.
+ ****************************************/
+template <typename T, typename H, typename E, typename A, typename I>
+typename unordered_set <T, H, E, A, I> ::insert_return_type unordered_set<T, H, E, A, I>::insert(node_type&& node)
+{
+   insert_return_type result;
+   if (node.empty())
+   {
+      result.position = end();
+      result.inserted = false;
+      return result;
+   }
+
+   custom::pair<iterator, bool> spliced = spliceUnique(node.nodes, node.nodes.begin());
+   result.position = spliced.first;
+   result.inserted = spliced.second;
+   if (!result.inserted)
+      result.node = std::move(node);
+   return result;
+}
+
+/*****************************************
+ * UNORDERED SET :: MERGE
+ * Splice every element of source that is not here
+ * into this set. The ones already here stay behind.
+ ****************************************/
+template <typename T, typename H, typename E, typename A, typename I>
+void unordered_set<T, H, E, A, I>::merge(unordered_set& source)
+{
+   if (&source == this)
+      return;
+
+   // the buckets of source, then those it has yet to migrate
+   size_t numBuckets = source.buckets.size();
+   size_t numOld = source.rehashing() ? source.bucketsOld.size() : 0;
+   for (size_t i = 0; i < numBuckets + numOld; i++)
+   {
+      Bucket& bucket = i < numBuckets ? source.buckets[i]
+                                      : source.bucketsOld[i - numBuckets];
+      if (i >= numBuckets && i - numBuckets < source.iMigrate)
+         continue;
+      for (auto itNode = bucket.begin(); itNode != bucket.end(); )
+      {
+         auto itNext = itNode;
+         ++itNext;
+         if (spliceUnique(bucket, itNode).second)
+         {
+            source.numElements--;
+            source.noteErased();
+         }
+         itNode = itNext;
+      }
+   }
+}
+/*****************************************
+ * UNORDERED SET :: INSERT INITIALIZER LIST
+ * Insert every element of the list as one batch
+ ****************************************/
+template <typename T, typename H, typename E, typename A, typename I>
+void unordered_set<T, H, E, A, I>::insert(const std::initializer_list<T> & il)
+{
+   insert_many(il);
+}
+
+/*****************************************
+ * UNORDERED SET :: PREFETCH WINDOW
+ * Hash the next BATCH_WINDOW keys from it and start
+ * loading their bucket slots and chain heads. Returns
+ * how many keys were taken.
+ ****************************************/
+template <typename T, typename H, typename E, typename A, typename I>
+template <class Iterator>
+size_t unordered_set<T, H, E, A, I>::prefetchWindow(Iterator& it, const Iterator& itEnd,
+                                                    const T * pKeys[BATCH_WINDOW], size_t hashes[BATCH_WINDOW],
+                                                    size_t iBuckets[BATCH_WINDOW])
+{
+   // Hash every key and prefetch the bucket it lands in.
+   size_t num = 0;
+   for (; num < BATCH_WINDOW && it != itEnd; ++it, num++)
+   {
+      pKeys[num] = &*it;
+      hashes[num] = hashFunction(*it);
+      iBuckets[num] = bucketOf(hashes[num]);
+      prefetch(&buckets[iBuckets[num]]);
+      if (filter.active())
+         filter.prefetch(hashes[num]);
+   }
+
+   // The slots are on their way, so prefetch the first node of each chain.
+   for (size_t i = 0; i < num; i++)
+   {
+      Bucket& bucket = buckets[iBuckets[i]];
+      if (!bucket.empty())
+         prefetch(&*bucket.begin());
+   }
+   return num;
+}
+
+/*****************************************
+ * UNORDERED SET :: FIND MANY
+ * Write whether each key is present to out, in
+ * the order of keys. Returns the number found.
+ ****************************************/
+template <typename T, typename H, typename E, typename A, typename I>
+template <class Keys, class OutIterator>
+size_t unordered_set<T, H, E, A, I>::find_many(const Keys& keys, OutIterator out)
+{
+   const T * pKeys[BATCH_WINDOW];
+   size_t hashes[BATCH_WINDOW];
+   size_t iBuckets[BATCH_WINDOW];
+   size_t numFound = 0;
+   auto it = keys.begin();
+   auto itEnd = keys.end();
+   while (it != itEnd)
+   {
+      size_t num = prefetchWindow(it, itEnd, pKeys, hashes, iBuckets);
+      for (size_t i = 0; i < num; i++)
+      {
+         counters.start();
+         bool found = lookupHashed(*pKeys[i], hashes[i], iBuckets[i]) != end();
+         counters.endFind();
+         numFound += found;
+         *out++ = found;
+      }
+   }
+   return numFound;
+}
+
+/*****************************************
+ * UNORDERED SET :: INSERT MANY
+ * Insert a batch of keys. Returns the number that
+ * were new. The table is grown for the whole batch
+ * up front, at least doubling like insert does, so
+ * no rehash happens part way through. The batch is
+ * sized as if every key were new: duplicates and keys
+ * already present may grow the table more than needed.
+ ****************************************/
+template <typename T, typename H, typename E, typename A, typename I>
+template <class Keys>
+size_t unordered_set<T, H, E, A, I>::insert_many(const Keys& keys)
 {
+   // An incremental table grows as it goes instead.
+   thinned = false;
+   size_t numBuckets = min_buckets_required(size() + (size_t)std::distance(keys.begin(), keys.end()));
+   if (!incremental && numBuckets > bucket_count())
+      rehash(std::max(numBuckets, bucket_count() * 2));
+
+   const T * pKeys[BATCH_WINDOW];
+   size_t hashes[BATCH_WINDOW];
+   size_t iBuckets[BATCH_WINDOW];
+   size_t numInserted = 0;
+   auto it = keys.begin();
+   auto itEnd = keys.end();
+   while (it != itEnd)
+   {
+      size_t num = prefetchWindow(it, itEnd, pKeys, hashes, iBuckets);
+      for (size_t i = 0; i < num; i++)
+         if (insertHashed(*pKeys[i], hashes[i]).second)
+            numInserted++;
+   }
+   return numInserted;
 }
 
 /*****************************************
  * UNORDERED SET :: REHASH
  * Re-Hash the unordered set by numBuckets
  ****************************************/
-template <typename T, typename Hash, typename E, typename A>
-void unordered_set<T, Hash, E, A>::rehash(size_t numBuckets)
+template <typename T, typename Hash, typename E, typename A, typename I>
+void unordered_set<T, Hash, E, A, I>::rehash(size_t numBuckets)
 {
-   Hash hash;
-   
-   
+   // An explicit rehash is never incremental, and sizes the table on purpose.
+   finishMigration();
+   thinned = false;
+
    // If the current bucket count is sufficient, then do nothing.
    if (numBuckets <= bucket_count())
       return;
    
-   // Create a new hash bucket.
-   custom::vector<custom::list<T,A>> bucketNew(numBuckets);
+   // Create a new hash bucket with a count the index policy accepts.
+   numBuckets = indexPolicy.bucket_count(numBuckets);
+   counters.rehashed();
+
+   // A table past the threshold, if one was set, is split across the hardware threads.
+   if ((size_t)numElements >= parallelThreshold)
+   {
+      thread_executor executor;
+      rehashSplit(numBuckets, executor);
+      return;
+   }
+   custom::vector<Bucket> bucketNew(numBuckets);
    
    // Insert the elements into the new hash table, one at a time.
+   // A cached hash is reused rather than recomputed.
    for (auto& bucket : buckets) 
    {
-      for (auto& element : bucket)
+      for (auto& entry : bucket)
       {
-         bucketNew[hash(element) % numBuckets].push_back(std::move(element));
+         bucketNew[indexPolicy.index(hashOf(entry), numBuckets)].push_back(std::move(entry));
       }
    }
    
@@ -484,45 +1273,428 @@ void unordered_set<T, Hash, E, A>::rehash(size_t numBuckets)
    
    //Swap the old bucket for the new.
    std::swap(buckets, bucketNew);
+   rebuildFilter();
    
    
 }
 
 
+/*****************************************
+ * UNORDERED SET :: SHRINK TO
+ * Give back buckets: move every node into a smaller
+ * table of at least numBuckets. Never grows.
+ ****************************************/
+template <typename T, typename H, typename E, typename A, typename I>
+void unordered_set<T, H, E, A, I>::shrinkTo(size_t numBuckets)
+{
+   finishMigration();
+   thinned = false;
+   numBuckets = indexPolicy.bucket_count(std::max(numBuckets, (size_t)MIN_BUCKETS));
+   if (numBuckets >= bucket_count())
+      return;
+   counters.rehashed();
+
+   // splicing keeps every node where it is in memory
+   if ((size_t)numElements >= parallelThreshold)
+   {
+      thread_executor executor;
+      rehashSplit(numBuckets, executor);
+   }
+   else
+   {
+      inline_executor executor;
+      rehashSplit(numBuckets, executor);
+   }
+}
+
+/*****************************************
+ * UNORDERED SET :: REHASH
+ * Re-Hash the unordered set by numBuckets, splitting
+ * the work into executor.concurrency() tasks
+ ****************************************/
+template <typename T, typename H, typename E, typename A, typename I>
+template <class Executor>
+void unordered_set<T, H, E, A, I>::rehash(size_t numBuckets, Executor&& executor)
+{
+   finishMigration();
+   thinned = false;
+   if (numBuckets <= bucket_count())
+      return;
+   counters.rehashed();
+   rehashSplit(indexPolicy.bucket_count(numBuckets), executor);
+}
+
+/*****************************************
+ * UNORDERED SET :: REHASH SPLIT
+ * Move every node into numBuckets new buckets in two
+ * rounds of tasks. Each node is spliced, never copied.
+ *   scatter: task t empties its share of the old buckets
+ *            into staging lists, one for each share of
+ *            the new buckets
+ *   merge:   task p owns share p of the new buckets and
+ *            empties every staging list bound for it
+ * No two tasks ever touch the same list, so there are
+ * no locks, and the nodes of a new bucket keep the order
+ * a single-threaded rehash would give them.
+ ****************************************/
+template <typename T, typename H, typename E, typename A, typename I>
+template <class Executor>
+void unordered_set<T, H, E, A, I>::rehashSplit(size_t numBuckets, Executor& executor)
+{
+   size_t numOld = buckets.size();
+   size_t numTasks = std::max((size_t)1, std::min(executor.concurrency(), std::min(numOld, numBuckets)));
+   custom::vector<Bucket> bucketNew(numBuckets);
+
+   // staged[t * numTasks + p]: from the old buckets of task t to the new ones of task p
+   custom::vector<Bucket> staged(numTasks * numTasks);
+
+   executor.run(numTasks, [&](size_t t)
+   {
+      I policy(indexPolicy);   // a policy may cache its divisor, so each task has its own
+      for (size_t iOld = t * numOld / numTasks; iOld < (t + 1) * numOld / numTasks; iOld++)
+      {
+         Bucket& bucket = buckets[iOld];
+         while (!bucket.empty())
+         {
+            size_t iNew = policy.index(hashOf(*bucket.begin()), numBuckets);
+            Bucket& stage = staged[t * numTasks + iNew * numTasks / numBuckets];
+            stage.splice(stage.end(), bucket, bucket.begin());
+         }
+      }
+   });
+
+   executor.run(numTasks, [&](size_t p)
+   {
+      I policy(indexPolicy);
+      for (size_t t = 0; t < numTasks; t++)
+      {
+         Bucket& stage = staged[t * numTasks + p];
+         while (!stage.empty())
+         {
+            Bucket& bucket = bucketNew[policy.index(hashOf(*stage.begin()), numBuckets)];
+            bucket.splice(bucket.end(), stage, stage.begin());
+         }
+      }
+   });
+
+   std::swap(buckets, bucketNew);
+   rebuildFilter();
+}
+
 /*****************************************
  * UNORDERED SET :: FIND
  * Find an element in an unordered set
  ****************************************/
-template <typename T, typename H, typename E, typename A>
-typename unordered_set <T, H, E, A> ::iterator unordered_set<T, H, E, A>::find(const T& t)
+template <typename T, typename H, typename E, typename A, typename I>
+typename unordered_set <T, H, E, A, I> ::iterator unordered_set<T, H, E, A, I>::find(const T& t)
 {
-   // Get the index of the bucket where 't' will be in
-   auto iBucket = bucket(t);
-   
-   // Get an iterator until we find the right bucket
-   for (auto itBucket = buckets.begin(); itBucket != buckets.end(); ++itBucket)
+   counters.start();
+   iterator it = lookupHashed(t, hashFunction(t));
+   counters.endFind();
+   return it;
+}
+
+/*****************************************
+ * UNORDERED SET :: STATS
+ * Summarize the chains, old and new while migrating,
+ * and report the counts if the set keeps them
+ ****************************************/
+template <typename T, typename H, typename E, typename A, typename I>
+hash_stats unordered_set<T, H, E, A, I>::stats() const
+{
+   hash_stats s;
+   s.numElements = size();
+
+   // The old buckets already migrated are gone, not empty.
+   size_t numUsed = 0;
+   for (size_t pass = 0; pass < 2; pass++)
    {
-      if ((*itBucket).begin() == buckets[iBucket].begin())
+      const custom::vector<Bucket>& table = pass ? bucketsOld : buckets;
+      for (size_t i = pass ? iMigrate : 0; i < table.size(); i++)
       {
-         // Get a list iterator to the element iterating through it
-         for (auto itList = buckets[iBucket].begin(); itList != buckets[iBucket].end(); ++itList)
+         size_t length = table[i].size();
+         if (length >= s.chains.size())
+            s.chains.resize(length + 1, 0);
+         s.chains[length]++;
+         s.numBuckets++;
+         if (length)
+            numUsed++;
+      }
+   }
+
+   s.maxChain = s.chains.empty() ? 0 : s.chains.size() - 1;
+   if (s.numBuckets)
+   {
+      s.loadFactor = (float)s.numElements / (float)s.numBuckets;
+      s.emptyRatio = (float)(s.numBuckets - numUsed) / (float)s.numBuckets;
+   }
+   if (numUsed)
+      s.meanChain = (float)s.numElements / (float)numUsed;
+
+   s.bloomBitsPerKey = filter.bits_per_key();
+   s.bloomBytes = filter.num_bytes();
+   s.bloomRejected = filter.num_rejected();
+   s.bloomFalsePositives = filter.num_false_positives();
+
+   counters.report(s);
+   return s;
+}
+
+/*****************************************
+ * UNORDERED SET :: SAVE
+ * Write every key to path, grouped by the bucket
+ * it has in a table of bucket_count() buckets
+ ****************************************/
+template <typename T, typename H, typename E, typename A, typename I>
+void unordered_set<T, H, E, A, I>::save(const char * path) const
+{
+   static_assert(std::is_trivially_copyable<T>::value,
+                 "only trivially copyable keys can be saved and mapped back");
+
+   // custom::list has no const iteration, but nothing here changes a bucket
+   unordered_set& self = const_cast<unordered_set&>(*this);
+   size_t numBuckets = bucket_count();
+   I policy(indexPolicy);
+
+   // Count the keys in each bucket, old buckets included while migrating.
+   std::vector<size_t> iBuckets;
+   iBuckets.reserve(size());
+   std::vector<uint64_t> offsets(numBuckets + 1, 0);
+   for (size_t pass = 0; pass < 2; pass++)
+   {
+      custom::vector<Bucket>& table = pass ? self.bucketsOld : self.buckets;
+      for (size_t i = pass ? iMigrate : 0; i < table.size(); i++)
+         for (auto it = table[i].begin(); it != table[i].end(); ++it)
          {
-            if (*itList == t)
-            {
-               return iterator(buckets.end(),itBucket, itList);
-            }
+            size_t iBucket = policy.index(hashOf(*it), numBuckets);
+            iBuckets.push_back(iBucket);
+            offsets[iBucket + 1]++;
          }
-      }
+   }
+   for (size_t i = 0; i < numBuckets; i++)
+      offsets[i + 1] += offsets[i];
+
+   // Then copy each key to the next free slot of its bucket.
+   std::vector<uint64_t> next(offsets.begin(), offsets.end() - 1);
+   std::vector<unsigned char> keys(size() * sizeof(T));
+   size_t iKey = 0;
+   for (size_t pass = 0; pass < 2; pass++)
+   {
+      custom::vector<Bucket>& table = pass ? self.bucketsOld : self.buckets;
+      for (size_t i = pass ? iMigrate : 0; i < table.size(); i++)
+         for (auto it = table[i].begin(); it != table[i].end(); ++it)
+            std::memcpy(&keys[next[iBuckets[iKey++]]++ * sizeof(T)], &valueOf(*it), sizeof(T));
+   }
+
+   snapshot_header header;
+   std::memcpy(header.magic, "CUSTSET", 8);
+   header.version     = snapshot_header::VERSION;
+   header.endian      = snapshot_header::ENDIAN;
+   header.keySize     = (uint32_t)sizeof(T);
+   header.keyAlign    = (uint32_t)alignof(T);
+   header.numElements = size();
+   header.numBuckets  = numBuckets;
+   header.keysOffset  = snapshot_keys_offset(numBuckets, alignof(T));
+   header.firstBucket = 0;
+   while (header.numElements && offsets[header.firstBucket + 1] == 0)
+      header.firstBucket++;
+   write_snapshot(path, header, offsets, keys.data());
+}
+
+/*****************************************
+ * UNORDERED SET :: FREEZE
+ * Copy every key out, then let frozen_set find
+ * each one its slot, partitions spread over executor
+ ****************************************/
+template <typename T, typename H, typename E, typename A, typename I>
+template <class Executor>
+frozen_set<T, H, E> unordered_set<T, H, E, A, I>::freeze(Executor&& executor) const
+{
+   // custom::list has no const iteration, but nothing here changes a bucket
+   unordered_set& self = const_cast<unordered_set&>(*this);
+   std::vector<T> keys;
+   keys.reserve(size());
+   for (auto it = self.begin(); it != self.end(); ++it)
+      keys.push_back(*it);
+   return frozen_set<T, H, E>(std::move(keys), hashFunction, executor);
+}
+
+/*****************************************
+ * UNORDERED SET :: FIND HASHED
+ * Find an element whose hash and new bucket are
+ * already known. The filter turns most misses away
+ * first. Insert and erase look here, so nothing is
+ * counted: the filter's stats are for lookups.
+ ****************************************/
+template <typename T, typename H, typename E, typename A, typename I>
+template <class K>
+typename unordered_set <T, H, E, A, I> ::iterator unordered_set<T, H, E, A, I>::findHashed(const K& key, size_t hash, size_t iBucket)
+{
+   if (filter.active() && !filter.may_contain(hash))
+      return end();
+   return findInTables(key, hash, iBucket);
+}
+
+/*****************************************
+ * UNORDERED SET :: LOOKUP HASHED
+ * findHashed for find and find_many, counting the
+ * misses the filter turns away and the ones it
+ * lets through
+ ****************************************/
+template <typename T, typename H, typename E, typename A, typename I>
+template <class K>
+typename unordered_set <T, H, E, A, I> ::iterator unordered_set<T, H, E, A, I>::lookupHashed(const K& key, size_t hash, size_t iBucket)
+{
+   if (filter.active() && !filter.admits(hash))
+      return end();
+
+   iterator it = findInTables(key, hash, iBucket);
+   if (filter.active() && it == end())
+      filter.missed();
+   return it;
+}
+
+/*****************************************
+ * UNORDERED SET :: FIND IN TABLES
+ * The new bucket, and while rehashing the old
+ * one if it has not migrated yet
+ ****************************************/
+template <typename T, typename H, typename E, typename A, typename I>
+template <class K>
+typename unordered_set <T, H, E, A, I> ::iterator unordered_set<T, H, E, A, I>::findInTables(const K& key, size_t hash, size_t iBucket)
+{
+   iterator it = end();
+   if (rehashing())
+   {
+      size_t iOld = indexPolicy.index(hash, bucketsOld.size());
+      if (iOld >= iMigrate)
+         it = findInBucket(bucketsOld, key, hash, iOld);
+   }
+   if (it == end())
+      it = findInBucket(buckets, key, hash, iBucket);
+   return it;
+}
+
+/*****************************************
+ * UNORDERED SET :: REBUILD FILTER
+ * Size the filter for what the table holds before
+ * it next grows and add every element again
+ ****************************************/
+template <typename T, typename H, typename E, typename A, typename I>
+void unordered_set<T, H, E, A, I>::rebuildFilter()
+{
+   if (!filter.active())
+      return;
+
+   size_t numKeys = std::max((size_t)numElements, (size_t)(bucket_count() * maxLoadFactor));
+   filter.configure(filter.bits_per_key(), numKeys);
+   for (size_t pass = 0; pass < 2; pass++)
+   {
+      custom::vector<Bucket>& table = pass ? bucketsOld : buckets;
+      for (size_t i = pass ? iMigrate : 0; i < table.size(); i++)
+         for (auto it = table[i].begin(); it != table[i].end(); ++it)
+            filter.add(hashOf(*it));
+   }
+}
+
+/*****************************************
+ * UNORDERED SET :: FIND IN BUCKET
+ * Find an element in the bucket it hashes to. The
+ * bucket is indexed directly so this is O(bucket_size)
+ ****************************************/
+template <typename T, typename H, typename E, typename A, typename I>
+template <class K>
+typename unordered_set <T, H, E, A, I> ::iterator unordered_set<T, H, E, A, I>::findInBucket(custom::vector<Bucket>& table, const K& key, size_t hash, size_t iBucket)
+{
+   // Walk the one list the element could be in. An iterator into
+   // the old table carries on into the new one.
+   for (auto itList = table[iBucket].begin(); itList != table[iBucket].end(); ++itList)
+   {
+      counters.probe();
+      if (holds(*itList, key, hash))
+         return iterator(table.end(),
+                         typename custom::vector<Bucket>::iterator(iBucket, table),
+                         itList,
+                         &table == &bucketsOld ? &buckets : nullptr);
    }
    return end();
 }
 
+/*****************************************
+ * UNORDERED SET :: BEGIN MIGRATION
+ * Start an incremental rehash: the current table
+ * becomes the old one and an empty table takes its place
+ ****************************************/
+template <typename T, typename H, typename E, typename A, typename I>
+void unordered_set<T, H, E, A, I>::beginMigration(size_t numBuckets)
+{
+   // Only one migration at a time
+   finishMigration();
+   thinned = false;
+   numBuckets = indexPolicy.bucket_count(numBuckets);
+   if (numBuckets <= bucket_count())
+      return;
+
+   counters.rehashed();
+   custom::vector<Bucket> bucketNew(numBuckets);
+   std::swap(bucketsOld, buckets);
+   std::swap(buckets, bucketNew);
+   iMigrate = 0;
+   rebuildFilter();
+}
+
+/*****************************************
+ * UNORDERED SET :: MIGRATE BUCKET
+ * Move every element of one old bucket into the new table.
+ * The nodes are spliced, so an iterator to one stays good.
+ ****************************************/
+template <typename T, typename H, typename E, typename A, typename I>
+void unordered_set<T, H, E, A, I>::migrateBucket(size_t iOld)
+{
+   Bucket& bucketOld = bucketsOld[iOld];
+   while (!bucketOld.empty())
+   {
+      Bucket& bucketNew = buckets[bucketOf(hashOf(*bucketOld.begin()))];
+      bucketNew.splice(bucketNew.end(), bucketOld, bucketOld.begin());
+   }
+}
+
+/*****************************************
+ * UNORDERED SET :: MIGRATE
+ * Move up to numSteps non-empty old buckets. Like the
+ * Redis dict, runs of empty buckets are bounded too.
+ ****************************************/
+template <typename T, typename H, typename E, typename A, typename I>
+void unordered_set<T, H, E, A, I>::migrate(size_t numSteps)
+{
+   size_t numEmpty = numSteps * 10;
+   while (numSteps > 0 && iMigrate < bucketsOld.size())
+   {
+      if (bucketsOld[iMigrate].empty())
+      {
+         iMigrate++;
+         if (--numEmpty == 0)
+            break;
+         continue;
+      }
+      migrateBucket(iMigrate++);
+      numSteps--;
+   }
+
+   // The last old bucket is gone: drop the old table
+   if (iMigrate == bucketsOld.size())
+   {
+      bucketsOld = custom::vector<Bucket>();
+      iMigrate = 0;
+   }
+}
+
 /*****************************************
  * UNORDERED SET :: ITERATOR :: INCREMENT
  * Advance by one element in an unordered set
  ****************************************/
-template <typename T, typename H, typename E, typename A>
-typename unordered_set <T, H, E, A> ::iterator & unordered_set<T, H, E, A>::iterator::operator ++ ()
+template <typename T, typename H, typename E, typename A, typename I>
+typename unordered_set <T, H, E, A, I> ::iterator & unordered_set<T, H, E, A, I>::iterator::operator ++ ()
 {
    
    // Only advance if we are not already at the end
@@ -539,6 +1711,16 @@ typename unordered_set <T, H, E, A> ::iterator & unordered_set<T, H, E, A>::iter
    ++itVector;
    while (itVector != itVectorEnd && (*itVector).empty())
       ++itVector;
+
+   // At the end of the old table, carry on into the new one.
+   if (itVector == itVectorEnd && pBucketsNext != nullptr)
+   {
+      itVectorEnd = pBucketsNext->end();
+      itVector = pBucketsNext->begin();
+      pBucketsNext = nullptr;
+      while (itVector != itVectorEnd && (*itVector).empty())
+         ++itVector;
+   }
    if (itVector != itVectorEnd)
       itList = (*itVector).begin();
    return *this;
@@ -548,8 +1730,8 @@ typename unordered_set <T, H, E, A> ::iterator & unordered_set<T, H, E, A>::iter
  * SWAP
  * Stand-alone unordered set swap
  ****************************************/
-template <typename T, typename H, typename E, typename A>
-void swap(unordered_set<T,H,E,A>& lhs, unordered_set<T,H,E,A>& rhs)
+template <typename T, typename H, typename E, typename A, typename I>
+void swap(unordered_set<T,H,E,A,I>& lhs, unordered_set<T,H,E,A,I>& rhs)
 {
    std::swap(lhs, rhs);
 }
@@ -0,0 +1,371 @@
+/***********************************************************************
+ * Header:
+ *    HASH FUNCTION
+ * Summary:
+ *    A seeded family of hash functions to use in place of std::hash.
+ *    std::hash<int> is the identity, so keys that share their low bits
+ *    share their buckets. These mix every bit of the key with a seed
+ *    in the style of wyhash: a 64 by 64 bit multiply folded to 64 bits.
+ *       hash<integer or enum>   : one fold of the key and the seed
+ *       hash<float or double>   : the bits, with -0.0 the same as 0.0
+ *       hash<T*>                : the address
+ *       hash<basic_string>      : hash_bytes over the characters,
+ *                                 transparent to pointers and views
+ *       hash<std::pair, tuple>  : the element hashes, combined in order
+ *       hash<custom::pair>      : the first only, as pair::operator==
+ *
+ *    Every one takes its seed in the constructor. The default is drawn
+ *    once for the process, so an attacker who does not know it cannot
+ *    choose keys that all land in one chain.
+ *
+ *    This will contain the class definition of:
+ *        hash, and the functions hash_bytes, hash_combine
+ * Author
+ *       Marco Varela &  Andre Regino
+ ************************************************************************/
+
+#pragma once
+
+#include "hashPolicy.h" // for mulhi64 and cache_hash_code
+#include "pair.h"       // for custom::pair
+#include <chrono>       // for std::chrono::steady_clock
+#include <cstddef>      // for size_t
+#include <cstdint>      // for uint64_t and uintptr_t
+#include <cstring>      // for std::memcpy
+#include <random>       // for std::random_device
+#include <string>       // for std::basic_string
+#include <tuple>        // for std::tuple
+#include <type_traits>  // for std::enable_if
+#include <utility>      // for std::pair and std::index_sequence
+#if __cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+#include <string_view>  // for std::basic_string_view
+#define CUSTOM_HASH_STRING_VIEW
+#endif
+
+namespace custom
+{
+
+// the wyhash constants: odd, with half their bits set
+const uint64_t HASH_P0 = 0xa0761d6478bd642fULL;
+const uint64_t HASH_P1 = 0xe7037ed1a0b428dbULL;
+const uint64_t HASH_P2 = 0x8ebc6af09c88c6e3ULL;
+const uint64_t HASH_P3 = 0x589965cc75374cc3ULL;
+
+/*****************************************************
+ * HASH MIX
+ * The 128 bit product of a and b folded to 64 bits
+ ****************************************************/
+inline uint64_t hash_mix(uint64_t a, uint64_t b)
+{
+   return (a * b) ^ mulhi64(a, b);
+}
+
+/*****************************************************
+ * DEFAULT HASH SEED
+ * One seed for the process, drawn the first time it
+ * is asked for. Different every run where the
+ * platform has a random device.
+ ****************************************************/
+inline uint64_t default_hash_seed()
+{
+   static const uint64_t seed = []()
+   {
+      int local = 0;
+      uint64_t s = (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count();
+      s ^= (uint64_t)(uintptr_t)&local;
+      try
+      {
+         std::random_device device;
+         s ^= ((uint64_t)device() << 32) | device();
+      }
+      catch (...)
+      {
+         // no random device: the clock and the stack address will do
+      }
+      return hash_mix(s ^ HASH_P0, HASH_P1);
+   }();
+   return seed;
+}
+
+/*****************************************************
+ * HASH BYTES
+ * wyhash over len bytes. Reads at most 8 bytes at
+ * a time, never past the end.
+ ****************************************************/
+inline uint64_t hashRead8(const unsigned char * p)
+{
+   uint64_t v;
+   std::memcpy(&v, p, 8);
+   return v;
+}
+inline uint64_t hashRead4(const unsigned char * p)
+{
+   uint32_t v;
+   std::memcpy(&v, p, 4);
+   return v;
+}
+inline uint64_t hash_bytes(const void * data, size_t len, uint64_t seed)
+{
+   const unsigned char * p = (const unsigned char *)data;
+   seed ^= hash_mix(seed ^ HASH_P0, HASH_P1);
+   uint64_t a;
+   uint64_t b;
+   if (len <= 16)
+   {
+      if (len >= 4)
+      {
+         // two overlapping reads from each end cover 4 to 16 bytes
+         size_t shift = (len >> 3) << 2;
+         a = (hashRead4(p) << 32) | hashRead4(p + shift);
+         b = (hashRead4(p + len - 4) << 32) | hashRead4(p + len - 4 - shift);
+      }
+      else if (len > 0)
+      {
+         a = ((uint64_t)p[0] << 16) | ((uint64_t)p[len >> 1] << 8) | p[len - 1];
+         b = 0;
+      }
+      else
+         a = b = 0;
+   }
+   else
+   {
+      size_t i = len;
+      if (i > 48)
+      {
+         // three independent lanes keep the multiplier busy
+         uint64_t see1 = seed;
+         uint64_t see2 = seed;
+         do
+         {
+            seed = hash_mix(hashRead8(p)      ^ HASH_P1, hashRead8(p + 8)  ^ seed);
+            see1 = hash_mix(hashRead8(p + 16) ^ HASH_P2, hashRead8(p + 24) ^ see1);
+            see2 = hash_mix(hashRead8(p + 32) ^ HASH_P3, hashRead8(p + 40) ^ see2);
+            p += 48;
+            i -= 48;
+         }
+         while (i > 48);
+         seed ^= see1 ^ see2;
+      }
+      while (i > 16)
+      {
+         seed = hash_mix(hashRead8(p) ^ HASH_P1, hashRead8(p + 8) ^ seed);
+         p += 16;
+         i -= 16;
+      }
+      a = hashRead8(p + i - 16);
+      b = hashRead8(p + i - 8);
+   }
+   a ^= HASH_P1;
+   b ^= seed;
+   uint64_t lo = a * b;
+   uint64_t hi = mulhi64(a, b);
+   return hash_mix(lo ^ HASH_P0 ^ len, hi ^ HASH_P1);
+}
+
+/*****************************************************
+ * HASH COMBINE
+ * Fold the hash of one more element into h. The
+ * order matters: (1, 2) and (2, 1) differ.
+ ****************************************************/
+inline uint64_t hash_combine(uint64_t h, uint64_t hElement)
+{
+   return hash_mix(h ^ HASH_P2, hElement ^ HASH_P3);
+}
+
+/************************************************
+ * HASH
+ * Only the specializations below are defined. The
+ * second parameter lets one cover a whole family.
+ ************************************************/
+template <typename T, typename Enable = void>
+class hash;
+
+/************************************************
+ * HASH : INTEGER AND ENUM
+ * Two folds: the seed into the key, then the
+ * result once more so every bit reaches the low
+ * bits a modulo index keeps
+ ************************************************/
+template <typename T>
+class hash<T, typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type>
+{
+public:
+   hash() : seedValue(default_hash_seed())            { }
+   explicit hash(uint64_t seed) : seedValue(seed)     { }
+   uint64_t seed() const                              { return seedValue; }
+
+   size_t operator () (T t) const
+   {
+      uint64_t h = hash_mix((uint64_t)t ^ HASH_P0, seedValue ^ HASH_P1);
+      return (size_t)hash_mix(h ^ HASH_P2, HASH_P3);
+   }
+
+private:
+   uint64_t seedValue;   // chosen at construction, the same for every key
+};
+
+/************************************************
+ * HASH : FLOATING POINT
+ * The bits of the value as a double, which has no
+ * padding to hash. 0.0 == -0.0, so both hash as 0.0
+ ************************************************/
+template <typename T>
+class hash<T, typename std::enable_if<std::is_floating_point<T>::value>::type>
+{
+public:
+   hash() : seedValue(default_hash_seed())            { }
+   explicit hash(uint64_t seed) : seedValue(seed)     { }
+   uint64_t seed() const                              { return seedValue; }
+
+   size_t operator () (T t) const
+   {
+      double d = (double)t;
+      if (d == 0)
+         d = 0;
+      return (size_t)hash_bytes(&d, sizeof(d), seedValue);
+   }
+
+private:
+   uint64_t seedValue;   // chosen at construction, the same for every key
+};
+
+/************************************************
+ * HASH : POINTER
+ * The address, mixed as an integer
+ ************************************************/
+template <typename T>
+class hash<T *, void>
+{
+public:
+   hash() : hashAddress()                             { }
+   explicit hash(uint64_t seed) : hashAddress(seed)   { }
+   uint64_t seed() const                              { return hashAddress.seed(); }
+
+   size_t operator () (T * p) const
+   {
+      return hashAddress((uintptr_t)p);
+   }
+
+private:
+   hash<uintptr_t> hashAddress;   // the integer hash of the address
+};
+
+/************************************************
+ * HASH : STRING
+ * The characters, not the object. Transparent, so
+ * a set of strings finds a pointer to characters
+ * or a string_view without building a string.
+ ************************************************/
+template <typename C, typename Tr, typename Al>
+class hash<std::basic_string<C, Tr, Al>, void>
+{
+public:
+   typedef void is_transparent;
+
+   hash() : seedValue(default_hash_seed())            { }
+   explicit hash(uint64_t seed) : seedValue(seed)     { }
+   uint64_t seed() const                              { return seedValue; }
+
+   size_t operator () (const std::basic_string<C, Tr, Al>& s) const
+   {
+      return (size_t)hash_bytes(s.data(), s.size() * sizeof(C), seedValue);
+   }
+   size_t operator () (const C * s) const
+   {
+      return (size_t)hash_bytes(s, Tr::length(s) * sizeof(C), seedValue);
+   }
+#ifdef CUSTOM_HASH_STRING_VIEW
+   size_t operator () (std::basic_string_view<C, Tr> s) const
+   {
+      return (size_t)hash_bytes(s.data(), s.size() * sizeof(C), seedValue);
+   }
+#endif
+
+private:
+   uint64_t seedValue;   // chosen at construction, the same for every key
+};
+
+// a string hash is worth keeping next to the string
+template <typename C, typename Tr, typename Al>
+struct cache_hash_code<std::basic_string<C, Tr, Al>, hash<std::basic_string<C, Tr, Al>>>
+   : std::true_type
+{
+};
+
+/************************************************
+ * HASH : STD PAIR
+ * Both elements, hashed with the same seed
+ ************************************************/
+template <typename T1, typename T2>
+class hash<std::pair<T1, T2>, void>
+{
+public:
+   hash() : hashFirst(), hashSecond(hashFirst.seed())               { }
+   explicit hash(uint64_t seed) : hashFirst(seed), hashSecond(seed) { }
+   uint64_t seed() const                                            { return hashFirst.seed(); }
+
+   size_t operator () (const std::pair<T1, T2>& p) const
+   {
+      return (size_t)hash_combine(hashFirst(p.first), hashSecond(p.second));
+   }
+
+private:
+   hash<T1> hashFirst;    // for p.first
+   hash<T2> hashSecond;   // for p.second
+};
+
+/************************************************
+ * HASH : CUSTOM PAIR
+ * Two custom::pairs are equal when their firsts
+ * are, so only the first is hashed
+ ************************************************/
+template <typename T1, typename T2, typename C>
+class hash<custom::pair<T1, T2, C>, void>
+{
+public:
+   hash() : hashFirst()                               { }
+   explicit hash(uint64_t seed) : hashFirst(seed)     { }
+   uint64_t seed() const                              { return hashFirst.seed(); }
+
+   size_t operator () (const custom::pair<T1, T2, C>& p) const
+   {
+      return hashFirst(p.first);
+   }
+
+private:
+   hash<T1> hashFirst;   // for p.first
+};
+
+/************************************************
+ * HASH : TUPLE
+ * Every element in order, each with the hash of
+ * its own type and the one seed
+ ************************************************/
+template <typename ... Ts>
+class hash<std::tuple<Ts...>, void>
+{
+public:
+   hash() : seedValue(default_hash_seed())            { }
+   explicit hash(uint64_t seed) : seedValue(seed)     { }
+   uint64_t seed() const                              { return seedValue; }
+
+   size_t operator () (const std::tuple<Ts...>& t) const
+   {
+      return (size_t)combine(t, std::index_sequence_for<Ts...>());
+   }
+
+private:
+   template <size_t ... Is>
+   uint64_t combine(const std::tuple<Ts...>& t, std::index_sequence<Is...>) const
+   {
+      uint64_t h = seedValue;
+      // a braced list runs its elements in order
+      int order[] = { 0, (h = hash_combine(h, hash<Ts>(seedValue)(std::get<Is>(t))), 0)... };
+      (void)order;
+      return h;
+   }
+
+   uint64_t seedValue;   // chosen at construction, the same for every key
+};
+
+}
@@ -0,0 +1,274 @@
+/***********************************************************************
+ * Header:
+ *    HASH POLICY
+ * Summary:
+ *    Bucket index policies for custom::unordered_set. A policy decides
+ *    which bucket counts are legal and how a hash becomes a bucket index:
+ *       modulo_index       : hash % n, any n (the original behavior)
+ *       power_of_two_index : mix the hash and mask it, n a power of two
+ *       fastrange_index    : multiply-high into [0, n), any n, no divide
+ *       prime_index        : n from a prime table, the folded hash mod n
+ *                            through Lemire's fastmod, for weak hashes
+ *
+ *    It also holds the trait that decides whether a bucket stores the
+ *    full hash next to each element:
+ *       cache_hash_code<T, Hash> : true to keep the hash in the node
+ *
+ *    and the trait that decides whether find, erase and bucket take
+ *    a key of another type than the element, such as a string_view:
+ *       transparent_lookup<Hash, EqPred> : both define is_transparent
+ *
+ *    This will contain the class definition of:
+ *        modulo_index, power_of_two_index, fastrange_index, prime_index,
+ *        cache_hash_code, hashed_value, transparent_lookup
+ * Author
+ *       Marco Varela &  Andre Regino
+ ************************************************************************/
+
+#pragma once
+
+#include <cstddef>      // for size_t
+#include <cstdint>      // for uint32_t and uint64_t
+#include <functional>   // for std::hash
+#include <string>       // for std::basic_string
+#include <type_traits>  // for std::true_type and std::false_type
+#include <utility>      // for std::move
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>     // for __umulh and _mm_prefetch
+#endif
+
+class TestHashPolicy;   // forward declaration for HashPolicy unit tests
+
+namespace custom
+{
+
+/*****************************************************
+ * MUL HI 64
+ * The high 64 bits of the 128 bit product a * b
+ ****************************************************/
+inline uint64_t mulhi64(uint64_t a, uint64_t b)
+{
+#if defined(__SIZEOF_INT128__)
+   return (uint64_t)(((unsigned __int128)a * b) >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+   return __umulh(a, b);
+#else
+   uint64_t aLo = (uint32_t)a, aHi = a >> 32;
+   uint64_t bLo = (uint32_t)b, bHi = b >> 32;
+   uint64_t mid1 = aHi * bLo + ((aLo * bLo) >> 32);
+   uint64_t mid2 = aLo * bHi + (uint32_t)mid1;
+   return aHi * bHi + (mid1 >> 32) + (mid2 >> 32);
+#endif
+}
+
+/*****************************************************
+ * MIX 64
+ * The murmur3 finalizer: every input bit reaches
+ * every output bit, so the low bits of an identity
+ * hash (std::hash<int>) are worth masking
+ ****************************************************/
+constexpr uint64_t mix64(uint64_t h)
+{
+   h ^= h >> 33;
+   h *= 0xff51afd7ed558ccdULL;
+   h ^= h >> 33;
+   h *= 0xc4ceb9fe1a85ec53ULL;
+   h ^= h >> 33;
+   return h;
+}
+
+/*****************************************************
+ * PREFETCH
+ * Start loading the cache line holding p without
+ * waiting for it. Only a hint: it never faults
+ ****************************************************/
+inline void prefetch(const void * p)
+{
+#if defined(__GNUC__) || defined(__clang__)
+   __builtin_prefetch(p);
+#elif defined(_MSC_VER) && defined(_M_X64)
+   _mm_prefetch((const char *)p, _MM_HINT_T0);
+#else
+   (void)p;
+#endif
+}
+
+/************************************************
+ * MODULO INDEX
+ * hash % n: any bucket count, one 64 bit divide
+ ************************************************/
+class modulo_index
+{
+public:
+   size_t bucket_count(size_t num) const
+   {
+      return num;
+   }
+   size_t index(size_t hash, size_t numBuckets)
+   {
+      return hash % numBuckets;
+   }
+};
+
+/************************************************
+ * POWER OF TWO INDEX
+ * Round every bucket count up to a power of two
+ * and mask the mixed hash. No divide at all.
+ ************************************************/
+class power_of_two_index
+{
+public:
+   size_t bucket_count(size_t num) const
+   {
+      size_t numBuckets = 1;
+      while (numBuckets < num)
+         numBuckets *= 2;
+      return numBuckets;
+   }
+   size_t index(size_t hash, size_t numBuckets)
+   {
+      return (size_t)mix64(hash) & (numBuckets - 1);
+   }
+};
+
+/************************************************
+ * FASTRANGE INDEX
+ * Lemire's fastrange: the high half of hash * n
+ * lands in [0, n) for any n. It reads the top
+ * bits, so the hash is spread with a multiply first.
+ ************************************************/
+class fastrange_index
+{
+public:
+   size_t bucket_count(size_t num) const
+   {
+      return num;
+   }
+   size_t index(size_t hash, size_t numBuckets)
+   {
+      return (size_t)mulhi64((uint64_t)hash * 0x9E3779B97F4A7C15ULL, numBuckets);
+   }
+};
+
+/************************************************
+ * PRIME INDEX
+ * Round every bucket count up to a prime so a weak
+ * hash (such as the digit sum of std::hash<Spy>)
+ * does not fall into a pattern of the bucket count.
+ * The hash is folded to 32 bits and the remainder
+ * comes from Lemire's fastmod, with the magic number
+ * cached for the current count.
+ ************************************************/
+class prime_index
+{
+   friend class ::TestHashPolicy;   // give unit tests access to the privates
+public:
+   prime_index() : divisor(0), magic(0)
+   {
+   }
+   size_t bucket_count(size_t num) const
+   {
+      // roughly doubling primes, each below 2^32
+      static const uint32_t primes[] =
+      {
+         5u, 11u, 23u, 47u, 97u, 199u, 409u, 823u, 1741u, 3469u, 6949u,
+         14033u, 28411u, 57557u, 116731u, 236897u, 480881u, 976369u,
+         1982627u, 4026031u, 8175383u, 16601593u, 33712729u, 68460391u,
+         139022417u, 282312799u, 573292817u, 1164186217u, 2364114217u,
+         4294967291u
+      };
+      for (uint32_t prime : primes)
+         if (prime >= num)
+            return prime;
+      return num;
+   }
+   size_t index(size_t hash, size_t numBuckets)
+   {
+      // fastmod works on 32 bit values
+      if ((uint64_t)numBuckets > 0xFFFFFFFFULL)
+         return hash % numBuckets;
+      if (numBuckets != divisor)
+      {
+         divisor = numBuckets;
+         magic = ~(uint64_t)0 / divisor + 1;
+      }
+      uint32_t h = (uint32_t)((uint64_t)hash ^ ((uint64_t)hash >> 32));
+      return (size_t)mulhi64(magic * h, divisor);
+   }
+
+private:
+   size_t   divisor;   // the bucket count the magic number is for
+   uint64_t magic;     // ceil(2^64 / divisor)
+};
+
+/************************************************
+ * CACHE HASH CODE
+ * Should unordered_set<T, Hash> keep each element's
+ * full hash in its node? Then rehash never calls Hash
+ * and a chain walk skips EqPred when the hashes differ.
+ * It costs a size_t per element, so it is off unless
+ * specialized to true. Strings hashed by std::hash are
+ * long enough to hash and compare that it is on.
+ ************************************************/
+template <typename T, typename Hash>
+struct cache_hash_code : std::false_type
+{
+};
+template <typename C, typename Tr, typename Al>
+struct cache_hash_code<std::basic_string<C, Tr, Al>, std::hash<std::basic_string<C, Tr, Al>>>
+   : std::true_type
+{
+};
+
+/************************************************
+ * HASHED VALUE
+ * An element and the full hash it was stored with:
+ * what a bucket holds when cache_hash_code is true
+ ************************************************/
+template <typename T>
+struct hashed_value
+{
+   hashed_value(const T& value, size_t hash) : value(value), hash(hash)
+   {
+   }
+   hashed_value(T&& value, size_t hash) : value(std::move(value)), hash(hash)
+   {
+   }
+
+   T      value;   // the element itself
+   size_t hash;    // Hash of the element, before any index policy
+};
+
+/************************************************
+ * HAS IS TRANSPARENT
+ * Does a function object declare is_transparent,
+ * promising to take any key it can compare or hash?
+ ************************************************/
+template <typename F>
+struct has_is_transparent
+{
+private:
+   template <typename U>
+   static std::true_type test(typename U::is_transparent *);
+   template <typename U>
+   static std::false_type test(...);
+public:
+   static const bool value = decltype(test<F>(nullptr))::value;
+};
+
+/************************************************
+ * TRANSPARENT LOOKUP
+ * Can unordered_set<T, Hash, EqPred> look up a key
+ * of type K without building a T from it? Only when
+ * both Hash and EqPred opt in, as in the standard.
+ * K only makes the test depend on the lookup key, so
+ * an overload on K drops out rather than failing.
+ ************************************************/
+template <typename Hash, typename EqPred, typename K = void>
+struct transparent_lookup
+   : std::integral_constant<bool, has_is_transparent<Hash>::value && has_is_transparent<EqPred>::value>
+{
+};
+
+}
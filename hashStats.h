@@ -0,0 +1,195 @@
+/***********************************************************************
+ * Header:
+ *    HASH STATS
+ * Summary:
+ *    The health of a custom::unordered_set: how long its chains are and,
+ *    when it is instrumented, how much work its finds and inserts do.
+ *    A bad hash shows up as long chains and many empty buckets.
+ *       hash_stats               : what unordered_set::stats() reports
+ *       instrument_hash<T, Hash> : true to count every probe and rehash
+ *       hash_counters<On>        : those counts, an empty class when off
+ *
+ *    This will contain the class definition of:
+ *        hash_stats, instrument_hash, hash_counters
+ * Author
+ *       Marco Varela &  Andre Regino
+ ************************************************************************/
+
+#pragma once
+
+#include <cstddef>      // for size_t
+#include <type_traits>  // for std::false_type
+#include <vector>       // for std::vector of chain counts
+
+class TestHashStats;    // forward declaration for HashStats unit tests
+
+namespace custom
+{
+
+/************************************************
+ * INSTRUMENT HASH
+ * Should unordered_set<T, Hash> count the elements
+ * each find and insert compares, and each rehash?
+ * Off unless specialized to true, so the default
+ * build carries no counters and no extra work.
+ ************************************************/
+template <typename T, typename Hash>
+struct instrument_hash : std::false_type
+{
+};
+
+/************************************************
+ * HASH STATS
+ * A snapshot of a table. The shape of the chains
+ * is always there; the cumulative counts are zero
+ * unless the set is instrumented, and the Bloom
+ * filter counts are zero unless it has one.
+ ************************************************/
+struct hash_stats
+{
+   hash_stats() : numElements(0), numBuckets(0), loadFactor(0),
+                  maxChain(0), meanChain(0), emptyRatio(0), instrumented(false),
+                  numRehashes(0), numFinds(0), numFindCompares(0),
+                  numInserts(0), numInsertCompares(0), bloomBitsPerKey(0), bloomBytes(0),
+                  bloomRejected(0), bloomFalsePositives(0)
+   {
+   }
+
+   // the mean elements compared by one find or one insert
+   float comparesPerFind() const
+   {
+      return numFinds ? (float)numFindCompares / (float)numFinds : 0;
+   }
+   float comparesPerInsert() const
+   {
+      return numInserts ? (float)numInsertCompares / (float)numInserts : 0;
+   }
+
+   // the share of the misses that the Bloom filter let through
+   float bloomFalsePositiveRate() const
+   {
+      size_t numMisses = bloomRejected + bloomFalsePositives;
+      return numMisses ? (float)bloomFalsePositives / (float)numMisses : 0;
+   }
+
+   // fold in the stats of another table, as if the two were one
+   void merge(const hash_stats& rhs)
+   {
+      numElements += rhs.numElements;
+      numBuckets  += rhs.numBuckets;
+      if (rhs.chains.size() > chains.size())
+         chains.resize(rhs.chains.size(), 0);
+      for (size_t length = 0; length < rhs.chains.size(); length++)
+         chains[length] += rhs.chains[length];
+      maxChain = chains.empty() ? 0 : chains.size() - 1;
+
+      size_t numEmpty = chains.empty() ? 0 : chains[0];
+      loadFactor = numBuckets ? (float)numElements / (float)numBuckets : 0;
+      emptyRatio = numBuckets ? (float)numEmpty / (float)numBuckets : 0;
+      meanChain  = numBuckets > numEmpty ? (float)numElements / (float)(numBuckets - numEmpty) : 0;
+
+      instrumented       = instrumented || rhs.instrumented;
+      numRehashes       += rhs.numRehashes;
+      numFinds          += rhs.numFinds;
+      numFindCompares   += rhs.numFindCompares;
+      numInserts        += rhs.numInserts;
+      numInsertCompares += rhs.numInsertCompares;
+
+      bloomBitsPerKey      = bloomBitsPerKey > rhs.bloomBitsPerKey ? bloomBitsPerKey : rhs.bloomBitsPerKey;
+      bloomBytes          += rhs.bloomBytes;
+      bloomRejected       += rhs.bloomRejected;
+      bloomFalsePositives += rhs.bloomFalsePositives;
+   }
+
+   size_t numElements;           // elements in the set
+   size_t numBuckets;            // buckets in the set, old and new while migrating
+   float  loadFactor;            // elements per bucket
+   std::vector<size_t> chains;   // chains[n] is how many buckets hold n elements
+   size_t maxChain;              // the longest chain
+   float  meanChain;             // the mean length of the chains that are not empty
+   float  emptyRatio;            // the share of the buckets that are empty
+
+   bool   instrumented;          // are the counts below being kept?
+   size_t numRehashes;           // rehashes and migrations started
+   size_t numFinds;              // finds, one for each key of a find_many
+   size_t numFindCompares;       // elements those finds compared
+   size_t numInserts;            // inserts, new or duplicate
+   size_t numInsertCompares;     // elements those inserts compared
+
+   size_t bloomBitsPerKey;       // the Bloom filter budget, 0 when there is none
+   size_t bloomBytes;            // the size of the filter
+   size_t bloomRejected;         // lookups the filter turned away
+   size_t bloomFalsePositives;   // lookups it let through that missed anyway
+};
+
+/************************************************
+ * HASH COUNTERS
+ * The cumulative counts of an instrumented set. A
+ * counted operation calls start(), every element a
+ * chain walk compares calls probe(), and the end
+ * call files the probes under that operation. When
+ * off every call is empty and inlines to nothing.
+ ************************************************/
+template <bool On>
+class hash_counters
+{
+public:
+   void start()                      { }
+   void probe()                      { }
+   void endFind()                    { }
+   void endInsert()                  { }
+   void rehashed()                   { }
+   void report(hash_stats&) const    { }
+};
+
+template <>
+class hash_counters<true>
+{
+   friend class ::TestHashStats;   // give unit tests access to the privates
+public:
+   hash_counters() : numProbes(0), numRehashes(0), numFinds(0), numFindCompares(0),
+                     numInserts(0), numInsertCompares(0)
+   {
+   }
+   void start()
+   {
+      numProbes = 0;
+   }
+   void probe()
+   {
+      numProbes++;
+   }
+   void endFind()
+   {
+      numFinds++;
+      numFindCompares += numProbes;
+   }
+   void endInsert()
+   {
+      numInserts++;
+      numInsertCompares += numProbes;
+   }
+   void rehashed()
+   {
+      numRehashes++;
+   }
+   void report(hash_stats& s) const
+   {
+      s.instrumented      = true;
+      s.numRehashes       = numRehashes;
+      s.numFinds          = numFinds;
+      s.numFindCompares   = numFindCompares;
+      s.numInserts        = numInserts;
+      s.numInsertCompares = numInsertCompares;
+   }
+
+private:
+   size_t numProbes;           // elements compared since the last start()
+   size_t numRehashes;         // rehashes and migrations started
+   size_t numFinds;            // finds counted
+   size_t numFindCompares;     // elements compared by those finds
+   size_t numInserts;          // inserts counted
+   size_t numInsertCompares;   // elements compared by those inserts
+};
+
+}
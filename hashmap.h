@@ -0,0 +1,445 @@
+/***********************************************************************
+ * Header:
+ *    HASH MAP
+ * Summary:
+ *    Our custom implementation of std::unordered_map. It uses the same
+ *    chained buckets as custom::unordered_set, a vector of lists, where
+ *    each element is a custom::pair of a key and its value. Every member
+ *    that adds a value builds it in place in its node, so a value is
+ *    never default-constructed and then assigned.
+ *
+ *    This will contain the class definition of:
+ *        unordered_map           : A class that represents a hash map
+ *        unordered_map::iterator : An interator through the map
+ * Author
+ *       Marco Varela &  Andre Regino
+ ************************************************************************/
+
+#pragma once
+
+#include "list.h"     // because this->buckets[0] is a list
+#include "vector.h"   // because this->buckets is a vector
+#include "pair.h"     // because each element is a custom::pair
+#include <cmath>      // for std::ceil
+#include <functional> // for std::hash
+#include <memory>     // for std::allocator
+#include <stdexcept>  // for std::out_of_range
+#include <tuple>      // for std::forward_as_tuple
+#include <utility>    // for std::piecewise_construct
+
+class TestHashMap;          // forward declaration for HashMap unit tests
+
+namespace custom
+{
+
+/************************************************
+ * UNORDERED MAP
+ * A map implemented as a hash
+ ************************************************/
+template <typename K,
+          typename V,
+          typename Hash = std::hash<K>,
+          typename EqPred = std::equal_to<K>,
+          typename A = std::allocator<custom::pair<const K, V>> >
+class unordered_map
+{
+   friend class ::TestHashMap;   // give unit tests access to the privates
+public:
+   typedef custom::pair<const K, V> value_type;
+private:
+   typedef custom::list<value_type, typename std::allocator_traits<A>::template rebind_alloc<value_type>> Bucket;
+public:
+   //
+   // Construct
+   //
+   unordered_map() : buckets(8), numElements(0), maxLoadFactor(1)
+   {
+   }
+   unordered_map(size_t numBuckets) : buckets(numBuckets), numElements(0), maxLoadFactor(1)
+   {
+   }
+   unordered_map(const std::initializer_list<value_type>& il) : buckets(8), numElements(0), maxLoadFactor(1)
+   {
+      for (auto& element : il)
+         insert(element);
+   }
+
+   //
+   // Iterator
+   //
+   class iterator;
+   iterator begin();
+   iterator end()
+   {
+      return iterator(buckets.end(), buckets.end(), buckets[0].end());
+   }
+
+   //
+   // Access
+   //
+   iterator find(const K& key);
+   size_t count(const K& key)
+   {
+      return find(key) == end() ? 0 : 1;
+   }
+   V& operator[](const K& key)
+   {
+      return (*try_emplace(key).first).second;
+   }
+   V& operator[](K&& key)
+   {
+      return (*try_emplace(std::move(key)).first).second;
+   }
+   V& at(const K& key);
+
+   //
+   // Insert
+   //
+   custom::pair<iterator, bool> insert(const value_type& element)
+   {
+      return emplaceKey(element.first, element);
+   }
+   template <class ... Args>
+   custom::pair<iterator, bool> try_emplace(const K& key, Args&& ... args)
+   {
+      return emplaceKey(key, std::piecewise_construct,
+                        std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...));
+   }
+   template <class ... Args>
+   custom::pair<iterator, bool> try_emplace(K&& key, Args&& ... args)
+   {
+      return emplaceKey(key, std::piecewise_construct,
+                        std::forward_as_tuple(std::move(key)), std::forward_as_tuple(std::forward<Args>(args)...));
+   }
+   template <class M>
+   custom::pair<iterator, bool> insert_or_assign(const K& key, M&& value);
+   template <class M>
+   custom::pair<iterator, bool> insert_or_assign(K&& key, M&& value);
+   void rehash(size_t numBuckets);
+   void reserve(size_t num)
+   {
+      rehash(min_buckets_required(num));
+   }
+
+   //
+   // Remove
+   //
+   void clear() noexcept
+   {
+      for (auto& bucket : buckets)
+         bucket.clear();
+      numElements = 0;
+   }
+   iterator erase(const K& key);
+
+   //
+   // Status
+   //
+   size_t size() const
+   {
+      return numElements;
+   }
+   bool empty() const
+   {
+      return size() == 0;
+   }
+   size_t bucket_count() const
+   {
+      return buckets.size();
+   }
+   size_t bucket_size(size_t i) const
+   {
+      return buckets[i].size();
+   }
+   float load_factor() const noexcept
+   {
+      return (float)size() / (float)bucket_count();
+   }
+   float max_load_factor() const noexcept
+   {
+      return maxLoadFactor;
+   }
+   void max_load_factor(float m)
+   {
+      maxLoadFactor = m;
+   }
+
+private:
+   size_t min_buckets_required(size_t num) const
+   {
+      return (size_t)std::ceil((float)num / maxLoadFactor);
+   }
+   size_t bucketOf(const K& key) const
+   {
+      return Hash()(key) % buckets.size();
+   }
+   iterator findInBucket(const K& key, size_t iBucket);
+   template <class ... Args>
+   custom::pair<iterator, bool> emplaceKey(const K& key, Args&& ... args);
+
+   custom::vector<Bucket> buckets;   // each bucket in the hash
+   size_t numElements;               // number of elements in the map
+   float maxLoadFactor;              // the ratio of elements to buckets signifying a rehash
+};
+
+
+/************************************************
+ * UNORDERED MAP ITERATOR
+ * Iterator for an unordered map
+ ************************************************/
+template <typename K, typename V, typename H, typename E, typename A>
+class unordered_map <K, V, H, E, A> ::iterator
+{
+   friend class ::TestHashMap;   // give unit tests access to the privates
+   template <typename KK, typename VV, typename HH, typename EE, typename AA>
+   friend class custom::unordered_map;
+public:
+   //
+   // Construct
+   //
+   iterator()
+   {
+   }
+   iterator(const typename custom::vector<Bucket>::iterator& itVectorEnd,
+            const typename custom::vector<Bucket>::iterator& itVector,
+            const typename Bucket::iterator& itList)
+      : itVectorEnd(itVectorEnd), itList(itList), itVector(itVector)
+   {
+   }
+
+   //
+   // Compare
+   //
+   bool operator == (const iterator& rhs) const
+   {
+      return itList == rhs.itList && itVector == rhs.itVector && itVectorEnd == rhs.itVectorEnd;
+   }
+   bool operator != (const iterator& rhs) const
+   {
+      return !(*this == rhs);
+   }
+
+   //
+   // Access
+   //
+   value_type& operator * ()
+   {
+      return *itList;
+   }
+   value_type * operator -> ()
+   {
+      return &*itList;
+   }
+
+   //
+   // Arithmetic
+   //
+   iterator& operator ++ ();
+   iterator operator ++ (int postfix)
+   {
+      iterator temp(*this);
+      ++(*this);
+      return temp;
+   }
+
+private:
+   typename vector<Bucket>::iterator itVectorEnd;
+   typename Bucket::iterator itList;
+   typename vector<Bucket>::iterator itVector;
+};
+
+
+/*****************************************
+ * UNORDERED MAP :: BEGIN
+ * The first element of the first non-empty bucket
+ ****************************************/
+template <typename K, typename V, typename H, typename E, typename A>
+typename unordered_map <K, V, H, E, A> ::iterator unordered_map<K, V, H, E, A>::begin()
+{
+   for (auto itBucket = buckets.begin(); itBucket != buckets.end(); itBucket++)
+      if (!(*itBucket).empty())
+         return iterator(buckets.end(), itBucket, (*itBucket).begin());
+   return end();
+}
+
+/*****************************************
+ * UNORDERED MAP :: FIND IN BUCKET
+ * Find a key in the bucket it hashes to
+ ****************************************/
+template <typename K, typename V, typename H, typename E, typename A>
+typename unordered_map <K, V, H, E, A> ::iterator unordered_map<K, V, H, E, A>::findInBucket(const K& key, size_t iBucket)
+{
+   E equal;
+   for (auto itList = buckets[iBucket].begin(); itList != buckets[iBucket].end(); ++itList)
+      if (equal((*itList).first, key))
+         return iterator(buckets.end(),
+                         typename custom::vector<Bucket>::iterator(iBucket, buckets),
+                         itList);
+   return end();
+}
+
+/*****************************************
+ * UNORDERED MAP :: FIND
+ * Find the element with a given key
+ ****************************************/
+template <typename K, typename V, typename H, typename E, typename A>
+typename unordered_map <K, V, H, E, A> ::iterator unordered_map<K, V, H, E, A>::find(const K& key)
+{
+   return findInBucket(key, bucketOf(key));
+}
+
+/*****************************************
+ * UNORDERED MAP :: AT
+ * The value of a key that must be present
+ ****************************************/
+template <typename K, typename V, typename H, typename E, typename A>
+V& unordered_map<K, V, H, E, A>::at(const K& key)
+{
+   iterator it = find(key);
+   if (it == end())
+      throw std::out_of_range("custom::unordered_map::at: key not found");
+   return (*it).second;
+}
+
+/*****************************************
+ * UNORDERED MAP :: EMPLACE KEY
+ * Insert an element built in place from args unless
+ * key is already there. If it is, args are not touched:
+ * nothing is copied, moved, or allocated.
+ ****************************************/
+template <typename K, typename V, typename H, typename E, typename A>
+template <class ... Args>
+custom::pair<typename unordered_map <K, V, H, E, A> ::iterator, bool>
+unordered_map<K, V, H, E, A>::emplaceKey(const K& key, Args&& ... args)
+{
+   // See if the key is already there. If so, then return out.
+   size_t iBucket = bucketOf(key);
+   iterator itFound = findInBucket(key, iBucket);
+   if (itFound != end())
+      return custom::pair<iterator, bool>(itFound, false);
+
+   // Grow first so the new node is never moved
+   if (min_buckets_required(numElements + 1) > bucket_count())
+   {
+      rehash(bucket_count() * 2);
+      iBucket = bucketOf(key);
+   }
+
+   // Build the element in a new node on the back of the bucket
+   buckets[iBucket].emplace_back(std::forward<Args>(args)...);
+   numElements++;
+   return custom::pair<iterator, bool>(
+      iterator(buckets.end(),
+               typename custom::vector<Bucket>::iterator(iBucket, buckets),
+               buckets[iBucket].rbegin()),
+      true);
+}
+
+/*****************************************
+ * UNORDERED MAP :: INSERT OR ASSIGN
+ * Assign the value of a key that is there,
+ * otherwise build a new element from it
+ ****************************************/
+template <typename K, typename V, typename H, typename E, typename A>
+template <class M>
+custom::pair<typename unordered_map <K, V, H, E, A> ::iterator, bool>
+unordered_map<K, V, H, E, A>::insert_or_assign(const K& key, M&& value)
+{
+   iterator it = find(key);
+   if (it != end())
+   {
+      (*it).second = std::forward<M>(value);
+      return custom::pair<iterator, bool>(it, false);
+   }
+   return try_emplace(key, std::forward<M>(value));
+}
+
+/*****************************************
+ * UNORDERED MAP :: INSERT OR ASSIGN - MOVE
+ * As above, moving the key into a new element.
+ * A key that is there is left untouched.
+ ****************************************/
+template <typename K, typename V, typename H, typename E, typename A>
+template <class M>
+custom::pair<typename unordered_map <K, V, H, E, A> ::iterator, bool>
+unordered_map<K, V, H, E, A>::insert_or_assign(K&& key, M&& value)
+{
+   iterator it = find(key);
+   if (it != end())
+   {
+      (*it).second = std::forward<M>(value);
+      return custom::pair<iterator, bool>(it, false);
+   }
+   return try_emplace(std::move(key), std::forward<M>(value));
+}
+
+/*****************************************
+ * UNORDERED MAP :: ERASE
+ * Remove the element with a given key. Return the
+ * element after it
+ ****************************************/
+template <typename K, typename V, typename H, typename E, typename A>
+typename unordered_map <K, V, H, E, A> ::iterator unordered_map<K, V, H, E, A>::erase(const K& key)
+{
+   size_t iBucket = bucketOf(key);
+   iterator itErase = findInBucket(key, iBucket);
+   if (itErase == end())
+      return itErase;
+
+   iterator itReturn = itErase;
+   ++itReturn;
+   buckets[iBucket].erase(itErase.itList);
+   numElements--;
+   return itReturn;
+}
+
+/*****************************************
+ * UNORDERED MAP :: REHASH
+ * Grow to at least numBuckets buckets. Each node
+ * is spliced, so no element is copied or moved
+ ****************************************/
+template <typename K, typename V, typename H, typename E, typename A>
+void unordered_map<K, V, H, E, A>::rehash(size_t numBuckets)
+{
+   // If the current bucket count is sufficient, then do nothing.
+   if (numBuckets <= bucket_count())
+      return;
+
+   // Relink the nodes into the new buckets, one at a time
+   H hash;
+   custom::vector<Bucket> bucketNew(numBuckets);
+   for (auto& bucket : buckets)
+      while (!bucket.empty())
+      {
+         Bucket& bucketTo = bucketNew[hash((*bucket.begin()).first) % numBuckets];
+         bucketTo.splice(bucketTo.end(), bucket, bucket.begin());
+      }
+   std::swap(buckets, bucketNew);
+}
+
+/*****************************************
+ * UNORDERED MAP :: ITERATOR :: INCREMENT
+ * Advance by one element in an unordered map
+ ****************************************/
+template <typename K, typename V, typename H, typename E, typename A>
+typename unordered_map <K, V, H, E, A> ::iterator & unordered_map<K, V, H, E, A>::iterator::operator ++ ()
+{
+   // Only advance if we are not already at the end
+   if (itVector == itVectorEnd)
+      return *this;
+
+   // Advance the list iterator. If we are not at the end, then we are done.
+   ++itList;
+   if (itList != (*itVector).end())
+      return *this;
+
+   // We are at the end of the list. Find the next bucket.
+   ++itVector;
+   while (itVector != itVectorEnd && (*itVector).empty())
+      ++itVector;
+   if (itVector != itVectorEnd)
+      itList = (*itVector).begin();
+   return *this;
+}
+
+}
@@ -21,10 +21,12 @@
 #include <cassert>     // for ASSERT
 #include <iostream>    // for nullptr
 #include <new>         // std::bad_alloc
-#include <memory>      // for std::allocator
+#include <memory>      // for std::allocator and std::allocator_traits
+#include <utility>     // for std::forward
 
 class TestList; // forward declaration for unit tests
 class TestHash; // forward declaration for hash used later
+class TestPool; // forward declaration for the node pool
 
 namespace custom
 {
@@ -38,19 +40,20 @@ class list
 {
    friend class ::TestList; // give unit tests access to the privates
    friend class ::TestHash;
+   friend class ::TestPool;
    friend void swap(list& lhs, list& rhs);
 public:
    
    //
    // Construct
    //
-   list(const A& a = A())
+   list(const A& a = A()) : alloc(a)
    {
       numElements = 0;
       pHead = pTail = nullptr;
    }
    
-   list(list <T, A> & rhs, const A& a = A())
+   list(list <T, A> & rhs, const A& a = A()) : alloc(a)
    {
       numElements = 0;
       pHead = pTail = nullptr;
@@ -62,7 +65,7 @@ public:
    list(list <T, A>&& rhs, const A& a = A());
    list(size_t num, const T & t, const A& a = A());
    list(size_t num, const A& a = A());
-   list(const std::initializer_list<T>& il, const A& a = A())
+   list(const std::initializer_list<T>& il, const A& a = A()) : alloc(a)
    {
       numElements = 0;
       pHead = pTail = nullptr;
@@ -72,7 +75,7 @@ public:
          push_back(elem);
    }
    template <class Iterator>
-   list(Iterator first, Iterator last, const A& a = A())
+   list(Iterator first, Iterator last, const A& a = A()) : alloc(a)
    {
       numElements = 0;
       pHead = pTail = nullptr;
@@ -86,7 +89,7 @@ public:
          // Erase every element in the list
          Node* temp = pHead;
          pHead = pHead->pNext;
-         delete temp;
+         deleteNode(temp);
       }
       pTail = nullptr;
    }
@@ -129,8 +132,12 @@ public:
    void push_front(      T && data);
    void push_back (const T &  data);
    void push_back (      T && data);
+   template <class ... Args>
+   void emplace_back(Args&& ... args);
    iterator insert(iterator it, const T &  data);
    iterator insert(iterator it,       T && data);
+   void splice(iterator it, list <T, A> & rhs);
+   void splice(iterator it, list <T, A> & rhs, iterator itMove);
 
    //
    // Remove
@@ -152,6 +159,12 @@ private:
    // nested linked list class
    class Node;
 
+   // nodes come from the allocator rebound to Node, never from new
+   typedef typename std::allocator_traits<A>::template rebind_alloc<Node> NodeAlloc;
+   template <class ... Args>
+   Node * newNode(Args&& ... args);
+   void deleteNode(Node * pDelete);
+
    // member variables
    A    alloc;         // use alloacator for memory allocation
    size_t numElements; // though we could count, it is faster to keep a variable
@@ -180,6 +193,11 @@ public:
 
    Node(T&& data) : data(std::move(data)), pNext(nullptr), pPrev(nullptr) {}
 
+   // build the data in place from its constructor arguments
+   struct Emplace {};
+   template <class ... Args>
+   Node(Emplace, Args&& ... args) : data(std::forward<Args>(args)...), pNext(nullptr), pPrev(nullptr) {}
+
 
    //
    // Member Variables
@@ -564,18 +582,56 @@ public:
    friend iterator list <T, A> :: insert(iterator it, const T &  data);
    friend iterator list <T, A> :: insert(iterator it,       T && data);
    friend iterator list <T, A> :: erase(const iterator & it);
+   friend void list <T, A> :: splice(iterator it, list <T, A> & rhs);
+   friend void list <T, A> :: splice(iterator it, list <T, A> & rhs, iterator itMove);
 
 private:
 
    typename list <T, A> :: Node * p;
 };
 
+/*****************************************
+ * LIST :: NEW NODE
+ * Allocate a node through the rebound allocator
+ * and construct it from the given arguments
+ ****************************************/
+template <typename T, typename A>
+template <class ... Args>
+typename list <T, A> ::Node * list <T, A> ::newNode(Args&& ... args)
+{
+   NodeAlloc nodeAlloc(alloc);
+   Node * pNew = std::allocator_traits<NodeAlloc>::allocate(nodeAlloc, 1);
+   try
+   {
+      std::allocator_traits<NodeAlloc>::construct(nodeAlloc, pNew, std::forward<Args>(args)...);
+   }
+   catch (...)
+   {
+      // give the memory back if the element constructor throws
+      std::allocator_traits<NodeAlloc>::deallocate(nodeAlloc, pNew, 1);
+      throw;
+   }
+   return pNew;
+}
+
+/*****************************************
+ * LIST :: DELETE NODE
+ * Destroy a node and return it to the allocator
+ ****************************************/
+template <typename T, typename A>
+void list <T, A> ::deleteNode(Node * pDelete)
+{
+   NodeAlloc nodeAlloc(alloc);
+   std::allocator_traits<NodeAlloc>::destroy(nodeAlloc, pDelete);
+   std::allocator_traits<NodeAlloc>::deallocate(nodeAlloc, pDelete, 1);
+}
+
 /*****************************************
  * LIST :: NON-DEFAULT constructors
  * Create a list initialized to a value
  ****************************************/
 template <typename T, typename A>
-list <T, A> ::list(size_t num, const T & t, const A& a)
+list <T, A> ::list(size_t num, const T & t, const A& a) : alloc(a)
 {
    numElements = num;
    pHead = nullptr;
@@ -583,14 +639,14 @@ list <T, A> ::list(size_t num, const T & t, const A& a)
    if (num > 0)
    {
       // Create a new node with the provided data
-      pHead = new Node (t);
+      pHead = newNode(t);
       pHead->pPrev = nullptr;
 
       Node *pPrevious = pHead;
       for (size_t i = 1; i < num; ++i)
       {
          // Create a new node with the provided data
-         Node *pNew = new Node(t);
+         Node *pNew = newNode(t);
          
          //Insert a new node into the list
          pNew->pPrev = pPrevious;
@@ -608,7 +664,7 @@ list <T, A> ::list(size_t num, const T & t, const A& a)
  * Create a list initialized to a value
  ****************************************/
 template <typename T, typename A>
-list <T, A> ::list(size_t num, const A& a)
+list <T, A> ::list(size_t num, const A& a) : alloc(a)
 {
    numElements = num;
    pHead = nullptr;
@@ -616,14 +672,14 @@ list <T, A> ::list(size_t num, const A& a)
    if (num > 0)
    {
       //Create a new node
-      pHead = new Node;
+      pHead = newNode();
       pHead->pPrev = nullptr;
 
       Node *pPrevious = pHead;
       for (size_t i = 1; i < num; ++i)
       {
          //Insert a new node into the list
-         Node *pNew = new Node;
+         Node *pNew = newNode();
          pNew->pPrev = pPrevious;
          pPrevious->pNext = pNew;
          pPrevious = pNew;
@@ -640,7 +696,7 @@ list <T, A> ::list(size_t num, const A& a)
  ****************************************/
 template <typename T, typename A>
 list <T, A> ::list(list <T, A>&& rhs, const A& a) :
-   numElements(rhs.numElements), pHead(rhs.pHead), pTail(rhs.pTail), alloc(a)
+   alloc(a), numElements(rhs.numElements), pHead(rhs.pHead), pTail(rhs.pTail)
 {
    rhs.pHead = rhs.pTail = nullptr;
    rhs.numElements = 0;
@@ -711,7 +767,7 @@ list <T, A> & list <T, A> :: operator = (list <T, A> & rhs)
       while (p != nullptr)
       {
          pNext = p->pNext;
-         delete p;
+         deleteNode(p);
          p = pNext;
          numElements--;
          pTail->pNext = nullptr;
@@ -772,7 +828,7 @@ list <T, A>& list <T, A> :: operator = (const std::initializer_list<T>& rhs)
       while (p != nullptr)
       {
          pNext = p->pNext;
-         delete p;
+         deleteNode(p);
          p = pNext;
          numElements--;
          pTail->pNext = nullptr;
@@ -798,7 +854,7 @@ void list <T, A> :: clear()
    while (p != nullptr)
    {
       Node * pNext = p->pNext;
-      delete p;
+      deleteNode(p);
       p = pNext;
    }
    pHead = pTail = nullptr;
@@ -816,7 +872,7 @@ template <typename T, typename A>
 void list <T, A> :: push_back(const T & data)
 {
    // Create a new node with the given data
-   Node* pNew = new Node(data);
+   Node* pNew = newNode(data);
    pNew->pPrev = pTail;
    
    //Check if the list is not empty
@@ -837,7 +893,7 @@ template <typename T, typename A>
 void list <T, A> ::push_back(T && data)
 {
    // Create a new node with the given data
-   Node* pNew = new Node(std::forward<T>(data));
+   Node* pNew = newNode(std::forward<T>(data));
    pNew->pPrev = pTail;
    
    //Check if the list is not empty
@@ -854,6 +910,31 @@ void list <T, A> ::push_back(T && data)
    numElements++;
 }
 
+/*********************************************
+ * LIST :: EMPLACE BACK
+ * construct an item in place at the end of the list
+ *    INPUT  : the constructor arguments of the item
+ *    OUTPUT :
+ *    COST   : O(1)
+ *********************************************/
+template <typename T, typename A>
+template <class ... Args>
+void list <T, A> ::emplace_back(Args&& ... args)
+{
+   // Create a new node, building the data inside it
+   Node* pNew = newNode(typename Node::Emplace(), std::forward<Args>(args)...);
+   pNew->pPrev = pTail;
+   
+   // Add to the end, or the front if the list is empty
+   if (pTail)
+      pTail->pNext = pNew;
+   else
+      pHead = pNew;
+   
+   pTail = pNew;
+   numElements++;
+}
+
 /*********************************************
  * LIST :: PUSH FRONT
  * add an item to the head of the list
@@ -865,7 +946,7 @@ template <typename T, typename A>
 void list <T, A> :: push_front(const T & data)
 {
    // Create a new node with the given data
-   Node* pNew = new Node(data);
+   Node* pNew = newNode(data);
    pNew->pNext = pHead;
    
    //Check if the list is not empty
@@ -885,7 +966,7 @@ template <typename T, typename A>
 void list <T, A> ::push_front(T && data)
 {
    // Create a new node with the given data
-   Node* pNew = new Node(std::forward<T>(data));
+   Node* pNew = newNode(std::forward<T>(data));
    pNew->pNext = pHead;
    
    //Check if the list is not empty
@@ -916,14 +997,14 @@ void list <T, A> ::pop_back()
       return;
    }
    else if (numElements == 1) {
-      delete pTail;
+      deleteNode(pTail);
       pHead = pTail = nullptr;
    }
    else {
       Node* temp = pTail;
       pTail = pTail->pPrev;
       pTail->pNext = nullptr;
-      delete temp;
+      deleteNode(temp);
    }
    --numElements;
 }
@@ -942,14 +1023,14 @@ void list <T, A> ::pop_front()
       return;
    }
    else if (numElements == 1) {
-      delete pHead;
+      deleteNode(pHead);
       pHead = pTail = nullptr;
    }
    else {
       Node* temp = pHead;
       pHead = pHead->pNext;
       pHead->pPrev = nullptr;
-      delete temp;
+      deleteNode(temp);
    }
    --numElements;
 }
@@ -1023,7 +1104,7 @@ typename list <T, A> :: iterator  list <T, A> :: erase(const list <T, A> :: iter
       pHead = pHead->pNext;
 
    // Delete the current node and decrement element count
-   delete it.p;
+   deleteNode(it.p);
    numElements--;
    
    return itNext;
@@ -1041,7 +1122,7 @@ template <typename T, typename A>
 typename list <T, A> :: iterator list <T, A> :: insert(list <T, A> :: iterator it,
                                                  const T & data)
 {
-   Node* newNode = new Node(data);
+   Node* pNew = newNode(data);
 
    if (it.p == nullptr)
    {
@@ -1049,13 +1130,13 @@ typename list <T, A> :: iterator list <T, A> :: insert(list <T, A> :: iterator i
       if (pTail == nullptr)
          
          // Update both head and tail if list is empty
-         pHead = pTail = newNode;
+         pHead = pTail = pNew;
       else
       {
          // Otherwise, adjust pointers for tail and new node
-         pTail->pNext = newNode;
-         newNode->pPrev = pTail;
-         pTail = newNode;
+         pTail->pNext = pNew;
+         pNew->pPrev = pTail;
+         pTail = pNew;
       }
    }
    else
@@ -1063,24 +1144,24 @@ typename list <T, A> :: iterator list <T, A> :: insert(list <T, A> :: iterator i
       // Inserting in the middle
       Node* current = it.p;
       Node* prev = current->pPrev;
-      newNode->pNext = current;
-      newNode->pPrev = prev;
+      pNew->pNext = current;
+      pNew->pPrev = prev;
       if (prev != nullptr)
          
          // Adjust previous node's next pointer
-         prev->pNext = newNode;
+         prev->pNext = pNew;
       else
          
          // Update head if there's no previous node
-         pHead = newNode;
+         pHead = pNew;
 
       // Adjust current node's previous pointer
-      current->pPrev = newNode;
+      current->pPrev = pNew;
    }
 
    // Increment element count and return iterator
    ++numElements;
-   return iterator(newNode);
+   return iterator(pNew);
 }
 
 
@@ -1096,34 +1177,114 @@ template <typename T, typename A>
 typename list <T, A> ::iterator list <T, A> ::insert(list <T, A> ::iterator it,
    T && data)
 {
-   Node* newNode = new Node(std::forward<T>(data));
+   Node* pNew = newNode(std::forward<T>(data));
    if (it.p == nullptr)
    {
       if (pTail == nullptr)
-         pHead = pTail = newNode;
+         pHead = pTail = pNew;
       else
       {
-         pTail->pNext = newNode;
-         newNode->pPrev = pTail;
-         pTail = newNode;
+         pTail->pNext = pNew;
+         pNew->pPrev = pTail;
+         pTail = pNew;
       }
    }
    else
    {
       Node* current = it.p;
       Node* prev = current->pPrev;
-      newNode->pNext = current;
-      newNode->pPrev = prev;
+      pNew->pNext = current;
+      pNew->pPrev = prev;
       if (prev != nullptr)
-         prev->pNext = newNode;
+         prev->pNext = pNew;
       else
-         pHead = newNode;
+         pHead = pNew;
 
-      current->pPrev = newNode;
+      current->pPrev = pNew;
    }
    
    ++numElements;
-   return iterator(newNode);
+   return iterator(pNew);
+}
+
+/******************************************
+ * LIST :: SPLICE
+ * move every node of rhs into the middle of this list.
+ * No element is copied, moved, or allocated, so the two
+ * lists must share an allocator
+ *     INPUT  : an iterator to the location where they go
+ *              the list they come from, left empty
+ *     OUTPUT :
+ *     COST   : O(1)
+ ******************************************/
+template <typename T, typename A>
+void list <T, A> ::splice(list <T, A> ::iterator it, list <T, A> & rhs)
+{
+   if (&rhs == this || rhs.pHead == nullptr)
+      return;
+
+   Node* pFirst = rhs.pHead;
+   Node* pLast = rhs.pTail;
+   Node* pPrev = (it.p == nullptr) ? pTail : it.p->pPrev;
+
+   // Hook the chain in between pPrev and it
+   pFirst->pPrev = pPrev;
+   pLast->pNext = it.p;
+   if (pPrev != nullptr)
+      pPrev->pNext = pFirst;
+   else
+      pHead = pFirst;
+   if (it.p != nullptr)
+      it.p->pPrev = pLast;
+   else
+      pTail = pLast;
+
+   numElements += rhs.numElements;
+   rhs.pHead = rhs.pTail = nullptr;
+   rhs.numElements = 0;
+}
+
+/******************************************
+ * LIST :: SPLICE
+ * move one node of rhs into the middle of this list
+ *     INPUT  : an iterator to the location where it goes
+ *              the list it comes from
+ *              an iterator to the node to be moved
+ *     OUTPUT :
+ *     COST   : O(1)
+ ******************************************/
+template <typename T, typename A>
+void list <T, A> ::splice(list <T, A> ::iterator it, list <T, A> & rhs,
+                          list <T, A> ::iterator itMove)
+{
+   Node* pMove = itMove.p;
+   if (pMove == nullptr || pMove == it.p)
+      return;
+
+   // Unhook the node from rhs
+   if (pMove->pPrev != nullptr)
+      pMove->pPrev->pNext = pMove->pNext;
+   else
+      rhs.pHead = pMove->pNext;
+   if (pMove->pNext != nullptr)
+      pMove->pNext->pPrev = pMove->pPrev;
+   else
+      rhs.pTail = pMove->pPrev;
+   rhs.numElements--;
+
+   // Hook it back in ahead of it
+   Node* pPrev = (it.p == nullptr) ? pTail : it.p->pPrev;
+   pMove->pPrev = pPrev;
+   pMove->pNext = it.p;
+   if (pPrev != nullptr)
+      pPrev->pNext = pMove;
+   else
+      pHead = pMove;
+   if (it.p != nullptr)
+      it.p->pPrev = pMove;
+   else
+      pTail = pMove;
+   numElements++;
 }
 
 /**********************************************
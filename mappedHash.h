@@ -0,0 +1,362 @@
+/***********************************************************************
+ * Header:
+ *    MAPPED HASH
+ * Summary:
+ *    A read-only set queried in place from a file that
+ *    unordered_set::save wrote, so a restart maps the table instead of
+ *    inserting every key again. The file is:
+ *       snapshot_header         : what the keys are and how many
+ *       uint64_t[numBuckets+1]  : where each bucket starts in the keys
+ *       T[numElements]          : the keys, bucket after bucket
+ *    Only trivially copyable keys can be saved, and the file is only
+ *    good on a machine with the same byte order and key layout.
+ *
+ *    This will contain the class definition of:
+ *        snapshot_header      : the first bytes of the file
+ *        mapped_unordered_set : the set the file maps back to
+ * Author
+ *       Marco Varela &  Andre Regino
+ ************************************************************************/
+
+#pragma once
+
+#include "hashPolicy.h" // for custom::modulo_index
+#include <cstddef>      // for size_t
+#include <cstdint>      // for uint32_t and uint64_t
+#include <cstring>      // for std::memcmp and std::memcpy
+#include <fstream>      // for std::ofstream
+#include <functional>   // for std::hash and std::equal_to
+#include <stdexcept>    // for std::runtime_error
+#include <string>       // for std::string in error messages
+#include <utility>      // for std::swap
+#include <vector>       // for std::vector of offsets
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>    // for CreateFileMapping and MapViewOfFile
+#else
+#include <fcntl.h>      // for open
+#include <sys/mman.h>   // for mmap and munmap
+#include <sys/stat.h>   // for fstat
+#include <unistd.h>     // for close
+#endif
+
+class TestMappedHash;   // forward declaration for MappedHash unit tests
+
+namespace custom
+{
+
+/************************************************
+ * SNAPSHOT HEADER
+ * The start of a snapshot file. Enough to refuse a
+ * file written for another key, byte order or hash.
+ ************************************************/
+struct snapshot_header
+{
+   static const uint32_t VERSION = 1;
+   static const uint32_t ENDIAN = 0x01020304;
+
+   char     magic[8];      // "CUSTSET" and a null
+   uint32_t version;       // VERSION when written
+   uint32_t endian;        // ENDIAN as the writer stored it
+   uint32_t keySize;       // sizeof(T)
+   uint32_t keyAlign;      // alignof(T)
+   uint64_t numElements;   // keys in the file
+   uint64_t numBuckets;    // entries in the offsets array, less one
+   uint64_t keysOffset;    // from the start of the file to the first key
+   uint64_t firstBucket;   // the bucket of the first key, to check the hash
+};
+
+/*****************************************************
+ * SNAPSHOT KEYS OFFSET
+ * The keys follow the offsets, aligned for T and
+ * never less than for a uint64_t
+ ****************************************************/
+inline uint64_t snapshot_keys_offset(uint64_t numBuckets, size_t keyAlign)
+{
+   uint64_t align = keyAlign > 8 ? keyAlign : 8;
+   uint64_t end = sizeof(snapshot_header) + (numBuckets + 1) * sizeof(uint64_t);
+   return (end + align - 1) / align * align;
+}
+
+/*****************************************************
+ * WRITE SNAPSHOT
+ * The header, the bucket offsets, the padding and
+ * the keys, in one file
+ ****************************************************/
+inline void write_snapshot(const char * path, const snapshot_header& header,
+                           const std::vector<uint64_t>& offsets, const void * keys)
+{
+   std::ofstream fout(path, std::ios::out | std::ios::binary | std::ios::trunc);
+   if (!fout)
+      throw std::runtime_error(std::string("cannot create the snapshot ") + path);
+
+   fout.write((const char *)&header, sizeof(header));
+   fout.write((const char *)offsets.data(), offsets.size() * sizeof(uint64_t));
+   uint64_t padding = header.keysOffset - sizeof(header) - offsets.size() * sizeof(uint64_t);
+   static const char zeros[64] = {};
+   fout.write(zeros, padding);
+   fout.write((const char *)keys, header.numElements * header.keySize);
+
+   fout.close();
+   if (!fout)
+      throw std::runtime_error(std::string("cannot write the snapshot ") + path);
+}
+
+/*****************************************************
+ * MAP FILE
+ * The whole of path, read only, and its length in
+ * numBytes. Give it back with unmap_file.
+ ****************************************************/
+inline const void * map_file(const char * path, size_t& numBytes)
+{
+#ifdef _WIN32
+   HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr,
+                             OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+   if (file == INVALID_HANDLE_VALUE)
+      throw std::runtime_error(std::string("cannot open the snapshot ") + path);
+   LARGE_INTEGER size;
+   HANDLE mapping = nullptr;
+   if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+      mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+   CloseHandle(file);
+   if (mapping == nullptr)
+      throw std::runtime_error(std::string("cannot map the snapshot ") + path);
+   const void * base = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+   CloseHandle(mapping);   // the view keeps the mapping alive
+   if (base == nullptr)
+      throw std::runtime_error(std::string("cannot map the snapshot ") + path);
+   numBytes = (size_t)size.QuadPart;
+   return base;
+#else
+   int fd = open(path, O_RDONLY);
+   if (fd < 0)
+      throw std::runtime_error(std::string("cannot open the snapshot ") + path);
+   struct stat status;
+   void * p = MAP_FAILED;
+   if (fstat(fd, &status) == 0 && status.st_size > 0)
+      p = mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+   close(fd);   // the mapping keeps the file open
+   if (p == MAP_FAILED)
+      throw std::runtime_error(std::string("cannot map the snapshot ") + path);
+   numBytes = (size_t)status.st_size;
+   return p;
+#endif
+}
+
+/*****************************************************
+ * UNMAP FILE
+ * Let go of what map_file returned
+ ****************************************************/
+inline void unmap_file(const void * base, size_t numBytes)
+{
+#ifdef _WIN32
+   (void)numBytes;
+   UnmapViewOfFile(base);
+#else
+   munmap(const_cast<void *>(base), numBytes);
+#endif
+}
+
+/************************************************
+ * MAPPED UNORDERED SET
+ * The keys of a snapshot where the file is mapped.
+ * Hash, EqPred and I must be those the set was
+ * saved with, and a seeded Hash needs its seed.
+ ************************************************/
+template <typename T,
+          typename Hash = std::hash<T>,
+          typename EqPred = std::equal_to<T>,
+          typename I = custom::modulo_index>
+class mapped_unordered_set
+{
+   friend class ::TestMappedHash;   // give unit tests access to the privates
+public:
+   // the keys are one array, so a pointer walks them
+   typedef const T * iterator;
+   typedef const T * local_iterator;
+
+   //
+   // Construct
+   //
+   mapped_unordered_set(const char * path, const Hash& hash = Hash());
+   mapped_unordered_set(mapped_unordered_set&& rhs) noexcept
+      : base(nullptr), numBytes(0), offsets(nullptr), keys(nullptr), numElements(0), numBuckets(0)
+   {
+      swap(rhs);
+   }
+   mapped_unordered_set(const mapped_unordered_set&) = delete;
+   mapped_unordered_set& operator=(const mapped_unordered_set&) = delete;
+   mapped_unordered_set& operator=(mapped_unordered_set&& rhs) noexcept
+   {
+      swap(rhs);
+      return *this;
+   }
+   ~mapped_unordered_set()
+   {
+      unmap();
+   }
+   void swap(mapped_unordered_set& rhs) noexcept
+   {
+      std::swap(base, rhs.base);
+      std::swap(numBytes, rhs.numBytes);
+      std::swap(offsets, rhs.offsets);
+      std::swap(keys, rhs.keys);
+      std::swap(numElements, rhs.numElements);
+      std::swap(numBuckets, rhs.numBuckets);
+      std::swap(indexPolicy, rhs.indexPolicy);
+      std::swap(hashFunction, rhs.hashFunction);
+   }
+
+   //
+   // Iterator
+   //
+   iterator begin() const                  { return keys;                        }
+   iterator end() const                    { return keys + numElements;          }
+   local_iterator begin(size_t i) const    { return keys + offsets[i];           }
+   local_iterator end(size_t i) const      { return keys + offsets[i + 1];       }
+
+   //
+   // Access
+   //
+   size_t bucket(const T& t) const
+   {
+      return indexPolicy.index(hashFunction(t), numBuckets);
+   }
+   iterator find(const T& t) const
+   {
+      size_t i = bucket(t);
+      for (const T * p = begin(i); p != end(i); ++p)
+         if (EqPred()(*p, t))
+            return p;
+      return end();
+   }
+   size_t count(const T& t) const
+   {
+      return find(t) == end() ? 0 : 1;
+   }
+
+   //
+   // Status
+   //
+   size_t size() const                     { return numElements;                 }
+   bool empty() const                      { return numElements == 0;            }
+   size_t bucket_count() const             { return numBuckets;                  }
+   size_t bucket_size(size_t i) const      { return (size_t)(offsets[i + 1] - offsets[i]); }
+   float load_factor() const
+   {
+      return (float)numElements / (float)numBuckets;
+   }
+   Hash hash_function() const
+   {
+      return hashFunction;
+   }
+
+private:
+   void map(const char * path);
+   void unmap();
+
+   const void * base;           // the start of the mapped file
+   size_t numBytes;             // the length of the mapping
+   const uint64_t * offsets;    // bucket i is keys[offsets[i]] up to keys[offsets[i+1]]
+   const T * keys;              // every key, bucket after bucket
+   size_t numElements;          // the length of keys
+   size_t numBuckets;           // the length of offsets, less one
+   mutable I indexPolicy;       // turns a hash into a bucket index
+   Hash hashFunction;           // must hash as the saved set did
+};
+
+/*****************************************
+ * MAPPED UNORDERED SET :: CONSTRUCTOR
+ * Map the file and check that it holds
+ * this kind of key, hashed this way
+ ****************************************/
+template <typename T, typename H, typename E, typename I>
+mapped_unordered_set<T, H, E, I>::mapped_unordered_set(const char * path, const H& hash)
+   : base(nullptr), numBytes(0), offsets(nullptr), keys(nullptr),
+     numElements(0), numBuckets(0), hashFunction(hash)
+{
+   map(path);
+
+   snapshot_header header;
+   bool valid = numBytes >= sizeof(header);
+   if (valid)
+   {
+      std::memcpy(&header, base, sizeof(header));
+      valid = std::memcmp(header.magic, "CUSTSET", 8) == 0 &&
+              header.version == snapshot_header::VERSION &&
+              header.endian == snapshot_header::ENDIAN &&
+              header.keySize == sizeof(T) &&
+              header.keyAlign == alignof(T) &&
+              header.numBuckets > 0 &&
+              header.keysOffset == snapshot_keys_offset(header.numBuckets, alignof(T)) &&
+              header.keysOffset + header.numElements * sizeof(T) <= numBytes;
+   }
+   if (!valid)
+   {
+      unmap();
+      throw std::runtime_error(std::string("not a snapshot of this key type: ") + path);
+   }
+
+   const char * bytes = (const char *)base;
+   offsets     = (const uint64_t *)(bytes + sizeof(header));
+   keys        = (const T *)(bytes + header.keysOffset);
+   numElements = (size_t)header.numElements;
+   numBuckets  = (size_t)header.numBuckets;
+
+   // the buckets must run in order within the keys, or a find reads past them
+   valid = offsets[0] == 0;
+   for (size_t i = 0; valid && i < numBuckets; i++)
+      valid = offsets[i] <= offsets[i + 1] && offsets[i + 1] <= numElements;
+   if (!valid)
+   {
+      unmap();
+      throw std::runtime_error(std::string("not a snapshot of this key type: ") + path);
+   }
+
+   // settle any cache the policy keeps, so a find from any thread only reads
+   indexPolicy.index(0, numBuckets);
+
+   // a hash with another seed, or another hash, puts the first key elsewhere
+   if (offsets[numBuckets] != numElements ||
+       (numElements && bucket(keys[0]) != header.firstBucket))
+   {
+      unmap();
+      throw std::runtime_error(std::string("the snapshot was saved with another hash: ") + path);
+   }
+}
+
+/*****************************************
+ * MAPPED UNORDERED SET :: MAP
+ * The whole file, read only
+ ****************************************/
+template <typename T, typename H, typename E, typename I>
+void mapped_unordered_set<T, H, E, I>::map(const char * path)
+{
+   base = map_file(path, numBytes);
+}
+
+/*****************************************
+ * MAPPED UNORDERED SET :: UNMAP
+ * Let go of the file, if there is one
+ ****************************************/
+template <typename T, typename H, typename E, typename I>
+void mapped_unordered_set<T, H, E, I>::unmap()
+{
+   if (base == nullptr)
+      return;
+   unmap_file(base, numBytes);
+   base = nullptr;
+   numBytes = 0;
+   offsets = nullptr;
+   keys = nullptr;
+   numElements = 0;
+   numBuckets = 0;
+}
+
+}
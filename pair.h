@@ -10,6 +10,8 @@
 #pragma once
 
 #include <iostream>  // for ISTREAM and OSTREAM
+#include <tuple>     // for std::tuple and std::piecewise_construct_t
+#include <utility>   // for std::index_sequence
 
 namespace custom
 {
@@ -50,6 +52,11 @@ public:
    // Move Constructor: call the T1, T2 move constructors
    pair(pair <T1, T2> && rhs, const C& c = C())
        : first(std::move(rhs.first)), second(std::move(rhs.second)), compare(c) {}
+   // Piecewise Constructor: build T1 and T2 in place from two tuples of
+   // constructor arguments, as in std::forward_as_tuple(key), std::forward_as_tuple()
+   template <class ... Args1, class ... Args2>
+   pair(std::piecewise_construct_t, std::tuple<Args1...> args1, std::tuple<Args2...> args2, const C& c = C())
+       : pair(args1, args2, std::index_sequence_for<Args1...>(), std::index_sequence_for<Args2...>(), c) {}
 
    //
    // Assignment Operators
@@ -111,6 +118,12 @@ public:
    // these are public. We cannot validate because we know nothing about T
    T1 first;
    T2 second;
+
+private:
+   // unpack the tuples of the piecewise constructor
+   template <class Tuple1, class Tuple2, size_t ... I1, size_t ... I2>
+   pair(Tuple1& args1, Tuple2& args2, std::index_sequence<I1...>, std::index_sequence<I2...>, const C& c)
+       : compare(c), first(std::get<I1>(std::move(args1))...), second(std::get<I2>(std::move(args2))...) {}
 };
 
 
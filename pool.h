@@ -0,0 +1,181 @@
+/***********************************************************************
+ * Header:
+ *    POOL
+ * Summary:
+ *    A slab/free-list pool for fixed-size nodes and an allocator that
+ *    draws from it. custom::list rebinds its allocator to its Node, so
+ *       custom::unordered_set<T, Hash, EqPred, custom::pool_allocator<T>>
+ *    takes every bucket's nodes from one shared pool instead of calling
+ *    the global allocator once per insert.
+ *
+ *    This will contain the class definition of:
+ *        node_pool      : Fixed-size blocks carved from growing slabs
+ *        pool_allocator : An allocator that uses the node_pool
+ * Author
+ *       Marco Varela &  Andre Regino
+ ************************************************************************/
+
+#pragma once
+
+#include <cstddef>     // for size_t and std::max_align_t
+#include <new>         // for ::operator new and std::bad_alloc
+
+class TestPool;        // forward declaration for Pool unit tests
+
+namespace custom
+{
+
+/************************************************
+ * NODE POOL
+ * Hands out blocks of Size bytes aligned to Align.
+ * Freed blocks go on a free list and are reused
+ * before a new slab is carved. Slabs double in size
+ * up to MAX_SLAB blocks and are never returned.
+ *
+ * There is one pool for each Size, Align, and Tag. Like
+ * the containers it serves, a pool is not thread-safe:
+ * containers used on different threads should use
+ * different Tags (or std::allocator).
+ ************************************************/
+template <size_t Size, size_t Align, typename Tag = void>
+class node_pool
+{
+   friend class ::TestPool;   // give unit tests access to the privates
+public:
+   static const size_t MIN_SLAB = 64;      // blocks in the first slab
+   static const size_t MAX_SLAB = 65536;   // blocks in the largest slab
+
+   //
+   // Access
+   //
+
+   // the one pool for this size. It is never destroyed so containers
+   // with static storage may safely return nodes during shutdown
+   static node_pool & instance()
+   {
+      static node_pool * pPool = new node_pool;
+      return *pPool;
+   }
+
+   //
+   // Allocate
+   //
+   void * allocate()
+   {
+      if (pFree == nullptr)
+         grow();
+      Block * pBlock = pFree;
+      pFree = pBlock->pNext;
+      return pBlock;
+   }
+   void deallocate(void * p) noexcept
+   {
+      Block * pBlock = static_cast<Block *>(p);
+      pBlock->pNext = pFree;
+      pFree = pBlock;
+   }
+
+   //
+   // Status
+   //
+   size_t slab_count() const { return numSlabs;  }
+   size_t capacity()   const { return numBlocks; }
+
+private:
+   // a free block holds the link to the next free block
+   struct Block
+   {
+      Block * pNext;
+   };
+
+   // every block is big enough for a link and keeps the alignment
+   static const size_t ALIGN = Align > alignof(Block) ? Align : alignof(Block);
+   static const size_t BLOCK = ((Size > sizeof(Block) ? Size : sizeof(Block)) + ALIGN - 1) / ALIGN * ALIGN;
+   static const size_t HEADER = (sizeof(void *) + ALIGN - 1) / ALIGN * ALIGN;
+   static_assert(ALIGN <= alignof(std::max_align_t), "node_pool cannot over-align");
+
+   node_pool() : pFree(nullptr), pSlabs(nullptr), numSlabs(0), numBlocks(0), slabBlocks(MIN_SLAB)
+   {
+   }
+
+   // carve a new slab into blocks and put them all on the free list
+   void grow()
+   {
+      char * pSlab = static_cast<char *>(::operator new(HEADER + slabBlocks * BLOCK));
+
+      // the first word of a slab links it to the previous slab
+      *reinterpret_cast<void **>(pSlab) = pSlabs;
+      pSlabs = pSlab;
+
+      // push the blocks so the lowest address is handed out first
+      for (size_t i = slabBlocks; i > 0; i--)
+         deallocate(pSlab + HEADER + (i - 1) * BLOCK);
+
+      numSlabs++;
+      numBlocks += slabBlocks;
+      if (slabBlocks < MAX_SLAB)
+         slabBlocks *= 2;
+   }
+
+   Block * pFree;       // the first free block
+   void *  pSlabs;      // the most recent slab
+   size_t  numSlabs;    // number of slabs carved so far
+   size_t  numBlocks;   // number of blocks in all the slabs
+   size_t  slabBlocks;  // number of blocks in the next slab
+};
+
+/************************************************
+ * POOL ALLOCATOR
+ * An allocator that takes single objects from the
+ * node_pool for sizeof(T). Arrays go to the global
+ * allocator, so it is only worth using for nodes.
+ ************************************************/
+template <typename T, typename Tag = void>
+class pool_allocator
+{
+public:
+   typedef T value_type;
+   template <typename U>
+   struct rebind
+   {
+      typedef pool_allocator<U, Tag> other;
+   };
+
+   //
+   // Construct
+   //
+   pool_allocator() noexcept
+   {
+   }
+   template <typename U>
+   pool_allocator(const pool_allocator<U, Tag>&) noexcept
+   {
+   }
+
+   //
+   // Allocate
+   //
+   T * allocate(size_t num)
+   {
+      if (num == 1)
+         return static_cast<T *>(node_pool<sizeof(T), alignof(T), Tag>::instance().allocate());
+      return static_cast<T *>(::operator new(num * sizeof(T)));
+   }
+   void deallocate(T * p, size_t num) noexcept
+   {
+      if (num == 1)
+         node_pool<sizeof(T), alignof(T), Tag>::instance().deallocate(p);
+      else
+         ::operator delete(p);
+   }
+
+   //
+   // Compare: every allocator with the same Tag shares the pools
+   //
+   template <typename U>
+   bool operator == (const pool_allocator<U, Tag>&) const noexcept { return true;  }
+   template <typename U>
+   bool operator != (const pool_allocator<U, Tag>&) const noexcept { return false; }
+};
+
+}
@@ -0,0 +1,319 @@
+/***********************************************************************
+ * Header:
+ *    SHARDED HASH
+ * Summary:
+ *    A thread-safe set split into Shards independent custom::unordered_sets,
+ *    each behind a lock of its own. The high bits of the mixed hash pick
+ *    the shard, the shard's own index policy picks the bucket from the
+ *    rest, so the two never work against each other:
+ *       shard  = mulhi64(mix64(hash), Shards)
+ *       bucket = the shard's index policy on hash
+ *    Each shard grows on its own, so a rehash stops only the threads
+ *    that need that one shard, where concurrent_unordered_set stops them
+ *    all. Size, stats and for_each visit the shards one at a time.
+ *
+ *    This will contain the class definition of:
+ *        sharded_unordered_set : Shards sets, each with its own lock
+ * Author
+ *       Marco Varela &  Andre Regino
+ ************************************************************************/
+
+#pragma once
+
+#include "hash.h"          // for custom::unordered_set, one per shard
+#include "hashPolicy.h"    // for mix64 and mulhi64
+#include "hashStats.h"     // for hash_stats of every shard together
+#include "executor.h"      // for the parallel for_each
+#include <cstddef>         // for size_t
+#include <functional>      // for std::hash and std::equal_to
+#include <memory>          // for std::allocator
+#include <mutex>           // for std::mutex and std::lock_guard
+#include <utility>         // for std::forward
+
+class TestShardedHash;     // forward declaration for ShardedHash unit tests
+
+namespace custom
+{
+
+/************************************************
+ * SHARDED UNORDERED SET
+ * Shards sets, each guarded by one mutex. A find is
+ * not read-only in unordered_set (the probe and Bloom
+ * counters, a cached divisor), so a shard has a plain
+ * mutex rather than a reader-writer lock. There are
+ * no iterators: they could not stay valid while other
+ * threads insert. Use contains() and for_each().
+ *
+ * The allocator must be thread-safe, so
+ * custom::pool_allocator does not belong here.
+ ************************************************/
+template <typename T,
+          size_t Shards = 64,
+          typename Hash = std::hash<T>,
+          typename EqPred = std::equal_to<T>,
+          typename A = std::allocator<T>,
+          typename I = custom::modulo_index >
+class sharded_unordered_set
+{
+   friend class ::TestShardedHash;   // give unit tests access to the privates
+
+   typedef custom::unordered_set<T, Hash, EqPred, A, I> Set;
+   static_assert(Shards > 0, "a sharded set has at least one shard");
+public:
+   static const size_t NUM_SHARDS = Shards;
+
+   //
+   // Construct
+   //
+   sharded_unordered_set()
+   {
+   }
+   sharded_unordered_set(size_t numBuckets, const Hash& hash = Hash()) : hashFunction(hash)
+   {
+      for (size_t s = 0; s < Shards; s++)
+         shards[s].set = Set(numBuckets / Shards ? numBuckets / Shards : 1, hash);
+   }
+   sharded_unordered_set(const sharded_unordered_set& rhs) = delete;
+   sharded_unordered_set& operator=(const sharded_unordered_set& rhs) = delete;
+
+   //
+   // Access
+   //
+   bool contains(const T& t)
+   {
+      size_t hash = hashFunction(t);
+      Shard& shard = shards[shardOf(hash)];
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      shard.set.counters.start();
+      bool found = shard.set.findHashed(t, hash) != shard.set.end();
+      shard.set.counters.endFind();
+      return found;
+   }
+   size_t count(const T& t)
+   {
+      return contains(t) ? 1 : 0;
+   }
+   template <class Callback>
+   void for_each(Callback callback);
+   template <class Callback, class Executor>
+   void for_each(Callback callback, Executor&& executor);
+
+   //
+   // Insert
+   //
+   bool insert(const T& t)
+   {
+      return insertUnique(t);
+   }
+   bool insert(T&& t)
+   {
+      return insertUnique(std::move(t));
+   }
+   void reserve(size_t num)
+   {
+      // the hash spreads the elements evenly, give or take
+      for (size_t s = 0; s < Shards; s++)
+      {
+         std::lock_guard<std::mutex> lock(shards[s].mutex);
+         shards[s].set.reserve(num / Shards + 1);
+      }
+   }
+
+   //
+   // Remove
+   //
+   size_t erase(const T& t);
+   void clear();
+
+   //
+   // Status: each shard in turn, so only a moment
+   // no other thread writes gives an exact answer
+   //
+   size_t size();
+   bool empty()
+   {
+      return size() == 0;
+   }
+   size_t bucket_count();
+   hash_stats stats();
+   float max_load_factor()
+   {
+      std::lock_guard<std::mutex> lock(shards[0].mutex);
+      return shards[0].set.max_load_factor();
+   }
+   void max_load_factor(float m);
+   Hash hash_function() const
+   {
+      return hashFunction;
+   }
+   size_t shard_of(const T& t) const
+   {
+      return shardOf(hashFunction(t));
+   }
+
+private:
+   // a set and its lock on cache lines of their own, so
+   // threads in neighboring shards do not bounce lines
+   struct alignas(64) Shard
+   {
+      std::mutex mutex;
+      Set set;
+   };
+
+   // the high bits of the mixed hash, so the low bits a shard's
+   // buckets use are not all the same within one shard
+   static size_t shardOf(size_t hash)
+   {
+      return (size_t)mulhi64(mix64(hash), Shards);
+   }
+
+   template <class U>
+   bool insertUnique(U&& t);
+
+   Shard shards[Shards];   // each an independent set
+   Hash hashFunction;      // hashes once for the shard and the bucket
+};
+
+/*****************************************
+ * SHARDED UNORDERED SET :: INSERT UNIQUE
+ * Hash once, and lock only the one shard
+ ****************************************/
+template <typename T, size_t S, typename H, typename E, typename A, typename I>
+template <class U>
+bool sharded_unordered_set<T, S, H, E, A, I>::insertUnique(U&& t)
+{
+   size_t hash = hashFunction(t);
+   Shard& shard = shards[shardOf(hash)];
+   std::lock_guard<std::mutex> lock(shard.mutex);
+   return shard.set.insertHashed(std::forward<U>(t), hash).second;
+}
+
+/*****************************************
+ * SHARDED UNORDERED SET :: ERASE
+ * Remove t, returning how many were removed
+ ****************************************/
+template <typename T, size_t S, typename H, typename E, typename A, typename I>
+size_t sharded_unordered_set<T, S, H, E, A, I>::erase(const T& t)
+{
+   Shard& shard = shards[shard_of(t)];
+   std::lock_guard<std::mutex> lock(shard.mutex);
+   size_t numBefore = shard.set.size();
+   shard.set.erase(t);
+   return numBefore - shard.set.size();
+}
+
+/*****************************************
+ * SHARDED UNORDERED SET :: CLEAR
+ * Empty every shard, one after another
+ ****************************************/
+template <typename T, size_t S, typename H, typename E, typename A, typename I>
+void sharded_unordered_set<T, S, H, E, A, I>::clear()
+{
+   for (size_t s = 0; s < S; s++)
+   {
+      std::lock_guard<std::mutex> lock(shards[s].mutex);
+      shards[s].set.clear();
+   }
+}
+
+/*****************************************
+ * SHARDED UNORDERED SET :: SIZE
+ * The elements of every shard
+ ****************************************/
+template <typename T, size_t S, typename H, typename E, typename A, typename I>
+size_t sharded_unordered_set<T, S, H, E, A, I>::size()
+{
+   size_t num = 0;
+   for (size_t s = 0; s < S; s++)
+   {
+      std::lock_guard<std::mutex> lock(shards[s].mutex);
+      num += shards[s].set.size();
+   }
+   return num;
+}
+
+/*****************************************
+ * SHARDED UNORDERED SET :: BUCKET COUNT
+ * The buckets of every shard
+ ****************************************/
+template <typename T, size_t S, typename H, typename E, typename A, typename I>
+size_t sharded_unordered_set<T, S, H, E, A, I>::bucket_count()
+{
+   size_t num = 0;
+   for (size_t s = 0; s < S; s++)
+   {
+      std::lock_guard<std::mutex> lock(shards[s].mutex);
+      num += shards[s].set.bucket_count();
+   }
+   return num;
+}
+
+/*****************************************
+ * SHARDED UNORDERED SET :: STATS
+ * The chains and counts of every shard, as if
+ * the shards were one table
+ ****************************************/
+template <typename T, size_t S, typename H, typename E, typename A, typename I>
+hash_stats sharded_unordered_set<T, S, H, E, A, I>::stats()
+{
+   hash_stats s;
+   for (size_t iShard = 0; iShard < S; iShard++)
+   {
+      std::lock_guard<std::mutex> lock(shards[iShard].mutex);
+      s.merge(shards[iShard].set.stats());
+   }
+   return s;
+}
+
+/*****************************************
+ * SHARDED UNORDERED SET :: MAX LOAD FACTOR
+ * Every shard grows at the same load
+ ****************************************/
+template <typename T, size_t S, typename H, typename E, typename A, typename I>
+void sharded_unordered_set<T, S, H, E, A, I>::max_load_factor(float m)
+{
+   for (size_t s = 0; s < S; s++)
+   {
+      std::lock_guard<std::mutex> lock(shards[s].mutex);
+      shards[s].set.max_load_factor(m);
+   }
+}
+
+/*****************************************
+ * SHARDED UNORDERED SET :: FOR EACH
+ * Call callback on every element. Each shard is
+ * held while it is visited, so callback must not
+ * modify this set.
+ ****************************************/
+template <typename T, size_t S, typename H, typename E, typename A, typename I>
+template <class Callback>
+void sharded_unordered_set<T, S, H, E, A, I>::for_each(Callback callback)
+{
+   for_each(callback, inline_executor());
+}
+
+/*****************************************
+ * SHARDED UNORDERED SET :: FOR EACH
+ * The shards dealt out to executor.concurrency()
+ * tasks, so callback is called from several
+ * threads at once and must be safe to
+ ****************************************/
+template <typename T, size_t S, typename H, typename E, typename A, typename I>
+template <class Callback, class Executor>
+void sharded_unordered_set<T, S, H, E, A, I>::for_each(Callback callback, Executor&& executor)
+{
+   size_t numTasks = executor.concurrency() < S ? executor.concurrency() : S;
+   if (numTasks == 0)
+      numTasks = 1;
+   executor.run(numTasks, [&](size_t t)
+   {
+      for (size_t s = t; s < S; s += numTasks)
+      {
+         std::lock_guard<std::mutex> lock(shards[s].mutex);
+         for (auto it = shards[s].set.begin(); it != shards[s].set.end(); ++it)
+            callback(*it);
+      }
+   });
+}
+
+}
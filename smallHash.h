@@ -0,0 +1,450 @@
+/***********************************************************************
+ * Header:
+ *    SMALL HASH
+ * Summary:
+ *    A set that keeps its first N elements inline, in the set object
+ *    itself, and finds them by walking them with EqPred. Only when an
+ *    insert would make it N + 1 does it move everything into a
+ *    custom::unordered_set on the heap. A set that never outgrows N
+ *    never allocates, never hashes, and never touches a bucket.
+ *
+ *    This will contain the class definition of:
+ *        small_unordered_set           : N elements inline, then a hash
+ *        small_unordered_set::iterator : An iterator through either
+ * Author
+ *       Marco Varela &  Andre Regino
+ ************************************************************************/
+
+#pragma once
+
+#include "hash.h"       // for custom::unordered_set once the set is large
+#include "pair.h"       // for custom::pair returned from insert
+#include <cstddef>      // for size_t
+#include <functional>   // for std::hash and std::equal_to
+#include <memory>       // for std::allocator and std::allocator_traits
+#include <new>          // for placement new
+#include <type_traits>  // for std::is_nothrow_move_constructible
+#include <utility>      // for std::move, std::move_if_noexcept and std::forward
+
+class TestSmallHash;    // forward declaration for SmallHash unit tests
+
+namespace custom
+{
+
+/************************************************
+ * SMALL UNORDERED SET
+ * Up to N elements in place, searched in a line.
+ * Once it spills to the hash it stays there until
+ * clear() brings it back inline.
+ ************************************************/
+template <typename T,
+          size_t N = 8,
+          typename Hash = std::hash<T>,
+          typename EqPred = std::equal_to<T>,
+          typename A = std::allocator<T>,
+          typename I = custom::modulo_index >
+class small_unordered_set
+{
+   friend class ::TestSmallHash;   // give unit tests access to the privates
+
+   typedef custom::unordered_set<T, Hash, EqPred, A, I> Large;
+   typedef typename std::allocator_traits<A>::template rebind_alloc<Large> LargeAlloc;
+   static_assert(N > 0, "a small set holds at least one element inline");
+public:
+   static const size_t SMALL_CAPACITY = N;
+
+   //
+   // Construct
+   //
+   small_unordered_set() : numInline(0), pLarge(nullptr)
+   {
+   }
+   explicit small_unordered_set(const Hash& hash) : numInline(0), pLarge(nullptr), hashFunction(hash)
+   {
+   }
+   small_unordered_set(const small_unordered_set& rhs) : numInline(0), pLarge(nullptr)
+   {
+      *this = rhs;
+   }
+   small_unordered_set(small_unordered_set&& rhs) noexcept : numInline(0), pLarge(nullptr)
+   {
+      *this = std::move(rhs);
+   }
+   small_unordered_set(const std::initializer_list<T>& il) : numInline(0), pLarge(nullptr)
+   {
+      insert(il);
+   }
+   ~small_unordered_set()
+   {
+      clear();
+   }
+
+   //
+   // Assign
+   //
+   small_unordered_set& operator=(const small_unordered_set& rhs);
+   small_unordered_set& operator=(small_unordered_set&& rhs) noexcept;
+   void swap(small_unordered_set& rhs)
+   {
+      small_unordered_set temp(std::move(rhs));
+      rhs = std::move(*this);
+      *this = std::move(temp);
+   }
+
+   //
+   // Iterator
+   //
+   class iterator;
+   iterator begin()
+   {
+      return pLarge ? iterator(pLarge->begin()) : iterator(inlineAt(0));
+   }
+   iterator end()
+   {
+      return pLarge ? iterator(pLarge->end()) : iterator(inlineAt(numInline));
+   }
+
+   //
+   // Access
+   //
+   iterator find(const T& t)
+   {
+      if (pLarge)
+         return iterator(pLarge->find(t));
+      return iterator(inlineAt(findInline(t)));
+   }
+   size_t count(const T& t)
+   {
+      return find(t) == end() ? 0 : 1;
+   }
+
+   //
+   // Insert
+   //
+   custom::pair<iterator, bool> insert(const T& t)
+   {
+      return insertUnique(t);
+   }
+   custom::pair<iterator, bool> insert(T&& t)
+   {
+      return insertUnique(std::move(t));
+   }
+   template <class ... Args>
+   custom::pair<iterator, bool> emplace(Args&& ... args)
+   {
+      return insertUnique(T(std::forward<Args>(args)...));
+   }
+   void insert(const std::initializer_list<T>& il)
+   {
+      for (auto& t : il)
+         insert(t);
+   }
+
+   //
+   // Remove
+   //
+   void clear() noexcept;
+   iterator erase(const T& t);
+
+   //
+   // Status
+   //
+   size_t size() const
+   {
+      return pLarge ? pLarge->size() : numInline;
+   }
+   bool empty() const
+   {
+      return size() == 0;
+   }
+   bool is_small() const noexcept
+   {
+      return pLarge == nullptr;
+   }
+   size_t bucket_count() const
+   {
+      // the inline elements are in no bucket at all
+      return pLarge ? pLarge->bucket_count() : 0;
+   }
+   Hash hash_function() const
+   {
+      return hashFunction;
+   }
+
+private:
+   T * inlineAt(size_t i)
+   {
+      return reinterpret_cast<T *>(items) + i;
+   }
+
+   // the index of t among the inline elements, or numInline when missing
+   size_t findInline(const T& t)
+   {
+      for (size_t i = 0; i < numInline; i++)
+         if (EqPred()(*inlineAt(i), t))
+            return i;
+      return numInline;
+   }
+
+   template <class U>
+   custom::pair<iterator, bool> insertUnique(U&& t);
+   void spill();
+
+   alignas(T) unsigned char items[N * sizeof(T)];   // numInline elements, the rest raw
+   size_t numInline;                                  // elements in items, 0 once large
+   Large * pLarge;                                    // every element once past N, else null
+   Hash hashFunction;                                 // handed to the hash when it spills
+};
+
+/************************************************
+ * SMALL UNORDERED SET ITERATOR
+ * A pointer into the inline elements, or an
+ * iterator of the hash once the set has spilled
+ ************************************************/
+template <typename T, size_t N, typename H, typename E, typename A, typename I>
+class small_unordered_set <T, N, H, E, A, I> ::iterator
+{
+   friend class ::TestSmallHash;   // give unit tests access to the privates
+   template <typename TT, size_t NN, typename HH, typename EE, typename AA, typename II>
+   friend class custom::small_unordered_set;
+public:
+   //
+   // Construct
+   //
+   iterator() : p(nullptr), large(false)
+   {
+   }
+   iterator(T * p) : p(p), large(false)
+   {
+   }
+   iterator(const typename Large::iterator& itLarge) : p(nullptr), itLarge(itLarge), large(true)
+   {
+   }
+
+   //
+   // Compare
+   //
+   bool operator == (const iterator& rhs) const
+   {
+      return large ? itLarge == rhs.itLarge : p == rhs.p;
+   }
+   bool operator != (const iterator& rhs) const
+   {
+      return !(*this == rhs);
+   }
+
+   //
+   // Access
+   //
+   T& operator * ()
+   {
+      return large ? *itLarge : *p;
+   }
+
+   //
+   // Arithmetic
+   //
+   iterator& operator ++ ()
+   {
+      if (large)
+         ++itLarge;
+      else
+         ++p;
+      return *this;
+   }
+   iterator operator ++ (int)
+   {
+      iterator temp(*this);
+      ++(*this);
+      return temp;
+   }
+
+private:
+   T * p;                              // the inline element while small
+   typename Large::iterator itLarge;   // the element in the hash once large
+   bool large;                         // which of the two this is
+};
+
+/*****************************************
+ * SMALL UNORDERED SET :: ASSIGNMENT
+ * Copy every element, inline or into a hash
+ * of its own
+ ****************************************/
+template <typename T, size_t N, typename H, typename E, typename A, typename I>
+small_unordered_set<T, N, H, E, A, I>& small_unordered_set<T, N, H, E, A, I>::operator=(const small_unordered_set& rhs)
+{
+   if (this == &rhs)
+      return *this;
+
+   clear();
+   hashFunction = rhs.hashFunction;
+   if (rhs.pLarge)
+   {
+      // pLarge is only set once the copy is whole
+      LargeAlloc alloc;
+      Large * pNew = std::allocator_traits<LargeAlloc>::allocate(alloc, 1);
+      try
+      {
+         new (pNew) Large(*rhs.pLarge);
+      }
+      catch (...)
+      {
+         std::allocator_traits<LargeAlloc>::deallocate(alloc, pNew, 1);
+         throw;
+      }
+      pLarge = pNew;
+      return *this;
+   }
+   for (size_t i = 0; i < rhs.numInline; i++)
+   {
+      new (inlineAt(i)) T(*const_cast<small_unordered_set&>(rhs).inlineAt(i));
+      numInline++;
+   }
+   return *this;
+}
+
+/*****************************************
+ * SMALL UNORDERED SET :: ASSIGNMENT - MOVE
+ * Take the hash whole, or move each inline element
+ ****************************************/
+template <typename T, size_t N, typename H, typename E, typename A, typename I>
+small_unordered_set<T, N, H, E, A, I>& small_unordered_set<T, N, H, E, A, I>::operator=(small_unordered_set&& rhs) noexcept
+{
+   if (this == &rhs)
+      return *this;
+
+   clear();
+   hashFunction = rhs.hashFunction;
+   if (rhs.pLarge)
+   {
+      pLarge = rhs.pLarge;
+      rhs.pLarge = nullptr;
+      return *this;
+   }
+   for (size_t i = 0; i < rhs.numInline; i++)
+      new (inlineAt(i)) T(std::move(*rhs.inlineAt(i)));
+   numInline = rhs.numInline;
+   rhs.clear();
+   return *this;
+}
+
+/*****************************************
+ * SMALL UNORDERED SET :: INSERT UNIQUE
+ * Look through the inline elements. With room, the
+ * new one goes on the end; without, spill first.
+ ****************************************/
+template <typename T, size_t N, typename H, typename E, typename A, typename I>
+template <class U>
+custom::pair<typename small_unordered_set<T, N, H, E, A, I>::iterator, bool> small_unordered_set<T, N, H, E, A, I>::insertUnique(U&& t)
+{
+   if (pLarge == nullptr)
+   {
+      size_t i = findInline(t);
+      if (i != numInline)
+         return custom::pair<iterator, bool>(iterator(inlineAt(i)), false);
+      if (numInline < N)
+      {
+         new (inlineAt(numInline)) T(std::forward<U>(t));
+         return custom::pair<iterator, bool>(iterator(inlineAt(numInline++)), true);
+      }
+      spill();
+   }
+
+   custom::pair<typename Large::iterator, bool> result = pLarge->insert(std::forward<U>(t));
+   return custom::pair<iterator, bool>(iterator(result.first), result.second);
+}
+
+/*****************************************
+ * SMALL UNORDERED SET :: SPILL
+ * Move every inline element into a new hash with
+ * room for twice as many. The set only changes
+ * once they are all in: if one throws, the moved
+ * ones come back and the set stays inline.
+ ****************************************/
+template <typename T, size_t N, typename H, typename E, typename A, typename I>
+void small_unordered_set<T, N, H, E, A, I>::spill()
+{
+   LargeAlloc alloc;
+   Large * pNew = std::allocator_traits<LargeAlloc>::allocate(alloc, 1);
+   try
+   {
+      new (pNew) Large(I().bucket_count(N * 2 > 8 ? N * 2 : 8), hashFunction);
+   }
+   catch (...)
+   {
+      std::allocator_traits<LargeAlloc>::deallocate(alloc, pNew, 1);
+      throw;
+   }
+
+   size_t i = 0;
+   try
+   {
+      for (; i < numInline; i++)
+         pNew->insert(std::move_if_noexcept(*inlineAt(i)));
+   }
+   catch (...)
+   {
+      // a move that cannot throw left a shell in each of the first i slots
+      if (std::is_nothrow_move_constructible<T>::value)
+      {
+         T * pSlot = inlineAt(0);
+         for (auto it = pNew->begin(); it != pNew->end(); ++it, ++pSlot)
+         {
+            pSlot->~T();
+            new (pSlot) T(std::move(*it));
+         }
+      }
+      pNew->~Large();
+      std::allocator_traits<LargeAlloc>::deallocate(alloc, pNew, 1);
+      throw;
+   }
+
+   for (i = 0; i < numInline; i++)
+      inlineAt(i)->~T();
+   numInline = 0;
+   pLarge = pNew;
+}
+
+/*****************************************
+ * SMALL UNORDERED SET :: ERASE
+ * Inline, the last element fills the hole, so the
+ * iterator returned is where the next one now is
+ ****************************************/
+template <typename T, size_t N, typename H, typename E, typename A, typename I>
+typename small_unordered_set<T, N, H, E, A, I>::iterator small_unordered_set<T, N, H, E, A, I>::erase(const T& t)
+{
+   if (pLarge)
+      return iterator(pLarge->erase(t));
+
+   size_t i = findInline(t);
+   if (i == numInline)
+      return end();
+
+   if (i != numInline - 1)
+      *inlineAt(i) = std::move(*inlineAt(numInline - 1));
+   inlineAt(--numInline)->~T();
+   return iterator(inlineAt(i));
+}
+
+/*****************************************
+ * SMALL UNORDERED SET :: CLEAR
+ * Destroy every element and free the hash, back
+ * to inline
+ ****************************************/
+template <typename T, size_t N, typename H, typename E, typename A, typename I>
+void small_unordered_set<T, N, H, E, A, I>::clear() noexcept
+{
+   for (size_t i = 0; i < numInline; i++)
+      inlineAt(i)->~T();
+   numInline = 0;
+
+   if (pLarge)
+   {
+      LargeAlloc alloc;
+      pLarge->~Large();
+      std::allocator_traits<LargeAlloc>::deallocate(alloc, pLarge, 1);
+      pLarge = nullptr;
+   }
+}
+
+}
@@ -0,0 +1,393 @@
+/***********************************************************************
+ * Header:
+ *    TEST BLOOM FILTER
+ * Summary:
+ *    Unit tests for blocked_bloom_filter and the filter in front of
+ *    unordered_set::find
+ * Author
+ *    Marco Varela &  Andre Regino
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "bloomFilter.h"   // class under test
+#include "hash.h"          // the set the filter sits in front of
+#include "unitTest.h"      // unit test baseclass
+#include "spy.h"           // spy is a mock class to monitor the class under test
+
+/***********************************************
+ * TEST BLOOM FILTER
+ * Unit tests for the Bloom filter
+ ***********************************************/
+class TestBloomFilter : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Filter
+      test_filter_off();
+      test_filter_configure();
+      test_filter_aligned();
+      test_filter_numHashes();
+      test_filter_noFalseNegatives();
+      test_filter_falsePositives();
+      test_filter_clear();
+      test_filter_admits();
+
+      // Set
+      test_set_off();
+      test_set_missRejected();
+      test_set_hit();
+      test_set_grow();
+      test_set_observedRate();
+      test_set_insertUncounted();
+      test_set_erase();
+      test_set_eraseRebuild();
+      test_set_incremental();
+      test_set_clear();
+      test_set_copy();
+
+      report("BloomFilter");
+   }
+
+   /***************************************
+    * FILTER
+    ***************************************/
+
+   // no bits until it is asked for some
+   void test_filter_off()
+   {  // exercise
+      custom::blocked_bloom_filter filter;
+      // verify
+      assertUnit(!filter.active());
+      assertUnit(filter.num_bytes() == 0);
+      assertUnit(filter.num_hashes() == 0);
+   }
+
+   // 1000 keys at 10 bits is 20 cache lines, 7 bits a key
+   void test_filter_configure()
+   {  // setup
+      custom::blocked_bloom_filter filter;
+      // exercise
+      filter.configure(10, 1000);
+      // verify
+      assertUnit(filter.active());
+      assertUnit(filter.bits_per_key() == 10);
+      assertUnit(filter.numBlocks == 20);
+      assertUnit(filter.num_bytes() == 20 * 64);
+      assertUnit(filter.num_hashes() == 7);
+   }
+
+   // every block is one cache line, in the filter and in a copy of it
+   void test_filter_aligned()
+   {  // setup
+      custom::blocked_bloom_filter filter;
+      filter.configure(10, 1000);
+      for (size_t i = 0; i < 1000; i++)
+         filter.add(i * 7919);
+      // exercise
+      custom::blocked_bloom_filter copy(filter);
+      // verify
+      bool aligned = true;
+      for (size_t i = 0; i < filter.numBlocks; i++)
+         if ((uintptr_t)filter.blockAt(i) % 64 != 0 || (uintptr_t)copy.blockAt(i) % 64 != 0)
+            aligned = false;
+      assertUnit(aligned);
+      bool found = true;
+      for (size_t i = 0; i < 1000; i++)
+         if (!copy.may_contain(i * 7919))
+            found = false;
+      assertUnit(found);
+   }
+
+   // ln 2 bits set per key, rounded, from 1 to MAX_HASHES
+   void test_filter_numHashes()
+   {  // setup
+      custom::blocked_bloom_filter filter;
+      // exercise and verify
+      filter.configure(1, 10);
+      assertUnit(filter.num_hashes() == 1);
+      filter.configure(4, 10);
+      assertUnit(filter.num_hashes() == 3);
+      filter.configure(8, 10);
+      assertUnit(filter.num_hashes() == 6);
+      filter.configure(20, 10);
+      assertUnit(filter.num_hashes() == 7);
+      filter.configure(0, 10);
+      assertUnit(!filter.active());
+   }
+
+   // every key added is let through
+   void test_filter_noFalseNegatives()
+   {  // setup
+      custom::blocked_bloom_filter filter;
+      filter.configure(4, 1000);
+      // exercise
+      for (size_t i = 0; i < 1000; i++)
+         filter.add(i);
+      // verify
+      bool all = true;
+      for (size_t i = 0; i < 1000; i++)
+         if (!filter.may_contain(i))
+            all = false;
+      assertUnit(all);
+   }
+
+   // at 10 bits a key, about 1% of other keys get through
+   void test_filter_falsePositives()
+   {  // setup
+      custom::blocked_bloom_filter filter;
+      filter.configure(10, 10000);
+      for (size_t i = 0; i < 10000; i++)
+         filter.add(i);
+      size_t numPassed = 0;
+      // exercise
+      for (size_t i = 10000; i < 20000; i++)
+         numPassed += filter.may_contain(i);
+      // verify
+      assertUnit(numPassed < 300);   // under 3%
+   }
+
+   // nothing passes a cleared filter
+   void test_filter_clear()
+   {  // setup
+      custom::blocked_bloom_filter filter;
+      filter.configure(8, 100);
+      for (size_t i = 0; i < 100; i++)
+         filter.add(i);
+      filter.erased();
+      // exercise
+      filter.clear();
+      // verify
+      size_t numPassed = 0;
+      for (size_t i = 0; i < 100; i++)
+         numPassed += filter.may_contain(i);
+      assertUnit(numPassed == 0);
+      assertUnit(filter.num_stale() == 0);
+      assertUnit(filter.num_bytes() == 64 * 2);
+   }
+
+   // a key turned away is counted
+   void test_filter_admits()
+   {  // setup
+      custom::blocked_bloom_filter filter;
+      filter.configure(8, 100);
+      filter.add(5);
+      // exercise
+      bool admitted = filter.admits(5);
+      filter.admits(6);
+      filter.missed();
+      // verify
+      assertUnit(admitted);
+      assertUnit(filter.num_rejected() + filter.num_false_positives() == 2);
+   }
+
+   /***************************************
+    * SET
+    ***************************************/
+
+   // a set has no filter unless asked for one
+   void test_set_off()
+   {  // setup
+      custom::unordered_set<int> us;
+      us.insert(3);
+      us.find(4);
+      // exercise
+      custom::hash_stats s = us.stats();
+      // verify
+      assertUnit(us.bloom_filter() == 0);
+      assertUnit(s.bloomBitsPerKey == 0);
+      assertUnit(s.bloomBytes == 0);
+      assertUnit(s.bloomRejected == 0);
+      assertUnit(s.bloomFalsePositives == 0);
+   }
+
+   // a miss the filter turns away compares nothing
+   void test_set_missRejected()
+   {  // setup
+      custom::unordered_set<Spy> us;
+      us.bloom_filter(16);
+      us.insert(Spy(31));
+      us.insert(Spy(49));
+      us.insert(Spy(67));
+      us.insert(Spy(59));
+      Spy key(99);
+      size_t numRejected = us.stats().bloomRejected;
+      Spy::reset();
+      // exercise
+      auto it = us.find(key);
+      // verify
+      assertUnit(it == us.end());
+      assertUnit(Spy::numEquals() == 0);
+      assertUnit(us.stats().bloomRejected == numRejected + 1);
+   }
+
+   // a hit is never turned away
+   void test_set_hit()
+   {  // setup
+      custom::unordered_set<Spy> us;
+      us.bloom_filter(16);
+      us.insert(Spy(31));
+      us.insert(Spy(49));
+      us.insert(Spy(67));
+      us.insert(Spy(59));
+      size_t numRejected = us.stats().bloomRejected;
+      // exercise
+      bool found = us.find(Spy(31)) != us.end() && us.find(Spy(49)) != us.end() &&
+                   us.find(Spy(67)) != us.end() && us.find(Spy(59)) != us.end();
+      // verify
+      assertUnit(found);
+      assertUnit(us.stats().bloomRejected == numRejected);
+   }
+
+   // each rehash sizes the filter for the new table
+   void test_set_grow()
+   {  // setup
+      custom::unordered_set<int> us;
+      us.bloom_filter(8);
+      size_t numBytesEmpty = us.stats().bloomBytes;
+      // exercise
+      for (int i = 0; i < 1000; i++)
+         us.insert(i);
+      // verify
+      bool found = true;
+      for (int i = 0; i < 1000; i++)
+         if (us.find(i) == us.end())
+            found = false;
+      assertUnit(found);
+      assertUnit(numBytesEmpty == 64);     // 64 bits, one whole cache line
+      assertUnit(us.stats().bloomBytes == 1024 * 8 / 8);
+   }
+
+   // the stats count every miss, turned away or not
+   void test_set_observedRate()
+   {  // setup
+      custom::unordered_set<int> us;
+      us.bloom_filter(10);
+      for (int i = 0; i < 1000; i++)
+         us.insert(i);
+      custom::hash_stats sBefore = us.stats();
+      // exercise
+      for (int i = 1000; i < 11000; i++)
+         us.find(i);
+      // verify
+      custom::hash_stats s = us.stats();
+      assertUnit(s.bloomRejected + s.bloomFalsePositives -
+                 sBefore.bloomRejected - sBefore.bloomFalsePositives == 10000);
+      assertUnit(s.bloomFalsePositiveRate() < (float)0.05);
+      assertUnit(s.bloomBitsPerKey == 10);
+   }
+
+   // only lookups count: inserting and erasing new keys leaves the stats alone
+   void test_set_insertUncounted()
+   {  // setup
+      custom::unordered_set<int> us;
+      us.bloom_filter(10);
+      for (int i = 0; i < 1000; i++)
+         us.insert(i);
+      // exercise
+      for (int i = 1000; i < 2000; i++)
+         us.insert(i);
+      for (int i = 0; i < 500; i++)
+         us.erase(i);
+      // verify
+      custom::hash_stats s = us.stats();
+      assertUnit(s.bloomRejected == 0);
+      assertUnit(s.bloomFalsePositives == 0);
+      assertUnit(us.find(5000) == us.end());
+      assertUnit(us.stats().bloomRejected + us.stats().bloomFalsePositives == 1);
+   }
+
+   // an erased key is gone, though its bits may still let it through
+   void test_set_erase()
+   {  // setup
+      custom::unordered_set<int> us;
+      us.bloom_filter(10);
+      for (int i = 0; i < 100; i++)
+         us.insert(i);
+      // exercise
+      us.erase(40);
+      // verify
+      assertUnit(us.find(40) == us.end());
+      assertUnit(us.find(41) != us.end());
+      assertUnit(us.size() == 99);
+   }
+
+   // once most keys are gone the filter forgets them
+   void test_set_eraseRebuild()
+   {  // setup
+      custom::unordered_set<int> us;
+      us.bloom_filter(10);
+      for (int i = 0; i < 100; i++)
+         us.insert(i);
+      // exercise
+      for (int i = 0; i < 60; i++)
+         us.erase(i);
+      size_t numRejectedBefore = us.stats().bloomRejected;
+      for (int i = 0; i < 60; i++)
+         us.find(i);
+      // verify
+      bool found = true;
+      for (int i = 60; i < 100; i++)
+         if (us.find(i) == us.end())
+            found = false;
+      assertUnit(found);
+      assertUnit(us.stats().bloomRejected - numRejectedBefore > 45);   // most of the 60
+   }
+
+   // while migrating, the filter covers both tables
+   void test_set_incremental()
+   {  // setup
+      custom::unordered_set<int> us(4);
+      us.incremental_rehash(true);
+      us.bloom_filter(10);
+      // exercise
+      for (int i = 0; i < 50; i++)
+         us.insert(i);
+      // verify
+      bool found = true;
+      for (int i = 0; i < 50; i++)
+         if (us.find(i) == us.end())
+            found = false;
+      assertUnit(found);
+      assertUnit(us.stats().bloomFalsePositives == 0);
+   }
+
+   // clear forgets every key
+   void test_set_clear()
+   {  // setup
+      custom::unordered_set<int> us;
+      us.bloom_filter(10);
+      for (int i = 0; i < 5; i++)
+         us.insert(i);
+      size_t numRejected = us.stats().bloomRejected;
+      // exercise
+      us.clear();
+      for (int i = 0; i < 5; i++)
+         us.find(i);
+      // verify
+      assertUnit(us.stats().bloomRejected == numRejected + 5);
+      assertUnit(us.bloom_filter() == 10);
+   }
+
+   // a copy has its own filter, with the same keys
+   void test_set_copy()
+   {  // setup
+      custom::unordered_set<int> us;
+      us.bloom_filter(10);
+      for (int i = 0; i < 20; i++)
+         us.insert(i);
+      // exercise
+      custom::unordered_set<int> usCopy(us);
+      // verify
+      assertUnit(usCopy.bloom_filter() == 10);
+      assertUnit(usCopy.find(7) != usCopy.end());
+      assertUnit(usCopy.find(77) == usCopy.end());
+   }
+};
+
+#endif // DEBUG
@@ -0,0 +1,332 @@
+/***********************************************************************
+ * Header:
+ *    TEST CONCURRENT HASH
+ * Summary:
+ *    Unit tests for the lock-striped concurrent_unordered_set
+ * Author
+ *    Marco Varela &  Andre Regino
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "concurrentHash.h"   // class under test
+#include "unitTest.h"         // unit test baseclass
+#include "spy.h"              // spy is a mock class to monitor the class under test
+
+#include <thread>             // for std::thread
+#include <vector>             // for std::vector of keys and threads
+
+/***********************************************
+ * TEST CONCURRENT HASH
+ * Unit tests for the concurrent_unordered_set class
+ ***********************************************/
+class TestConcurrentHash : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Construct
+      test_construct_default();
+      test_construct_nonDefault100();
+
+      // Access
+      test_contains_standard();
+      test_findMany_standard();
+      test_forEach_standard();
+
+      // Insert
+      test_insert_standard();
+      test_insert_standardDuplicate();
+      test_insert_grow();
+      test_insertMany_standard();
+
+      // Remove
+      test_erase_standard();
+      test_clear_standard();
+
+      // Threads
+      test_threads_insert();
+      test_threads_mixed();
+
+      report("ConcurrentHash");
+   }
+
+   /***************************************
+    * CONSTRUCT
+    ***************************************/
+
+   // one bucket for each stripe
+   void test_construct_default()
+   {  // setup
+      Spy::reset();
+      // exercise
+      custom::concurrent_unordered_set<Spy> us;
+      // verify
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(us.size() == 0);
+      assertUnit(us.empty());
+      assertUnit(us.bucket_count() == custom::concurrent_unordered_set<Spy>::NUM_STRIPES);
+   }  // teardown
+
+   // the bucket count is rounded up to a multiple of the stripes
+   void test_construct_nonDefault100()
+   {  // exercise
+      custom::concurrent_unordered_set<Spy> us(100);
+      // verify
+      assertUnit(us.bucket_count() == 128);
+      assertUnit(us.size() == 0);
+   }  // teardown
+
+   /***************************************
+    * ACCESS
+    ***************************************/
+
+   // contains looks in the one bucket
+   void test_contains_standard()
+   {  // setup
+      custom::concurrent_unordered_set<Spy> us;
+      us.insert(Spy(31));
+      us.insert(Spy(49));
+      us.insert(Spy(67));
+      Spy s67(67);
+      Spy s59(59);
+      Spy::reset();
+      // exercise
+      bool found67 = us.contains(s67);
+      bool found59 = us.contains(s59);
+      // verify
+      assertUnit(found67);
+      assertUnit(!found59);
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(Spy::numEquals() == 2);   // 49 67
+      assertUnit(us.count(Spy(31)) == 1);
+   }  // teardown
+
+   // find_many answers in the order of the keys
+   void test_findMany_standard()
+   {  // setup
+      custom::concurrent_unordered_set<int> us;
+      for (int i = 0; i < 100; i += 2)
+         us.insert(i);
+      std::vector<int> keys{ 4, 5, 98, 99, 0, 64 };
+      std::vector<bool> found;
+      // exercise
+      size_t numFound = us.find_many(keys, std::back_inserter(found));
+      // verify
+      assertUnit(numFound == 4);
+      assertUnit(found.size() == 6);
+      if (found.size() == 6)
+      {
+         assertUnit(found[0] == true);
+         assertUnit(found[1] == false);
+         assertUnit(found[2] == true);
+         assertUnit(found[3] == false);
+         assertUnit(found[4] == true);
+         assertUnit(found[5] == true);
+      }
+   }  // teardown
+
+   // for_each visits every element once
+   void test_forEach_standard()
+   {  // setup
+      custom::concurrent_unordered_set<int> us;
+      for (int i = 1; i <= 200; i++)
+         us.insert(i);
+      int sum = 0;
+      int count = 0;
+      // exercise
+      us.for_each([&](int i) { sum += i; count++; });
+      // verify
+      assertUnit(count == 200);
+      assertUnit(sum == 200 * 201 / 2);
+   }  // teardown
+
+   /***************************************
+    * INSERT
+    ***************************************/
+
+   // insert copies the element into its bucket
+   void test_insert_standard()
+   {  // setup
+      custom::concurrent_unordered_set<Spy> us;
+      Spy s(49);
+      Spy::reset();
+      // exercise
+      bool inserted = us.insert(s);
+      // verify
+      assertUnit(inserted);
+      assertUnit(Spy::numAlloc() == 1);
+      assertUnit(Spy::numCopy() == 1);
+      assertUnit(us.size() == 1);
+      assertUnit(us.buckets[13].size() == 1);   // 4 + 9
+   }  // teardown
+
+   // inserting a duplicate changes nothing
+   void test_insert_standardDuplicate()
+   {  // setup
+      custom::concurrent_unordered_set<Spy> us;
+      us.insert(Spy(49));
+      us.insert(Spy(67));
+      Spy s(67);
+      Spy::reset();
+      // exercise
+      bool inserted = us.insert(s);
+      // verify
+      assertUnit(!inserted);
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(Spy::numEquals() == 2);   // 49 67
+      assertUnit(us.size() == 2);
+   }  // teardown
+
+   // growth keeps every element in a bucket of its stripe
+   void test_insert_grow()
+   {  // setup
+      typedef custom::concurrent_unordered_set<int> Set;
+      Set us;
+      // exercise
+      for (int i = 0; i < 300; i++)
+         us.insert(i * 7);
+      // verify
+      assertUnit(us.size() == 300);
+      assertUnit(us.bucket_count() >= 300);
+      assertUnit(us.bucket_count() % Set::NUM_STRIPES == 0);
+      bool striped = true;
+      for (size_t iBucket = 0; iBucket < us.buckets.size(); iBucket++)
+         for (auto it = us.buckets[iBucket].begin(); it != us.buckets[iBucket].end(); ++it)
+            if (Set::stripeOf(std::hash<int>()(*it)) != iBucket % Set::NUM_STRIPES)
+               striped = false;
+      assertUnit(striped);
+      bool found = true;
+      for (int i = 0; i < 300; i++)
+         if (!us.contains(i * 7))
+            found = false;
+      assertUnit(found);
+   }  // teardown
+
+   // a batch grows the table once and skips its own duplicates
+   void test_insertMany_standard()
+   {  // setup
+      custom::concurrent_unordered_set<int> us;
+      us.insert(5);
+      std::vector<int> keys;
+      for (int i = 0; i < 500; i++)
+         keys.push_back(i % 250);
+      // exercise
+      size_t numInserted = us.insert_many(keys);
+      // verify
+      assertUnit(numInserted == 249);   // all but 5
+      assertUnit(us.size() == 250);
+      assertUnit(us.bucket_count() >= 250);
+      assertUnit(us.contains(249));
+      assertUnit(!us.contains(250));
+   }  // teardown
+
+   /***************************************
+    * REMOVE
+    ***************************************/
+
+   // erase removes one element from its bucket
+   void test_erase_standard()
+   {  // setup
+      custom::concurrent_unordered_set<Spy> us;
+      us.insert(Spy(49));
+      us.insert(Spy(67));
+      Spy s(49);
+      Spy::reset();
+      // exercise
+      size_t numErased = us.erase(s);
+      // verify
+      assertUnit(numErased == 1);
+      assertUnit(Spy::numDestructor() == 1);
+      assertUnit(us.size() == 1);
+      assertUnit(us.erase(Spy(49)) == 0);
+      assertUnit(us.contains(Spy(67)));
+   }  // teardown
+
+   // clear keeps the buckets
+   void test_clear_standard()
+   {  // setup
+      custom::concurrent_unordered_set<Spy> us;
+      us.insert(Spy(31));
+      us.insert(Spy(49));
+      Spy::reset();
+      // exercise
+      us.clear();
+      // verify
+      assertUnit(Spy::numDestructor() == 2);
+      assertUnit(us.empty());
+      assertUnit(us.bucket_count() == 64);
+      assertUnit(!us.contains(Spy(31)));
+   }  // teardown
+
+   /***************************************
+    * THREADS
+    ***************************************/
+
+   // threads inserting their own keys lose none of them
+   void test_threads_insert()
+   {  // setup
+      custom::concurrent_unordered_set<int> us;
+      std::vector<std::thread> threads;
+      // exercise
+      for (int t = 0; t < 4; t++)
+         threads.emplace_back([&us, t]()
+         {
+            for (int i = 0; i < 2000; i++)
+               us.insert(t * 2000 + i);
+         });
+      for (auto& thread : threads)
+         thread.join();
+      // verify
+      assertUnit(us.size() == 8000);
+      bool found = true;
+      for (int i = 0; i < 8000; i++)
+         if (!us.contains(i))
+            found = false;
+      assertUnit(found);
+   }  // teardown
+
+   // readers always find the keys that were there before they started
+   void test_threads_mixed()
+   {  // setup
+      custom::concurrent_unordered_set<int> us;
+      for (int i = 0; i < 1000; i++)
+         us.insert(i);
+      std::vector<std::thread> threads;
+      std::atomic<int> numMissing(0);
+      // exercise
+      for (int t = 0; t < 2; t++)
+         threads.emplace_back([&us, t]()
+         {
+            std::vector<int> batch;
+            for (int i = 0; i < 3000; i++)
+            {
+               batch.push_back(1000 + t * 3000 + i);
+               if (batch.size() == 100)
+               {
+                  us.insert_many(batch);
+                  batch.clear();
+               }
+            }
+         });
+      for (int t = 0; t < 2; t++)
+         threads.emplace_back([&us, &numMissing]()
+         {
+            for (int round = 0; round < 5; round++)
+               for (int i = 0; i < 1000; i++)
+                  if (!us.contains(i))
+                     numMissing++;
+         });
+      for (auto& thread : threads)
+         thread.join();
+      // verify
+      assertUnit(numMissing == 0);
+      assertUnit(us.size() == 7000);
+   }  // teardown
+};
+
+#endif // DEBUG
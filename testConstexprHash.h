@@ -0,0 +1,220 @@
+/***********************************************************************
+ * Header:
+ *    TEST CONSTEXPR HASH
+ * Summary:
+ *    Unit tests for constexpr_unordered_set. What the compiler can
+ *    check is checked twice: in a static_assert, and again at run time
+ *    so the report counts it.
+ * Author
+ *    Marco Varela &  Andre Regino
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "constexprHash.h"   // class under test
+#include "unitTest.h"        // unit test baseclass
+
+#include <cstring>           // for std::strcpy into a buffer
+#include <stdexcept>         // for std::logic_error
+
+/***********************************************
+ * TEST CONSTEXPR HASH
+ * Unit tests for the compile-time set
+ ***********************************************/
+class TestConstexprHash : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Hash
+      test_hash_constant();
+      test_equal_cString();
+
+      // Build
+      test_build_ints();
+      test_build_minimal();
+      test_build_oneKey();
+      test_build_runtime();
+      test_build_sameHash();
+
+      // Find
+      test_find_slot();
+      test_find_cString();
+      test_find_stringView();
+
+      report("ConstexprHash");
+   }
+
+   /***************************************
+    * HASH
+    ***************************************/
+
+   // the compiler and the program hash alike
+   void test_hash_constant()
+   {  // setup
+      constexpr size_t hashConstant = custom::constexpr_hash<const char *>()("while");
+      char buffer[8] = {};
+      std::strcpy(buffer, "while");
+      // exercise
+      size_t hashRuntime = custom::constexpr_hash<const char *>()(buffer);
+      // verify
+      assertUnit(hashRuntime == hashConstant);
+      static_assert(custom::constexpr_hash<int>()(7) == custom::mix64(7), "an int is mixed");
+      assertUnit(custom::constexpr_hash<int>()(7) != custom::constexpr_hash<int>()(8));
+   }  // teardown
+
+   // two C strings compare by their characters
+   void test_equal_cString()
+   {  // setup
+      char buffer[8] = {};
+      std::strcpy(buffer, "else");
+      custom::constexpr_equal_to<const char *> equal;
+      // exercise and verify
+      static_assert(custom::constexpr_equal_to<const char *>()("if", "if"), "same characters");
+      static_assert(!custom::constexpr_equal_to<const char *>()("if", "iff"), "a longer string");
+      assertUnit(equal(buffer, "else"));
+      assertUnit(!equal(buffer, "els"));
+      assertUnit(!equal("", buffer));
+   }  // teardown
+
+   /***************************************
+    * BUILD
+    ***************************************/
+
+   // a set the compiler builds and searches
+   void test_build_ints()
+   {  // exercise
+      static constexpr int primes[] = { 2, 3, 5, 7, 11, 13, 17, 19, 23, 29 };
+      static constexpr custom::constexpr_unordered_set<int, 10> s(primes);
+      // verify
+      static_assert(s.contains(23) && !s.contains(21), "found at compile time");
+      static_assert(s.size() == 10, "ten primes");
+      assertUnit(s.size() == 10);
+      assertUnit(!s.empty());
+      assertUnit(s.contains(23));
+      assertUnit(!s.contains(21));
+      assertUnit(s.count(2) == 1);
+      assertUnit(s.count(4) == 0);
+   }  // teardown
+
+   // n keys in n slots, every key once
+   void test_build_minimal()
+   {  // setup
+      static constexpr int keys[] = { 10, 20, 30, 40, 50, 60, 70, 80, 90, 100, 110, 120, 130 };
+      // exercise
+      static constexpr auto s = custom::make_constexpr_unordered_set(keys);
+      // verify
+      assertUnit(s.end() - s.begin() == 13);
+      int sum = 0;
+      for (auto it = s.begin(); it != s.end(); ++it)
+         sum += *it;
+      assertUnit(sum == 910);
+      assertUnit(sizeof(s) == sizeof(int) * 13 + sizeof(uint32_t) * 5);
+   }  // teardown
+
+   // a single key is its own slot
+   void test_build_oneKey()
+   {  // exercise
+      static constexpr auto s = custom::make_constexpr_unordered_set<const char *>({ "only" });
+      // verify
+      static_assert(s.contains("only") && !s.contains("other"), "one key");
+      assertUnit(s.size() == 1);
+      assertUnit(s.contains("only"));
+      assertUnit(!s.contains("onl"));
+   }  // teardown
+
+   // built at run time, the layout is the same
+   void test_build_runtime()
+   {  // setup
+      static constexpr int keys[] = { 31, 49, 67, 59 };
+      static constexpr custom::constexpr_unordered_set<int, 4> sConstant(keys);
+      int keysRuntime[] = { 31, 49, 67, 59 };
+      // exercise
+      custom::constexpr_unordered_set<int, 4> sRuntime(keysRuntime);
+      // verify
+      bool same = true;
+      for (size_t i = 0; i < 4; i++)
+         if (sRuntime.keys[i] != sConstant.keys[i])
+            same = false;
+      assertUnit(same);
+      assertUnit(sRuntime.pilots[0] == sConstant.pilots[0]);
+      assertUnit(sRuntime.pilots[1] == sConstant.pilots[1]);
+   }  // teardown
+
+   // two equal keys cannot both have a slot: a compile
+   // error when constexpr, an exception at run time
+   void test_build_sameHash()
+   {  // setup
+      int keys[] = { 4, 5, 4 };
+      bool thrown = false;
+      // exercise
+      try
+      {
+         custom::constexpr_unordered_set<int, 3> s(keys);
+      }
+      catch (const std::logic_error&)
+      {
+         thrown = true;
+      }
+      // verify
+      assertUnit(thrown);
+   }  // teardown
+
+   /***************************************
+    * FIND
+    ***************************************/
+
+   // find points at the key in its slot, or at end
+   void test_find_slot()
+   {  // setup
+      static constexpr auto s = custom::make_constexpr_unordered_set<unsigned>({ 0x10u, 0x20u, 0x30u, 0x40u, 0x50u });
+      // exercise
+      auto it = s.find(0x30u);
+      // verify
+      assertUnit(it != s.end());
+      if (it != s.end())
+         assertUnit(*it == 0x30u);
+      assertUnit(s.find(0x31u) == s.end());
+      static_assert(*s.find(0x50u) == 0x50u, "found at compile time");
+   }  // teardown
+
+   // a keyword set finds characters read at run time
+   void test_find_cString()
+   {  // setup
+      static constexpr auto keywords = custom::make_constexpr_unordered_set<const char *>(
+         { "if", "else", "while", "for", "do", "return", "switch", "case", "break" });
+      char buffer[16] = {};
+      // exercise and verify
+      std::strcpy(buffer, "return");
+      assertUnit(keywords.contains(buffer));
+      std::strcpy(buffer, "returns");
+      assertUnit(!keywords.contains(buffer));
+      std::strcpy(buffer, "");
+      assertUnit(!keywords.contains(buffer));
+      static_assert(keywords.contains("break") && !keywords.contains("goto"), "keywords");
+   }  // teardown
+
+   // string_view keys, where there are string_views
+   void test_find_stringView()
+   {
+#ifdef CUSTOM_CONSTEXPR_STRING_VIEW
+      // setup
+      static constexpr std::string_view words[] = { "alpha", "beta", "gamma" };
+      static constexpr custom::constexpr_unordered_set<std::string_view, 3> s(words);
+      const char text[] = "a gamma ray";
+      // exercise
+      bool found = s.contains(std::string_view(text + 2, 5));
+      bool missed = s.contains(std::string_view(text + 2, 4));
+      // verify
+      assertUnit(found);
+      assertUnit(!missed);
+      static_assert(s.contains("beta"), "found at compile time");
+#endif
+   }  // teardown
+};
+
+#endif // DEBUG
@@ -0,0 +1,450 @@
+/***********************************************************************
+ * Header:
+ *    TEST CUCKOO HASH
+ * Summary:
+ *    Unit tests for the bucketized cuckoo_unordered_set
+ * Author
+ *    Marco Varela &  Andre Regino
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "cuckooHash.h"  // class under test
+#include "hashFunction.h" // for a seeded custom::hash
+#include "unitTest.h"    // unit test baseclass
+#include "spy.h"         // spy is a mock class to monitor the class under test
+
+#include <cstdint>       // for uint64_t and uintptr_t
+#include <set>           // for std::set to check the iterator
+#include <stdexcept>     // for std::runtime_error
+
+/***********************************************
+ * SAME HASH
+ * Every int has one hash, so every int has the
+ * same two buckets
+ ***********************************************/
+struct SameHash
+{
+   size_t operator()(int) const
+   {
+      return 7;
+   }
+};
+
+/***********************************************
+ * TEST CUCKOO HASH
+ * Unit tests for the cuckoo_unordered_set class
+ ***********************************************/
+class TestCuckooHash : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Construct
+      test_construct_default();
+      test_construct_nonDefault10();
+      test_construct_copyStandard();
+      test_construct_seeded();
+
+      // Access
+      test_bucket_layout();
+      test_find_empty();
+      test_find_standard();
+      test_find_standardMissing();
+
+      // Insert
+      test_insert_standardDuplicate();
+      test_insert_highLoad();
+      test_insert_grow();
+      test_insert_sameHash();
+      test_reserve_noRehash();
+
+      // Remove
+      test_erase_standard();
+      test_erase_standardMissing();
+      test_erase_churn();
+      test_clear_standard();
+
+      // Iterator
+      test_iterator_visitsAll();
+
+      report("CuckooHash");
+   }
+
+   /***************************************
+    * CONSTRUCT
+    ***************************************/
+
+   // the default constructor does not allocate a table
+   void test_construct_default()
+   {  // setup
+      Spy::reset();
+      // exercise
+      custom::cuckoo_unordered_set<Spy> us;
+      // verify
+      assertUnit(Spy::numDefault() == 0);
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(us.buckets == nullptr);
+      assertUnit(us.numBuckets == 0);
+      assertUnit(us.numElements == 0);
+      assertUnit(us.max_load_factor() == (float)0.95);
+      assertUnit(us.begin() == us.end());
+   }  // teardown
+
+   // any bucket count will do, not only a power of two
+   void test_construct_nonDefault10()
+   {  // setup
+      Spy::reset();
+      // exercise
+      custom::cuckoo_unordered_set<Spy> us(10);
+      // verify
+      assertUnit(Spy::numDefault() == 0);
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(us.numBuckets == 10);
+      assertUnit(us.numElements == 0);
+      bool allEmpty = true;
+      for (size_t b = 0; b < 10; b++)
+         for (size_t i = 0; i < us.SLOTS; i++)
+            if (us.buckets[b].tags[i] != 0)
+               allEmpty = false;
+      assertUnit(allEmpty);
+      assertUnit(us.begin() == us.end());
+   }  // teardown
+
+   // copy the table slot for slot
+   void test_construct_copyStandard()
+   {  // setup
+      custom::cuckoo_unordered_set<Spy> usSrc;
+      setupStandardFixture(usSrc);
+      Spy::reset();
+      // exercise
+      custom::cuckoo_unordered_set<Spy> usDes(usSrc);
+      // verify
+      assertUnit(Spy::numCopy() == 4);
+      assertUnit(Spy::numAlloc() == 4);
+      assertUnit(Spy::numCopyMove() == 0);
+      assertUnit(Spy::numEquals() == 0);
+      assertUnit(usDes.numBuckets == usSrc.numBuckets);
+      assertUnit(usDes.size() == 4);
+      assertUnit(usDes.find(Spy(67)) != usDes.end());
+      assertUnit(usDes.find(Spy(31)) != usDes.end());
+   }  // teardown
+
+   // the set keeps the hasher it was given, seed and all
+   void test_construct_seeded()
+   {  // setup
+      typedef custom::cuckoo_unordered_set<int, custom::hash<int>> Seeded;
+      Seeded us(8, custom::hash<int>(5));
+      for (int i = 0; i < 100; i++)
+         us.insert(i);
+      // exercise
+      Seeded usCopy(us);
+      Seeded usOther(8, custom::hash<int>(6));
+      usOther.swap(usCopy);
+      // verify
+      assertUnit(us.hash_function().seed() == 5);
+      assertUnit(us.hashOf(3) == custom::mix64(custom::hash<int>(5)(3)));
+      assertUnit(usOther.hash_function().seed() == 5);
+      assertUnit(usCopy.hash_function().seed() == 6);
+      bool found = true;
+      for (int i = 0; i < 100; i++)
+         if (us.find(i) == us.end() || usOther.find(i) == usOther.end())
+            found = false;
+      assertUnit(found);
+      assertUnit(usCopy.empty());
+   }  // teardown
+
+   /***************************************
+    * ACCESS
+    ***************************************/
+
+   // a bucket of small keys is a power of two, on its own
+   // boundary, so it never spans two cache lines
+   void test_bucket_layout()
+   {  // setup
+      custom::cuckoo_unordered_set<uint64_t> us(3);
+      // exercise
+      uintptr_t address = (uintptr_t)us.buckets;
+      // verify
+      assertUnit(custom::cuckoo_unordered_set<uint64_t>::bucket_bytes() == 64);
+      assertUnit(custom::cuckoo_unordered_set<int>::bucket_bytes() == 32);
+      assertUnit(address % 64 == 0);
+      assertUnit(us.num_bytes() == 3 * 64);
+      assertUnit(custom::cuckoo_bucket_alignment(40, 8) == 64);
+      assertUnit(custom::cuckoo_bucket_alignment(136, 8) == 8);
+   }  // teardown
+
+   // find in a set that has no table
+   void test_find_empty()
+   {  // setup
+      custom::cuckoo_unordered_set<Spy> us;
+      Spy s(99);
+      Spy::reset();
+      // exercise
+      custom::cuckoo_unordered_set<Spy>::iterator it = us.find(s);
+      // verify
+      assertUnit(Spy::numEquals() == 0);
+      assertUnit(it == us.end());
+   }  // teardown
+
+   // find an element: only the matching tag is compared
+   void test_find_standard()
+   {  // setup
+      custom::cuckoo_unordered_set<Spy> us;
+      setupStandardFixture(us);
+      Spy s(49);
+      Spy::reset();
+      // exercise
+      custom::cuckoo_unordered_set<Spy>::iterator it = us.find(s);
+      // verify
+      assertUnit(Spy::numEquals() == 1);
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(it != us.end());
+      if (it != us.end())
+         assertUnit(*it == Spy(49));
+   }  // teardown
+
+   // find something that is not there: two buckets, then done
+   void test_find_standardMissing()
+   {  // setup
+      custom::cuckoo_unordered_set<Spy> us;
+      setupStandardFixture(us);
+      Spy s(50);
+      Spy::reset();
+      // exercise
+      custom::cuckoo_unordered_set<Spy>::iterator it = us.find(s);
+      // verify
+      assertUnit(Spy::numEquals() <= 2 * (int)us.SLOTS);
+      assertUnit(it == us.end());
+   }  // teardown
+
+   /***************************************
+    * INSERT
+    ***************************************/
+
+   // the second insert of an element finds the first
+   void test_insert_standardDuplicate()
+   {  // setup
+      custom::cuckoo_unordered_set<int> us;
+      // exercise
+      auto first = us.insert(7);
+      auto second = us.insert(7);
+      // verify
+      assertUnit(first.second);
+      assertUnit(!second.second);
+      assertUnit(first.first == second.first);
+      assertUnit(*second.first == 7);
+      assertUnit(us.size() == 1);
+   }  // teardown
+
+   // displacing elements fills the table to 95% without growing,
+   // and every element is still in one of its two buckets
+   void test_insert_highLoad()
+   {  // setup
+      custom::cuckoo_unordered_set<uint64_t> us(1000);
+      // exercise
+      for (uint64_t i = 0; i < 3800; i++)
+         us.insert(i * 0x9E3779B97F4A7C15ULL);
+      // verify
+      assertUnit(us.bucket_count() == 1000);
+      assertUnit(us.size() == 3800);
+      assertUnit(us.load_factor() == (float)0.95);
+      bool inOwnBucket = true;
+      for (size_t b = 0; b < us.numBuckets; b++)
+         for (size_t i = 0; i < us.SLOTS; i++)
+            if (us.buckets[b].tags[i] != 0)
+            {
+               uint64_t hash = us.hashOf(*us.buckets[b].slot(i));
+               if (b != us.bucket1(hash) && b != us.bucket2(hash, us.bucket1(hash)))
+                  inOwnBucket = false;
+            }
+      assertUnit(inOwnBucket);
+      bool found = true;
+      for (uint64_t i = 0; i < 3800; i++)
+         if (us.find(i * 0x9E3779B97F4A7C15ULL) == us.end())
+            found = false;
+      assertUnit(found);
+   }  // teardown
+
+   // past 95% the table doubles
+   void test_insert_grow()
+   {  // setup
+      custom::cuckoo_unordered_set<int> us;
+      // exercise
+      for (int i = 0; i < 10000; i++)
+         us.insert(i);
+      // verify
+      assertUnit(us.size() == 10000);
+      assertUnit(us.load_factor() <= us.max_load_factor());
+      bool found = true;
+      for (int i = 0; i < 10000; i++)
+         if (us.find(i) == us.end())
+            found = false;
+      assertUnit(found);
+      assertUnit(us.find(10000) == us.end());
+   }  // teardown
+
+   // eight elements fill their two buckets, the ninth cannot
+   // go anywhere however large the table
+   void test_insert_sameHash()
+   {  // setup
+      custom::cuckoo_unordered_set<int, SameHash> us;
+      bool thrown = false;
+      int num = 0;
+      // exercise
+      try
+      {
+         for (num = 0; num < 100; num++)
+            us.insert(num);
+      }
+      catch (const std::runtime_error&)
+      {
+         thrown = true;
+      }
+      // verify
+      assertUnit(thrown);
+      assertUnit(num == 2 * (int)us.SLOTS);
+      assertUnit(us.size() == 2 * us.SLOTS);
+      assertUnit(us.find(3) != us.end());
+      assertUnit(us.find(8) == us.end());
+   }  // teardown
+
+   // room enough that no insert grows the table
+   void test_reserve_noRehash()
+   {  // setup
+      custom::cuckoo_unordered_set<int> us;
+      // exercise
+      us.reserve(1000);
+      size_t numBuckets = us.bucket_count();
+      for (int i = 0; i < 1000; i++)
+         us.insert(i);
+      // verify
+      assertUnit(numBuckets == 264);
+      assertUnit(us.bucket_count() == numBuckets);
+   }  // teardown
+
+   /***************************************
+    * REMOVE
+    ***************************************/
+
+   // the slot is empty again and the next element is returned
+   void test_erase_standard()
+   {  // setup
+      custom::cuckoo_unordered_set<Spy> us;
+      setupStandardFixture(us);
+      Spy s(49);
+      Spy::reset();
+      // exercise
+      custom::cuckoo_unordered_set<Spy>::iterator it = us.erase(s);
+      // verify
+      assertUnit(Spy::numDestructor() == 1);
+      assertUnit(Spy::numDelete() == 1);
+      assertUnit(us.size() == 3);
+      assertUnit(us.find(Spy(49)) == us.end());
+      assertUnit(us.find(Spy(31)) != us.end());
+      assertUnit(us.find(Spy(59)) != us.end());
+      assertUnit(us.find(Spy(67)) != us.end());
+      if (it != us.end())
+         assertUnit(!(*it == Spy(49)));
+   }  // teardown
+
+   // erase something that is not there
+   void test_erase_standardMissing()
+   {  // setup
+      custom::cuckoo_unordered_set<Spy> us;
+      setupStandardFixture(us);
+      Spy s(50);
+      Spy::reset();
+      // exercise
+      custom::cuckoo_unordered_set<Spy>::iterator it = us.erase(s);
+      // verify
+      assertUnit(Spy::numDestructor() == 0);
+      assertUnit(it == us.end());
+      assertUnit(us.size() == 4);
+   }  // teardown
+
+   // erasing and inserting at 95% leaves no trace and never grows
+   void test_erase_churn()
+   {  // setup
+      custom::cuckoo_unordered_set<int> us(100);
+      for (int i = 0; i < 380; i++)
+         us.insert(i);
+      // exercise
+      for (int i = 380; i < 10000; i++)
+      {
+         us.erase(i - 380);
+         us.insert(i);
+      }
+      // verify
+      assertUnit(us.bucket_count() == 100);
+      assertUnit(us.size() == 380);
+      bool found = true;
+      for (int i = 10000 - 380; i < 10000; i++)
+         if (us.find(i) == us.end())
+            found = false;
+      assertUnit(found);
+      assertUnit(us.find(10000 - 381) == us.end());
+   }  // teardown
+
+   // clear destroys every element but keeps the buckets
+   void test_clear_standard()
+   {  // setup
+      custom::cuckoo_unordered_set<Spy> us;
+      setupStandardFixture(us);
+      size_t numBuckets = us.bucket_count();
+      Spy::reset();
+      // exercise
+      us.clear();
+      // verify
+      assertUnit(Spy::numDestructor() == 4);
+      assertUnit(Spy::numDelete() == 4);
+      assertUnit(us.empty());
+      assertUnit(us.bucket_count() == numBuckets);
+      assertUnit(us.begin() == us.end());
+   }  // teardown
+
+   /***************************************
+    * ITERATOR
+    ***************************************/
+
+   // the iterator visits every element once
+   void test_iterator_visitsAll()
+   {  // setup
+      custom::cuckoo_unordered_set<int> us;
+      for (int i = 0; i < 500; i++)
+         us.insert(i);
+      std::set<int> seen;
+      size_t num = 0;
+      // exercise
+      for (auto it = us.begin(); it != us.end(); ++it)
+      {
+         seen.insert(*it);
+         num++;
+      }
+      // verify
+      assertUnit(num == 500);
+      assertUnit(seen.size() == 500);
+      assertUnit(*seen.begin() == 0);
+      assertUnit(*seen.rbegin() == 499);
+   }  // teardown
+
+   /*************************************************************
+    * SETUP STANDARD FIXTURE
+    *   { 31, 49, 59, 67 }
+    *************************************************************/
+   void setupStandardFixture(custom::cuckoo_unordered_set<Spy>& us)
+   {
+      us.insert(Spy(31));
+      us.insert(Spy(49));
+      us.insert(Spy(59));
+      us.insert(Spy(67));
+      assert(us.size() == 4);
+   }
+};
+
+#endif // DEBUG
@@ -0,0 +1,330 @@
+/***********************************************************************
+ * Header:
+ *    TEST EPOCH HASH
+ * Summary:
+ *    Unit tests for epoch_unordered_set and its epoch_domain
+ * Author
+ *    Marco Varela &  Andre Regino
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "epochHash.h"       // class under test
+#include "hashFunction.h"    // for a seeded custom::hash
+#include "unitTest.h"        // unit test baseclass
+
+#include <atomic>            // for std::atomic flags shared by the threads
+#include <string>            // for std::string, so a freed node is caught
+#include <thread>            // for std::thread
+#include <vector>            // for std::vector of threads
+
+/***********************************************
+ * TEST EPOCH HASH
+ * Unit tests for the epoch_unordered_set class
+ ***********************************************/
+class TestEpochHash : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Construct
+      test_construct_default();
+      test_construct_seeded();
+
+      // Insert, find and erase
+      test_insert_contains();
+      test_insert_grow();
+      test_reserve_standard();
+      test_erase_standard();
+      test_clear_standard();
+      test_forEach_all();
+
+      // Reclaim
+      test_reclaim_noReaders();
+      test_reclaim_readerHolds();
+      test_reclaim_nested();
+      test_threadIndex_distinct();
+
+      // Threads
+      test_threads_readWhileWrite();
+      test_threads_readWhileGrow();
+
+      report("EpochHash");
+   }
+
+   /***************************************
+    * CONSTRUCT
+    ***************************************/
+
+   // an empty table of eight buckets
+   void test_construct_default()
+   {  // exercise
+      custom::epoch_unordered_set<int> s;
+      // verify
+      assertUnit(s.empty());
+      assertUnit(s.size() == 0);
+      assertUnit(s.bucket_count() == 8);
+      assertUnit(s.max_load_factor() == (float)1.0);
+      assertUnit(!s.contains(0));
+      assertUnit(s.num_retired() == 0);
+   }  // teardown
+
+   // the bucket count rounds up to a power of two
+   void test_construct_seeded()
+   {  // exercise
+      custom::epoch_unordered_set<int, custom::hash<int>> s(100, custom::hash<int>(3));
+      // verify
+      assertUnit(s.bucket_count() == 128);
+      assertUnit(s.hash_function().seed() == 3);
+   }  // teardown
+
+   /***************************************
+    * INSERT, FIND AND ERASE
+    ***************************************/
+
+   // every key found once, and no other
+   void test_insert_contains()
+   {  // setup
+      custom::epoch_unordered_set<int> s;
+      // exercise
+      bool inserted = s.insert(7);
+      bool duplicate = s.insert(7);
+      // verify
+      assertUnit(inserted);
+      assertUnit(!duplicate);
+      assertUnit(s.size() == 1);
+      assertUnit(s.contains(7));
+      assertUnit(s.count(7) == 1);
+      assertUnit(s.count(8) == 0);
+   }  // teardown
+
+   // past the load factor a new table is published and the old retired
+   void test_insert_grow()
+   {  // setup
+      custom::epoch_unordered_set<int> s;
+      // exercise
+      for (int i = 0; i < 1000; i++)
+         s.insert(i);
+      // verify
+      assertUnit(s.size() == 1000);
+      assertUnit(s.bucket_count() == 1024);
+      bool found = true;
+      for (int i = 0; i < 1000; i++)
+         if (!s.contains(i))
+            found = false;
+      assertUnit(found);
+      assertUnit(!s.contains(1000));
+      assertUnit(s.num_retired() == 0);
+   }  // teardown
+
+   // room enough that no insert grows the table
+   void test_reserve_standard()
+   {  // setup
+      custom::epoch_unordered_set<int> s;
+      // exercise
+      s.reserve(500);
+      size_t numBuckets = s.bucket_count();
+      for (int i = 0; i < 500; i++)
+         s.insert(i);
+      // verify
+      assertUnit(numBuckets == 512);
+      assertUnit(s.bucket_count() == 512);
+   }  // teardown
+
+   // erase says how many went
+   void test_erase_standard()
+   {  // setup
+      custom::epoch_unordered_set<int> s;
+      for (int i = 0; i < 100; i++)
+         s.insert(i);
+      // exercise
+      size_t numErased = s.erase(42);
+      size_t numMissing = s.erase(142);
+      // verify
+      assertUnit(numErased == 1);
+      assertUnit(numMissing == 0);
+      assertUnit(!s.contains(42));
+      assertUnit(s.contains(41));
+      assertUnit(s.contains(43));
+      assertUnit(s.size() == 99);
+   }  // teardown
+
+   // an empty table in place of the full one
+   void test_clear_standard()
+   {  // setup
+      custom::epoch_unordered_set<int> s;
+      for (int i = 0; i < 100; i++)
+         s.insert(i);
+      // exercise
+      s.clear();
+      // verify
+      assertUnit(s.empty());
+      assertUnit(s.bucket_count() == 8);
+      assertUnit(!s.contains(7));
+   }  // teardown
+
+   // every element once
+   void test_forEach_all()
+   {  // setup
+      custom::epoch_unordered_set<int> s;
+      for (int i = 1; i <= 100; i++)
+         s.insert(i);
+      int sum = 0;
+      int num = 0;
+      // exercise
+      s.for_each([&](const int& value) { sum += value; num++; });
+      // verify
+      assertUnit(num == 100);
+      assertUnit(sum == 5050);
+   }  // teardown
+
+   /***************************************
+    * RECLAIM
+    ***************************************/
+
+   // with no reader in, an erased node is freed at once
+   void test_reclaim_noReaders()
+   {  // setup
+      custom::epoch_unordered_set<std::string> s;
+      s.insert("alpha");
+      s.insert("beta");
+      // exercise
+      s.erase("alpha");
+      // verify
+      assertUnit(s.num_retired() == 0);
+      assertUnit(s.contains("beta"));
+   }  // teardown
+
+   // a reader still in keeps the node, leaving lets it go
+   void test_reclaim_readerHolds()
+   {  // setup
+      custom::epoch_unordered_set<std::string> s;
+      s.insert("alpha");
+      s.insert("beta");
+      s.domain.enter();
+      // exercise
+      s.erase("alpha");
+      size_t numHeld = s.num_retired();
+      s.domain.leave();
+      s.erase("beta");
+      // verify
+      assertUnit(numHeld == 1);
+      assertUnit(s.num_retired() == 0);
+      assertUnit(s.empty());
+   }  // teardown
+
+   // a find within for_each does not end the outer read
+   void test_reclaim_nested()
+   {  // setup
+      custom::epoch_unordered_set<int> s;
+      s.insert(1);
+      s.insert(2);
+      uint64_t epochInside = 0;
+      size_t i = custom::epoch_thread_index();
+      // exercise
+      s.for_each([&](const int& value)
+      {
+         s.contains(value);
+         epochInside = s.domain.slots[i].epoch.load();
+      });
+      // verify
+      assertUnit(epochInside != 0);
+      assertUnit(s.domain.slots[i].epoch.load() == 0);
+      assertUnit(s.domain.slots[i].depth == 0);
+   }  // teardown
+
+   // threads alive at once have slots of their own
+   void test_threadIndex_distinct()
+   {  // setup
+      size_t indexMain = custom::epoch_thread_index();
+      size_t indexOther = custom::EPOCH_MAX_THREADS;
+      // exercise
+      std::thread thread([&indexOther]() { indexOther = custom::epoch_thread_index(); });
+      thread.join();
+      // verify
+      assertUnit(indexMain < custom::EPOCH_MAX_THREADS);
+      assertUnit(indexOther < custom::EPOCH_MAX_THREADS);
+      assertUnit(indexMain != indexOther);
+      assertUnit(custom::epoch_thread_index() == indexMain);
+   }  // teardown
+
+   /***************************************
+    * THREADS
+    ***************************************/
+
+   // readers never miss a key no one erases while a writer
+   // inserts and erases others around it
+   void test_threads_readWhileWrite()
+   {  // setup
+      custom::epoch_unordered_set<std::string> s;
+      for (int i = 0; i < 100; i++)
+         s.insert(std::to_string(i));
+      std::atomic<bool> done(false);
+      std::atomic<int> numMissed(0);
+      std::vector<std::thread> readers;
+      // exercise
+      for (int t = 0; t < 3; t++)
+         readers.emplace_back([&s, &done, &numMissed]()
+         {
+            while (!done.load())
+               for (int i = 0; i < 100; i++)
+                  if (!s.contains(std::to_string(i)))
+                     numMissed++;
+         });
+      for (int round = 0; round < 20; round++)
+      {
+         for (int i = 1000; i < 1050; i++)
+            s.insert(std::to_string(i));
+         for (int i = 1000; i < 1050; i++)
+            s.erase(std::to_string(i));
+      }
+      done = true;
+      for (auto& reader : readers)
+         reader.join();
+      // verify
+      assertUnit(numMissed == 0);
+      assertUnit(s.size() == 100);
+      assertUnit(!s.contains("1000"));
+   }  // teardown
+
+   // readers keep finding a key while the table grows and
+   // empties under them, one new table after another
+   void test_threads_readWhileGrow()
+   {  // setup
+      custom::epoch_unordered_set<int> s;
+      s.insert(-1);
+      std::atomic<bool> done(false);
+      std::atomic<int> numMissed(0);
+      std::vector<std::thread> readers;
+      // exercise
+      for (int t = 0; t < 3; t++)
+         readers.emplace_back([&s, &done, &numMissed]()
+         {
+            while (!done.load())
+            {
+               if (!s.contains(-1))
+                  numMissed++;
+               s.for_each([](const int&) {});
+            }
+         });
+      for (int round = 0; round < 5; round++)
+      {
+         for (int i = 0; i < 2000; i++)
+            s.insert(i);
+         for (int i = 0; i < 2000; i++)
+            s.erase(i);
+      }
+      done = true;
+      for (auto& reader : readers)
+         reader.join();
+      // verify
+      assertUnit(numMissed == 0);
+      assertUnit(s.size() == 1);
+   }  // teardown
+};
+
+#endif // DEBUG
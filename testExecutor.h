@@ -0,0 +1,137 @@
+/***********************************************************************
+ * Header:
+ *    TEST EXECUTOR
+ * Summary:
+ *    Unit tests for the inline and thread executors
+ * Author
+ *    Marco Varela &  Andre Regino
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "executor.h"   // class under test
+#include "unitTest.h"   // unit test baseclass
+
+#include <atomic>       // for std::atomic counters
+#include <stdexcept>    // for std::runtime_error
+#include <vector>       // for std::vector of results
+
+/***********************************************
+ * TEST EXECUTOR
+ * Unit tests for the executor classes
+ ***********************************************/
+class TestExecutor : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Inline
+      test_inline_concurrency();
+      test_inline_order();
+
+      // Thread
+      test_thread_concurrency();
+      test_thread_everyTask();
+      test_thread_zeroTasks();
+      test_thread_exception();
+
+      report("Executor");
+   }
+
+   /***************************************
+    * INLINE
+    ***************************************/
+
+   // the work is split as asked, never into zero tasks
+   void test_inline_concurrency()
+   {  // verify
+      assertUnit(custom::inline_executor().concurrency() == 1);
+      assertUnit(custom::inline_executor(4).concurrency() == 4);
+      assertUnit(custom::inline_executor(0).concurrency() == 1);
+   }
+
+   // the tasks run in order on this thread
+   void test_inline_order()
+   {  // setup
+      custom::inline_executor executor(3);
+      std::vector<size_t> order;
+      // exercise
+      executor.run(5, [&order](size_t i) { order.push_back(i); });
+      // verify
+      assertUnit(order.size() == 5);
+      bool inOrder = true;
+      for (size_t i = 0; i < order.size(); i++)
+         if (order[i] != i)
+            inOrder = false;
+      assertUnit(inOrder);
+   }
+
+   /***************************************
+    * THREAD
+    ***************************************/
+
+   // one task for each thread, and at least one
+   void test_thread_concurrency()
+   {  // verify
+      assertUnit(custom::thread_executor(3).concurrency() == 3);
+      assertUnit(custom::thread_executor(0).concurrency() == 1);
+      assertUnit(custom::thread_executor().concurrency() >= 1);
+   }
+
+   // every task runs exactly once
+   void test_thread_everyTask()
+   {  // setup
+      custom::thread_executor executor(4);
+      std::vector<int> count(8, 0);
+      // exercise
+      executor.run(count.size(), [&count](size_t i) { count[i]++; });
+      // verify
+      bool once = true;
+      for (int c : count)
+         if (c != 1)
+            once = false;
+      assertUnit(once);
+   }
+
+   // no tasks, no calls
+   void test_thread_zeroTasks()
+   {  // setup
+      custom::thread_executor executor(4);
+      int numCalls = 0;
+      // exercise
+      executor.run(0, [&numCalls](size_t) { numCalls++; });
+      // verify
+      assertUnit(numCalls == 0);
+   }
+
+   // a task that throws does not stop the others, and the error comes back
+   void test_thread_exception()
+   {  // setup
+      custom::thread_executor executor(4);
+      std::atomic<int> numRun(0);
+      bool thrown = false;
+      // exercise
+      try
+      {
+         executor.run(4, [&numRun](size_t i)
+         {
+            numRun++;
+            if (i == 2)
+               throw std::runtime_error("task 2");
+         });
+      }
+      catch (const std::runtime_error&)
+      {
+         thrown = true;
+      }
+      // verify
+      assertUnit(thrown);
+      assertUnit(numRun == 4);
+   }
+};
+
+#endif // DEBUG
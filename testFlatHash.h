@@ -0,0 +1,441 @@
+/***********************************************************************
+ * Header:
+ *    TEST FLAT HASH
+ * Summary:
+ *    Unit tests for the open-addressing flat_unordered_set
+ * Author
+ *    Marco Varela &  Andre Regino
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "flatHash.h"   // class under test
+#include "unitTest.h"   // unit test baseclass
+#include "spy.h"        // spy is a mock class to monitor the class under test
+
+#include <new>          // for std::bad_alloc from FailAllocator
+#include <set>          // for std::set to check the iterator
+
+/***********************************************
+ * FAIL ALLOCATOR
+ * A std::allocator that throws once numLeft
+ * allocations, of any type, have been handed out
+ ***********************************************/
+template <class T>
+class FailAllocator : public std::allocator<T>
+{
+public:
+   static int & numLeft() { static int num = -1; return num; }   // -1 never fails
+   template <class U>
+   struct rebind { typedef FailAllocator<U> other; };
+   FailAllocator() {}
+   template <class U>
+   FailAllocator(const FailAllocator<U>&) {}
+   T * allocate(size_t num)
+   {
+      int& left = FailAllocator<char>::numLeft();
+      if (left == 0)
+         throw std::bad_alloc();
+      if (left > 0)
+         left--;
+      return std::allocator<T>::allocate(num);
+   }
+};
+
+/***********************************************
+ * TEST FLAT HASH
+ * Unit tests for the flat_unordered_set class
+ ***********************************************/
+class TestFlatHash : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Construct
+      test_construct_default();
+      test_construct_nonDefault20();
+      test_construct_copyStandard();
+
+      // Access
+      test_group_match();
+      test_find_empty();
+      test_find_standard();
+      test_find_standardMissing();
+
+      // Insert
+      test_insert_empty();
+      test_insert_standardDuplicate();
+      test_insert_grow();
+      test_reserve_noRehash();
+      test_reserve_slotsThrow();
+
+      // Remove
+      test_erase_standard();
+      test_erase_standardMissing();
+      test_erase_churn();
+      test_clear_standard();
+
+      // Iterator
+      test_iterator_visitsAll();
+
+      report("FlatHash");
+   }
+
+   /***************************************
+    * CONSTRUCT
+    ***************************************/
+
+   // the default constructor does not allocate a table
+   void test_construct_default()
+   {  // setup
+      Spy::reset();
+      // exercise
+      custom::flat_unordered_set<Spy> us;
+      // verify
+      assertUnit(Spy::numDefault() == 0);
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(us.ctrl == nullptr);
+      assertUnit(us.slots == nullptr);
+      assertUnit(us.numCapacity == 0);
+      assertUnit(us.numElements == 0);
+      assertUnit(us.begin() == us.end());
+   }  // teardown
+
+   // room for 20 rounds up to a power of two
+   void test_construct_nonDefault20()
+   {  // setup
+      Spy::reset();
+      // exercise
+      custom::flat_unordered_set<Spy> us(20);
+      // verify
+      assertUnit(Spy::numDefault() == 0);
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(us.numCapacity == 32);
+      assertUnit(us.numElements == 0);
+      assertUnit(us.numGrowth == 28);
+      for (size_t i = 0; i < 32 + custom::control_group::WIDTH; i++)
+         assertUnit(us.ctrl[i] == custom::control_group::EMPTY);
+   }  // teardown
+
+   // copy the table slot for slot
+   void test_construct_copyStandard()
+   {  // setup
+      custom::flat_unordered_set<Spy> usSrc;
+      setupStandardFixture(usSrc);
+      Spy::reset();
+      // exercise
+      custom::flat_unordered_set<Spy> usDes(usSrc);
+      // verify
+      assertUnit(Spy::numCopy() == 4);
+      assertUnit(Spy::numAlloc() == 4);
+      assertUnit(Spy::numCopyMove() == 0);
+      assertUnit(Spy::numEquals() == 0);
+      assertUnit(usDes.numCapacity == usSrc.numCapacity);
+      assertUnit(usDes.size() == 4);
+      assertUnit(usDes.find(Spy(67)) != usDes.end());
+      assertUnit(usDes.find(Spy(31)) != usDes.end());
+   }  // teardown
+
+   /***************************************
+    * ACCESS
+    ***************************************/
+
+   // the group finds every tag in one compare
+   void test_group_match()
+   {  // setup
+      int8_t tags[custom::control_group::WIDTH];
+      for (size_t i = 0; i < custom::control_group::WIDTH; i++)
+         tags[i] = custom::control_group::EMPTY;
+      tags[0] = 5;
+      tags[3] = custom::control_group::DELETED;
+      tags[9] = 5;
+      tags[15] = 7;
+      // exercise
+      custom::control_group group(tags);
+      // verify
+      assertUnit(group.match(5) == ((1u << 0) | (1u << 9)));
+      assertUnit(group.match(7) == (1u << 15));
+      assertUnit(group.match(6) == 0);
+      assertUnit(group.matchEmpty() == (0xFFFFu & ~((1u << 0) | (1u << 3) | (1u << 9) | (1u << 15))));
+      assertUnit(group.matchEmptyOrDeleted() == (0xFFFFu & ~((1u << 0) | (1u << 9) | (1u << 15))));
+      assertUnit(custom::control_group::lowestBit(1u << 9) == 9);
+      assertUnit(custom::control_group::leadingZeros(1u << 9) == 6);
+      assertUnit(custom::control_group::leadingZeros(0) == 16);
+   }  // teardown
+
+   // find in a set that has no table
+   void test_find_empty()
+   {  // setup
+      custom::flat_unordered_set<Spy> us;
+      Spy s(99);
+      Spy::reset();
+      // exercise
+      custom::flat_unordered_set<Spy>::iterator it = us.find(s);
+      // verify
+      assertUnit(Spy::numEquals() == 0);
+      assertUnit(it == us.end());
+   }  // teardown
+
+   // find an element: only the matching tag is compared
+   void test_find_standard()
+   {  // setup
+      custom::flat_unordered_set<Spy> us;
+      setupStandardFixture(us);
+      Spy s(49);
+      Spy::reset();
+      // exercise
+      custom::flat_unordered_set<Spy>::iterator it = us.find(s);
+      // verify
+      assertUnit(Spy::numEquals() == 1);
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(it != us.end());
+      if (it != us.end())
+         assertUnit(*it == Spy(49));
+   }  // teardown
+
+   // find something that is not there
+   void test_find_standardMissing()
+   {  // setup
+      custom::flat_unordered_set<Spy> us;
+      setupStandardFixture(us);
+      Spy s(10);
+      Spy::reset();
+      // exercise
+      custom::flat_unordered_set<Spy>::iterator it = us.find(s);
+      // verify
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(it == us.end());
+   }  // teardown
+
+   /***************************************
+    * INSERT
+    ***************************************/
+
+   // insert into an empty set creates the first group
+   void test_insert_empty()
+   {  // setup
+      custom::flat_unordered_set<Spy> us;
+      Spy s(58);
+      Spy::reset();
+      // exercise
+      custom::pair<custom::flat_unordered_set<Spy>::iterator, bool> p = us.insert(s);
+      // verify
+      assertUnit(Spy::numCopy() == 1);
+      assertUnit(Spy::numAlloc() == 1);
+      assertUnit(Spy::numEquals() == 0);
+      assertUnit(p.second == true);
+      assertUnit(p.first != us.end());
+      if (p.first != us.end())
+         assertUnit(*(p.first) == Spy(58));
+      assertUnit(us.numCapacity == 16);
+      assertUnit(us.numElements == 1);
+      assertUnit(us.numGrowth == 13);
+   }  // teardown
+
+   // insert a duplicate copies nothing
+   void test_insert_standardDuplicate()
+   {  // setup
+      custom::flat_unordered_set<Spy> us;
+      setupStandardFixture(us);
+      Spy s(31);
+      Spy::reset();
+      // exercise
+      custom::pair<custom::flat_unordered_set<Spy>::iterator, bool> p = us.insert(s);
+      // verify
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(Spy::numEquals() == 1);
+      assertUnit(p.second == false);
+      assertUnit(p.first != us.end());
+      if (p.first != us.end())
+         assertUnit(*(p.first) == Spy(31));
+      assertUnit(us.size() == 4);
+   }  // teardown
+
+   // fill past 7/8 of the table so it doubles
+   void test_insert_grow()
+   {  // setup
+      custom::flat_unordered_set<int> us;
+      // exercise
+      for (int i = 0; i < 15; i++)
+         us.insert(i * 1000);
+      // verify
+      assertUnit(us.numCapacity == 32);
+      assertUnit(us.size() == 15);
+      for (int i = 0; i < 15; i++)
+         assertUnit(us.find(i * 1000) != us.end());
+      assertUnit(us.find(7) == us.end());
+   }  // teardown
+
+   // reserve so many inserts never rehash
+   void test_reserve_noRehash()
+   {  // setup
+      custom::flat_unordered_set<int> us;
+      // exercise
+      us.reserve(1000);
+      int8_t * ctrlReserved = us.ctrl;
+      for (int i = 0; i < 1000; i++)
+         us.insert(i);
+      // verify
+      assertUnit(us.ctrl == ctrlReserved);
+      assertUnit(us.numCapacity == 2048);
+      assertUnit(us.size() == 1000);
+      assertUnit(us.load_factor() > (float)0.48 && us.load_factor() < (float)0.49);
+   }  // teardown
+
+   // when the slots cannot be allocated the set keeps its old table
+   void test_reserve_slotsThrow()
+   {  // setup
+      custom::flat_unordered_set<int, std::hash<int>, std::equal_to<int>, FailAllocator<int>> us;
+      for (int i = 0; i < 10; i++)
+         us.insert(i);
+      int8_t * ctrlOld = us.ctrl;
+      size_t capacityOld = us.numCapacity;
+      FailAllocator<char>::numLeft() = 1;   // the control bytes, not the slots
+      bool thrown = false;
+      // exercise
+      try
+      {
+         us.reserve(1000);
+      }
+      catch (const std::bad_alloc&)
+      {
+         thrown = true;
+      }
+      FailAllocator<char>::numLeft() = -1;
+      // verify
+      assertUnit(thrown);
+      assertUnit(us.ctrl == ctrlOld);
+      assertUnit(us.numCapacity == capacityOld);
+      assertUnit(us.size() == 10);
+      bool found = true;
+      for (int i = 0; i < 10; i++)
+         if (us.find(i) == us.end())
+            found = false;
+      assertUnit(found);
+      us.insert(10);
+      assertUnit(us.find(10) != us.end());
+   }  // teardown
+
+   /***************************************
+    * REMOVE
+    ***************************************/
+
+   // erase an element from the standard fixture
+   void test_erase_standard()
+   {  // setup
+      custom::flat_unordered_set<Spy> us;
+      setupStandardFixture(us);
+      Spy s(49);
+      Spy::reset();
+      // exercise
+      us.erase(s);
+      // verify
+      assertUnit(Spy::numDestructor() == 1);
+      assertUnit(Spy::numDelete() == 1);
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(us.size() == 3);
+      assertUnit(us.find(Spy(49)) == us.end());
+      assertUnit(us.find(Spy(67)) != us.end());
+   }  // teardown
+
+   // erase something that is not there
+   void test_erase_standardMissing()
+   {  // setup
+      custom::flat_unordered_set<Spy> us;
+      setupStandardFixture(us);
+      Spy s(10);
+      Spy::reset();
+      // exercise
+      custom::flat_unordered_set<Spy>::iterator it = us.erase(s);
+      // verify
+      assertUnit(Spy::numDestructor() == 0);
+      assertUnit(it == us.end());
+      assertUnit(us.size() == 4);
+   }  // teardown
+
+   // repeated insert and erase never leaves the table without an empty slot
+   void test_erase_churn()
+   {  // setup
+      custom::flat_unordered_set<int> us;
+      for (int i = 0; i < 10; i++)
+         us.insert(i);
+      // exercise
+      for (int i = 10; i < 10000; i++)
+      {
+         us.insert(i);
+         us.erase(i - 10);
+      }
+      // verify
+      assertUnit(us.size() == 10);
+      assertUnit(us.numCapacity <= 32);
+      for (int i = 9990; i < 10000; i++)
+         assertUnit(us.find(i) != us.end());
+      assertUnit(us.find(9989) == us.end());
+   }  // teardown
+
+   // clear destroys the elements but keeps the table
+   void test_clear_standard()
+   {  // setup
+      custom::flat_unordered_set<Spy> us;
+      setupStandardFixture(us);
+      size_t capacity = us.numCapacity;
+      Spy::reset();
+      // exercise
+      us.clear();
+      // verify
+      assertUnit(Spy::numDestructor() == 4);
+      assertUnit(Spy::numDelete() == 4);
+      assertUnit(us.size() == 0);
+      assertUnit(us.numCapacity == capacity);
+      assertUnit(us.begin() == us.end());
+   }  // teardown
+
+   /***************************************
+    * ITERATOR
+    ***************************************/
+
+   // the iterator visits every element exactly once
+   void test_iterator_visitsAll()
+   {  // setup
+      custom::flat_unordered_set<int> us;
+      for (int i = 0; i < 100; i++)
+         us.insert(i * 7);
+      for (int i = 0; i < 100; i += 2)
+         us.erase(i * 7);
+      std::set<int> seen;
+      size_t count = 0;
+      // exercise
+      for (auto it = us.begin(); it != us.end(); ++it)
+      {
+         seen.insert(*it);
+         count++;
+      }
+      // verify
+      assertUnit(count == 50);
+      assertUnit(seen.size() == 50);
+      assertUnit(seen.count(7) == 1);
+      assertUnit(seen.count(14) == 0);
+   }  // teardown
+
+   /*************************************************************
+    * SETUP STANDARD FIXTURE
+    *      { 31, 49, 59, 67 }
+    *************************************************************/
+   void setupStandardFixture(custom::flat_unordered_set<Spy>& us)
+   {
+      us.insert(Spy(31));
+      us.insert(Spy(49));
+      us.insert(Spy(59));
+      us.insert(Spy(67));
+      assert(us.size() == 4);
+   }
+};
+
+#endif // DEBUG
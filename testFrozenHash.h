@@ -0,0 +1,357 @@
+/***********************************************************************
+ * Header:
+ *    TEST FROZEN HASH
+ * Summary:
+ *    Unit tests for frozen_set and unordered_set::freeze
+ * Author
+ *    Marco Varela &  Andre Regino
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "frozenHash.h"    // class under test
+#include "hash.h"          // the set that freezes
+#include "hashFunction.h"  // for a seeded custom::hash
+#include "executor.h"      // for the parallel build
+#include "unitTest.h"      // unit test baseclass
+
+#include <cstdint>         // for uint64_t
+#include <cstdio>          // for std::remove
+#include <fstream>         // for std::ofstream of a bad file
+#include <stdexcept>       // for std::runtime_error
+#include <string>          // for std::string keys
+#include <vector>          // for std::vector of keys
+
+/***********************************************
+ * TEST FROZEN HASH
+ * Unit tests for the minimal perfect hash set
+ ***********************************************/
+class TestFrozenHash : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Build
+      test_build_empty();
+      test_build_standard();
+      test_build_minimal();
+      test_build_partitions();
+      test_build_parallelSame();
+      test_build_strings();
+      test_build_sameHash();
+
+      // Freeze
+      test_freeze_standard();
+      test_freeze_migrating();
+      test_freeze_seeded();
+
+      // Save and load
+      test_load_standard();
+      test_load_move();
+      test_refuse_garbage();
+      test_refuse_keyType();
+      test_refuse_seed();
+
+      report("FrozenHash");
+   }
+
+   /***************************************
+    * BUILD
+    ***************************************/
+
+   // no keys, nothing found
+   void test_build_empty()
+   {  // exercise
+      custom::frozen_set<int> fs;
+      // verify
+      assertUnit(fs.empty());
+      assertUnit(fs.size() == 0);
+      assertUnit(fs.begin() == fs.end());
+      assertUnit(fs.find(3) == fs.end());
+      assertUnit(fs.numPartitions == 1);
+   }  // teardown
+
+   // every key is found, and no other
+   void test_build_standard()
+   {  // exercise
+      custom::frozen_set<int> fs(std::vector<int>{ 31, 49, 67, 59 });
+      // verify
+      assertUnit(fs.size() == 4);
+      assertUnit(fs.find(31) != fs.end());
+      assertUnit(fs.find(49) != fs.end());
+      assertUnit(fs.find(67) != fs.end());
+      assertUnit(fs.find(59) != fs.end());
+      if (fs.find(67) != fs.end())
+         assertUnit(*fs.find(67) == 67);
+      assertUnit(fs.find(58) == fs.end());
+      assertUnit(fs.count(49) == 1);
+      assertUnit(!fs.contains(50));
+   }  // teardown
+
+   // n keys in n slots, one pilot for every three keys
+   void test_build_minimal()
+   {  // setup
+      std::vector<uint64_t> keys;
+      for (uint64_t i = 1; i <= 1000; i++)
+         keys.push_back(i * 7);
+      // exercise
+      custom::frozen_set<uint64_t> fs(keys);
+      // verify
+      assertUnit(fs.end() - fs.begin() == 1000);
+      bool inOwnSlot = true;
+      for (auto key : keys)
+         if (fs.find(key) == fs.end() || *fs.find(key) != key)
+            inOwnSlot = false;
+      assertUnit(inOwnSlot);
+      uint64_t sum = 0;
+      for (auto it = fs.begin(); it != fs.end(); ++it)
+         sum += *it;
+      assertUnit(sum == 7 * 1000 * 1001 / 2);
+      assertUnit(fs.parts[1].firstBucket == 334);
+      assertUnit(fs.num_bytes() == 2 * sizeof(custom::frozen_partition) + 334 * 4 + 1000 * 8);
+   }  // teardown
+
+   // many keys are split over partitions, built one by one
+   void test_build_partitions()
+   {  // setup
+      std::vector<int> keys;
+      for (int i = 0; i < 100000; i++)
+         keys.push_back(i * 3);
+      // exercise
+      custom::frozen_set<int> fs(keys);
+      // verify
+      assertUnit(fs.numPartitions == 100000 / 32768 + 1);
+      bool found = true;
+      bool missed = true;
+      for (int i = 0; i < 100000; i++)
+      {
+         if (fs.find(i * 3) == fs.end())
+            found = false;
+         if (fs.find(i * 3 + 1) != fs.end())
+            missed = false;
+      }
+      assertUnit(found);
+      assertUnit(missed);
+   }  // teardown
+
+   // the partitions spread over threads give the same layout
+   void test_build_parallelSame()
+   {  // setup
+      std::vector<int> keys;
+      for (int i = 0; i < 100000; i++)
+         keys.push_back(i);
+      // exercise
+      custom::frozen_set<int> fsInline(keys);
+      custom::frozen_set<int> fsThreads(keys, std::hash<int>(), custom::thread_executor(4));
+      // verify
+      assertUnit(fsInline.ownKeys == fsThreads.ownKeys);
+      assertUnit(fsInline.ownPilots == fsThreads.ownPilots);
+   }  // teardown
+
+   // keys that own memory are moved into their slots
+   void test_build_strings()
+   {  // setup
+      std::vector<std::string> keys = { "alpha", "beta", "gamma", "delta", "epsilon" };
+      // exercise
+      custom::frozen_set<std::string> fs(keys);
+      // verify
+      assertUnit(fs.size() == 5);
+      assertUnit(fs.contains("gamma"));
+      assertUnit(fs.contains("epsilon"));
+      assertUnit(!fs.contains("zeta"));
+   }  // teardown
+
+   // two keys with one hash cannot both have a slot
+   void test_build_sameHash()
+   {  // setup
+      bool thrown = false;
+      // exercise
+      try
+      {
+         custom::frozen_set<int> fs(std::vector<int>{ 4, 5, 4 });
+      }
+      catch (const std::runtime_error&)
+      {
+         thrown = true;
+      }
+      // verify
+      assertUnit(thrown);
+   }  // teardown
+
+   /***************************************
+    * FREEZE
+    ***************************************/
+
+   // the frozen set holds what the set does
+   void test_freeze_standard()
+   {  // setup
+      custom::unordered_set<int> us;
+      for (int i = 0; i < 1000; i++)
+         us.insert(i);
+      // exercise
+      custom::frozen_set<int> fs = us.freeze();
+      // verify
+      assertUnit(fs.size() == 1000);
+      assertUnit(us.size() == 1000);
+      bool found = true;
+      for (int i = 0; i < 1000; i++)
+         if (!fs.contains(i))
+            found = false;
+      assertUnit(found);
+      assertUnit(!fs.contains(1000));
+   }  // teardown
+
+   // the keys not yet migrated are frozen too
+   void test_freeze_migrating()
+   {  // setup
+      custom::unordered_set<int> us(4);
+      us.incremental_rehash(true);
+      for (int i = 0; i < 5; i++)
+         us.insert(i);
+      // exercise
+      auto fs = us.freeze(custom::thread_executor(2));
+      // verify
+      assertUnit(us.rehashing());
+      assertUnit(fs.size() == 5);
+      bool found = true;
+      for (int i = 0; i < 5; i++)
+         if (!fs.contains(i))
+            found = false;
+      assertUnit(found);
+   }  // teardown
+
+   // the frozen set hashes with the set's seed
+   void test_freeze_seeded()
+   {  // setup
+      custom::unordered_set<int, custom::hash<int>> us(8, custom::hash<int>(5));
+      for (int i = 0; i < 100; i++)
+         us.insert(i);
+      // exercise
+      auto fs = us.freeze();
+      // verify
+      assertUnit(fs.hash_function().seed() == 5);
+      assertUnit(fs.contains(42));
+   }  // teardown
+
+   /***************************************
+    * SAVE AND LOAD
+    ***************************************/
+
+   // the keys are found in the file itself
+   void test_load_standard()
+   {  // setup
+      std::vector<uint64_t> keys;
+      for (uint64_t i = 0; i < 50000; i++)
+         keys.push_back(i * 11);
+      custom::frozen_set<uint64_t> fsSaved(keys);
+      fsSaved.save(PATH);
+      // exercise
+      auto fs = custom::frozen_set<uint64_t>::load(PATH);
+      // verify
+      assertUnit(fs.base != nullptr);
+      assertUnit(fs.ownKeys.empty());
+      assertUnit((const void *)fs.begin() > fs.base);
+      assertUnit(fs.size() == 50000);
+      assertUnit(fs.numPartitions == 2);
+      bool found = true;
+      for (auto key : keys)
+         if (!fs.contains(key))
+            found = false;
+      assertUnit(found);
+      assertUnit(!fs.contains(12));
+      assertUnit(fs.num_bytes() == fsSaved.num_bytes());
+      // teardown
+      std::remove(PATH);
+   }
+
+   // the mapping moves, the source is left empty
+   void test_load_move()
+   {  // setup
+      custom::frozen_set<int>(std::vector<int>{ 31, 49, 67, 59 }).save(PATH);
+      auto fsSrc = custom::frozen_set<int>::load(PATH);
+      // exercise
+      custom::frozen_set<int> fsDest(std::move(fsSrc));
+      // verify
+      assertUnit(fsSrc.base == nullptr);
+      assertUnit(fsSrc.empty());
+      assertUnit(fsDest.size() == 4);
+      assertUnit(fsDest.contains(59));
+      // teardown
+      std::remove(PATH);
+   }
+
+   // a file that is not a frozen set
+   void test_refuse_garbage()
+   {  // setup
+      std::ofstream fout(PATH, std::ios::binary);
+      fout << "a text file, not a frozen set, but longer than the header is";
+      fout.close();
+      // exercise and verify
+      assertUnit(throws<int>());
+      // teardown
+      std::remove(PATH);
+   }
+
+   // the keys are ints, not 64 bit numbers
+   void test_refuse_keyType()
+   {  // setup
+      custom::frozen_set<int>(std::vector<int>{ 31, 49, 67, 59 }).save(PATH);
+      // exercise and verify
+      assertUnit(throws<uint64_t>());
+      assertUnit(!throws<int>());
+      // teardown
+      std::remove(PATH);
+   }
+
+   // a seeded hash must be loaded with its seed
+   void test_refuse_seed()
+   {  // setup
+      typedef custom::frozen_set<int, custom::hash<int>> Seeded;
+      std::vector<int> keys;
+      for (int i = 0; i < 100; i++)
+         keys.push_back(i);
+      Seeded(keys, custom::hash<int>(1)).save(PATH);
+      bool thrown = false;
+      // exercise
+      try
+      {
+         Seeded::load(PATH, custom::hash<int>(2));
+      }
+      catch (const std::runtime_error&)
+      {
+         thrown = true;
+      }
+      auto fs = Seeded::load(PATH, custom::hash<int>(1));
+      // verify
+      assertUnit(thrown);
+      assertUnit(fs.size() == 100);
+      assertUnit(fs.contains(42));
+      // teardown
+      std::remove(PATH);
+   }
+
+   // does loading PATH as a frozen set of T throw?
+   template <class T>
+   bool throws()
+   {
+      try
+      {
+         custom::frozen_set<T>::load(PATH);
+      }
+      catch (const std::runtime_error&)
+      {
+         return true;
+      }
+      return false;
+   }
+
+   static const char * const PATH;
+};
+
+const char * const TestFrozenHash::PATH = "testFrozenHash.frozen";
+
+#endif // DEBUG
@@ -13,6 +13,22 @@
 
 #include "testPair.h"       // for the pair unit tests
 #include "testHash.h"       // for the hash unit tests
+#include "testFlatHash.h"   // for the flat hash unit tests
+#include "testPool.h"       // for the node pool unit tests
+#include "testHashPolicy.h" // for the bucket index policy unit tests
+#include "testConcurrentHash.h" // for the concurrent hash unit tests
+#include "testHashMap.h"    // for the hash map unit tests
+#include "testExecutor.h"   // for the executor unit tests
+#include "testHashStats.h"  // for the hash stats unit tests
+#include "testHashFunction.h" // for the hash function unit tests
+#include "testMappedHash.h"  // for the snapshot unit tests
+#include "testBloomFilter.h" // for the Bloom filter unit tests
+#include "testSmallHash.h"   // for the small set unit tests
+#include "testShardedHash.h" // for the sharded set unit tests
+#include "testEpochHash.h"   // for the epoch set unit tests
+#include "testFrozenHash.h"  // for the frozen set unit tests
+#include "testConstexprHash.h" // for the constexpr set unit tests
+#include "testCuckooHash.h"  // for the cuckoo set unit tests
 #include "testList.h"       // for the list unit tests
 #include "testVector.h"     // for the vector unit tests
 #include "testSpy.h"        // for the spy unit tests
@@ -31,6 +47,22 @@ int main()
    TestList().run();
    TestVector().run();
    TestHash().run();
+   TestFlatHash().run();
+   TestPool().run();
+   TestHashPolicy().run();
+   TestConcurrentHash().run();
+   TestHashMap().run();
+   TestExecutor().run();
+   TestHashStats().run();
+   TestHashFunction().run();
+   TestMappedHash().run();
+   TestBloomFilter().run();
+   TestSmallHash().run();
+   TestShardedHash().run();
+   TestEpochHash().run();
+   TestFrozenHash().run();
+   TestConstexprHash().run();
+   TestCuckooHash().run();
 #endif // DEBUG
    
    // driver
@@ -14,12 +14,16 @@
 #include "hash.h"
 #include "unitTest.h"
 #include "spy.h"
+#include "hashFunction.h"
 
 #include <cassert>
 #include <memory>
 #include <unordered_set>
 #include <functional>
 #include <vector>
+#include <string>
+#include <sstream>
+#include <iterator>
 
 using std::cout;
 using std::endl;
@@ -34,6 +38,49 @@ class Hash1
 template <class T>
 size_t hash1(const T & t) { return 1; }
 
+// std::hash that counts how many times it is called
+template <class T>
+class HashCount
+{
+   public:
+      static int count;
+      std::size_t operator() (const T & t) const { count++; return std::hash<T>()(t); }
+};
+template <class T>
+int HashCount<T>::count = 0;
+
+// HashCount that keeps the hash in every node
+template <class T>
+class HashCached : public HashCount<T>
+{
+};
+namespace custom
+{
+   template <class T>
+   struct cache_hash_code<T, HashCached<T>> : std::true_type
+   {
+   };
+}
+
+// std::hash<Spy> that also hashes a plain int, so a Spy can be found
+// by its value without building one
+class SpyKeyHash
+{
+   public:
+      typedef void is_transparent;
+      std::size_t operator() (const Spy & s) const { return std::hash<Spy>()(s); }
+      std::size_t operator() (int i) const { return (i / 10) + (i % 10); }
+};
+
+// std::equal_to<Spy> that also compares a Spy to a plain int
+class SpyKeyEqual
+{
+   public:
+      typedef void is_transparent;
+      bool operator() (const Spy & lhs, const Spy & rhs) const { return lhs == rhs; }
+      bool operator() (const Spy & lhs, int rhs) const { return lhs.get() == rhs; }
+};
+
 class TestHash : public UnitTest
 {
 
@@ -45,7 +92,10 @@ public:
       // Construct
       test_construct_default();
       test_construct_nonDefault11();
-//      test_construct_nonDefaultIterator();
+      test_construct_nonDefaultIterator();
+      test_construct_uniqueIterator();
+      test_construct_inputIterator();
+      test_construct_emptyIterator();
       test_construct_copyEmpty();
       test_construct_copyStandard();
       test_construct_nonDefaultHash();
@@ -56,7 +106,11 @@ public:
       test_assign_standardEmpty();
       test_assignMove_emptyEmpty();
       test_assignMove_emptyStandard();
-//      test_assignMove_standardEmpty();
+      test_assign_rangeStandard();
+      test_assign_rangeGrow();
+      test_assign_rangeUnique();
+      test_assign_initializerList();
+      test_assignMove_standardEmpty();
       test_swapMember_emptyEmpty();
 //      test_swapMember_standardEmpty();
 //      test_swapMember_standardOther();
@@ -106,10 +160,17 @@ public:
       test_reserve_standard8();
       test_insert_empty0();
       test_insert_empty58();
-//      test_insert_standard3();
-//      test_insert_standard44();
+      test_insert_standard3();
+      test_insert_standard44();
       test_insert_standardDuplicate();
       test_insert_standardRehash();
+      test_insert_moveStandard3();
+      test_insert_moveDuplicate();
+      test_emplace_standard3();
+      test_emplace_standardDuplicate();
+      test_emplace_key();
+      test_emplaceHint_standard3();
+      test_construct_moveIterator();
 
       // Remove
       test_clear_empty();
@@ -121,6 +182,85 @@ public:
       test_erase_standardBack();
       test_erase_standardLast();
 
+      // Cost
+      test_find_costFront();
+      test_find_costBack();
+      test_find_costMissing();
+      test_insert_costDuplicate();
+      test_insert_costNew();
+      test_erase_costBack();
+      test_erase_costMissing();
+
+      // Cached hash
+      test_cached_trait();
+      test_cached_entry();
+      test_cached_rehash();
+      test_cached_findSkipsEquals();
+      test_cached_findCollision();
+      test_cached_erase();
+
+      // Incremental rehash
+      test_incremental_begin();
+      test_incremental_step();
+      test_incremental_find();
+      test_incremental_duplicate();
+      test_incremental_iterate();
+      test_incremental_iteratorKept();
+      test_incremental_eraseOld();
+      test_incremental_eraseLoop();
+      test_incremental_move();
+      test_incremental_finish();
+      test_incremental_off();
+
+      // Transparent lookup
+      test_transparent_trait();
+      test_transparent_find();
+      test_transparent_findMissing();
+      test_transparent_bucket();
+      test_transparent_erase();
+      test_transparent_eraseMissing();
+
+      // Batch
+      test_findMany_standard();
+      test_findMany_empty();
+      test_findMany_incremental();
+      test_insertMany_standard();
+      test_insertMany_duplicates();
+      test_insertMany_incremental();
+
+      // Parallel rehash
+      test_parallelRehash_standard();
+      test_parallelRehash_smaller();
+      test_parallelRehash_sameOrder();
+      test_parallelRehash_cached();
+      test_parallelRehash_incremental();
+      test_parallelRehash_threshold();
+
+      // Node handle
+      test_extract_key();
+      test_extract_iterator();
+      test_extract_missing();
+      test_extract_destroy();
+      test_insertNode_standard();
+      test_insertNode_duplicate();
+      test_insertNode_empty();
+      test_merge_standard();
+      test_merge_incremental();
+      test_merge_seeded();
+      test_merge_filter();
+
+      // Shrink
+      test_shrinkToFit_drained();
+      test_shrinkToFit_splice();
+      test_shrinkToFit_neverGrows();
+      test_minLoadFactor_off();
+      test_minLoadFactor_shrink();
+      test_minLoadFactor_hysteresis();
+      test_minLoadFactor_clamp();
+      test_minLoadFactor_eraseLoop();
+      test_minLoadFactor_reserve();
+      test_minLoadFactor_filter();
+
       // Status
       test_size_empty();
       test_size_standard();
@@ -134,6 +274,7 @@ public:
       test_bucketCount_standard();
       test_loadFactor_empty();
       test_loadFactor_standard();
+      test_loadFactor_fraction();
       test_loadFactor_default();
       test_loadFactor_two();
       test_setLoadFactor_five();
@@ -210,6 +351,36 @@ public:
       }
    }  // teardown
 
+   // create a spy unordered set by moving from a vector
+   void test_construct_moveIterator()
+   {  // setup
+      std::vector<Spy> v{Spy(31), Spy(49), Spy(67), Spy(59)};
+      std::allocator<custom::unordered_set<Spy>> alloc;
+      custom::unordered_set<Spy> us;
+      us.numElements = 99;
+      us.buckets = 88;
+      us.maxLoadFactor = (float)77.7;
+      Spy::reset();
+      // exercise
+      alloc.construct(&us, std::make_move_iterator(v.begin()), std::make_move_iterator(v.end()));
+      // verify
+      assertUnit(Spy::numCopyMove() == 4); // 31, 49, 67, 59
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numAssign() == 0);
+      assertUnit(Spy::numDelete() == 0);
+      assertUnit(Spy::numDestructor() == 0);
+      assertUnit(v[0].empty());
+      // h[0] --> 31 
+      // h[1] --> 49 67
+      // h[2] --> 59 
+      // h[3] -->
+      us.maxLoadFactor = (float)1.3;
+      assertStandardFixture(us);
+      // teardown
+      teardownStandardFixture(us);
+   }
+
    // create a spy unordered set from a vector iterator
    void test_construct_nonDefaultIterator()
    {  // setup
@@ -242,6 +413,52 @@ public:
       // teardown
       teardownStandardFixture(us);
    } 
+
+   // unique keys are placed without comparing them to anything
+   void test_construct_uniqueIterator()
+   {  // setup
+      std::vector<Spy> v{Spy(31), Spy(49), Spy(67), Spy(59)};
+      Spy::reset();
+      // exercise
+      custom::unordered_set<Spy> us(custom::unique_keys, v.begin(), v.end());
+      // verify
+      assertUnit(Spy::numEquals() == 0);
+      assertUnit(Spy::numAlloc() == 4);   // 31, 49, 67, 59
+      assertUnit(Spy::numCopy() == 4);    // 31, 49, 67, 59
+      assertUnit(Spy::numCopyMove() == 0);
+      // h[0] --> 31
+      // h[1] --> 49 67
+      // h[2] --> 59
+      // h[3] -->
+      us.maxLoadFactor = (float)1.3;
+      assertStandardFixture(us);
+      // teardown
+      teardownStandardFixture(us);
+   }
+
+   // a range that can only be read once still drops duplicates
+   void test_construct_inputIterator()
+   {  // setup
+      std::istringstream in("5 6 7 6 5");
+      // exercise
+      custom::unordered_set<int> us((std::istream_iterator<int>(in)), std::istream_iterator<int>());
+      // verify
+      assertUnit(us.size() == 3);
+      assertUnit(us.bucket_count() == 8);
+      assertUnit(us.find(7) != us.end());
+   }  // teardown
+
+   // an empty range makes the default eight buckets
+   void test_construct_emptyIterator()
+   {  // setup
+      std::vector<Spy> v;
+      // exercise
+      custom::unordered_set<Spy> us(v.begin(), v.end());
+      // verify
+      assertUnit(us.size() == 0);
+      assertUnit(us.bucket_count() == 8);
+      assertUnit(us.maxLoadFactor == (float)1.0);
+   }  // teardown
    
    // copy an empty set
    void test_construct_copyEmpty()
@@ -1001,6 +1218,20 @@ public:
       teardownStandardFixture(us);
    }
 
+   // the load factor is not rounded down to a whole number
+   void test_loadFactor_fraction()
+   {  // setup
+      custom::unordered_set<int> us;
+      for (int i = 0; i < 5; i++)
+         us.insert(i);
+      float lf = float(-99.9);
+      // exercise
+      lf = us.load_factor();
+      // verify
+      assertUnit(us.bucket_count() == 8);
+      assertUnit(lf == (float)0.625);
+   }  // teardown
+
    // verify the maximum load factor is 1.0
    void test_loadFactor_default()
    {  // setup
@@ -1215,6 +1446,82 @@ public:
       teardownStandardFixture(usSrc);
       teardownStandardFixture(usDes);
    }
+
+   // assign a range over a standard set, keeping its buckets
+   void test_assign_rangeStandard()
+   {  // setup
+      custom::unordered_set<Spy> us;
+      setupStandardFixture(us);
+      std::vector<Spy> v{Spy(10), Spy(21)};
+      Spy::reset();
+      // exercise
+      us.assign(v.begin(), v.end());
+      // verify
+      assertUnit(Spy::numDestructor() == 4);   // [31, 49, 67, 59]
+      assertUnit(Spy::numCopy() == 2);         // [10, 21]
+      assertUnit(us.size() == 2);
+      assertUnit(us.bucket_count() == 4);
+      assertUnit(us.bucket_size(1) == 1);      // 10
+      assertUnit(us.bucket_size(3) == 1);      // 21
+      // teardown
+      teardownStandardFixture(us);
+   }
+
+   // a range too large for the buckets sizes the table once
+   void test_assign_rangeGrow()
+   {  // setup
+      custom::unordered_set<int> us(4);
+      us.insert(1000);
+      std::vector<int> v;
+      for (int i = 0; i < 100; i++)
+         v.push_back(i);
+      // exercise
+      us.assign(v.begin(), v.end());
+      // verify
+      assertUnit(us.size() == 100);
+      assertUnit(us.bucket_count() == 100);
+      assertUnit(us.find(1000) == us.end());
+      bool found = true;
+      for (int i = 0; i < 100; i++)
+         if (us.bucket_size(i) != 1)
+            found = false;
+      assertUnit(found);
+   }  // teardown
+
+   // assign unique keys without comparing them
+   void test_assign_rangeUnique()
+   {  // setup
+      custom::unordered_set<Spy> us;
+      us.insert(Spy(49));
+      std::vector<Spy> v{Spy(31), Spy(49), Spy(67), Spy(59)};
+      Spy::reset();
+      // exercise
+      us.assign(custom::unique_keys, v.begin(), v.end());
+      // verify
+      assertUnit(Spy::numEquals() == 0);
+      assertUnit(Spy::numCopy() == 4);
+      assertUnit(us.size() == 4);
+      assertUnit(us.bucket_count() == 8);
+   }  // teardown
+
+   // assign a list replaces what was there
+   void test_assign_initializerList()
+   {  // setup
+      custom::unordered_set<int> us;
+      us.insert(8);
+      us.insert(9);
+      // exercise
+      us = { 1, 2, 3, 2 };
+      // verify
+      assertUnit(us.size() == 3);
+      assertUnit(us.find(8) == us.end());
+      assertUnit(us.find(2) != us.end());
+      // exercise
+      us.insert({ 3, 4 });
+      // verify
+      assertUnit(us.size() == 4);
+      assertUnit(us.find(4) != us.end());
+   }  // teardown
    
    
    // swap empty hashes use member swap
@@ -2881,6 +3188,1562 @@ public:
       teardownStandardFixture(us);
    }
 
+   /***************************************
+    * INSERT MOVE AND EMPLACE
+    * The element is moved or built into its
+    * node rather than copied
+    ***************************************/
+
+   // move a new element into the standard fixture
+   void test_insert_moveStandard3()
+   {  // setup
+      // h[0] --> 31 
+      // h[1] --> 49 67
+      // h[2] --> 59 
+      // h[3] --> 
+      custom::unordered_set<Spy> us;
+      setupStandardFixture(us);
+      Spy s(3);   // into slot (3)%4 = 3
+      Spy::reset();
+      // exercise
+      auto p = us.insert(std::move(s));
+      // verify
+      assertUnit(Spy::numCopyMove() == 1); // move     [3]
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numAssign() == 0);
+      assertUnit(Spy::numDestructor() == 0);
+      assertUnit(s.empty());
+      assertUnit(p.second == true);
+      assertUnit(p.first != us.end());
+      if (p.first != us.end())
+         assertUnit(*(p.first) == Spy(3));
+      // h[3] --> [3]
+      assertUnit(us.numElements == 5);
+      if (us.buckets[3].size() == 1)
+      {
+         us.buckets[3].pop_back();
+         us.numElements = 4;
+      }
+      assertStandardFixture(us);
+      // teardown
+      teardownStandardFixture(us);
+   }
+
+   // moving a duplicate leaves it alone
+   void test_insert_moveDuplicate()
+   {  // setup
+      custom::unordered_set<Spy> us;
+      setupStandardFixture(us);
+      Spy s(67);
+      Spy::reset();
+      // exercise
+      auto p = us.insert(std::move(s));
+      // verify
+      assertUnit(Spy::numCopyMove() == 0);
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(!s.empty());
+      assertUnit(p.second == false);
+      assertStandardFixture(us);
+      // teardown
+      teardownStandardFixture(us);
+   }
+
+   // emplace builds the element once and moves it into the node
+   void test_emplace_standard3()
+   {  // setup
+      custom::unordered_set<Spy> us;
+      setupStandardFixture(us);
+      Spy::reset();
+      // exercise
+      auto p = us.emplace(3);
+      // verify
+      assertUnit(Spy::numNondefault() == 1); // build    [3]
+      assertUnit(Spy::numAlloc() == 1);      // allocate [3]
+      assertUnit(Spy::numCopyMove() == 1);   // move     [3]
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numAssign() == 0);
+      assertUnit(p.second == true);
+      assertUnit(us.numElements == 5);
+      assertUnit(us.buckets[3].size() == 1);
+      if (us.buckets[3].size() == 1)
+      {
+         assertUnit(us.buckets[3].front() == Spy(3));
+         us.buckets[3].pop_back();
+         us.numElements = 4;
+      }
+      assertStandardFixture(us);
+      // teardown
+      teardownStandardFixture(us);
+   }
+
+   // emplace of a duplicate hashes and compares before any node
+   void test_emplace_standardDuplicate()
+   {  // setup
+      custom::unordered_set<Spy> us;
+      setupStandardFixture(us);
+      Spy::reset();
+      // exercise
+      auto p = us.emplace(67);
+      // verify
+      assertUnit(Spy::numNondefault() == 1); // the one to compare
+      assertUnit(Spy::numDestructor() == 1); // and it goes away
+      assertUnit(Spy::numEquals() == 2);     // 49 67
+      assertUnit(Spy::numCopyMove() == 0);
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(p.second == false);
+      assertStandardFixture(us);
+      // teardown
+      teardownStandardFixture(us);
+   }
+
+   // emplace of a T is an insert: nothing is built on the side
+   void test_emplace_key()
+   {  // setup
+      custom::unordered_set<Spy> us;
+      setupStandardFixture(us);
+      Spy s(3);
+      Spy::reset();
+      // exercise
+      auto p = us.emplace(s);
+      // verify
+      assertUnit(Spy::numCopy() == 1);       // copy     [3]
+      assertUnit(Spy::numAlloc() == 1);      // allocate [3]
+      assertUnit(Spy::numCopyMove() == 0);
+      assertUnit(Spy::numNondefault() == 0);
+      assertUnit(p.second == true);
+      if (us.buckets[3].size() == 1)
+      {
+         us.buckets[3].pop_back();
+         us.numElements = 4;
+      }
+      assertStandardFixture(us);
+      // teardown
+      teardownStandardFixture(us);
+   }
+
+   // emplace_hint returns the element, new or not
+   void test_emplaceHint_standard3()
+   {  // setup
+      custom::unordered_set<Spy> us;
+      setupStandardFixture(us);
+      // exercise
+      auto itNew = us.emplace_hint(us.begin(), 3);
+      auto itOld = us.emplace_hint(us.end(), 49);
+      // verify
+      assertUnit(itNew != us.end());
+      assertUnit(itOld != us.end());
+      if (itNew != us.end())
+         assertUnit(*itNew == Spy(3));
+      if (itOld != us.end())
+         assertUnit(*itOld == Spy(49));
+      assertUnit(us.numElements == 5);
+      if (us.buckets[3].size() == 1)
+      {
+         us.buckets[3].pop_back();
+         us.numElements = 4;
+      }
+      assertStandardFixture(us);
+      // teardown
+      teardownStandardFixture(us);
+   }
+
+   /***************************************
+    * COST
+    * Each operation hashes once and only compares
+    * against the bucket the element hashes to
+    ***************************************/
+
+   // find the element at the front of its bucket
+   void test_find_costFront()
+   {  // setup
+      // h[0] --> 31 
+      // h[1] --> 49 67
+      // h[2] --> 59 
+      // h[3] --> 
+      custom::unordered_set<Spy, HashCount<Spy>> us;
+      setupStandardFixture(us);
+      Spy s(49);
+      Spy::reset();
+      HashCount<Spy>::count = 0;
+      // exercise
+      auto it = us.find(s);
+      // verify
+      assertUnit(HashCount<Spy>::count == 1);
+      assertUnit(Spy::numEquals() == 1);    // 49
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(it != us.end());
+      if (it != us.end())
+         assertUnit(*it == Spy(49));
+      assertStandardFixture(us);
+      // teardown
+      teardownStandardFixture(us);
+   }
+
+   // find the element at the back of its bucket
+   void test_find_costBack()
+   {  // setup
+      // h[0] --> 31 
+      // h[1] --> 49 67
+      // h[2] --> 59 
+      // h[3] --> 
+      custom::unordered_set<Spy, HashCount<Spy>> us;
+      setupStandardFixture(us);
+      Spy s(67);
+      Spy::reset();
+      HashCount<Spy>::count = 0;
+      // exercise
+      auto it = us.find(s);
+      // verify
+      assertUnit(HashCount<Spy>::count == 1);
+      assertUnit(Spy::numEquals() == 2);    // 49 67
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(it != us.end());
+      if (it != us.end())
+      {
+         assertUnit(it.itVector == typename custom::vector<custom::list<Spy>>::iterator(1, us.buckets));
+         assertUnit(*it == Spy(67));
+      }
+      assertStandardFixture(us);
+      // teardown
+      teardownStandardFixture(us);
+   }
+
+   // find something that hashes to an empty bucket
+   void test_find_costMissing()
+   {  // setup
+      // h[0] --> 31 
+      // h[1] --> 49 67
+      // h[2] --> 59 
+      // h[3] --> 
+      custom::unordered_set<Spy, HashCount<Spy>> us;
+      setupStandardFixture(us);
+      Spy s(12);  // hashes to bucket 3
+      Spy::reset();
+      HashCount<Spy>::count = 0;
+      // exercise
+      auto it = us.find(s);
+      // verify
+      assertUnit(HashCount<Spy>::count == 1);
+      assertUnit(Spy::numEquals() == 0);
+      assertUnit(it == us.end());
+      assertStandardFixture(us);
+      // teardown
+      teardownStandardFixture(us);
+   }
+
+   // insert a duplicate: hash once, no second find
+   void test_insert_costDuplicate()
+   {  // setup
+      // h[0] --> 31 
+      // h[1] --> 49 67
+      // h[2] --> 59 
+      // h[3] --> 
+      custom::unordered_set<Spy, HashCount<Spy>> us;
+      setupStandardFixture(us);
+      Spy s(67);
+      Spy::reset();
+      HashCount<Spy>::count = 0;
+      // exercise
+      auto p = us.insert(s);
+      // verify
+      assertUnit(HashCount<Spy>::count == 1);
+      assertUnit(Spy::numEquals() == 2);    // 49 67
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(p.second == false);
+      assertUnit(p.first != us.end());
+      if (p.first != us.end())
+         assertUnit(*(p.first) == Spy(67));
+      assertStandardFixture(us);
+      // teardown
+      teardownStandardFixture(us);
+   }
+
+   // insert a new element: the iterator comes from the push, not a find
+   void test_insert_costNew()
+   {  // setup
+      // h[0] --> 31 
+      // h[1] --> 49 67
+      // h[2] --> 59 
+      // h[3] --> 
+      custom::unordered_set<Spy, HashCount<Spy>> us;
+      setupStandardFixture(us);
+      Spy s(76);  // (7+6)%4 = 1
+      Spy::reset();
+      HashCount<Spy>::count = 0;
+      // exercise
+      auto p = us.insert(s);
+      // verify
+      assertUnit(HashCount<Spy>::count == 1);
+      assertUnit(Spy::numEquals() == 2);    // 49 67
+      assertUnit(Spy::numAlloc() == 1);     // [76]
+      assertUnit(Spy::numCopy() == 1);      // [76]
+      assertUnit(p.second == true);
+      assertUnit(p.first != us.end());
+      if (p.first != us.end())
+      {
+         assertUnit(p.first.itList == us.buckets[1].rbegin());
+         assertUnit(*(p.first) == Spy(76));
+      }
+      // h[1] --> 49 67 [76]
+      assertUnit(us.numElements == 5);
+      if (us.buckets[1].size() == 3)
+      {
+         us.buckets[1].pop_back();
+         us.numElements = 4;
+      }
+      assertStandardFixture(us);
+      // teardown
+      teardownStandardFixture(us);
+   }
+
+   // erase the back of a bucket: one hash, no second find
+   void test_erase_costBack()
+   {  // setup
+      // h[0] --> 31 
+      // h[1] --> 49 67
+      // h[2] --> 59 
+      // h[3] --> 
+      custom::unordered_set<Spy, HashCount<Spy>> us;
+      setupStandardFixture(us);
+      Spy s(67);
+      Spy::reset();
+      HashCount<Spy>::count = 0;
+      // exercise
+      auto it = us.erase(s);
+      // verify
+      assertUnit(HashCount<Spy>::count == 1);
+      assertUnit(Spy::numEquals() == 2);    // 49 67
+      assertUnit(Spy::numDestructor() == 1);
+      assertUnit(Spy::numDelete() == 1);
+      assertUnit(us.numElements == 3);
+      assertUnit(us.buckets[1].size() == 1);
+      assertUnit(it != us.end());
+      if (it != us.end())
+         assertUnit(*it == Spy(59));
+      // teardown
+      teardownStandardFixture(us);
+   }
+
+   // erase something missing: one hash and nothing else
+   void test_erase_costMissing()
+   {  // setup
+      // h[0] --> 31 
+      // h[1] --> 49 67
+      // h[2] --> 59 
+      // h[3] --> 
+      custom::unordered_set<Spy, HashCount<Spy>> us;
+      setupStandardFixture(us);
+      Spy s(10);  // hashes to bucket 1
+      Spy::reset();
+      HashCount<Spy>::count = 0;
+      // exercise
+      auto it = us.erase(s);
+      // verify
+      assertUnit(HashCount<Spy>::count == 1);
+      assertUnit(Spy::numEquals() == 2);    // 49 67
+      assertUnit(Spy::numDestructor() == 0);
+      assertUnit(it == us.end());
+      assertStandardFixture(us);
+      // teardown
+      teardownStandardFixture(us);
+   }
+
+   /***************************************
+    * CACHED HASH
+    * The nodes keep the full hash: rehash reuses
+    * it and a chain walk compares it before EqPred
+    ***************************************/
+
+   // strings cache by default, ints and Spy do not
+   void test_cached_trait()
+   {  // verify
+      assertUnit((custom::cache_hash_code<std::string, std::hash<std::string>>::value));
+      assertUnit(!(custom::cache_hash_code<int, std::hash<int>>::value));
+      assertUnit(!(custom::cache_hash_code<Spy, std::hash<Spy>>::value));
+      assertUnit((custom::cache_hash_code<Spy, HashCached<Spy>>::value));
+   }
+
+   // each node holds the element and its hash
+   void test_cached_entry()
+   {  // setup
+      custom::unordered_set<Spy, HashCached<Spy>> us;
+      // exercise
+      us.insert(Spy(49));
+      // verify
+      assertUnit(us.size() == 1);
+      assertUnit(us.buckets[5].size() == 1);   // 13 % 8 = 5
+      if (us.buckets[5].size() == 1)
+      {
+         assertUnit(us.buckets[5].front().hash == 13);
+         assertUnit(us.buckets[5].front().value == Spy(49));
+         assertUnit(*us.begin() == Spy(49));
+      }
+   }  // teardown
+
+   // rehash moves the nodes without calling the hash
+   void test_cached_rehash()
+   {  // setup
+      custom::unordered_set<Spy, HashCached<Spy>> us(4);
+      us.insert(Spy(31));
+      us.insert(Spy(49));
+      us.insert(Spy(67));
+      us.insert(Spy(59));
+      HashCount<Spy>::count = 0;
+      // exercise
+      us.rehash(20);
+      // verify
+      assertUnit(HashCount<Spy>::count == 0);
+      assertUnit(us.bucket_count() == 20);
+      assertUnit(us.buckets[4].size() == 1);    // 31
+      assertUnit(us.buckets[13].size() == 2);   // 49 67
+      assertUnit(us.buckets[14].size() == 1);   // 59
+      assertUnit(us.find(Spy(67)) != us.end());
+   }  // teardown
+
+   // a different hash in the same bucket is passed over without EqPred
+   void test_cached_findSkipsEquals()
+   {  // setup
+      // h[4] --> 31 39
+      custom::unordered_set<Spy, HashCached<Spy>> us;
+      us.insert(Spy(31));   // 4  % 8 = 4
+      us.insert(Spy(39));   // 12 % 8 = 4
+      Spy s(39);
+      Spy::reset();
+      // exercise
+      auto it = us.find(s);
+      // verify
+      assertUnit(Spy::numEquals() == 1);   // 39
+      assertUnit(it != us.end());
+      if (it != us.end())
+         assertUnit(*it == Spy(39));
+   }  // teardown
+
+   // the same hash still needs EqPred to tell the elements apart
+   void test_cached_findCollision()
+   {  // setup
+      // h[5] --> 49 67
+      custom::unordered_set<Spy, HashCached<Spy>> us;
+      us.insert(Spy(49));
+      us.insert(Spy(67));
+      Spy s(67);
+      Spy::reset();
+      // exercise
+      auto it = us.find(s);
+      // verify
+      assertUnit(Spy::numEquals() == 2);   // 49 67
+      assertUnit(it != us.end());
+      if (it != us.end())
+         assertUnit(*it == Spy(67));
+   }  // teardown
+
+   // erase finds the node through the cached hash too
+   void test_cached_erase()
+   {  // setup
+      // h[4] --> 31 39
+      custom::unordered_set<Spy, HashCached<Spy>> us;
+      us.insert(Spy(31));
+      us.insert(Spy(39));
+      Spy s(39);
+      Spy::reset();
+      // exercise
+      us.erase(s);
+      // verify
+      assertUnit(Spy::numEquals() == 1);   // 39
+      assertUnit(Spy::numDestructor() == 1);
+      assertUnit(us.size() == 1);
+      assertUnit(us.find(Spy(31)) != us.end());
+      assertUnit(us.find(Spy(39)) == us.end());
+   }  // teardown
+
+   /***************************************
+    * INCREMENTAL REHASH
+    * Growing starts a migration from the old
+    * table to the new one, a few buckets a call
+    ***************************************/
+
+   // crossing the load factor starts a migration and moves nothing
+   void test_incremental_begin()
+   {  // setup
+      // h[0] --> 0   h[1] --> 1   h[2] --> 2   h[3] --> 3
+      custom::unordered_set<int> us(4);
+      us.incremental_rehash(true);
+      for (int i = 0; i < 4; i++)
+         us.insert(i);
+      // exercise
+      us.insert(4);
+      // verify
+      // old: h[0] --> 0   h[1] --> 1   h[2] --> 2   h[3] --> 3
+      // new: h[4] --> 4
+      assertUnit(us.rehashing());
+      assertUnit(us.size() == 5);
+      assertUnit(us.bucket_count() == 8);
+      assertUnit(us.bucketsOld.size() == 4);
+      assertUnit(us.iMigrate == 0);
+      assertUnit(us.buckets[4].size() == 1);
+      if (us.bucketsOld.size() == 4)
+         for (size_t i = 0; i < 4; i++)
+            assertUnit(us.bucketsOld[i].size() == 1);
+   }  // teardown
+
+   // each insert afterwards migrates MIGRATE_STEP old buckets
+   void test_incremental_step()
+   {  // setup
+      custom::unordered_set<int> us(4);
+      setupIncrementalFixture(us);
+      // exercise
+      us.insert(5);
+      // verify
+      // old: h[2] --> 2   h[3] --> 3
+      // new: h[0] --> 0   h[1] --> 1   h[4] --> 4   h[5] --> 5
+      assertUnit(us.rehashing());
+      assertUnit(us.iMigrate == 2);
+      assertUnit(us.bucketsOld[0].empty());
+      assertUnit(us.bucketsOld[1].empty());
+      assertUnit(us.bucketsOld[2].size() == 1);
+      assertUnit(us.buckets[0].size() == 1);
+      assertUnit(us.buckets[1].size() == 1);
+      assertUnit(us.buckets[5].size() == 1);
+      assertUnit(us.size() == 6);
+   }  // teardown
+
+   // find looks in the old bucket, then the new one
+   void test_incremental_find()
+   {  // setup
+      custom::unordered_set<int> us(4);
+      setupIncrementalFixture(us);
+      // exercise
+      auto itOld = us.find(2);
+      auto itNew = us.find(4);
+      auto itMissing = us.find(9);
+      // verify
+      assertUnit(itOld != us.end());
+      assertUnit(itNew != us.end());
+      assertUnit(itMissing == us.end());
+      if (itOld != us.end())
+         assertUnit(*itOld == 2);
+      if (itNew != us.end())
+         assertUnit(*itNew == 4);
+      assertUnit(us.iMigrate == 0);   // lookups do not migrate
+   }  // teardown
+
+   // an element still in the old table is not inserted twice
+   void test_incremental_duplicate()
+   {  // setup
+      custom::unordered_set<int> us(4);
+      setupIncrementalFixture(us);
+      // exercise
+      auto p = us.insert(3);
+      // verify
+      assertUnit(p.second == false);
+      assertUnit(p.first != us.end());
+      if (p.first != us.end())
+         assertUnit(*(p.first) == 3);
+      assertUnit(us.size() == 5);
+   }  // teardown
+
+   // iteration walks the old buckets then the new ones, each element once
+   void test_incremental_iterate()
+   {  // setup
+      custom::unordered_set<int> us(4);
+      setupIncrementalFixture(us);
+      us.insert(5);
+      int sum = 0;
+      int count = 0;
+      // exercise
+      for (auto it = us.begin(); it != us.end(); ++it)
+      {
+         sum += *it;
+         count++;
+      }
+      // verify
+      assertUnit(count == 6);
+      assertUnit(sum == 0 + 1 + 2 + 3 + 4 + 5);
+   }  // teardown
+
+   // an element found in an old bucket keeps its node when it migrates
+   void test_incremental_iteratorKept()
+   {  // setup
+      custom::unordered_set<Spy> us(4);
+      us.incremental_rehash(true);
+      for (int i = 0; i < 5; i++)
+         us.insert(Spy(i));
+      auto it = us.find(Spy(2));
+      Spy * pFound = &*it;
+      Spy::reset();
+      // exercise
+      us.insert(Spy(5));
+      us.insert(Spy(6));
+      // verify
+      assertUnit(!us.rehashing());
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numCopyMove() == 2);     // [5, 6], none migrated
+      assertUnit(Spy::numDelete() == 0);
+      assertUnit(*it == Spy(2));
+      assertUnit(&*us.find(Spy(2)) == pFound);
+   }  // teardown
+
+   // erasing the last old element returns the first new one
+   void test_incremental_eraseOld()
+   {  // setup
+      custom::unordered_set<int> us(4);
+      setupIncrementalFixture(us);
+      // exercise
+      auto it = us.erase(3);
+      // verify
+      // old: h[0] --> 0   h[1] --> 1   h[2] --> 2   h[3] -->
+      // new: h[4] --> 4
+      assertUnit(us.size() == 4);
+      assertUnit(us.iMigrate == 0);   // erase does not migrate
+      assertUnit(us.find(3) == us.end());
+      assertUnit(it != us.end());
+      if (it != us.end())
+         assertUnit(*it == 4);
+   }  // teardown
+
+   // erasing as we iterate part way through a migration visits every
+   // element once, none skipped and none twice
+   void test_incremental_eraseLoop()
+   {  // setup
+      custom::unordered_set<int> us(64);
+      us.incremental_rehash(true);
+      for (int i = 0; i < 137; i++)
+         us.insert(i);
+      bool midMigration = us.rehashing() && us.iMigrate > 0;
+      std::vector<int> numVisits(137, 0);
+      // exercise
+      for (auto it = us.begin(); it != us.end(); )
+      {
+         numVisits[*it]++;
+         it = us.erase(*it);
+      }
+      // verify
+      assertUnit(midMigration);
+      bool once = true;
+      for (int num : numVisits)
+         if (num != 1)
+            once = false;
+      assertUnit(once);
+      assertUnit(us.empty());
+   }  // teardown
+
+   // moving a set part way through a migration takes the old table too
+   // and leaves the source empty, with nothing left to migrate
+   void test_incremental_move()
+   {  // setup
+      custom::unordered_set<int> usSrc(4);
+      setupIncrementalFixture(usSrc);
+      custom::unordered_set<int> usDest;
+      // exercise
+      usDest = std::move(usSrc);
+      // verify
+      assertUnit(usDest.size() == 5);
+      assertUnit(usDest.rehashing());
+      for (int i = 0; i < 5; i++)
+         assertUnit(usDest.find(i) != usDest.end());
+      assertUnit(usSrc.size() == 0);
+      assertUnit(usSrc.iMigrate == 0);
+      assertUnit(usSrc.bucketsOld.empty());
+      assertUnit(!usSrc.rehashing());
+      assertUnit(usSrc.begin() == usSrc.end());
+      usSrc.insert(7);
+      assertUnit(usSrc.size() == 1);
+      assertUnit(usSrc.find(7) != usSrc.end());
+   }  // teardown
+
+   // the migration ends on its own and the old table is freed
+   void test_incremental_finish()
+   {  // setup
+      custom::unordered_set<int> us(4);
+      setupIncrementalFixture(us);
+      // exercise
+      us.insert(5);
+      us.insert(6);
+      // verify
+      assertUnit(!us.rehashing());
+      assertUnit(us.bucketsOld.size() == 0);
+      assertUnit(us.bucket_count() == 8);
+      for (size_t i = 0; i < 7; i++)
+         assertUnit(us.buckets[i].size() == 1);
+      assertUnit(us.size() == 7);
+   }  // teardown
+
+   // turning incremental rehash off finishes the migration at once
+   void test_incremental_off()
+   {  // setup
+      custom::unordered_set<int> us(4);
+      setupIncrementalFixture(us);
+      // exercise
+      us.incremental_rehash(false);
+      // verify
+      assertUnit(!us.incremental_rehash());
+      assertUnit(!us.rehashing());
+      assertUnit(us.size() == 5);
+      bool found = true;
+      for (int i = 0; i < 5; i++)
+         if (us.find(i) == us.end())
+            found = false;
+      assertUnit(found);
+   }  // teardown
+
+   /***************************************
+    * TRANSPARENT LOOKUP
+    ***************************************/
+
+   // only a Hash and an EqPred that both opt in make a lookup transparent
+   void test_transparent_trait()
+   {  // verify
+      assertUnit((custom::transparent_lookup<SpyKeyHash, SpyKeyEqual>::value));
+      assertUnit(!(custom::transparent_lookup<SpyKeyHash, std::equal_to<Spy>>::value));
+      assertUnit(!(custom::transparent_lookup<std::hash<Spy>, SpyKeyEqual>::value));
+      assertUnit(!(custom::transparent_lookup<std::hash<Spy>, std::equal_to<Spy>>::value));
+   }
+
+   // find by an int never builds a Spy
+   void test_transparent_find()
+   {  // setup
+      custom::unordered_set<Spy, SpyKeyHash, SpyKeyEqual> us;
+      setupStandardFixture(us);
+      Spy::reset();
+      // exercise
+      auto it = us.find(67);
+      // verify
+      assertUnit(Spy::numNondefault() == 0);
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numEquals() == 0);   // compared as ints
+      assertUnit(it != us.end());
+      if (it != us.end())
+         assertUnit((*it).get() == 67);
+      // teardown
+      teardownStandardFixture(us);
+   }
+
+   // a missing int key walks its one bucket
+   void test_transparent_findMissing()
+   {  // setup
+      custom::unordered_set<Spy, SpyKeyHash, SpyKeyEqual> us;
+      setupStandardFixture(us);
+      Spy::reset();
+      // exercise
+      auto it = us.find(58);   // 13 % 4 = 1, with 49 and 67
+      // verify
+      assertUnit(it == us.end());
+      assertUnit(Spy::numNondefault() == 0);
+      assertUnit(Spy::numAlloc() == 0);
+      // teardown
+      teardownStandardFixture(us);
+   }
+
+   // bucket hashes the int the way it would hash the Spy
+   void test_transparent_bucket()
+   {  // setup
+      custom::unordered_set<Spy, SpyKeyHash, SpyKeyEqual> us;
+      setupStandardFixture(us);
+      Spy::reset();
+      // exercise
+      size_t iBucket = us.bucket(49);
+      // verify
+      assertUnit(iBucket == 1);
+      assertUnit(iBucket == us.bucket(Spy(49)));
+      assertUnit(Spy::numNondefault() == 1);   // only the Spy(49) above
+      // teardown
+      teardownStandardFixture(us);
+   }
+
+   // erase by an int destroys only the element
+   void test_transparent_erase()
+   {  // setup
+      custom::unordered_set<Spy, SpyKeyHash, SpyKeyEqual> us;
+      setupStandardFixture(us);
+      Spy::reset();
+      // exercise
+      auto it = us.erase(49);
+      // verify
+      assertUnit(Spy::numNondefault() == 0);
+      assertUnit(Spy::numDestructor() == 1);
+      assertUnit(Spy::numDelete() == 1);
+      assertUnit(us.size() == 3);
+      assertUnit(us.bucket_size(1) == 1);
+      assertUnit(it != us.end());
+      if (it != us.end())
+         assertUnit((*it).get() == 67);
+      assertUnit(us.find(49) == us.end());
+      // teardown
+      teardownStandardFixture(us);
+   }
+
+   // erase of a missing int key changes nothing
+   void test_transparent_eraseMissing()
+   {  // setup
+      custom::unordered_set<Spy, SpyKeyHash, SpyKeyEqual> us;
+      setupStandardFixture(us);
+      Spy::reset();
+      // exercise
+      auto it = us.erase(76);
+      // verify
+      assertUnit(it == us.end());
+      assertUnit(Spy::numNondefault() == 0);
+      assertUnit(Spy::numDestructor() == 0);
+      assertUnit(us.size() == 4);
+      // teardown
+      teardownStandardFixture(us);
+   }
+
+   /***************************************
+    * BATCH
+    ***************************************/
+
+   // find_many answers in the order of the keys without copying them
+   void test_findMany_standard()
+   {  // setup
+      custom::unordered_set<Spy> us;
+      setupStandardFixture(us);
+      std::vector<Spy> keys{ Spy(67), Spy(58), Spy(31), Spy(76), Spy(59) };
+      std::vector<bool> found;
+      Spy::reset();
+      // exercise
+      size_t numFound = us.find_many(keys, std::back_inserter(found));
+      // verify
+      assertUnit(numFound == 3);
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(found.size() == 5);
+      if (found.size() == 5)
+      {
+         assertUnit(found[0] == true);
+         assertUnit(found[1] == false);
+         assertUnit(found[2] == true);
+         assertUnit(found[3] == false);
+         assertUnit(found[4] == true);
+      }
+      assertStandardFixture(us);
+      // teardown
+      teardownStandardFixture(us);
+   }
+
+   // an empty batch writes nothing
+   void test_findMany_empty()
+   {  // setup
+      custom::unordered_set<Spy> us;
+      setupStandardFixture(us);
+      std::vector<Spy> keys;
+      std::vector<bool> found;
+      // exercise
+      size_t numFound = us.find_many(keys, std::back_inserter(found));
+      // verify
+      assertUnit(numFound == 0);
+      assertUnit(found.empty());
+      // teardown
+      teardownStandardFixture(us);
+   }
+
+   // keys not yet migrated are still found, across more than one window
+   void test_findMany_incremental()
+   {  // setup
+      custom::unordered_set<int> us(4);
+      setupIncrementalFixture(us);
+      std::vector<int> keys;
+      for (int i = 0; i < 40; i++)
+         keys.push_back(i % 8);
+      std::vector<bool> found;
+      // exercise
+      size_t numFound = us.find_many(keys, std::back_inserter(found));
+      // verify
+      assertUnit(numFound == 25);   // 0..4 of every 8
+      assertUnit(found.size() == 40);
+      if (found.size() == 40)
+      {
+         assertUnit(found[0] == true);
+         assertUnit(found[4] == true);
+         assertUnit(found[5] == false);
+         assertUnit(found[39] == false);
+      }
+      assertUnit(us.rehashing());   // a lookup never migrates
+   }  // teardown
+
+   // insert_many copies each new key once, after growing for the batch
+   void test_insertMany_standard()
+   {  // setup
+      custom::unordered_set<Spy> us;
+      setupStandardFixture(us);
+      std::vector<Spy> keys{ Spy(76), Spy(49) };
+      Spy::reset();
+      // exercise
+      size_t numInserted = us.insert_many(keys);
+      // verify
+      assertUnit(numInserted == 1);
+      assertUnit(Spy::numCopy() == 1);
+      assertUnit(Spy::numAlloc() == 1);
+      assertUnit(Spy::numCopyMove() == 4);   // 6 keys need 6 buckets: doubled to 8
+      assertUnit(us.bucket_count() == 8);
+      assertUnit(us.size() == 5);
+      assertUnit(us.find(Spy(76)) != us.end());
+      // teardown
+      teardownStandardFixture(us);
+   }
+
+   // a batch grows the table once and skips its own duplicates
+   void test_insertMany_duplicates()
+   {  // setup
+      custom::unordered_set<int> us;
+      us.insert(5);
+      std::vector<int> keys;
+      for (int i = 0; i < 500; i++)
+         keys.push_back(i % 250);
+      // exercise
+      size_t numInserted = us.insert_many(keys);
+      // verify
+      assertUnit(numInserted == 249);   // all but 5
+      assertUnit(us.size() == 250);
+      assertUnit(us.load_factor() <= us.max_load_factor());
+      bool found = true;
+      for (int i = 0; i < 250; i++)
+         if (us.find(i) == us.end())
+            found = false;
+      assertUnit(found);
+      assertUnit(us.find(250) == us.end());
+   }  // teardown
+
+   // an incremental table is not grown up front
+   void test_insertMany_incremental()
+   {  // setup
+      custom::unordered_set<int> us(4);
+      setupIncrementalFixture(us);
+      std::vector<int> keys{ 5, 6, 0 };
+      // exercise
+      size_t numInserted = us.insert_many(keys);
+      // verify
+      assertUnit(numInserted == 2);
+      assertUnit(us.size() == 7);
+      assertUnit(us.bucket_count() == 8);
+      assertUnit(us.find(0) != us.end());
+      assertUnit(us.find(6) != us.end());
+   }  // teardown
+
+   /***************************************
+    * PARALLEL REHASH
+    ***************************************/
+
+   // the nodes are spliced into the new buckets, no element moves
+   void test_parallelRehash_standard()
+   {  // setup
+      custom::unordered_set<Spy> us;
+      setupStandardFixture(us);
+      Spy::reset();
+      // exercise
+      us.rehash(6, custom::thread_executor(3));
+      // verify
+      assertUnit(Spy::numCopyMove() == 0);
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(Spy::numDelete() == 0);
+      assertUnit(Spy::numDestructor() == 0);
+      // h[0] -->
+      // h[1] --> 49 67
+      // h[2] --> 59
+      // h[3] -->
+      // h[4] --> 31
+      // h[5] -->
+      assertUnit(us.numElements == 4);
+      assertUnit(us.buckets.size() == 6);
+      if (us.buckets.size() == 6)
+      {
+         assertUnit(us.buckets[0].size() == 0);
+         assertUnit(us.buckets[1].size() == 2);
+         assertUnit(us.buckets[2].size() == 1);
+         assertUnit(us.buckets[3].size() == 0);
+         assertUnit(us.buckets[4].size() == 1);
+         assertUnit(us.buckets[5].size() == 0);
+         assertUnit(us.buckets[1].front() == Spy(49));
+         assertUnit(us.buckets[1].back()  == Spy(67));
+      }
+      // teardown
+      teardownStandardFixture(us);
+   }
+
+   // asking for fewer buckets changes nothing
+   void test_parallelRehash_smaller()
+   {  // setup
+      custom::unordered_set<Spy> us;
+      setupStandardFixture(us);
+      Spy::reset();
+      // exercise
+      us.rehash(3, custom::thread_executor(3));
+      // verify
+      assertUnit(Spy::numCopyMove() == 0);
+      assertStandardFixture(us);
+      // teardown
+      teardownStandardFixture(us);
+   }
+
+   // every bucket ends up just as a single-threaded rehash leaves it
+   void test_parallelRehash_sameOrder()
+   {  // setup
+      custom::unordered_set<int> usSerial(7);
+      custom::unordered_set<int> usSplit(7);
+      for (int i = 0; i < 1000; i++)
+      {
+         usSerial.insert(i * 37);
+         usSplit.insert(i * 37);
+      }
+      // exercise
+      usSerial.rehash(3001);
+      usSplit.rehash(3001, custom::inline_executor(4));
+      // verify
+      assertUnit(usSplit.size() == 1000);
+      assertUnit(usSplit.bucket_count() == usSerial.bucket_count());
+      bool same = true;
+      for (size_t i = 0; i < usSerial.bucket_count(); i++)
+      {
+         auto itSerial = usSerial.begin(i);
+         auto itSplit = usSplit.begin(i);
+         for (; itSerial != usSerial.end(i) && itSplit != usSplit.end(i); ++itSerial, ++itSplit)
+            if (*itSerial != *itSplit)
+               same = false;
+         if (itSerial != usSerial.end(i) || itSplit != usSplit.end(i))
+            same = false;
+      }
+      assertUnit(same);
+   }  // teardown
+
+   // a cached hash is reused from every thread
+   void test_parallelRehash_cached()
+   {  // setup
+      custom::unordered_set<Spy, HashCached<Spy>> us(4);
+      us.insert(Spy(31));
+      us.insert(Spy(49));
+      us.insert(Spy(67));
+      us.insert(Spy(59));
+      HashCount<Spy>::count = 0;
+      // exercise
+      us.rehash(20, custom::thread_executor(4));
+      // verify
+      assertUnit(HashCount<Spy>::count == 0);
+      assertUnit(us.bucket_count() == 20);
+      assertUnit(us.buckets[4].size() == 1);    // 31
+      assertUnit(us.buckets[13].size() == 2);   // 49 67
+      assertUnit(us.buckets[14].size() == 1);   // 59
+   }  // teardown
+
+   // a migration under way is finished before the split
+   void test_parallelRehash_incremental()
+   {  // setup
+      custom::unordered_set<int> us(4);
+      setupIncrementalFixture(us);
+      // exercise
+      us.rehash(32, custom::thread_executor(2));
+      // verify
+      assertUnit(!us.rehashing());
+      assertUnit(us.bucket_count() == 32);
+      assertUnit(us.size() == 5);
+      bool found = true;
+      for (int i = 0; i < 5; i++)
+         if (us.bucket_size(i) != 1)
+            found = false;
+      assertUnit(found);
+   }  // teardown
+
+   // off by default; at a threshold asked for, a plain rehash splices too
+   void test_parallelRehash_threshold()
+   {  // setup
+      custom::unordered_set<Spy> us;
+      setupStandardFixture(us);
+      us.parallel_rehash_threshold(4);
+      Spy::reset();
+      // exercise
+      us.rehash(6);
+      // verify
+      assertUnit(Spy::numCopyMove() == 0);
+      assertUnit(Spy::numDestructor() == 0);
+      assertUnit(us.bucket_count() == 6);
+      assertUnit(us.bucket_size(1) == 2);
+      assertUnit(custom::unordered_set<int>().parallel_rehash_threshold() ==
+                 custom::unordered_set<int>::PARALLEL_REHASH_OFF);
+      // teardown
+      teardownStandardFixture(us);
+   }
+
+   /***************************************
+    * NODE HANDLE
+    ***************************************/
+
+   // the node leaves its bucket, nothing allocated, copied or moved
+   void test_extract_key()
+   {  // setup
+      custom::unordered_set<Spy> us;
+      setupStandardFixture(us);
+      Spy s67(67);
+      Spy::reset();
+      // exercise
+      auto node = us.extract(s67);
+      // verify
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(Spy::numDelete() == 0);
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numCopyMove() == 0);
+      assertUnit(Spy::numDestructor() == 0);
+      assertUnit(!node.empty());
+      assertUnit(node.value().get() == 67);
+      assertUnit(us.size() == 3);
+      assertUnit(us.bucket_size(1) == 1);
+      assertUnit(us.find(s67) == us.end());
+      // teardown
+      teardownStandardFixture(us);
+   }
+
+   // extract what an iterator points to
+   void test_extract_iterator()
+   {  // setup
+      custom::unordered_set<Spy> us;
+      setupStandardFixture(us);
+      auto it = us.find(Spy(31));
+      Spy::reset();
+      // exercise
+      auto node = us.extract(it);
+      // verify
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(bool(node));
+      assertUnit(node.value().get() == 31);
+      assertUnit(us.size() == 3);
+      assertUnit(us.bucket_size(0) == 0);
+      // teardown
+      teardownStandardFixture(us);
+   }
+
+   // no element, no node
+   void test_extract_missing()
+   {  // setup
+      custom::unordered_set<Spy> us;
+      setupStandardFixture(us);
+      Spy s99(99);
+      // exercise
+      auto node = us.extract(s99);
+      auto nodeEnd = us.extract(us.end());
+      // verify
+      assertUnit(node.empty());
+      assertUnit(!nodeEnd);
+      assertStandardFixture(us);
+      // teardown
+      teardownStandardFixture(us);
+   }
+
+   // a node nobody takes frees its element
+   void test_extract_destroy()
+   {  // setup
+      custom::unordered_set<Spy> us;
+      setupStandardFixture(us);
+      Spy s59(59);
+      Spy::reset();
+      // exercise
+      {
+         auto node = us.extract(s59);
+      }
+      // verify
+      assertUnit(Spy::numDestructor() == 1);
+      assertUnit(Spy::numDelete() == 1);
+      assertUnit(us.size() == 3);
+      // teardown
+      teardownStandardFixture(us);
+   }
+
+   // the node goes into another set as it was
+   void test_insertNode_standard()
+   {  // setup
+      custom::unordered_set<Spy> usSrc;
+      setupStandardFixture(usSrc);
+      custom::unordered_set<Spy> usDest;
+      Spy s67(67);
+      auto node = usSrc.extract(s67);
+      Spy::reset();
+      // exercise
+      auto result = usDest.insert(std::move(node));
+      // verify
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numCopyMove() == 0);
+      assertUnit(Spy::numDestructor() == 0);
+      assertUnit(result.inserted);
+      assertUnit(result.node.empty());
+      assertUnit(result.position != usDest.end());
+      if (result.position != usDest.end())
+         assertUnit((*result.position).get() == 67);
+      assertUnit(node.empty());
+      assertUnit(usDest.size() == 1);
+      assertUnit(usDest.find(s67) != usDest.end());
+      // teardown
+      teardownStandardFixture(usSrc);
+   }
+
+   // an equal element is already there, so the node comes back
+   void test_insertNode_duplicate()
+   {  // setup
+      custom::unordered_set<Spy> us;
+      setupStandardFixture(us);
+      Spy s67(67);
+      auto node = us.extract(s67);
+      us.insert(s67);
+      Spy::reset();
+      // exercise
+      auto result = us.insert(std::move(node));
+      // verify
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(Spy::numDestructor() == 0);
+      assertUnit(!result.inserted);
+      assertUnit(!result.node.empty());
+      assertUnit(result.node.value().get() == 67);
+      assertUnit(result.position == us.find(s67));
+      assertUnit(us.size() == 4);
+      // teardown
+      teardownStandardFixture(us);
+   }
+
+   // nothing to insert
+   void test_insertNode_empty()
+   {  // setup
+      custom::unordered_set<Spy> us;
+      setupStandardFixture(us);
+      custom::unordered_set<Spy>::node_type node;
+      // exercise
+      auto result = us.insert(std::move(node));
+      // verify
+      assertUnit(!result.inserted);
+      assertUnit(result.position == us.end());
+      assertUnit(result.node.empty());
+      assertStandardFixture(us);
+      // teardown
+      teardownStandardFixture(us);
+   }
+
+   // every element not already there moves over, the rest stay
+   void test_merge_standard()
+   {  // setup
+      custom::unordered_set<Spy> usSrc;
+      setupStandardFixture(usSrc);
+      custom::unordered_set<Spy> usDest;
+      Spy s49(49);
+      usDest.insert(s49);
+      Spy::reset();
+      // exercise
+      usDest.merge(usSrc);
+      // verify
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(Spy::numDelete() == 0);
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numCopyMove() == 0);
+      assertUnit(usDest.size() == 4);
+      assertUnit(usSrc.size() == 1);
+      assertUnit(usSrc.find(s49) != usSrc.end());
+      assertUnit(usSrc.bucket_size(1) == 1);
+      assertUnit(usDest.find(Spy(31)) != usDest.end());
+      assertUnit(usDest.find(Spy(59)) != usDest.end());
+      assertUnit(usDest.find(Spy(67)) != usDest.end());
+      // teardown
+      teardownStandardFixture(usSrc);
+   }
+
+   // the elements the source has yet to migrate move too
+   void test_merge_incremental()
+   {  // setup
+      custom::unordered_set<int> usSrc(4);
+      setupIncrementalFixture(usSrc);
+      custom::unordered_set<int> usDest;
+      // exercise
+      usDest.merge(usSrc);
+      // verify
+      assertUnit(usSrc.empty());
+      assertUnit(usSrc.begin() == usSrc.end());
+      assertUnit(usDest.size() == 5);
+      bool found = true;
+      for (int i = 0; i < 5; i++)
+         if (usDest.find(i) == usDest.end())
+            found = false;
+      assertUnit(found);
+   }  // teardown
+
+   // a set with another seed hashes each element again
+   void test_merge_seeded()
+   {  // setup
+      typedef custom::unordered_set<int, custom::hash<int>> Seeded;
+      Seeded usSrc(8, custom::hash<int>(1));
+      Seeded usDest(8, custom::hash<int>(2));
+      for (int i = 0; i < 100; i++)
+         usSrc.insert(i);
+      // exercise
+      usDest.merge(usSrc);
+      // verify
+      assertUnit(usSrc.empty());
+      assertUnit(usDest.size() == 100);
+      bool found = true;
+      for (int i = 0; i < 100; i++)
+         if (usDest.find(i) == usDest.end())
+            found = false;
+      assertUnit(found);
+      assertUnit(usDest.find(100) == usDest.end());
+   }  // teardown
+
+   // the filter of each set learns what came and what went
+   void test_merge_filter()
+   {  // setup
+      custom::unordered_set<int> usSrc;
+      custom::unordered_set<int> usDest;
+      usSrc.bloom_filter(10);
+      usDest.bloom_filter(10);
+      for (int i = 0; i < 50; i++)
+         usSrc.insert(i);
+      usDest.insert(7);
+      // exercise
+      usDest.merge(usSrc);
+      // verify
+      bool found = true;
+      for (int i = 0; i < 50; i++)
+         if (usDest.find(i) == usDest.end())
+            found = false;
+      assertUnit(found);
+      assertUnit(usSrc.size() == 1);
+      assertUnit(usSrc.find(7) != usSrc.end());
+      assertUnit(usSrc.find(8) == usSrc.end());
+   }  // teardown
+
+   /***************************************
+    * SHRINK
+    ***************************************/
+
+   // a drained table keeps its buckets until asked to give them back
+   void test_shrinkToFit_drained()
+   {  // setup
+      custom::unordered_set<int> us;
+      for (int i = 0; i < 1000; i++)
+         us.insert(i);
+      for (int i = 10; i < 1000; i++)
+         us.erase(i);
+      size_t numBucketsDrained = us.bucket_count();
+      // exercise
+      us.shrink_to_fit();
+      // verify
+      assertUnit(numBucketsDrained >= 1000);
+      assertUnit(us.bucket_count() == 10);
+      assertUnit(us.size() == 10);
+      bool found = true;
+      for (int i = 0; i < 10; i++)
+         if (us.find(i) == us.end())
+            found = false;
+      assertUnit(found);
+   }  // teardown
+
+   // the nodes are spliced into the smaller table, never copied
+   void test_shrinkToFit_splice()
+   {  // setup
+      custom::unordered_set<Spy> us;
+      setupStandardFixture(us);
+      us.rehash(64);
+      Spy::reset();
+      // exercise
+      us.shrink_to_fit();
+      // verify
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(Spy::numDelete() == 0);
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numCopyMove() == 0);
+      assertUnit(Spy::numDestructor() == 0);
+      assertUnit(us.bucket_count() == custom::unordered_set<Spy>::MIN_BUCKETS);
+      assertUnit(us.size() == 4);
+      assertUnit(us.find(Spy(67)) != us.end());
+      // teardown
+      teardownStandardFixture(us);
+   }
+
+   // shrink_to_fit never adds buckets
+   void test_shrinkToFit_neverGrows()
+   {  // setup
+      custom::unordered_set<Spy> us;
+      setupStandardFixture(us);
+      // exercise
+      us.shrink_to_fit();
+      // verify
+      assertStandardFixture(us);
+      // teardown
+      teardownStandardFixture(us);
+   }
+
+   // off unless asked for
+   void test_minLoadFactor_off()
+   {  // setup
+      custom::unordered_set<int> us;
+      for (int i = 0; i < 1000; i++)
+         us.insert(i);
+      size_t numBuckets = us.bucket_count();
+      // exercise
+      for (int i = 0; i < 1000; i++)
+         us.erase(i);
+      // verify
+      assertUnit(us.min_load_factor() == (float)0.0);
+      assertUnit(us.bucket_count() == numBuckets);
+   }  // teardown
+
+   // the insert after draining below the minimum leaves the table half full
+   void test_minLoadFactor_shrink()
+   {  // setup
+      custom::unordered_set<int> us;
+      us.min_load_factor((float)0.1);
+      for (int i = 0; i < 1000; i++)
+         us.insert(i);
+      size_t numBuckets = us.bucket_count();
+      // exercise
+      for (int i = 100; i < 1000; i++)
+         us.erase(i);
+      bool kept = us.bucket_count() == numBuckets;
+      us.insert(1000);
+      // verify
+      assertUnit(kept);                  // erase never rebuckets
+      assertUnit(us.bucket_count() < 250);
+      assertUnit(us.load_factor() >= (float)0.1);
+      assertUnit(us.size() == 101);
+      bool found = us.find(1000) != us.end();
+      for (int i = 0; i < 100; i++)
+         if (us.find(i) == us.end())
+            found = false;
+      assertUnit(found);
+   }  // teardown
+
+   // a size that swings back and forth does not rehash every time
+   void test_minLoadFactor_hysteresis()
+   {  // setup
+      custom::unordered_set<int> us;
+      us.min_load_factor((float)0.1);
+      for (int i = 0; i < 1000; i++)
+         us.insert(i);
+      for (int i = 100; i < 1000; i++)
+         us.erase(i);
+      us.insert(100);                    // gives the buckets back
+      us.erase(100);
+      size_t numBuckets = us.bucket_count();
+      // exercise
+      for (int round = 0; round < 50; round++)
+      {
+         for (int i = 100; i < 150; i++)
+            us.insert(i);
+         for (int i = 100; i < 150; i++)
+            us.erase(i);
+      }
+      // verify
+      assertUnit(us.bucket_count() == numBuckets);
+      assertUnit(us.size() == 100);
+   }  // teardown
+
+   // the trigger is never above a quarter of max_load_factor
+   void test_minLoadFactor_clamp()
+   {  // setup
+      custom::unordered_set<int> us;
+      us.min_load_factor((float)0.9);
+      for (int i = 0; i < 1000; i++)
+         us.insert(i);
+      size_t numBuckets = us.bucket_count();
+      // exercise
+      for (int i = 0; i < 500; i++)
+         us.erase(i);
+      us.insert(0);
+      // verify
+      assertUnit(us.bucket_count() == numBuckets);
+      assertUnit(us.load_factor() < (float)0.9);
+   }  // teardown
+
+   // erasing as we iterate a set far below the minimum visits every
+   // element once, so nothing is skipped and nothing seen twice
+   void test_minLoadFactor_eraseLoop()
+   {  // setup
+      custom::unordered_set<int> usAll;
+      custom::unordered_set<int> usMost;
+      usAll.min_load_factor((float)0.2);
+      usMost.min_load_factor((float)0.2);
+      for (int i = 0; i < 5000; i++)
+      {
+         usAll.insert(i);
+         usMost.insert(i);
+      }
+      size_t numBuckets = usMost.bucket_count();
+      int numVisitAll = 0;
+      int numVisitMost = 0;
+      // exercise
+      for (auto it = usAll.begin(); it != usAll.end(); numVisitAll++)
+         it = usAll.erase(*it);
+      for (auto it = usMost.begin(); it != usMost.end(); numVisitMost++)
+      {
+         if (*it % 10 == 0)
+            ++it;
+         else
+            it = usMost.erase(*it);
+      }
+      // verify
+      assertUnit(numVisitAll == 5000);
+      assertUnit(usAll.empty());
+      assertUnit(numVisitMost == 5000);
+      assertUnit(usMost.size() == 500);
+      assertUnit(usMost.bucket_count() == numBuckets);
+   }  // teardown
+
+   // a table reserved on purpose is not given back by the next insert
+   void test_minLoadFactor_reserve()
+   {  // setup
+      custom::unordered_set<int> us;
+      us.min_load_factor((float)0.1);
+      us.reserve(10000);
+      size_t numBuckets = us.bucket_count();
+      int numRehashes = 0;
+      // exercise
+      for (int i = 0; i < 10000; i++)
+      {
+         size_t numBefore = us.bucket_count();
+         us.insert(i);
+         if (us.bucket_count() != numBefore)
+            numRehashes++;
+      }
+      // verify
+      assertUnit(numBuckets >= 10000);
+      assertUnit(us.bucket_count() == numBuckets);
+      assertUnit(numRehashes == 0);
+      assertUnit(us.size() == 10000);
+   }  // teardown
+
+   // the filter is sized for the smaller table
+   void test_minLoadFactor_filter()
+   {  // setup
+      custom::unordered_set<int> us;
+      us.bloom_filter(10);
+      us.min_load_factor((float)0.1);
+      for (int i = 0; i < 1000; i++)
+         us.insert(i);
+      size_t numBytes = us.stats().bloomBytes;
+      // exercise
+      for (int i = 50; i < 1000; i++)
+         us.erase(i);
+      us.insert(1000);
+      // verify
+      assertUnit(us.stats().bloomBytes < numBytes);
+      bool found = true;
+      for (int i = 0; i < 50; i++)
+         if (us.find(i) == us.end())
+            found = false;
+      assertUnit(found);
+      assertUnit(us.find(500) == us.end());
+   }  // teardown
+
+   /*************************************************************
+    * SETUP INCREMENTAL FIXTURE
+    *   old: h[0] --> 0   h[1] --> 1   h[2] --> 2   h[3] --> 3
+    *   new: h[4] --> 4   (eight buckets, nothing migrated yet)
+    *************************************************************/
+   void setupIncrementalFixture(custom::unordered_set<int>& us)
+   {
+      us.incremental_rehash(true);
+      for (int i = 0; i < 5; i++)
+         us.insert(i);
+   }
+
    /*************************************************************
     * SETUP STANDARD FIXTURE
     *      h[0] --> 31 
@@ -2888,7 +4751,8 @@ public:
     *      h[2] --> 59 
     *      h[3] --> 
     *************************************************************/
-   void setupStandardFixture(custom::unordered_set<Spy> & us)
+   template <class H, class E>
+   void setupStandardFixture(custom::unordered_set<Spy, H, E> & us)
    {
       // clear out whatever the default constructor created
       us.buckets.clear();
@@ -2925,7 +4789,8 @@ public:
     *      h[2] --> 59
     *      h[3] -->
     *************************************************************/
-   void assertStandardFixtureParameters(custom::unordered_set<Spy>& us, int line, const char * function)
+   template <class H>
+   void assertStandardFixtureParameters(custom::unordered_set<Spy, H>& us, int line, const char * function)
    {
       assertIndirect(us.numElements == 4);
       assertIndirect(us.buckets.size() == 4);
@@ -2974,7 +4839,8 @@ public:
    /*************************************************************
     * TEARDOWN STANDARD FIXTURE
     *************************************************************/
-   void teardownStandardFixture(custom::unordered_set<Spy>& us)
+   template <class H, class E>
+   void teardownStandardFixture(custom::unordered_set<Spy, H, E>& us)
    {
       // explicitly clear each bucket
       for (auto & bucket : us.buckets)
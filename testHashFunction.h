@@ -0,0 +1,264 @@
+/***********************************************************************
+ * Header:
+ *    TEST HASH FUNCTION
+ * Summary:
+ *    Unit tests for the seeded custom::hash family
+ * Author
+ *    Marco Varela &  Andre Regino
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "hashFunction.h"  // class under test
+#include "hash.h"          // the set the hashes are meant for
+#include "pair.h"          // for custom::pair
+#include "unitTest.h"      // unit test baseclass
+
+#include <cstdint>         // for uint64_t
+#include <set>             // for std::set of distinct hashes
+#include <string>          // for std::string keys
+#include <tuple>           // for std::tuple keys
+#include <utility>         // for std::pair keys
+#include <vector>          // for std::vector of bucket counts
+
+/***********************************************
+ * TEST HASH FUNCTION
+ * Unit tests for the hash function family
+ ***********************************************/
+class TestHashFunction : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Seed
+      test_seed_default();
+      test_seed_differs();
+
+      // Integer
+      test_integer_lowBits();
+      test_integer_enum();
+      test_float_zero();
+      test_pointer_standard();
+
+      // String
+      test_string_equal();
+      test_string_everyLength();
+      test_string_transparent();
+
+      // Combine
+      test_stdPair_order();
+      test_customPair_firstOnly();
+      test_tuple_order();
+
+      // Set
+      test_set_seed();
+      test_set_strided();
+
+      report("HashFunction");
+   }
+
+   /***************************************
+    * SEED
+    ***************************************/
+
+   // every default hash shares the process seed
+   void test_seed_default()
+   {  // setup
+      custom::hash<int> h1;
+      custom::hash<int> h2;
+      custom::hash<std::string> h3;
+      // verify
+      assertUnit(h1.seed() == h2.seed());
+      assertUnit(h1.seed() == h3.seed());
+      assertUnit(h1.seed() == custom::default_hash_seed());
+      assertUnit(h1(42) == h2(42));
+      assertUnit(custom::hash<int>(7).seed() == 7);
+   }
+
+   // another seed, other hashes
+   void test_seed_differs()
+   {  // setup
+      custom::hash<int> h1(1);
+      custom::hash<int> h2(2);
+      custom::hash<std::string> s1(1);
+      custom::hash<std::string> s2(2);
+      // verify
+      assertUnit(h1(42) == custom::hash<int>(1)(42));
+      assertUnit(h1(42) != h2(42));
+      assertUnit(s1("flood") != s2("flood"));
+   }
+
+   /***************************************
+    * INTEGER
+    ***************************************/
+
+   // multiples of 1024 share every low bit, yet fill eight buckets evenly
+   void test_integer_lowBits()
+   {  // setup
+      custom::hash<uint64_t> h(1);
+      std::vector<int> count(8, 0);
+      // exercise
+      for (uint64_t i = 0; i < 1024; i++)
+         count[h(i << 10) % 8]++;
+      // verify
+      bool even = true;
+      for (int c : count)
+         if (c < 96 || c > 160)   // 128 each, give or take
+            even = false;
+      assertUnit(even);
+   }
+
+   // an enum hashes as its value
+   void test_integer_enum()
+   {  // setup
+      enum class Color { RED, GREEN };
+      custom::hash<Color> hColor(3);
+      custom::hash<int> hInt(3);
+      // verify
+      assertUnit(hColor(Color::GREEN) == hInt(1));
+      assertUnit(hColor(Color::RED) != hColor(Color::GREEN));
+   }
+
+   // 0.0 == -0.0, so they hash the same
+   void test_float_zero()
+   {  // setup
+      custom::hash<double> h(1);
+      custom::hash<float> hFloat(1);
+      // verify
+      assertUnit(h(0.0) == h(-0.0));
+      assertUnit(h(1.0) != h(-1.0));
+      assertUnit(hFloat((float)0.5) == h(0.5));
+   }
+
+   // the address, not what it points to
+   void test_pointer_standard()
+   {  // setup
+      int values[2] = { 5, 5 };
+      custom::hash<int *> h(1);
+      // verify
+      assertUnit(h(values) == h(&values[0]));
+      assertUnit(h(values) != h(values + 1));
+   }
+
+   /***************************************
+    * STRING
+    ***************************************/
+
+   // equal strings, equal hashes, whatever their storage
+   void test_string_equal()
+   {  // setup
+      custom::hash<std::string> h(1);
+      std::string s1 = "a string long enough to leave the small buffer";
+      std::string s2 = s1;
+      // verify
+      assertUnit(h(s1) == h(s2));
+      assertUnit(h(std::string()) == h(std::string()));
+      assertUnit(h(std::string()) != h(std::string(1, '\0')));
+   }
+
+   // every prefix of a long string is distinct, through every code path
+   void test_string_everyLength()
+   {  // setup
+      custom::hash<std::string> h(1);
+      std::string s;
+      for (int i = 0; i < 120; i++)
+         s += (char)('a' + i % 26);
+      std::set<size_t> hashes;
+      // exercise
+      for (size_t len = 0; len <= s.size(); len++)
+         hashes.insert(h(s.substr(0, len)));
+      // verify
+      assertUnit(hashes.size() == s.size() + 1);
+   }
+
+   // the characters of a pointer hash as the string does
+   void test_string_transparent()
+   {  // setup
+      custom::hash<std::string> h(1);
+      custom::unordered_set<std::string, custom::hash<std::string>, std::equal_to<>> us;
+      us.insert("apple");
+      us.insert("banana");
+      // verify
+      assertUnit(h("banana") == h(std::string("banana")));
+      assertUnit(us.find("banana") != us.end());
+      assertUnit(us.find("cherry") == us.end());
+   }
+
+   /***************************************
+    * COMBINE
+    ***************************************/
+
+   // (1, 2) is not (2, 1)
+   void test_stdPair_order()
+   {  // setup
+      custom::hash<std::pair<int, int>> h(1);
+      // verify
+      assertUnit(h(std::make_pair(1, 2)) == h(std::make_pair(1, 2)));
+      assertUnit(h(std::make_pair(1, 2)) != h(std::make_pair(2, 1)));
+      assertUnit(h(std::make_pair(1, 2)) != h(std::make_pair(1, 3)));
+   }
+
+   // custom::pairs with the same first are equal, so they hash the same
+   void test_customPair_firstOnly()
+   {  // setup
+      custom::hash<custom::pair<int, std::string>> h(1);
+      custom::pair<int, std::string> p1(7, std::string("seven"));
+      custom::pair<int, std::string> p2(7, std::string("siete"));
+      // verify
+      assertUnit(p1 == p2);
+      assertUnit(h(p1) == h(p2));
+      assertUnit(h(p1) == custom::hash<int>(1)(7));
+   }
+
+   // every element, in order
+   void test_tuple_order()
+   {  // setup
+      custom::hash<std::tuple<int, std::string, int>> h(1);
+      // verify
+      assertUnit(h(std::make_tuple(1, std::string("x"), 2)) == h(std::make_tuple(1, std::string("x"), 2)));
+      assertUnit(h(std::make_tuple(1, std::string("x"), 2)) != h(std::make_tuple(2, std::string("x"), 1)));
+      assertUnit(h(std::make_tuple(1, std::string("x"), 2)) != h(std::make_tuple(1, std::string("y"), 2)));
+   }
+
+   /***************************************
+    * SET
+    ***************************************/
+
+   // the set keeps the hash it was given, and its copies do too
+   void test_set_seed()
+   {  // setup
+      custom::unordered_set<int, custom::hash<int>> us(8, custom::hash<int>(99));
+      for (int i = 0; i < 20; i++)
+         us.insert(i);
+      // exercise
+      custom::unordered_set<int, custom::hash<int>> usCopy(us);
+      // verify
+      assertUnit(us.hash_function().seed() == 99);
+      assertUnit(usCopy.hash_function().seed() == 99);
+      assertUnit(usCopy.size() == 20);
+      assertUnit(usCopy.find(13) != usCopy.end());
+      assertUnit(usCopy.find(20) == usCopy.end());
+   }
+
+   // keys std::hash piles into a few chains spread out
+   void test_set_strided()
+   {  // setup
+      custom::unordered_set<uint64_t> usStd;
+      custom::unordered_set<uint64_t, custom::hash<uint64_t>> usCustom(8, custom::hash<uint64_t>(1));
+      // exercise
+      for (uint64_t i = 0; i < 1000; i++)
+      {
+         usStd.insert(i << 10);
+         usCustom.insert(i << 10);
+      }
+      // verify
+      assertUnit(usStd.stats().maxChain >= 500);
+      assertUnit(usCustom.stats().maxChain <= 10);
+   }
+};
+
+#endif // DEBUG
@@ -0,0 +1,438 @@
+/***********************************************************************
+ * Header:
+ *    TEST HASH MAP
+ * Summary:
+ *    Unit tests for unordered_map
+ * Author
+ *    Marco Varela &  Andre Regino
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "hashmap.h"    // class under test
+#include "unitTest.h"   // unit test baseclass
+#include "spy.h"        // spy is a mock class to monitor the class under test
+
+#include <stdexcept>    // for std::out_of_range
+#include <string>       // for std::string values
+
+/***********************************************
+ * TEST HASH MAP
+ * Unit tests for the unordered_map class
+ ***********************************************/
+class TestHashMap : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Construct
+      test_construct_default();
+      test_construct_initializerList();
+
+      // Access
+      test_find_standard();
+      test_find_standardMissing();
+      test_at_standard();
+      test_at_missing();
+      test_square_existing();
+      test_square_missing();
+
+      // Insert
+      test_tryEmplace_new();
+      test_tryEmplace_existing();
+      test_tryEmplace_moveKeyExisting();
+      test_insertOrAssign_new();
+      test_insertOrAssign_existing();
+      test_insertOrAssign_moveKeyNew();
+      test_insert_grow();
+      test_rehash_splices();
+
+      // Remove
+      test_erase_standard();
+      test_erase_missing();
+      test_clear_standard();
+
+      // Iterator
+      test_iterator_visitsAll();
+
+      report("HashMap");
+   }
+
+   /***************************************
+    * CONSTRUCT
+    ***************************************/
+
+   // an empty map has eight buckets
+   void test_construct_default()
+   {  // setup
+      Spy::reset();
+      // exercise
+      custom::unordered_map<Spy, Spy> m;
+      // verify
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(Spy::numDefault() == 0);
+      assertUnit(m.size() == 0);
+      assertUnit(m.empty());
+      assertUnit(m.bucket_count() == 8);
+   }  // teardown
+
+   // every pair in the list is copied in
+   void test_construct_initializerList()
+   {  // exercise
+      custom::unordered_map<int, std::string> m{ { 1, "one" }, { 2, "two" }, { 3, "three" } };
+      // verify
+      assertUnit(m.size() == 3);
+      assertUnit(m.at(2) == "two");
+   }  // teardown
+
+   /***************************************
+    * ACCESS
+    ***************************************/
+
+   // find by key only compares keys
+   void test_find_standard()
+   {  // setup
+      custom::unordered_map<Spy, Spy> m;
+      setupStandardFixture(m);
+      Spy key(67);
+      Spy::reset();
+      // exercise
+      auto it = m.find(key);
+      // verify
+      assertUnit(Spy::numEquals() == 2);   // 49 67
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(it != m.end());
+      if (it != m.end())
+      {
+         assertUnit(it->first.get() == 67);
+         assertUnit(it->second.get() == 670);
+      }
+   }  // teardown
+
+   // a key that is not there
+   void test_find_standardMissing()
+   {  // setup
+      custom::unordered_map<Spy, Spy> m;
+      setupStandardFixture(m);
+      Spy key(58);
+      // exercise
+      auto it = m.find(key);
+      // verify
+      assertUnit(it == m.end());
+      assertUnit(m.count(key) == 0);
+      assertUnit(m.count(Spy(59)) == 1);
+   }  // teardown
+
+   // at hands back the value itself
+   void test_at_standard()
+   {  // setup
+      custom::unordered_map<Spy, Spy> m;
+      setupStandardFixture(m);
+      Spy key(31);
+      Spy::reset();
+      // exercise
+      Spy& value = m.at(key);
+      // verify
+      assertUnit(value.get() == 310);
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numAlloc() == 0);
+   }  // teardown
+
+   // at throws when the key is not there
+   void test_at_missing()
+   {  // setup
+      custom::unordered_map<int, int> m;
+      m.try_emplace(1, 10);
+      bool thrown = false;
+      // exercise
+      try
+      {
+         m.at(2);
+      }
+      catch (const std::out_of_range&)
+      {
+         thrown = true;
+      }
+      // verify
+      assertUnit(thrown);
+      assertUnit(m.size() == 1);
+   }  // teardown
+
+   // [] on a key that is there changes nothing
+   void test_square_existing()
+   {  // setup
+      custom::unordered_map<Spy, Spy> m;
+      setupStandardFixture(m);
+      Spy key(59);
+      Spy::reset();
+      // exercise
+      Spy& value = m[key];
+      // verify
+      assertUnit(value.get() == 590);
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numDefault() == 0);
+      assertUnit(m.size() == 4);
+   }  // teardown
+
+   // [] on a new key default-constructs the value in its node, no assign
+   void test_square_missing()
+   {  // setup
+      custom::unordered_map<Spy, Spy> m;
+      setupStandardFixture(m);
+      Spy key(76);
+      Spy::reset();
+      // exercise
+      Spy& value = m[key];
+      // verify
+      assertUnit(Spy::numCopy() == 1);      // the key
+      assertUnit(Spy::numDefault() == 1);   // the value
+      assertUnit(Spy::numAssign() == 0);
+      assertUnit(Spy::numAssignMove() == 0);
+      assertUnit(Spy::numCopyMove() == 0);
+      assertUnit(value.empty());
+      assertUnit(m.size() == 5);
+   }  // teardown
+
+   /***************************************
+    * INSERT
+    ***************************************/
+
+   // a new key builds the value from the arguments inside the node
+   void test_tryEmplace_new()
+   {  // setup
+      custom::unordered_map<Spy, Spy> m;
+      setupStandardFixture(m);
+      Spy key(76);
+      Spy::reset();
+      // exercise
+      auto p = m.try_emplace(key, 760);
+      // verify
+      assertUnit(p.second == true);
+      assertUnit(Spy::numCopy() == 1);         // the key
+      assertUnit(Spy::numNondefault() == 1);   // the value, from 760
+      assertUnit(Spy::numAlloc() == 2);        // the key and the value
+      assertUnit(Spy::numCopyMove() == 0);
+      assertUnit(Spy::numDefault() == 0);
+      assertUnit(Spy::numAssign() == 0);
+      assertUnit((*p.first).second.get() == 760);
+      assertUnit(m.size() == 5);
+   }  // teardown
+
+   // an existing key copies nothing and allocates nothing
+   void test_tryEmplace_existing()
+   {  // setup
+      custom::unordered_map<Spy, Spy> m;
+      setupStandardFixture(m);
+      Spy key(49);
+      Spy value(999);
+      Spy::reset();
+      // exercise
+      auto p = m.try_emplace(key, value);
+      // verify
+      assertUnit(p.second == false);
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numCopyMove() == 0);
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(Spy::numNondefault() == 0);
+      assertUnit(Spy::numAssign() == 0);
+      assertUnit(Spy::numDestructor() == 0);
+      assertUnit((*p.first).second.get() == 490);
+      assertUnit(m.size() == 4);
+   }  // teardown
+
+   // an existing key passed by rvalue is not moved from
+   void test_tryEmplace_moveKeyExisting()
+   {  // setup
+      custom::unordered_map<Spy, Spy> m;
+      setupStandardFixture(m);
+      Spy key(49);
+      Spy::reset();
+      // exercise
+      auto p = m.try_emplace(std::move(key), 999);
+      // verify
+      assertUnit(p.second == false);
+      assertUnit(Spy::numCopyMove() == 0);
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(!key.empty());
+      assertUnit(key.get() == 49);
+   }  // teardown
+
+   // a new key is built like try_emplace
+   void test_insertOrAssign_new()
+   {  // setup
+      custom::unordered_map<Spy, Spy> m;
+      Spy key(31);
+      Spy value(310);
+      Spy::reset();
+      // exercise
+      auto p = m.insert_or_assign(key, value);
+      // verify
+      assertUnit(p.second == true);
+      assertUnit(Spy::numCopy() == 2);   // the key and the value
+      assertUnit(Spy::numAssign() == 0);
+      assertUnit(m.size() == 1);
+   }  // teardown
+
+   // an existing key has its value assigned
+   void test_insertOrAssign_existing()
+   {  // setup
+      custom::unordered_map<Spy, Spy> m;
+      setupStandardFixture(m);
+      Spy key(67);
+      Spy::reset();
+      // exercise
+      auto p = m.insert_or_assign(key, Spy(1));
+      // verify
+      assertUnit(p.second == false);
+      assertUnit(Spy::numAssignMove() == 1);
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numAlloc() == 1);   // the temporary Spy(1)
+      assertUnit(m.at(key).get() == 1);
+      assertUnit(m.size() == 4);
+   }  // teardown
+
+   // a key moved in is moved into the new element, never copied
+   void test_insertOrAssign_moveKeyNew()
+   {  // setup
+      custom::unordered_map<Spy, Spy> m;
+      Spy key(31);
+      Spy value(310);
+      Spy::reset();
+      // exercise
+      auto p = m.insert_or_assign(std::move(key), std::move(value));
+      // verify
+      assertUnit(p.second == true);
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numCopyMove() == 2);   // the key and the value
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(key.empty());
+      assertUnit((*p.first).second.get() == 310);
+      assertUnit(m.size() == 1);
+   }  // teardown
+
+   // a rehash relinks the nodes: nothing is copied, moved or freed
+   void test_rehash_splices()
+   {  // setup
+      custom::unordered_map<Spy, Spy> m;
+      setupStandardFixture(m);
+      const Spy * pValue = &m.at(Spy(49));
+      Spy::reset();
+      // exercise
+      m.rehash(64);
+      // verify
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numCopyMove() == 0);
+      assertUnit(Spy::numDestructor() == 0);
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(m.bucket_count() == 64);
+      assertUnit(&m.at(Spy(49)) == pValue);
+      assertUnit(m.size() == 4);
+   }  // teardown
+
+   // crossing the load factor doubles the buckets
+   void test_insert_grow()
+   {  // setup
+      custom::unordered_map<int, int> m;
+      // exercise
+      for (int i = 0; i < 100; i++)
+         m[i] = i * i;
+      // verify
+      assertUnit(m.size() == 100);
+      assertUnit(m.bucket_count() == 128);
+      assertUnit(m.load_factor() <= m.max_load_factor());
+      bool same = true;
+      for (int i = 0; i < 100; i++)
+         if (m.at(i) != i * i)
+            same = false;
+      assertUnit(same);
+   }  // teardown
+
+   /***************************************
+    * REMOVE
+    ***************************************/
+
+   // erase returns the element after the one removed
+   void test_erase_standard()
+   {  // setup
+      custom::unordered_map<int, int> m;
+      m[1] = 10;
+      m[9] = 90;   // same bucket as 1
+      m[2] = 20;
+      // exercise
+      auto it = m.erase(1);
+      // verify
+      assertUnit(m.size() == 2);
+      assertUnit(m.find(1) == m.end());
+      assertUnit(it != m.end());
+      if (it != m.end())
+         assertUnit(it->first == 9);
+   }  // teardown
+
+   // erase of a missing key returns end
+   void test_erase_missing()
+   {  // setup
+      custom::unordered_map<int, int> m;
+      m[1] = 10;
+      // exercise
+      auto it = m.erase(2);
+      // verify
+      assertUnit(it == m.end());
+      assertUnit(m.size() == 1);
+   }  // teardown
+
+   // clear destroys every key and value
+   void test_clear_standard()
+   {  // setup
+      custom::unordered_map<Spy, Spy> m;
+      setupStandardFixture(m);
+      Spy::reset();
+      // exercise
+      m.clear();
+      // verify
+      assertUnit(Spy::numDestructor() == 8);
+      assertUnit(m.empty());
+      assertUnit(m.begin() == m.end());
+   }  // teardown
+
+   /***************************************
+    * ITERATOR
+    ***************************************/
+
+   // every element once
+   void test_iterator_visitsAll()
+   {  // setup
+      custom::unordered_map<Spy, Spy> m;
+      setupStandardFixture(m);
+      int sumKeys = 0;
+      int sumValues = 0;
+      // exercise
+      for (auto it = m.begin(); it != m.end(); ++it)
+      {
+         sumKeys += it->first.get();
+         sumValues += it->second.get();
+      }
+      // verify
+      assertUnit(sumKeys == 31 + 49 + 67 + 59);
+      assertUnit(sumValues == 310 + 490 + 670 + 590);
+   }  // teardown
+
+   /*************************************************************
+    * SETUP STANDARD FIXTURE
+    *   31 -> 310, 49 -> 490, 67 -> 670, 59 -> 590
+    *************************************************************/
+   void setupStandardFixture(custom::unordered_map<Spy, Spy>& m)
+   {
+      m.try_emplace(Spy(31), 310);
+      m.try_emplace(Spy(49), 490);
+      m.try_emplace(Spy(67), 670);
+      m.try_emplace(Spy(59), 590);
+   }
+};
+
+#endif // DEBUG
@@ -0,0 +1,219 @@
+/***********************************************************************
+ * Header:
+ *    TEST HASH POLICY
+ * Summary:
+ *    Unit tests for the bucket index policies
+ * Author
+ *    Marco Varela &  Andre Regino
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "hashPolicy.h" // class under test
+#include "hash.h"       // the policies index the unordered_set buckets
+#include "unitTest.h"   // unit test baseclass
+#include "spy.h"        // spy is a mock class to monitor the class under test
+
+/***********************************************
+ * TEST HASH POLICY
+ * Unit tests for the bucket index policies
+ ***********************************************/
+class TestHashPolicy : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Helpers
+      test_mulhi64();
+
+      // Bucket count
+      test_modulo_bucketCount();
+      test_powerOfTwo_bucketCount();
+      test_prime_bucketCount();
+
+      // Index
+      test_modulo_index();
+      test_powerOfTwo_spread();
+      test_fastrange_range();
+      test_prime_matchesModulo();
+
+      // Unordered set
+      test_hash_primeDefault();
+      test_hash_primeFixture();
+      test_hash_powerOfTwoRehash();
+
+      report("HashPolicy");
+   }
+
+   /***************************************
+    * HELPERS
+    ***************************************/
+
+   // the high half of a 128 bit product
+   void test_mulhi64()
+   {  // verify
+      assertUnit(custom::mulhi64(0, 12345) == 0);
+      assertUnit(custom::mulhi64(1ULL << 32, 1ULL << 32) == 1);
+      assertUnit(custom::mulhi64(~0ULL, ~0ULL) == ~0ULL - 1);
+      assertUnit(custom::mulhi64(0x8000000000000000ULL, 10) == 5);
+   }
+
+   /***************************************
+    * BUCKET COUNT
+    ***************************************/
+
+   // modulo takes any count
+   void test_modulo_bucketCount()
+   {  // setup
+      custom::modulo_index policy;
+      // verify
+      assertUnit(policy.bucket_count(4) == 4);
+      assertUnit(policy.bucket_count(7) == 7);
+   }
+
+   // power of two rounds up
+   void test_powerOfTwo_bucketCount()
+   {  // setup
+      custom::power_of_two_index policy;
+      // verify
+      assertUnit(policy.bucket_count(1) == 1);
+      assertUnit(policy.bucket_count(5) == 8);
+      assertUnit(policy.bucket_count(8) == 8);
+      assertUnit(policy.bucket_count(1000) == 1024);
+   }
+
+   // prime rounds up to the next prime in the table
+   void test_prime_bucketCount()
+   {  // setup
+      custom::prime_index policy;
+      // verify
+      assertUnit(policy.bucket_count(0) == 5);
+      assertUnit(policy.bucket_count(8) == 11);
+      assertUnit(policy.bucket_count(11) == 11);
+      assertUnit(policy.bucket_count(1000) == 1741);
+   }
+
+   /***************************************
+    * INDEX
+    ***************************************/
+
+   // modulo is the plain remainder
+   void test_modulo_index()
+   {  // setup
+      custom::modulo_index policy;
+      // verify
+      assertUnit(policy.index(13, 8) == 5);
+      assertUnit(policy.index(13, 4) == 1);
+   }
+
+   // sequential keys that share their low bits still spread out
+   void test_powerOfTwo_spread()
+   {  // setup
+      custom::power_of_two_index policy;
+      size_t count[16] = {};
+      // exercise
+      for (size_t i = 0; i < 1600; i++)
+         count[policy.index(i * 16, 16)]++;
+      // verify
+      for (size_t i = 0; i < 16; i++)
+         assertUnit(count[i] > 50 && count[i] < 150);
+   }
+
+   // fastrange always lands in range, even for an odd count
+   void test_fastrange_range()
+   {  // setup
+      custom::fastrange_index policy;
+      size_t count[7] = {};
+      bool inRange = true;
+      // exercise
+      for (size_t i = 0; i < 700; i++)
+      {
+         size_t index = policy.index(i, 7);
+         if (index < 7)
+            count[index]++;
+         else
+            inRange = false;
+      }
+      // verify
+      assertUnit(inRange);
+      for (size_t i = 0; i < 7; i++)
+         assertUnit(count[i] > 50 && count[i] < 150);
+   }
+
+   // fastmod gives the same answer as the divide it replaces
+   void test_prime_matchesModulo()
+   {  // setup
+      custom::prime_index policy;
+      const size_t divisors[] = { 1, 5, 11, 1741, 1000, 4294967291u };
+      bool same = true;
+      // exercise
+      for (size_t divisor : divisors)
+         for (size_t hash = 0; hash < 100000; hash += 7)
+            if (policy.index(hash * 40503, divisor) != (hash * 40503) % divisor)
+               same = false;
+      // verify
+      assertUnit(same);
+      assertUnit(policy.divisor == 4294967291u);
+   }
+
+   /***************************************
+    * UNORDERED SET
+    ***************************************/
+
+   // the default bucket count is rounded up to a prime
+   void test_hash_primeDefault()
+   {  // setup
+      Spy::reset();
+      // exercise
+      custom::unordered_set<Spy, std::hash<Spy>, std::equal_to<Spy>,
+                            std::allocator<Spy>, custom::prime_index> us;
+      // verify
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(us.bucket_count() == 11);
+      assertUnit(us.size() == 0);
+   }
+
+   // the digit-sum hash of Spy indexes into the prime buckets
+   void test_hash_primeFixture()
+   {  // setup
+      custom::unordered_set<Spy, std::hash<Spy>, std::equal_to<Spy>,
+                            std::allocator<Spy>, custom::prime_index> us;
+      us.insert(Spy(31));   // 4  % 11 = 4
+      us.insert(Spy(49));   // 13 % 11 = 2
+      us.insert(Spy(67));   // 13 % 11 = 2
+      us.insert(Spy(59));   // 14 % 11 = 3
+      // exercise
+      size_t iBucket = us.bucket(Spy(58));   // 13 % 11 = 2
+      // verify
+      assertUnit(iBucket == 2);
+      assertUnit(us.bucket_size(2) == 2);
+      assertUnit(us.bucket_size(3) == 1);
+      assertUnit(us.bucket_size(4) == 1);
+      assertUnit(us.find(Spy(67)) != us.end());
+   }  // teardown
+
+   // every rehash keeps the bucket count a power of two
+   void test_hash_powerOfTwoRehash()
+   {  // setup
+      custom::unordered_set<int, std::hash<int>, std::equal_to<int>,
+                            std::allocator<int>, custom::power_of_two_index> us(10);
+      assertUnit(us.bucket_count() == 16);
+      // exercise
+      for (int i = 0; i < 100; i++)
+         us.insert(i * 64);
+      // verify
+      assertUnit(us.size() == 100);
+      assertUnit((us.bucket_count() & (us.bucket_count() - 1)) == 0);
+      bool found = true;
+      for (int i = 0; i < 100; i++)
+         if (us.find(i * 64) == us.end())
+            found = false;
+      assertUnit(found);
+   }  // teardown
+};
+
+#endif // DEBUG
@@ -0,0 +1,329 @@
+/***********************************************************************
+ * Header:
+ *    TEST HASH STATS
+ * Summary:
+ *    Unit tests for the hash table health report and probe counters
+ * Author
+ *    Marco Varela &  Andre Regino
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "hashStats.h"  // class under test
+#include "hash.h"       // the stats describe an unordered_set
+#include "unitTest.h"   // unit test baseclass
+#include "spy.h"        // spy is a mock class to monitor the class under test
+
+#include <iterator>     // for std::back_inserter
+#include <type_traits>  // for std::is_empty
+#include <vector>       // for std::vector of keys
+
+// std::hash under another name, so the set counts its probes
+template <class T>
+class HashProbed
+{
+   public:
+      std::size_t operator() (const T & t) const { return std::hash<T>()(t); }
+};
+namespace custom
+{
+   template <class T>
+   struct instrument_hash<T, HashProbed<T>> : std::true_type
+   {
+   };
+}
+
+/***********************************************
+ * TEST HASH STATS
+ * Unit tests for hash_stats and hash_counters
+ ***********************************************/
+class TestHashStats : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Counters
+      test_counters_off();
+      test_counters_count();
+
+      // Shape
+      test_stats_empty();
+      test_stats_standard();
+      test_stats_digitSum();
+      test_stats_migrating();
+      test_stats_merge();
+
+      // Instrumented
+      test_instrumented_insert();
+      test_instrumented_find();
+      test_instrumented_findMany();
+      test_instrumented_rehash();
+      test_instrumented_insertManyMinLoad();
+
+      report("HashStats");
+   }
+
+   /***************************************
+    * COUNTERS
+    ***************************************/
+
+   // off, the counters are an empty class and report nothing
+   void test_counters_off()
+   {  // setup
+      custom::unordered_set<int> us;
+      us.insert(3);
+      us.find(3);
+      // exercise
+      custom::hash_stats s = us.stats();
+      // verify
+      assertUnit(std::is_empty<custom::hash_counters<false>>::value);
+      assertUnit(!(custom::instrument_hash<int, std::hash<int>>::value));
+      assertUnit(s.instrumented == false);
+      assertUnit(s.numFinds == 0);
+      assertUnit(s.numInserts == 0);
+      assertUnit(s.comparesPerFind() == 0);
+   }  // teardown
+
+   // probes are filed under the operation that made them
+   void test_counters_count()
+   {  // setup
+      custom::hash_counters<true> counters;
+      custom::hash_stats s;
+      // exercise
+      counters.start();
+      counters.probe();
+      counters.probe();
+      counters.probe();
+      counters.endFind();
+      counters.start();
+      counters.probe();
+      counters.endInsert();
+      counters.start();
+      counters.endFind();
+      counters.rehashed();
+      counters.report(s);
+      // verify
+      assertUnit(s.instrumented == true);
+      assertUnit(s.numFinds == 2);
+      assertUnit(s.numFindCompares == 3);
+      assertUnit(s.numInserts == 1);
+      assertUnit(s.numInsertCompares == 1);
+      assertUnit(s.numRehashes == 1);
+      assertUnit(s.comparesPerFind() == (float)1.5);
+      assertUnit(s.comparesPerInsert() == (float)1.0);
+   }  // teardown
+
+   /***************************************
+    * SHAPE
+    ***************************************/
+
+   // eight empty buckets
+   void test_stats_empty()
+   {  // setup
+      custom::unordered_set<int> us;
+      // exercise
+      custom::hash_stats s = us.stats();
+      // verify
+      assertUnit(s.numElements == 0);
+      assertUnit(s.numBuckets == 8);
+      assertUnit(s.chains.size() == 1);
+      if (s.chains.size() == 1)
+         assertUnit(s.chains[0] == 8);
+      assertUnit(s.maxChain == 0);
+      assertUnit(s.meanChain == 0);
+      assertUnit(s.emptyRatio == (float)1.0);
+      assertUnit(s.loadFactor == 0);
+   }  // teardown
+
+   // h[0] --> 31, h[1] --> 49 67, h[2] --> 59, h[3] -->
+   void test_stats_standard()
+   {  // setup
+      custom::unordered_set<Spy> us(4);
+      us.max_load_factor((float)1.3);
+      us.insert(Spy(31));
+      us.insert(Spy(49));
+      us.insert(Spy(67));
+      us.insert(Spy(59));
+      Spy::reset();
+      // exercise
+      custom::hash_stats s = us.stats();
+      // verify
+      assertUnit(Spy::numEquals() == 0);
+      assertUnit(s.numElements == 4);
+      assertUnit(s.numBuckets == 4);
+      assertUnit(s.chains.size() == 3);
+      if (s.chains.size() == 3)
+      {
+         assertUnit(s.chains[0] == 1);
+         assertUnit(s.chains[1] == 2);
+         assertUnit(s.chains[2] == 1);
+      }
+      assertUnit(s.maxChain == 2);
+      assertUnit(s.meanChain == (float)4.0 / (float)3.0);
+      assertUnit(s.emptyRatio == (float)0.25);
+      assertUnit(s.loadFactor == (float)1.0);
+   }  // teardown
+
+   // the digit-sum hash of Spy leaves most buckets empty
+   void test_stats_digitSum()
+   {  // setup
+      custom::unordered_set<Spy> usSpy;
+      custom::unordered_set<int> usInt;
+      for (int i = 0; i < 1000; i++)
+      {
+         usSpy.insert(Spy(i));
+         usInt.insert(i);
+      }
+      // exercise
+      custom::hash_stats sSpy = usSpy.stats();
+      custom::hash_stats sInt = usInt.stats();
+      // verify
+      assertUnit(sSpy.numBuckets == sInt.numBuckets);
+      assertUnit(sSpy.emptyRatio > (float)0.85);   // at most 109 sums
+      assertUnit(sSpy.maxChain >= 10);
+      assertUnit(sInt.maxChain == 1);
+      assertUnit(sInt.emptyRatio < (float)0.05);
+   }  // teardown
+
+   // while migrating, the old buckets still to move are counted too
+   void test_stats_migrating()
+   {  // setup
+      custom::unordered_set<int> us(4);
+      us.incremental_rehash(true);
+      for (int i = 0; i < 5; i++)
+         us.insert(i);
+      // exercise
+      custom::hash_stats s = us.stats();
+      // verify
+      assertUnit(us.rehashing());
+      assertUnit(s.numElements == 5);
+      assertUnit(s.numBuckets == 12);   // 4 old and 8 new
+      assertUnit(s.maxChain == 1);
+   }  // teardown
+
+   /***************************************
+    * INSTRUMENTED
+    ***************************************/
+
+   // two tables summed as one: the standard fixture and eight empty buckets
+   void test_stats_merge()
+   {  // setup
+      custom::unordered_set<Spy> usStandard(4);
+      usStandard.max_load_factor((float)1.3);
+      usStandard.insert(Spy(31));
+      usStandard.insert(Spy(49));
+      usStandard.insert(Spy(67));
+      usStandard.insert(Spy(59));
+      custom::unordered_set<Spy> usEmpty;
+      custom::hash_stats s = usStandard.stats();
+      // exercise
+      s.merge(usEmpty.stats());
+      // verify
+      assertUnit(s.numElements == 4);
+      assertUnit(s.numBuckets == 12);
+      assertUnit(s.chains.size() == 3);
+      if (s.chains.size() == 3)
+      {
+         assertUnit(s.chains[0] == 9);
+         assertUnit(s.chains[1] == 2);
+         assertUnit(s.chains[2] == 1);
+      }
+      assertUnit(s.maxChain == 2);
+      assertUnit(s.meanChain == (float)4.0 / (float)3.0);
+      assertUnit(s.emptyRatio == (float)0.75);
+      assertUnit(s.loadFactor == (float)4.0 / (float)12.0);
+   }  // teardown
+
+   // an insert counts the elements it compared to find a duplicate
+   void test_instrumented_insert()
+   {  // setup
+      custom::unordered_set<Spy, HashProbed<Spy>> us(4);
+      us.max_load_factor((float)1.3);
+      // exercise
+      us.insert(Spy(31));
+      us.insert(Spy(49));
+      us.insert(Spy(67));   // compared to 49
+      us.insert(Spy(59));
+      us.insert(Spy(67));   // compared to 49 67
+      // verify
+      custom::hash_stats s = us.stats();
+      assertUnit(s.instrumented);
+      assertUnit(s.numInserts == 5);
+      assertUnit(s.numInsertCompares == 3);
+      assertUnit(s.numFinds == 0);
+   }  // teardown
+
+   // a find counts the chain it walked
+   void test_instrumented_find()
+   {  // setup
+      custom::unordered_set<Spy, HashProbed<Spy>> us(4);
+      us.max_load_factor((float)1.3);
+      us.insert(Spy(31));
+      us.insert(Spy(49));
+      us.insert(Spy(67));
+      us.insert(Spy(59));
+      // exercise
+      us.find(Spy(67));   // 49 67
+      us.find(Spy(58));   // 49 67
+      us.find(Spy(31));   // 31
+      // verify
+      custom::hash_stats s = us.stats();
+      assertUnit(s.numFinds == 3);
+      assertUnit(s.numFindCompares == 5);
+      assertUnit(s.comparesPerFind() == (float)5.0 / (float)3.0);
+   }  // teardown
+
+   // every key of a batch is one find
+   void test_instrumented_findMany()
+   {  // setup
+      custom::unordered_set<int, HashProbed<int>> us;
+      for (int i = 0; i < 8; i++)
+         us.insert(i);
+      std::vector<int> keys{ 1, 2, 3, 100 };
+      std::vector<bool> found;
+      // exercise
+      us.find_many(keys, std::back_inserter(found));
+      // verify
+      custom::hash_stats s = us.stats();
+      assertUnit(s.numFinds == 4);
+      assertUnit(s.numFindCompares == 4);   // 100 is compared to 4
+   }  // teardown
+
+   // every growth is counted, a rehash that does nothing is not
+   void test_instrumented_rehash()
+   {  // setup
+      custom::unordered_set<int, HashProbed<int>> us;
+      // exercise
+      for (int i = 0; i < 9; i++)
+         us.insert(i);    // 8 to 16 buckets
+      us.rehash(64);
+      us.rehash(10);
+      // verify
+      custom::hash_stats s = us.stats();
+      assertUnit(s.numRehashes == 2);
+      assertUnit(s.numBuckets == 64);
+   }  // teardown
+
+   // a batch grows once, even with a min_load_factor to shrink by
+   void test_instrumented_insertManyMinLoad()
+   {  // setup
+      custom::unordered_set<int, HashProbed<int>> us;
+      us.min_load_factor((float)0.1);
+      std::vector<int> keys;
+      for (int i = 0; i < 100000; i++)
+         keys.push_back(i);
+      // exercise
+      us.insert_many(keys);
+      // verify
+      custom::hash_stats s = us.stats();
+      assertUnit(s.numRehashes == 1);
+      assertUnit(s.numBuckets >= 100000);
+      assertUnit(us.size() == 100000);
+   }  // teardown
+};
+
+#endif // DEBUG
@@ -21,6 +21,43 @@
 #include <memory>
 #include <iostream>
 
+/***********************************************
+ * ALLOCATOR COUNT
+ * What every CountAllocator has handed out,
+ * no matter what type it was rebound to
+ ***********************************************/
+struct AllocatorCount
+{
+   static int & numAllocate()   { static int num = 0; return num; }
+   static int & numDeallocate() { static int num = 0; return num; }
+   static void reset()          { numAllocate() = numDeallocate() = 0; }
+};
+
+/***********************************************
+ * COUNT ALLOCATOR
+ * A std::allocator that counts what it hands out
+ ***********************************************/
+template <class T>
+class CountAllocator : public std::allocator<T>
+{
+public:
+   template <class U>
+   struct rebind { typedef CountAllocator<U> other; };
+   CountAllocator() {}
+   template <class U>
+   CountAllocator(const CountAllocator<U>&) {}
+   T * allocate(size_t num)
+   {
+      AllocatorCount::numAllocate()++;
+      return std::allocator<T>::allocate(num);
+   }
+   void deallocate(T * p, size_t num)
+   {
+      AllocatorCount::numDeallocate()++;
+      std::allocator<T>::deallocate(p, num);
+   }
+};
+
 class TestList : public UnitTest
 {
 public:
@@ -89,6 +126,7 @@ public:
       test_pushback_standard();
       test_pushback_moveEmpty();
       test_pushback_moveStandard();
+      test_emplaceback_empty();
       test_pushfront_empty();
       test_pushfront_standard();
       test_pushfront_moveEmpty();
@@ -100,6 +138,9 @@ public:
       test_insertMove_empty();
       test_insertMove_standardFront();
       test_insertMove_standardMiddle();
+      test_splice_standardToEmpty();
+      test_splice_oneToFront();
+      test_splice_oneToEnd();
 
       // Remove
       test_clear_empty();
@@ -121,6 +162,10 @@ public:
       test_empty_empty();
       test_empty_three();
 
+      // Allocator
+      test_allocator_pushback();
+      test_allocator_clear();
+
       report("List");
    }
 
@@ -1362,6 +1407,118 @@ public:
       teardownStandardFixture(l);
    }
 
+   // build an element in place on the back of an empty list
+   // splice the whole standard list into an empty one
+   void test_splice_standardToEmpty()
+   {  // setup
+      //        pHead             pTail
+      //       +----+   +----+   +----+
+      //       | 11 | - | 26 | - | 31 |
+      //       +----+   +----+   +----+
+      custom::list<Spy> lSrc;
+      setupStandardFixture(lSrc);
+      custom::list<Spy> lDes;
+      Spy::reset();
+      // exercise
+      lDes.splice(lDes.end(), lSrc);
+      // verify
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numCopyMove() == 0);
+      assertUnit(Spy::numDestructor() == 0);
+      assertEmptyFixture(lSrc);
+      assertStandardFixture(lDes);
+      // teardown
+      teardownStandardFixture(lDes);
+   }
+
+   // splice the tail of one list onto the front of another
+   void test_splice_oneToFront()
+   {  // setup
+      custom::list<Spy> lSrc;
+      setupStandardFixture(lSrc);
+      custom::list<Spy>::Node* p3 = lSrc.pTail;
+      custom::list<Spy> lDes;
+      lDes.push_back(Spy(99));
+      Spy::reset();
+      // exercise
+      lDes.splice(lDes.begin(), lSrc, lSrc.rbegin());
+      // verify
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(Spy::numCopyMove() == 0);
+      //        pHead    pTail
+      //       +----+   +----+
+      //       | 31 | - | 99 |
+      //       +----+   +----+
+      assertUnit(lDes.numElements == 2);
+      assertUnit(lDes.pHead == p3);
+      assertUnit(lDes.front() == Spy(31));
+      assertUnit(lDes.back() == Spy(99));
+      assertUnit(lDes.pHead->pPrev == nullptr);
+      assertUnit(lDes.pTail->pPrev == p3);
+      //        pHead    pTail
+      //       +----+   +----+
+      //       | 11 | - | 26 |
+      //       +----+   +----+
+      assertUnit(lSrc.numElements == 2);
+      assertUnit(lSrc.back() == Spy(26));
+      assertUnit(lSrc.pTail->pNext == nullptr);
+      // teardown
+      teardownStandardFixture(lSrc);
+   }
+
+   // splice the head of one list onto the end of another
+   void test_splice_oneToEnd()
+   {  // setup
+      custom::list<Spy> lSrc;
+      setupStandardFixture(lSrc);
+      custom::list<Spy> lDes;
+      Spy::reset();
+      // exercise
+      lDes.splice(lDes.end(), lSrc, lSrc.begin());
+      // verify
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(Spy::numCopyMove() == 0);
+      assertUnit(lDes.numElements == 1);
+      assertUnit(lDes.pHead == lDes.pTail);
+      assertUnit(lDes.front() == Spy(11));
+      assertUnit(lSrc.numElements == 2);
+      assertUnit(lSrc.front() == Spy(26));
+      assertUnit(lSrc.pHead->pPrev == nullptr);
+      // teardown
+      teardownStandardFixture(lSrc);
+   }
+
+   void test_emplaceback_empty()
+   {  // setup
+      custom::list<Spy> l;
+      Spy::reset();
+      // exercise
+      l.emplace_back(99);
+      // verify
+      assertUnit(Spy::numNondefault() == 1); // build [99] in the node
+      assertUnit(Spy::numAlloc() == 1);      // allocate [99]
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numCopyMove() == 0);
+      assertUnit(Spy::numDestructor() == 0);
+      assertUnit(Spy::numAssign() == 0);
+      assertUnit(Spy::numDefault() == 0);
+      //       +----+
+      //       | 99 |
+      //       +----+
+      assertUnit(l.pHead != nullptr);
+      assertUnit(l.pTail == l.pHead);
+      assertUnit(l.numElements == 1);
+      if (l.pHead)
+      {
+         assertUnit(l.pHead->data == Spy(99));
+         assertUnit(l.pHead->pNext == nullptr);
+         assertUnit(l.pHead->pPrev == nullptr);
+      }
+      // teardown
+      teardownStandardFixture(l);
+   }
+
    // push an element onto the back of the standard fixture
    void test_pushback_standard()
    {  // setup
@@ -3119,6 +3276,49 @@ public:
       teardownStandardFixture(l);
    }
 
+   /***************************************
+    * ALLOCATOR
+    ***************************************/
+
+   // push_back takes its node from the rebound allocator
+   void test_allocator_pushback()
+   {  // setup
+      custom::list<Spy, CountAllocator<Spy>> l;
+      Spy s(99);
+      Spy::reset();
+      AllocatorCount::reset();
+      // exercise
+      l.push_back(s);
+      l.push_front(s);
+      l.insert(l.end(), s);
+      // verify
+      assertUnit(AllocatorCount::numAllocate() == 3);
+      assertUnit(AllocatorCount::numDeallocate() == 0);
+      assertUnit(Spy::numCopy() == 3);
+      assertUnit(l.size() == 3);
+      // teardown
+      l.clear();
+   }
+
+   // clear, pop, and erase give every node back to the allocator
+   void test_allocator_clear()
+   {  // setup
+      custom::list<Spy, CountAllocator<Spy>> l{ Spy(11), Spy(26), Spy(31), Spy(49), Spy(67) };
+      Spy::reset();
+      AllocatorCount::reset();
+      // exercise
+      l.pop_back();
+      l.pop_front();
+      l.erase(l.begin());
+      l.clear();
+      // verify
+      assertUnit(AllocatorCount::numAllocate() == 0);
+      assertUnit(AllocatorCount::numDeallocate() == 5);
+      assertUnit(Spy::numDestructor() == 5);
+      assertUnit(Spy::numDelete() == 5);
+      assertUnit(l.empty());
+   }  // teardown
+
    /****************************************************************
     * Setup Standard Fixture
     *        pHead             pTail
@@ -0,0 +1,311 @@
+/***********************************************************************
+ * Header:
+ *    TEST MAPPED HASH
+ * Summary:
+ *    Unit tests for unordered_set::save and mapped_unordered_set
+ * Author
+ *    Marco Varela &  Andre Regino
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "mappedHash.h"    // class under test
+#include "hash.h"          // the set that writes the snapshot
+#include "hashFunction.h"  // for a seeded custom::hash
+#include "unitTest.h"      // unit test baseclass
+
+#include <cstdint>         // for uint64_t
+#include <cstdio>          // for std::remove
+#include <fstream>         // for std::ofstream of a bad file, std::fstream to patch one
+#include <stdexcept>       // for std::runtime_error
+
+/***********************************************
+ * TEST MAPPED HASH
+ * Unit tests for the snapshot of a set
+ ***********************************************/
+class TestMappedHash : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Save and load
+      test_load_empty();
+      test_load_standard();
+      test_load_buckets();
+      test_load_iterate();
+      test_load_migrating();
+      test_load_move();
+
+      // Refuse
+      test_refuse_missing();
+      test_refuse_garbage();
+      test_refuse_keyType();
+      test_refuse_seed();
+      test_refuse_offsets();
+
+      report("MappedHash");
+   }
+
+   /***************************************
+    * SAVE AND LOAD
+    ***************************************/
+
+   // no keys, the same eight buckets
+   void test_load_empty()
+   {  // setup
+      custom::unordered_set<int> us;
+      us.save(PATH);
+      // exercise
+      custom::mapped_unordered_set<int> ms(PATH);
+      // verify
+      assertUnit(ms.empty());
+      assertUnit(ms.size() == 0);
+      assertUnit(ms.bucket_count() == 8);
+      assertUnit(ms.begin() == ms.end());
+      assertUnit(ms.find(3) == ms.end());
+      // teardown
+      std::remove(PATH);
+   }
+
+   // every key is found, and no other
+   void test_load_standard()
+   {  // setup
+      custom::unordered_set<int> us(4);
+      setupStandardFixture(us);
+      us.save(PATH);
+      // exercise
+      auto ms = custom::unordered_set<int>::load_mapped(PATH);
+      // verify
+      assertUnit(ms.size() == 4);
+      assertUnit(ms.bucket_count() == 4);
+      assertUnit(ms.load_factor() == (float)1.0);
+      assertUnit(ms.find(31) != ms.end());
+      assertUnit(ms.find(49) != ms.end());
+      assertUnit(ms.find(67) != ms.end());
+      assertUnit(ms.find(59) != ms.end());
+      if (ms.find(67) != ms.end())
+         assertUnit(*ms.find(67) == 67);
+      assertUnit(ms.find(58) == ms.end());
+      assertUnit(ms.count(49) == 1);
+      assertUnit(ms.count(50) == 0);
+      // teardown
+      std::remove(PATH);
+   }
+
+   // every key is in the bucket it had in the set
+   void test_load_buckets()
+   {  // setup
+      custom::unordered_set<int> us(4);
+      setupStandardFixture(us);
+      us.save(PATH);
+      // exercise
+      custom::mapped_unordered_set<int> ms(PATH);
+      // verify
+      bool same = true;
+      for (size_t i = 0; i < us.bucket_count(); i++)
+         if (ms.bucket_size(i) != us.bucket_size(i))
+            same = false;
+      assertUnit(same);
+      assertUnit(ms.bucket(67) == us.bucket(67));
+      bool inBucket = true;
+      for (size_t i = 0; i < ms.bucket_count(); i++)
+         for (auto it = ms.begin(i); it != ms.end(i); ++it)
+            if (ms.bucket(*it) != i)
+               inBucket = false;
+      assertUnit(inBucket);
+      // teardown
+      std::remove(PATH);
+   }
+
+   // every key once
+   void test_load_iterate()
+   {  // setup
+      custom::unordered_set<uint64_t> us;
+      uint64_t sum = 0;
+      for (uint64_t i = 1; i <= 1000; i++)
+         us.insert(i * 7);
+      us.save(PATH);
+      custom::mapped_unordered_set<uint64_t> ms(PATH);
+      // exercise
+      for (auto it = ms.begin(); it != ms.end(); ++it)
+         sum += *it;
+      // verify
+      assertUnit(ms.size() == 1000);
+      assertUnit(ms.bucket_count() == us.bucket_count());
+      assertUnit(sum == 7 * 1000 * 1001 / 2);
+      // teardown
+      std::remove(PATH);
+   }
+
+   // the keys not yet migrated are saved in their new buckets
+   void test_load_migrating()
+   {  // setup
+      custom::unordered_set<int> us(4);
+      us.incremental_rehash(true);
+      for (int i = 0; i < 5; i++)
+         us.insert(i);
+      // exercise
+      us.save(PATH);
+      custom::mapped_unordered_set<int> ms(PATH);
+      // verify
+      assertUnit(us.rehashing());
+      assertUnit(ms.size() == 5);
+      assertUnit(ms.bucket_count() == 8);
+      bool found = true;
+      for (int i = 0; i < 5; i++)
+         if (ms.find(i) == ms.end())
+            found = false;
+      assertUnit(found);
+      // teardown
+      std::remove(PATH);
+   }
+
+   // the mapping moves, the source is left empty
+   void test_load_move()
+   {  // setup
+      custom::unordered_set<int> us(4);
+      setupStandardFixture(us);
+      us.save(PATH);
+      custom::mapped_unordered_set<int> msSrc(PATH);
+      // exercise
+      custom::mapped_unordered_set<int> msDest(std::move(msSrc));
+      // verify
+      assertUnit(msSrc.base == nullptr);
+      assertUnit(msSrc.empty());
+      assertUnit(msDest.size() == 4);
+      assertUnit(msDest.find(59) != msDest.end());
+      // teardown
+      std::remove(PATH);
+   }
+
+   /***************************************
+    * REFUSE
+    ***************************************/
+
+   // no file, no set
+   void test_refuse_missing()
+   {  // setup
+      std::remove(PATH);
+      // exercise and verify
+      assertUnit(throws<custom::mapped_unordered_set<int>>());
+   }
+
+   // a file that is not a snapshot
+   void test_refuse_garbage()
+   {  // setup
+      std::ofstream fout(PATH, std::ios::binary);
+      fout << "a text file, not a snapshot, but longer than the header is";
+      fout.close();
+      // exercise and verify
+      assertUnit(throws<custom::mapped_unordered_set<int>>());
+      // teardown
+      std::remove(PATH);
+   }
+
+   // the keys are ints, not 64 bit numbers
+   void test_refuse_keyType()
+   {  // setup
+      custom::unordered_set<int> us(4);
+      setupStandardFixture(us);
+      us.save(PATH);
+      // exercise and verify
+      assertUnit(throws<custom::mapped_unordered_set<uint64_t>>());
+      assertUnit(!throws<custom::mapped_unordered_set<int>>());
+      // teardown
+      std::remove(PATH);
+   }
+
+   // a seeded hash must be loaded with its seed
+   void test_refuse_seed()
+   {  // setup
+      typedef custom::unordered_set<int, custom::hash<int>> Seeded;
+      Seeded us(8, custom::hash<int>(1));
+      for (int i = 0; i < 100; i++)
+         us.insert(i);
+      us.save(PATH);
+      bool thrown = false;
+      // exercise
+      try
+      {
+         Seeded::load_mapped(PATH, custom::hash<int>(2));
+      }
+      catch (const std::runtime_error&)
+      {
+         thrown = true;
+      }
+      auto ms = Seeded::load_mapped(PATH, us.hash_function());
+      // verify
+      assertUnit(thrown);
+      assertUnit(ms.size() == 100);
+      assertUnit(ms.find(42) != ms.end());
+      // teardown
+      std::remove(PATH);
+   }
+
+   // bucket offsets out of order, or past the keys, are refused
+   void test_refuse_offsets()
+   {  // setup
+      custom::unordered_set<int> us(4);
+      setupStandardFixture(us);
+      us.save(PATH);
+      // exercise and verify
+      assertUnit(!throws<custom::mapped_unordered_set<int>>());
+      setOffset(0, 1);                   // the first bucket does not start at 0
+      assertUnit(throws<custom::mapped_unordered_set<int>>());
+      us.save(PATH);
+      setOffset(2, 100);                 // past the four keys
+      assertUnit(throws<custom::mapped_unordered_set<int>>());
+      us.save(PATH);
+      setOffset(1, 4);                   // bucket 1 ends before it starts
+      setOffset(2, 0);
+      assertUnit(throws<custom::mapped_unordered_set<int>>());
+      // teardown
+      std::remove(PATH);
+   }
+
+   /*************************************************************
+    * SETUP STANDARD FIXTURE
+    *   31, 49, 67, 59 in four buckets
+    *************************************************************/
+   void setupStandardFixture(custom::unordered_set<int>& us)
+   {
+      us.max_load_factor((float)1.3);
+      us.insert(31);
+      us.insert(49);
+      us.insert(67);
+      us.insert(59);
+   }
+
+   // overwrite the start of bucket i in the snapshot at PATH
+   void setOffset(size_t i, uint64_t offset)
+   {
+      std::fstream file(PATH, std::ios::binary | std::ios::in | std::ios::out);
+      file.seekp(sizeof(custom::snapshot_header) + i * sizeof(uint64_t));
+      file.write((const char *)&offset, sizeof(offset));
+   }
+
+   // does mapping PATH as a MappedSet throw?
+   template <class MappedSet>
+   bool throws()
+   {
+      try
+      {
+         MappedSet ms(PATH);
+      }
+      catch (const std::runtime_error&)
+      {
+         return true;
+      }
+      return false;
+   }
+
+   static const char * const PATH;
+};
+
+const char * const TestMappedHash::PATH = "testMappedHash.snapshot";
+
+#endif // DEBUG
@@ -30,6 +30,7 @@ public:
       test_create_default();
       test_create_nondefault();
       test_create_nondefaultMove();
+      test_create_piecewise();
       
       // Make Pair
       test_makePair_default();
@@ -136,6 +137,25 @@ public:
       assertUnit(s.get() == 99);
    }  // teardown
 
+   // create with each value built in place from its own arguments
+   void test_create_piecewise()
+   {  // setup
+      Spy s(99);
+      Spy::reset();
+      // exercise
+      custom::pair <Spy, Spy> p(std::piecewise_construct,
+                                std::forward_as_tuple(s), std::forward_as_tuple(100));
+      // verify
+      assertUnit(Spy::numCopy() == 1);       // p.first
+      assertUnit(Spy::numNondefault() == 1); // p.second
+      assertUnit(Spy::numAlloc() == 2);      // p.first and p.second
+      assertUnit(Spy::numCopyMove() == 0);
+      assertUnit(Spy::numDefault() == 0);
+      assertUnit(Spy::numAssign() == 0);
+      assertUnit(p.first.get() == 99);
+      assertUnit(p.second.get() == 100);
+   }  // teardown
+
    // create with the nondefault constructor moving the values
    void test_create_nondefaultMove()
    {  // setup
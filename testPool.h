@@ -0,0 +1,169 @@
+/***********************************************************************
+ * Header:
+ *    TEST POOL
+ * Summary:
+ *    Unit tests for the node pool and the pool allocator
+ * Author
+ *    Marco Varela &  Andre Regino
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "pool.h"       // class under test
+#include "list.h"       // the list draws its nodes from the pool
+#include "hash.h"       // the buckets share the pool
+#include "unitTest.h"   // unit test baseclass
+#include "spy.h"        // spy is a mock class to monitor the class under test
+
+#include <type_traits>  // for std::is_same
+
+/***********************************************
+ * TEST POOL
+ * Unit tests for node_pool and pool_allocator
+ ***********************************************/
+class TestPool : public UnitTest
+{
+   // each test gets its own pools so they start out empty
+   struct TagReuse  {};
+   struct TagGrow   {};
+   struct TagList   {};
+   struct TagHash   {};
+
+public:
+   void run()
+   {
+      reset();
+
+      // Pool
+      test_pool_blockSize();
+      test_pool_reuse();
+      test_pool_grow();
+
+      // Allocator
+      test_allocator_rebind();
+      test_list_pool();
+      test_hash_pool();
+
+      report("Pool");
+   }
+
+   /***************************************
+    * POOL
+    ***************************************/
+
+   // every block holds a link and keeps its alignment
+   void test_pool_blockSize()
+   {  // verify
+      assertUnit((custom::node_pool<1, 1>::BLOCK == sizeof(void *)));
+      assertUnit((custom::node_pool<24, 8>::BLOCK == 24));
+      assertUnit((custom::node_pool<20, 8>::BLOCK == 24));
+      assertUnit((custom::node_pool<32, 16>::BLOCK == 32));
+      assertUnit((custom::node_pool<32, 16>::HEADER == 16));
+   }
+
+   // a freed block is the next one handed out
+   void test_pool_reuse()
+   {  // setup
+      typedef custom::node_pool<24, 8, TagReuse> Pool;
+      Pool & pool = Pool::instance();
+      void * p1 = pool.allocate();
+      void * p2 = pool.allocate();
+      // exercise
+      pool.deallocate(p1);
+      void * p3 = pool.allocate();
+      // verify
+      assertUnit(p3 == p1);
+      assertUnit(p2 == static_cast<char *>(p1) + 24);
+      assertUnit(pool.slab_count() == 1);
+      assertUnit(pool.capacity() == Pool::MIN_SLAB);
+      // teardown
+      pool.deallocate(p2);
+      pool.deallocate(p3);
+   }
+
+   // running out of blocks carves a slab twice as big
+   void test_pool_grow()
+   {  // setup
+      typedef custom::node_pool<16, 8, TagGrow> Pool;
+      Pool & pool = Pool::instance();
+      const size_t num = Pool::MIN_SLAB + 1;
+      void * blocks[Pool::MIN_SLAB + 1];
+      // exercise
+      for (size_t i = 0; i < num; i++)
+         blocks[i] = pool.allocate();
+      // verify
+      assertUnit(pool.slab_count() == 2);
+      assertUnit(pool.capacity() == 3 * Pool::MIN_SLAB);
+      assertUnit(pool.slabBlocks == 4 * Pool::MIN_SLAB);
+      // teardown
+      for (size_t i = 0; i < num; i++)
+         pool.deallocate(blocks[i]);
+   }
+
+   /***************************************
+    * ALLOCATOR
+    ***************************************/
+
+   // rebinding keeps the tag
+   void test_allocator_rebind()
+   {  // setup
+      typedef custom::pool_allocator<int, TagList> IntAlloc;
+      typedef std::allocator_traits<IntAlloc>::rebind_alloc<double> DoubleAlloc;
+      // verify
+      assertUnit((std::is_same<DoubleAlloc, custom::pool_allocator<double, TagList>>::value));
+      assertUnit(IntAlloc() == DoubleAlloc());
+   }
+
+   // a list returns its nodes to the pool and takes them back
+   void test_list_pool()
+   {  // setup
+      typedef custom::list<Spy, custom::pool_allocator<Spy, TagList>> List;
+      typedef custom::node_pool<sizeof(List::Node), alignof(List::Node), TagList> Pool;
+      List l;
+      l.push_back(Spy(11));
+      l.push_back(Spy(26));
+      l.push_back(Spy(31));
+      List::Node * pHead = l.pHead;
+      l.clear();
+      Spy::reset();
+      // exercise
+      l.push_back(Spy(49));
+      l.push_back(Spy(67));
+      l.push_back(Spy(59));
+      // verify
+      assertUnit(Pool::instance().slab_count() == 1);
+      assertUnit(l.pTail == pHead);    // last freed, first reused
+      assertUnit(Spy::numCopyMove() == 3);
+      assertUnit(l.size() == 3);
+      // teardown
+      l.clear();
+   }
+
+   // every bucket of a hash draws from the same pool
+   void test_hash_pool()
+   {  // setup
+      typedef custom::unordered_set<int, std::hash<int>, std::equal_to<int>,
+                                    custom::pool_allocator<int, TagHash>> Set;
+      typedef custom::list<int, custom::pool_allocator<int, TagHash>>::Node Node;
+      typedef custom::node_pool<sizeof(Node), alignof(Node), TagHash> Pool;
+      Set us;
+      for (int i = 0; i < 50; i++)
+         us.insert(i);
+      size_t capacity = Pool::instance().capacity();
+      // exercise
+      for (int i = 0; i < 50; i++)
+         us.erase(i);
+      for (int i = 100; i < 150; i++)
+         us.insert(i);
+      // verify
+      assertUnit(capacity == Pool::instance().capacity());
+      assertUnit(Pool::instance().slab_count() == 1);
+      assertUnit(us.size() == 50);
+      assertUnit(us.find(120) != us.end());
+      assertUnit(us.find(20) == us.end());
+   }  // teardown
+};
+
+#endif // DEBUG
@@ -0,0 +1,279 @@
+/***********************************************************************
+ * Header:
+ *    TEST SHARDED HASH
+ * Summary:
+ *    Unit tests for sharded_unordered_set
+ * Author
+ *    Marco Varela &  Andre Regino
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "shardedHash.h"     // class under test
+#include "hashFunction.h"    // for a seeded custom::hash
+#include "executor.h"        // for the parallel for_each
+#include "unitTest.h"        // unit test baseclass
+
+#include <atomic>            // for std::atomic sums from several threads
+#include <cstdint>           // for uint64_t
+#include <thread>            // for std::thread
+#include <vector>            // for std::vector of threads
+
+/***********************************************
+ * TEST SHARDED HASH
+ * Unit tests for the sharded_unordered_set class
+ ***********************************************/
+class TestShardedHash : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Construct
+      test_construct_default();
+      test_construct_seeded();
+
+      // Shard
+      test_shard_spread();
+      test_shard_highBits();
+      test_shard_growAlone();
+
+      // Insert, find and erase
+      test_insert_contains();
+      test_erase_standard();
+      test_clear_standard();
+
+      // Aggregate
+      test_stats_merged();
+      test_forEach_all();
+      test_forEach_parallel();
+
+      // Threads
+      test_threads_insert();
+
+      report("ShardedHash");
+   }
+
+   /***************************************
+    * CONSTRUCT
+    ***************************************/
+
+   // every shard a default set
+   void test_construct_default()
+   {  // exercise
+      custom::sharded_unordered_set<int> s;
+      // verify
+      assertUnit(s.empty());
+      assertUnit(s.size() == 0);
+      assertUnit(s.bucket_count() == 64 * 8);
+      assertUnit(s.max_load_factor() == (float)1.0);
+      assertUnit(custom::sharded_unordered_set<int>::NUM_SHARDS == 64);
+   }  // teardown
+
+   // every shard hashes with the seed the set was given
+   void test_construct_seeded()
+   {  // exercise
+      custom::sharded_unordered_set<int, 4, custom::hash<int>> s(64, custom::hash<int>(3));
+      // verify
+      assertUnit(s.hash_function().seed() == 3);
+      bool seeded = true;
+      for (size_t i = 0; i < 4; i++)
+         if (s.shards[i].set.hash_function().seed() != 3 || s.shards[i].set.bucket_count() != 16)
+            seeded = false;
+      assertUnit(seeded);
+   }  // teardown
+
+   /***************************************
+    * SHARD
+    ***************************************/
+
+   // the keys spread over every shard about evenly
+   void test_shard_spread()
+   {  // setup
+      custom::sharded_unordered_set<int, 16> s;
+      // exercise
+      for (int i = 0; i < 16000; i++)
+         s.insert(i);
+      // verify
+      bool even = true;
+      for (size_t i = 0; i < 16; i++)
+         if (s.shards[i].set.size() < 800 || s.shards[i].set.size() > 1200)
+            even = false;
+      assertUnit(even);
+   }  // teardown
+
+   // keys that differ only in their high bits still spread
+   void test_shard_highBits()
+   {  // setup
+      custom::sharded_unordered_set<uint64_t, 8> s;
+      // exercise
+      for (uint64_t i = 0; i < 800; i++)
+         s.insert(i << 40);
+      // verify
+      bool used = true;
+      for (size_t i = 0; i < 8; i++)
+         if (s.shards[i].set.size() < 50)
+            used = false;
+      assertUnit(used);
+   }  // teardown
+
+   // one busy shard grows without the others
+   void test_shard_growAlone()
+   {  // setup
+      custom::sharded_unordered_set<int, 8> s;
+      int numInserted = 0;
+      // exercise
+      for (int i = 0; numInserted < 100; i++)
+         if (s.shard_of(i) == 0)
+         {
+            s.insert(i);
+            numInserted++;
+         }
+      // verify
+      assertUnit(s.shards[0].set.bucket_count() >= 100);
+      bool untouched = true;
+      for (size_t i = 1; i < 8; i++)
+         if (s.shards[i].set.bucket_count() != 8 || !s.shards[i].set.empty())
+            untouched = false;
+      assertUnit(untouched);
+   }  // teardown
+
+   /***************************************
+    * INSERT, FIND AND ERASE
+    ***************************************/
+
+   // every key found once, and no other
+   void test_insert_contains()
+   {  // setup
+      custom::sharded_unordered_set<int> s;
+      // exercise
+      for (int i = 0; i < 1000; i++)
+         s.insert(i);
+      bool duplicate = s.insert(500);
+      // verify
+      assertUnit(!duplicate);
+      assertUnit(s.size() == 1000);
+      bool found = true;
+      for (int i = 0; i < 1000; i++)
+         if (!s.contains(i))
+            found = false;
+      assertUnit(found);
+      assertUnit(!s.contains(1000));
+      assertUnit(s.count(999) == 1);
+   }  // teardown
+
+   // erase says how many went
+   void test_erase_standard()
+   {  // setup
+      custom::sharded_unordered_set<int> s;
+      for (int i = 0; i < 100; i++)
+         s.insert(i);
+      // exercise
+      size_t numErased = s.erase(42);
+      size_t numMissing = s.erase(142);
+      // verify
+      assertUnit(numErased == 1);
+      assertUnit(numMissing == 0);
+      assertUnit(!s.contains(42));
+      assertUnit(s.size() == 99);
+   }  // teardown
+
+   // every shard emptied
+   void test_clear_standard()
+   {  // setup
+      custom::sharded_unordered_set<int> s;
+      for (int i = 0; i < 100; i++)
+         s.insert(i);
+      // exercise
+      s.clear();
+      // verify
+      assertUnit(s.empty());
+      assertUnit(!s.contains(7));
+   }  // teardown
+
+   /***************************************
+    * AGGREGATE
+    ***************************************/
+
+   // the stats of the shards, summed
+   void test_stats_merged()
+   {  // setup
+      custom::sharded_unordered_set<int, 4> s;
+      for (int i = 0; i < 100; i++)
+         s.insert(i);
+      // exercise
+      custom::hash_stats stats = s.stats();
+      // verify
+      assertUnit(stats.numElements == 100);
+      assertUnit(stats.numBuckets == s.bucket_count());
+      size_t numChained = 0;
+      for (size_t length = 0; length < stats.chains.size(); length++)
+         numChained += stats.chains[length] * length;
+      assertUnit(numChained == 100);
+   }  // teardown
+
+   // every element once
+   void test_forEach_all()
+   {  // setup
+      custom::sharded_unordered_set<int> s;
+      for (int i = 1; i <= 100; i++)
+         s.insert(i);
+      int sum = 0;
+      int num = 0;
+      // exercise
+      s.for_each([&](const int& value) { sum += value; num++; });
+      // verify
+      assertUnit(num == 100);
+      assertUnit(sum == 5050);
+   }  // teardown
+
+   // the shards dealt out over several threads
+   void test_forEach_parallel()
+   {  // setup
+      custom::sharded_unordered_set<int> s;
+      for (int i = 1; i <= 1000; i++)
+         s.insert(i);
+      std::atomic<int> sum(0);
+      std::atomic<int> num(0);
+      // exercise
+      s.for_each([&](const int& value) { sum += value; num++; }, custom::thread_executor(4));
+      // verify
+      assertUnit(num == 1000);
+      assertUnit(sum == 500500);
+   }  // teardown
+
+   /***************************************
+    * THREADS
+    ***************************************/
+
+   // overlapping inserts from four threads: each key goes in once
+   void test_threads_insert()
+   {  // setup
+      custom::sharded_unordered_set<int, 8> s;
+      std::atomic<int> numInserted(0);
+      std::vector<std::thread> threads;
+      // exercise
+      for (int t = 0; t < 4; t++)
+         threads.emplace_back([&s, &numInserted, t]()
+         {
+            for (int i = t * 500; i < t * 500 + 1000; i++)
+               if (s.insert(i))
+                  numInserted++;
+         });
+      for (auto& thread : threads)
+         thread.join();
+      // verify
+      assertUnit(s.size() == 2500);
+      assertUnit(numInserted == 2500);
+      bool found = true;
+      for (int i = 0; i < 2500; i++)
+         if (!s.contains(i))
+            found = false;
+      assertUnit(found);
+   }  // teardown
+};
+
+#endif // DEBUG
@@ -0,0 +1,519 @@
+/***********************************************************************
+ * Header:
+ *    TEST SMALL HASH
+ * Summary:
+ *    Unit tests for the small_unordered_set with inline storage
+ * Author
+ *    Marco Varela &  Andre Regino
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "smallHash.h"     // class under test
+#include "hashFunction.h"  // for a seeded custom::hash
+#include "testList.h"      // for CountAllocator
+#include "unitTest.h"      // unit test baseclass
+#include "spy.h"           // spy is a mock class to monitor the class under test
+
+#include <set>             // for std::set to check the iterator
+#include <stdexcept>       // for std::runtime_error from ThrowHash
+
+/***********************************************
+ * COUNT HASH
+ * std::hash that counts how often it was called
+ ***********************************************/
+struct CountHash
+{
+   static int & numCalls() { static int num = 0; return num; }
+   size_t operator()(int value) const
+   {
+      numCalls()++;
+      return std::hash<int>()(value);
+   }
+};
+
+/***********************************************
+ * THROW HASH
+ * std::hash of a Spy that throws on one value
+ ***********************************************/
+struct ThrowHash
+{
+   static int & throwOn() { static int value = -1; return value; }
+   size_t operator()(const Spy& s) const
+   {
+      if (s.get() == throwOn())
+         throw std::runtime_error("ThrowHash");
+      return std::hash<Spy>()(s);
+   }
+};
+
+/***********************************************
+ * COPY THROWS
+ * An int whose copy throws while armed
+ ***********************************************/
+struct CopyThrows
+{
+   static bool & armed() { static bool value = false; return value; }
+   CopyThrows(int value) : value(value) {}
+   CopyThrows(const CopyThrows& rhs) : value(rhs.value)
+   {
+      if (armed())
+         throw std::runtime_error("CopyThrows");
+   }
+   bool operator==(const CopyThrows& rhs) const { return value == rhs.value; }
+   int value;
+};
+struct CopyThrowsHash
+{
+   size_t operator()(const CopyThrows& t) const { return std::hash<int>()(t.value); }
+};
+
+/***********************************************
+ * TEST SMALL HASH
+ * Unit tests for the small_unordered_set class
+ ***********************************************/
+class TestSmallHash : public UnitTest
+{
+   typedef custom::small_unordered_set<Spy, 8, std::hash<Spy>, std::equal_to<Spy>, CountAllocator<Spy>> SpySet;
+   typedef custom::small_unordered_set<int, 8, std::hash<int>, std::equal_to<int>, CountAllocator<int>> IntSet;
+public:
+   void run()
+   {
+      reset();
+
+      // Construct
+      test_construct_default();
+
+      // Access
+      test_find_small();
+      test_find_noHash();
+
+      // Insert
+      test_insert_noAlloc();
+      test_insert_duplicate();
+      test_insert_spill();
+      test_insert_spillMoves();
+      test_insert_spillThrows();
+      test_insert_seeded();
+
+      // Remove
+      test_erase_small();
+      test_erase_missing();
+      test_erase_large();
+      test_clear_backInline();
+
+      // Assign
+      test_copy_small();
+      test_copy_large();
+      test_copy_largeThrows();
+      test_move_small();
+      test_move_large();
+      test_swap_smallLarge();
+
+      // Iterator
+      test_iterator_visitsAll();
+
+      report("SmallHash");
+   }
+
+   /***************************************
+    * CONSTRUCT
+    ***************************************/
+
+   // nothing on the heap, not even a bucket
+   void test_construct_default()
+   {  // setup
+      AllocatorCount::reset();
+      // exercise
+      IntSet s;
+      // verify
+      assertUnit(AllocatorCount::numAllocate() == 0);
+      assertUnit(s.is_small());
+      assertUnit(s.empty());
+      assertUnit(s.size() == 0);
+      assertUnit(s.bucket_count() == 0);
+      assertUnit(s.begin() == s.end());
+   }  // teardown
+
+   /***************************************
+    * ACCESS
+    ***************************************/
+
+   // a walk through the inline elements
+   void test_find_small()
+   {  // setup
+      IntSet s;
+      setupStandardFixture(s);
+      // exercise
+      auto it = s.find(49);
+      // verify
+      assertUnit(it != s.end());
+      if (it != s.end())
+         assertUnit(*it == 49);
+      assertUnit(s.find(50) == s.end());
+      assertUnit(s.count(67) == 1);
+      assertUnit(s.count(68) == 0);
+   }  // teardown
+
+   // a small set never hashes
+   void test_find_noHash()
+   {  // setup
+      custom::small_unordered_set<int, 4, CountHash> s;
+      CountHash::numCalls() = 0;
+      // exercise
+      s.insert(1);
+      s.insert(2);
+      s.find(2);
+      s.find(3);
+      s.erase(1);
+      // verify
+      assertUnit(CountHash::numCalls() == 0);
+      assertUnit(s.size() == 1);
+   }  // teardown
+
+   /***************************************
+    * INSERT
+    ***************************************/
+
+   // up to N elements, no heap traffic at all
+   void test_insert_noAlloc()
+   {  // setup
+      SpySet s;
+      Spy spies[8] = { Spy(1), Spy(2), Spy(3), Spy(4), Spy(5), Spy(6), Spy(7), Spy(8) };
+      AllocatorCount::reset();
+      Spy::reset();
+      // exercise
+      for (int i = 0; i < 8; i++)
+         s.insert(std::move(spies[i]));
+      // verify
+      assertUnit(AllocatorCount::numAllocate() == 0);
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numCopyMove() == 8);
+      assertUnit(s.is_small());
+      assertUnit(s.size() == 8);
+   }  // teardown
+
+   // an equal element is already inline
+   void test_insert_duplicate()
+   {  // setup
+      IntSet s;
+      setupStandardFixture(s);
+      // exercise
+      auto result = s.insert(31);
+      // verify
+      assertUnit(!result.second);
+      assertUnit(result.first == s.find(31));
+      assertUnit(s.size() == 4);
+   }  // teardown
+
+   // the N + 1st element moves the set into a hash
+   void test_insert_spill()
+   {  // setup
+      IntSet s;
+      for (int i = 0; i < 8; i++)
+         s.insert(i);
+      AllocatorCount::reset();
+      // exercise
+      auto result = s.insert(8);
+      // verify
+      assertUnit(result.second);
+      assertUnit(*result.first == 8);
+      assertUnit(AllocatorCount::numAllocate() > 0);
+      assertUnit(!s.is_small());
+      assertUnit(s.size() == 9);
+      assertUnit(s.bucket_count() >= 16);
+      bool found = true;
+      for (int i = 0; i < 9; i++)
+         if (s.find(i) == s.end())
+            found = false;
+      assertUnit(found);
+   }  // teardown
+
+   // spilling moves the inline elements, it never copies them
+   void test_insert_spillMoves()
+   {  // setup
+      SpySet s;
+      for (int i = 0; i < 8; i++)
+         s.insert(Spy(i));
+      Spy spy8(8);
+      Spy::reset();
+      // exercise
+      s.insert(std::move(spy8));
+      // verify
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numDestructor() == 8);   // the moved-from inline ones
+      assertUnit(s.size() == 9);
+   }  // teardown
+
+   // a spill that throws part way leaves every element inline
+   void test_insert_spillThrows()
+   {  // setup
+      custom::small_unordered_set<Spy, 8, ThrowHash, std::equal_to<Spy>, CountAllocator<Spy>> s;
+      for (int i = 0; i < 8; i++)
+         s.insert(Spy(i));
+      ThrowHash::throwOn() = 5;
+      AllocatorCount::reset();
+      bool thrown = false;
+      // exercise
+      try
+      {
+         s.insert(Spy(8));
+      }
+      catch (const std::runtime_error&)
+      {
+         thrown = true;
+      }
+      // verify
+      assertUnit(thrown);
+      assertUnit(s.is_small());
+      assertUnit(s.size() == 8);
+      bool found = true;
+      for (int i = 0; i < 8; i++)
+         if (s.find(Spy(i)) == s.end())
+            found = false;
+      assertUnit(found);
+      assertUnit(s.find(Spy(8)) == s.end());
+      assertUnit(AllocatorCount::numAllocate() == AllocatorCount::numDeallocate());
+      // teardown
+      ThrowHash::throwOn() = -1;
+   }  // teardown
+
+   // the hash it spills into has the seed the set was given
+   void test_insert_seeded()
+   {  // setup
+      custom::small_unordered_set<int, 2, custom::hash<int>> s(custom::hash<int>(5));
+      // exercise
+      s.insert(1);
+      s.insert(2);
+      s.insert(3);
+      // verify
+      assertUnit(!s.is_small());
+      assertUnit(s.pLarge->hash_function().seed() == 5);
+      assertUnit(s.find(3) != s.end());
+   }  // teardown
+
+   /***************************************
+    * REMOVE
+    ***************************************/
+
+   // the last element fills the hole
+   void test_erase_small()
+   {  // setup
+      IntSet s;
+      setupStandardFixture(s);
+      // exercise
+      auto it = s.erase(49);
+      // verify
+      assertUnit(s.size() == 3);
+      assertUnit(s.find(49) == s.end());
+      assertUnit(it != s.end());
+      if (it != s.end())
+         assertUnit(*it == 59);
+      assertUnit(s.find(31) != s.end());
+      assertUnit(s.find(67) != s.end());
+      assertUnit(s.find(59) != s.end());
+   }  // teardown
+
+   // nothing to erase
+   void test_erase_missing()
+   {  // setup
+      IntSet s;
+      setupStandardFixture(s);
+      // exercise
+      auto it = s.erase(50);
+      // verify
+      assertUnit(it == s.end());
+      assertUnit(s.size() == 4);
+   }  // teardown
+
+   // once large, the hash erases
+   void test_erase_large()
+   {  // setup
+      IntSet s;
+      for (int i = 0; i < 20; i++)
+         s.insert(i);
+      // exercise
+      for (int i = 0; i < 15; i++)
+         s.erase(i);
+      // verify
+      assertUnit(!s.is_small());
+      assertUnit(s.size() == 5);
+      assertUnit(s.find(3) == s.end());
+      assertUnit(s.find(17) != s.end());
+   }  // teardown
+
+   // clear frees the hash and goes back inline
+   void test_clear_backInline()
+   {  // setup
+      IntSet s;
+      AllocatorCount::reset();
+      for (int i = 0; i < 20; i++)
+         s.insert(i);
+      // exercise
+      s.clear();
+      // verify
+      assertUnit(s.is_small());
+      assertUnit(s.empty());
+      assertUnit(AllocatorCount::numAllocate() > 0);
+      assertUnit(AllocatorCount::numAllocate() == AllocatorCount::numDeallocate());
+   }  // teardown
+
+   /***************************************
+    * ASSIGN
+    ***************************************/
+
+   // a copy of the inline elements is inline too
+   void test_copy_small()
+   {  // setup
+      IntSet s;
+      setupStandardFixture(s);
+      // exercise
+      IntSet sCopy(s);
+      s.erase(31);
+      // verify
+      assertUnit(sCopy.is_small());
+      assertUnit(sCopy.size() == 4);
+      assertUnit(sCopy.find(31) != sCopy.end());
+      assertUnit(s.find(31) == s.end());
+   }  // teardown
+
+   // a copy of a large set has its own hash
+   void test_copy_large()
+   {  // setup
+      IntSet s;
+      for (int i = 0; i < 20; i++)
+         s.insert(i);
+      // exercise
+      IntSet sCopy;
+      sCopy = s;
+      s.erase(5);
+      // verify
+      assertUnit(!sCopy.is_small());
+      assertUnit(sCopy.pLarge != s.pLarge);
+      assertUnit(sCopy.size() == 20);
+      assertUnit(sCopy.find(5) != sCopy.end());
+   }  // teardown
+
+   // a copy of the hash that throws leaves the set empty and inline
+   void test_copy_largeThrows()
+   {  // setup
+      typedef custom::small_unordered_set<CopyThrows, 2, CopyThrowsHash, std::equal_to<CopyThrows>, CountAllocator<CopyThrows>> ThrowSet;
+      ThrowSet s;
+      for (int i = 0; i < 5; i++)
+         s.insert(CopyThrows(i));
+      ThrowSet sCopy;
+      AllocatorCount::reset();
+      CopyThrows::armed() = true;
+      bool thrown = false;
+      // exercise
+      try
+      {
+         sCopy = s;
+      }
+      catch (const std::runtime_error&)
+      {
+         thrown = true;
+      }
+      CopyThrows::armed() = false;
+      // verify
+      assertUnit(thrown);
+      assertUnit(sCopy.is_small());
+      assertUnit(sCopy.empty());
+      assertUnit(AllocatorCount::numAllocate() == AllocatorCount::numDeallocate());
+      assertUnit(s.size() == 5);
+   }  // teardown
+
+   // the inline elements are moved one by one
+   void test_move_small()
+   {  // setup
+      SpySet s;
+      for (int i = 0; i < 4; i++)
+         s.insert(Spy(i));
+      Spy::reset();
+      // exercise
+      SpySet sDest(std::move(s));
+      // verify
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(Spy::numCopyMove() == 4);
+      assertUnit(sDest.size() == 4);
+      assertUnit(s.empty());
+   }  // teardown
+
+   // the hash is taken whole
+   void test_move_large()
+   {  // setup
+      IntSet s;
+      for (int i = 0; i < 20; i++)
+         s.insert(i);
+      auto pLarge = s.pLarge;
+      AllocatorCount::reset();
+      // exercise
+      IntSet sDest(std::move(s));
+      // verify
+      assertUnit(AllocatorCount::numAllocate() == 0);
+      assertUnit(sDest.pLarge == pLarge);
+      assertUnit(s.is_small());
+      assertUnit(s.empty());
+      assertUnit(sDest.size() == 20);
+   }  // teardown
+
+   // a small set and a large one trade places
+   void test_swap_smallLarge()
+   {  // setup
+      IntSet sSmall;
+      setupStandardFixture(sSmall);
+      IntSet sLarge;
+      for (int i = 0; i < 20; i++)
+         sLarge.insert(i);
+      // exercise
+      sSmall.swap(sLarge);
+      // verify
+      assertUnit(!sSmall.is_small());
+      assertUnit(sSmall.size() == 20);
+      assertUnit(sLarge.is_small());
+      assertUnit(sLarge.size() == 4);
+      assertUnit(sLarge.find(67) != sLarge.end());
+   }  // teardown
+
+   /***************************************
+    * ITERATOR
+    ***************************************/
+
+   // every element once, small and large
+   void test_iterator_visitsAll()
+   {  // setup
+      IntSet s;
+      std::set<int> visitedSmall;
+      std::set<int> visitedLarge;
+      setupStandardFixture(s);
+      // exercise
+      for (auto it = s.begin(); it != s.end(); ++it)
+         visitedSmall.insert(*it);
+      for (int i = 0; i < 20; i++)
+         s.insert(i);
+      for (auto it = s.begin(); it != s.end(); it++)
+         visitedLarge.insert(*it);
+      // verify
+      assertUnit(visitedSmall == std::set<int>({ 31, 49, 67, 59 }));
+      assertUnit(visitedLarge.size() == 24);
+   }  // teardown
+
+   /*************************************************************
+    * SETUP STANDARD FIXTURE
+    *   31, 49, 67, 59 inline
+    *************************************************************/
+   void setupStandardFixture(IntSet& s)
+   {
+      s.insert(31);
+      s.insert(49);
+      s.insert(67);
+      s.insert(59);
+   }
+};
+
+#endif // DEBUG